@@ -1,17 +1,24 @@
 // KV2CrashHandler.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
+// Supervises a KinectV2Process: waits on its process handle, frees the Kinect once it exits
+// and restarts it after a crash, handing over the recovery state it kept published
 
 #include <iostream>
 #include <thread>
 
 #include "KV2ModHandler.h"
+#include "../SFMLProject/inc/ProcessSupervisor.h"
 
-BOOL IsProcessRunning(DWORD pid)
+void ReleaseKinect()
 {
-    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
-    DWORD ret = WaitForSingleObject(process, 0);
-    CloseHandle(process);
-    return ret == WAIT_TIMEOUT;
+    // Open the kinect to get its handle
+    KinectV2Handler kinect;
+    kinect.update();
+
+    // Shut down the kinect
+    kinect.terminateColor();
+    kinect.terminateDepth();
+    kinect.terminateSkeleton();
 }
 
 int main(int argc, char* argv[])
@@ -19,23 +26,34 @@ int main(int argc, char* argv[])
     // Hide console window
     ShowWindow(GetConsoleWindow(), SW_HIDE);
 
-    if (argc > 1) {
-        auto pid = atoi(argv[1]);
-        while (IsProcessRunning(pid))
-        {
-            // Sleep not to load out CPU
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
+    if (argc < 2)
+    {
+        ReleaseKinect();
+        return 0;
     }
 
-    // Open the kinect to get its handle
-    KinectV2Handler kinect;
-    kinect.update();
+    Supervision::SupervisedProcess process;
+    if (!process.attach(atoi(argv[1])))
+    {
+        ReleaseKinect();
+        return 0;
+    }
+    const std::wstring image = process.imagePath();
 
-    // Shut down the kinect
-    kinect.terminateColor();
-    kinect.terminateDepth();
-    kinect.terminateSkeleton();
+    // Hold the recovery state open, so it survives the process dying
+    Supervision::RecoveryChannel recovery;
+    const bool canRestart = argc > 2 && recovery.open(argv[2]) && !image.empty();
+
+    RestartPolicy policy;
+    Supervision::superviseLoop(policy, canRestart,
+        [&]() { return process.waitForExit(); },
+        ReleaseKinect,
+        [&]()
+        {
+            const std::string arguments = std::string(Supervision::k_supervisedFlag) + " " + argv[2];
+            return process.launch(image, std::wstring(arguments.begin(), arguments.end()));
+        },
+        [](RestartPolicy::clock::duration delay) { std::this_thread::sleep_for(delay); });
 
     return 0;
 }
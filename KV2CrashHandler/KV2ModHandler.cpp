@@ -1,4 +1,5 @@
 #include "KV2ModHandler.h"
+#include "../SFMLProject/inc/StartupReadiness.h"
 
 #include <iostream>
 #include <thread>
@@ -200,11 +201,22 @@ bool KinectV2Handler::initKinect()
 		//    | FrameSourceTypes::FrameSourceTypes_Color,
 		//   &frameReader);
 		//return frameReader;
-		std::this_thread::sleep_for(std::chrono::seconds(2));
-		// Necessary to allow kinect to become available behind the scenes
 
+		// The kinect becomes available behind the scenes, wait for it to say so
 		BOOLEAN available = false;
-		kinectSensor->get_IsAvailable(&available);
+		WAITABLE_HANDLE availableChanged = 0;
+		if (SUCCEEDED(hr_open) && SUCCEEDED(kinectSensor->SubscribeIsAvailableChanged(&availableChanged)))
+		{
+			Readiness::waitForHandle(reinterpret_cast<HANDLE>(availableChanged), [this, &available, availableChanged]
+			{
+				IIsAvailableChangedEventArgs* args = nullptr;
+				if (SUCCEEDED(kinectSensor->GetIsAvailableChangedEventData(availableChanged, &args)) && args)
+					args->Release();
+				kinectSensor->get_IsAvailable(&available);
+				return available != FALSE;
+			}, std::chrono::seconds(5));
+			kinectSensor->UnsubscribeIsAvailableChanged(availableChanged);
+		}
 
 		if (FAILED(hr_open) || !available)
 		{
@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+
+#include <QuaternionMath.h>
+
+#define PI 3.14159265359
+
+// Smooths every joint's rotation against its own last few frames, the engine behind RotationalSmoothingFilter
+// Each frame's rotations go into a fixed ring, one slot per joint in struct-of-arrays layout, and one pass
+// averages all joints with the similarity weighting of the old SmoothFilter. Nothing is allocated per frame
+//
+// Only depends on QuaternionMath.h, so it builds on its own
+template <int JointCount>
+class JointRotationSmoother
+{
+public:
+	typedef KMath::Quat::QuaternionArray<JointCount> JointQuaternions;
+
+	// How much each remembered rotation counts towards the average
+	enum class Weighting
+	{
+		Similarity, // Rotations far from the last result are pulled towards it
+		Uniform // Plain average of the window
+	};
+
+	static constexpr int k_maxWindowLength = 16;
+
+	JointRotationSmoother() { reset(); }
+
+	void reset()
+	{
+		historyHead = 0;
+		historyCount = 0;
+		filtered = {};
+	}
+
+	// Frames remembered per joint, 1 (the default) only follows the last result towards the newest rotation
+	void setWindowLength(int length)
+	{
+		windowLength = std::max(1, std::min(length, k_maxWindowLength));
+		reset();
+	}
+
+	int getWindowLength() const { return windowLength; }
+
+	void setWeighting(Weighting mode) { weighting = mode; }
+	Weighting getWeighting() const { return weighting; }
+
+	// The slot the next frame goes into, call smooth() once every joint is written
+	JointQuaternions& nextFrame() { return history[historyHead]; }
+
+	void smooth()
+	{
+		historyHead = (historyHead + 1) % windowLength;
+		historyCount = std::min(historyCount + 1, windowLength);
+
+		JointQuaternions sum = {};
+		const bool similarity = weighting == Weighting::Similarity;
+
+		for (int slot = 0; slot < historyCount; ++slot)
+		{
+			const JointQuaternions& sample = history[slot];
+			for (int i = 0; i < JointCount; ++i)
+			{
+				const float lastX = filtered.x[i], lastY = filtered.y[i], lastZ = filtered.z[i], lastW = filtered.w[i];
+
+				// 0 degrees of difference => weight 1. 180 degrees of difference => weight 0.
+				const float weight = similarity
+					                     ? 1.0f - (lastX * sample.x[i] + lastY * sample.y[i] + lastZ * sample.z[i] +
+						                     lastW * sample.w[i]) / static_cast<float>(PI / 2.0f)
+					                     : 1.0f;
+				const float weight_ = 1.0f - weight;
+
+				float x = weight_ * lastX + weight * sample.x[i];
+				float y = weight_ * lastY + weight * sample.y[i];
+				float z = weight_ * lastZ + weight * sample.z[i];
+				float w = weight_ * lastW + weight * sample.w[i];
+
+				// As divideBySquaredLength, divides by the squared length
+				const float magnitude = x * x + y * y + z * z + w * w;
+				const float scale = magnitude > 0.f ? 1.0f / magnitude : 0.f;
+				sum.x[i] += x * scale;
+				sum.y[i] += y * scale;
+				sum.z[i] += z * scale;
+				sum.w[i] += w * scale;
+			}
+		}
+
+		// Dividing by the window size doesn't change the direction, normalising is enough
+		KMath::Quat::normalise(sum);
+		filtered = sum;
+	}
+
+	const JointQuaternions& result() const { return filtered; }
+
+private:
+	// Ring of the last frames, every joint is pushed once per frame so they share the head
+	JointQuaternions history[k_maxWindowLength];
+	int historyHead = 0;
+	int historyCount = 0;
+	int windowLength = 1;
+	Weighting weighting = Weighting::Similarity;
+
+	JointQuaternions filtered;
+};
@@ -13,14 +13,39 @@
 #include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <KinectSettings.h>
+#include <LatencyStats.h>
+#include <QuaternionMath.h>
 #include <VRHelper.h>
-#include <sfLine.h>
+#include <SkeletonOverlay.h>
 #include <iostream>
 #include <KinectJoint.h>
 #include <math.h>
 
 #include <../LowPassFilter.h>
 
+// KinectJointMap mirrors these without the SDK, keep them in step
+static_assert(NUI_SKELETON_POSITION_HIP_CENTER == KVR::JointMap::V1_HipCenter, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_SPINE == KVR::JointMap::V1_Spine, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_SHOULDER_CENTER == KVR::JointMap::V1_ShoulderCenter, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_HEAD == KVR::JointMap::V1_Head, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_SHOULDER_LEFT == KVR::JointMap::V1_ShoulderLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_ELBOW_LEFT == KVR::JointMap::V1_ElbowLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_WRIST_LEFT == KVR::JointMap::V1_WristLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_HAND_LEFT == KVR::JointMap::V1_HandLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_SHOULDER_RIGHT == KVR::JointMap::V1_ShoulderRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_ELBOW_RIGHT == KVR::JointMap::V1_ElbowRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_WRIST_RIGHT == KVR::JointMap::V1_WristRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_HAND_RIGHT == KVR::JointMap::V1_HandRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_HIP_LEFT == KVR::JointMap::V1_HipLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_KNEE_LEFT == KVR::JointMap::V1_KneeLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_ANKLE_LEFT == KVR::JointMap::V1_AnkleLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_FOOT_LEFT == KVR::JointMap::V1_FootLeft, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_HIP_RIGHT == KVR::JointMap::V1_HipRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_KNEE_RIGHT == KVR::JointMap::V1_KneeRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_ANKLE_RIGHT == KVR::JointMap::V1_AnkleRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_FOOT_RIGHT == KVR::JointMap::V1_FootRight, "v1 joint table out of date");
+static_assert(NUI_SKELETON_POSITION_COUNT == KVR::JointMap::V1_Count, "v1 joint table out of date");
+
 LowPassFilter lowPassFilter[3][4] = {
 	{
 		LowPassFilter(7.1, 0.005),
@@ -45,38 +70,11 @@ LowPassFilter lowPassFilter[3][4] = {
 void KinectV1Handler::initOpenGL()
 {
 	LOG(INFO) << "Attempted to initialise OpenGL";
-	int width = 0, height = 0;
-	if (kVersion == KinectVersion::Version1)
-	{
-		width = KinectSettings::kinectWidth;
-		height = KinectSettings::kinectHeight;
-	}
-	else if (kVersion == KinectVersion::Version2)
-	{
-		width = KinectSettings::kinectV2Width;
-		height = KinectSettings::kinectV2Height;
-	} // REMOVE THIS INTO KINECT V2 IMPL
-	// Initialize textures
-	glGenTextures(1, &kinectTextureId);
-	glBindTexture(GL_TEXTURE_2D, kinectTextureId);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height,
-	             0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, static_cast<GLvoid*>(kinectImageData.get()));
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// OpenGL setup
-	glClearColor(1, 0, 0, 0);
-	glClearDepth(1.0f);
-	glEnable(GL_TEXTURE_2D);
-
-	// Camera setup
-	glViewport(0, 0, SFMLsettings::m_window_width, SFMLsettings::m_window_height);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0, SFMLsettings::m_window_width, SFMLsettings::m_window_height, 0, 1, -1);
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	// Drawn through SFML, so no raw GL state is needed beyond the texture
+	if (!kinectTexture.create(KinectSettings::kinectWidth, KinectSettings::kinectHeight))
+		LOG(ERROR) << "Could not create the Kinect image texture!";
+	kinectTexture.setSmooth(false);
+	kinectSprite.setTexture(kinectTexture, true);
 }
 
 HRESULT KinectV1Handler::getStatusResult()
@@ -112,8 +110,7 @@ void KinectV1Handler::initialise()
 	try
 	{
 		kVersion = KinectVersion::Version1;
-		kinectImageData
-			= std::make_unique<GLubyte[]>(KinectSettings::kinectWidth * KinectSettings::kinectHeight * 4); // BGRA
+		kinectImage.resize(KinectSettings::kinectWidth, KinectSettings::kinectHeight);
 		initialised = initKinect();
 		LOG_IF(initialised, INFO) << "Kinect initialised successfully!";
 		if (!initialised) throw FailedKinectInitialisation;
@@ -154,22 +151,20 @@ void KinectV1Handler::drawKinectData(sf::RenderWindow& drawingWindow)
 
 void KinectV1Handler::drawKinectImageData(sf::RenderWindow& drawingWindow)
 {
-	glBindTexture(GL_TEXTURE_2D, kinectTextureId);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SFMLsettings::m_window_width, SFMLsettings::m_window_height, GL_BGRA_EXT,
-	                GL_UNSIGNED_BYTE, static_cast<GLvoid*>(kinectImageData.get()));
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 0.0f);
-	glVertex3f(0, 0, 0);
-	glTexCoord2f(1.0f, 0.0f);
-	glVertex3f(SFMLsettings::m_window_width, 0, 0);
-	glTexCoord2f(1.0f, 1.0f);
-	glVertex3f(SFMLsettings::m_window_width, SFMLsettings::m_window_height, 0.0f);
-	glTexCoord2f(0.0f, 1.0f);
-	glVertex3f(0, SFMLsettings::m_window_height, 0.0f);
-
-	glEnd();
+	// Upload only when the camera delivered something new since the last draw
+	kinectImage.consume(kinectTextureSequence, [this](const uint8_t* pixels)
+	{
+		kinectTexture.update(pixels);
+	});
+
+	kinectSprite.setScale(
+		static_cast<float>(SFMLsettings::m_window_width) / KinectSettings::kinectWidth,
+		static_cast<float>(SFMLsettings::m_window_height) / KinectSettings::kinectHeight);
+
+	drawingWindow.pushGLStates();
+	drawingWindow.resetGLStates();
+	drawingWindow.draw(kinectSprite);
+	drawingWindow.popGLStates();
 };
 
 NUI_SKELETON_DATA backup;
@@ -278,20 +273,18 @@ bool KinectV1Handler::getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdV
 			}
 
 			{
-				float jointX = jointPositions[convertJoint(device.joint0)].x;
-				float jointY = jointPositions[convertJoint(device.joint0)].y;
-				float jointZ = jointPositions[convertJoint(device.joint0)].z;
-				position = vr::HmdVector3d_t{jointX, jointY, jointZ};
+				const NUI_SKELETON_POSITION_INDEX joint = convertJoint(device.joint0);
+				position = vr::HmdVector3d_t{jointPositions[joint].x, jointPositions[joint].y, jointPositions[joint].z};
 
 				//Rotation - Need to seperate into function
 				Vector4 kRotation = {0, 0, 0, 1};
 				switch (device.rotationFilterOption)
 				{
 				case KVR::JointRotationFilterOption::Unfiltered:
-					kRotation = boneOrientations[convertJoint(device.joint0)].absoluteRotation.rotationQuaternion;
+					kRotation = boneOrientations[joint].absoluteRotation.rotationQuaternion;
 					break;
 				case KVR::JointRotationFilterOption::Filtered:
-					kRotation = rotFilter.GetFilteredJoints()[convertJoint(device.joint0)];
+					kRotation = rotFilter.GetFilteredJoints()[joint];
 					break;
 				case KVR::JointRotationFilterOption::HeadLook:
 					{
@@ -324,80 +317,30 @@ bool KinectV1Handler::getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdV
 	return false;
 }
 
-NUI_SKELETON_POSITION_INDEX KinectV1Handler::convertJoint(KVR::KinectJoint joint)
+bool KinectV1Handler::getBoneDirection(KVR::KinectJointType from, KVR::KinectJointType to,
+                                       vr::HmdVector3d_t& direction)
 {
-	using namespace KVR;
-	//Unfortunately I believe this is required because there are mismatches between v1 and v2 joint IDs
-	//Might consider investigating to see if there's a way to shorten this
-	switch (joint.joint)
+	for (int i = 0; i < NUI_SKELETON_COUNT; ++i)
 	{
-	case KinectJointType::SpineBase:
-		return NUI_SKELETON_POSITION_HIP_CENTER;
-	case KinectJointType::SpineMid:
-		return NUI_SKELETON_POSITION_SPINE;
-
-	case KinectJointType::Head:
-		return NUI_SKELETON_POSITION_HEAD;
-	case KinectJointType::ShoulderLeft:
-		return NUI_SKELETON_POSITION_SHOULDER_LEFT;
-	case KinectJointType::ShoulderRight:
-		return NUI_SKELETON_POSITION_SHOULDER_RIGHT;
-	case KinectJointType::SpineShoulder:
-		return NUI_SKELETON_POSITION_SHOULDER_CENTER;
-
-	case KinectJointType::ElbowLeft:
-		return NUI_SKELETON_POSITION_ELBOW_LEFT;
-	case KinectJointType::WristLeft:
-		return NUI_SKELETON_POSITION_WRIST_LEFT;
-	case KinectJointType::HandLeft:
-		return NUI_SKELETON_POSITION_HAND_LEFT;
-
-	case KinectJointType::ElbowRight:
-		return NUI_SKELETON_POSITION_ELBOW_RIGHT;
-	case KinectJointType::WristRight:
-		return NUI_SKELETON_POSITION_WRIST_RIGHT;
-	case KinectJointType::HandRight:
-		return NUI_SKELETON_POSITION_HAND_RIGHT;
-
-	case KinectJointType::HipLeft:
-		return NUI_SKELETON_POSITION_HIP_LEFT;
-	case KinectJointType::HipRight:
-		return NUI_SKELETON_POSITION_HIP_RIGHT;
-
-	case KinectJointType::KneeLeft:
-		return NUI_SKELETON_POSITION_KNEE_LEFT;
-	case KinectJointType::KneeRight:
-		return NUI_SKELETON_POSITION_KNEE_RIGHT;
-
-	case KinectJointType::AnkleLeft:
-		return NUI_SKELETON_POSITION_ANKLE_LEFT;
-	case KinectJointType::AnkleRight:
-		return NUI_SKELETON_POSITION_ANKLE_RIGHT;
-
-	case KinectJointType::FootLeft:
-		return NUI_SKELETON_POSITION_FOOT_LEFT;
-	case KinectJointType::FootRight:
-		return NUI_SKELETON_POSITION_FOOT_RIGHT;
-
-		/*BELOW DO NOT HAVE A 1:1 V1 REPRESENTATION*/
-		//refer to the skeleton images from Microsoft for diffs between v1 and 2
-
-	case KinectJointType::Neck:
-		return NUI_SKELETON_POSITION_SHOULDER_CENTER;
-	case KinectJointType::HandTipLeft:
-		return NUI_SKELETON_POSITION_HAND_LEFT;
-	case KinectJointType::HandTipRight:
-		return NUI_SKELETON_POSITION_HAND_RIGHT;
-	case KinectJointType::ThumbLeft:
-		return NUI_SKELETON_POSITION_HAND_LEFT;
-	case KinectJointType::ThumbRight:
-		return NUI_SKELETON_POSITION_HAND_RIGHT;
-
-	default:
-		LOG(ERROR) << "INVALID KinectJointType!!!";
-		return NUI_SKELETON_POSITION_WRIST_LEFT;
-		break;
+		const NUI_SKELETON_DATA& data = skeletonFrame.SkeletonData[i];
+		if (data.eTrackingState != NUI_SKELETON_TRACKED)
+			continue;
+
+		const NUI_SKELETON_POSITION_INDEX fromJoint = convertJoint(from);
+		const NUI_SKELETON_POSITION_INDEX toJoint = convertJoint(to);
+		// Inferred joints are guessed from their neighbours, their bones don't point anywhere reliable
+		if (data.eSkeletonPositionTrackingState[fromJoint] != NUI_SKELETON_POSITION_TRACKED
+			|| data.eSkeletonPositionTrackingState[toJoint] != NUI_SKELETON_POSITION_TRACKED)
+			return false;
+
+		direction = vr::HmdVector3d_t{
+			jointPositions[toJoint].x - jointPositions[fromJoint].x,
+			jointPositions[toJoint].y - jointPositions[fromJoint].y,
+			jointPositions[toJoint].z - jointPositions[fromJoint].z
+		};
+		return true;
 	}
+	return false;
 }
 
 bool KinectV1Handler::initKinect()
@@ -454,7 +397,7 @@ void KinectV1Handler::getKinectRGBData()
 		return;
 	}
 	INuiFrameTexture* texture = lockKinectPixelData(imageFrame, LockedRect);
-	copyKinectPixelData(LockedRect, kinectImageData.get());
+	copyKinectPixelData(LockedRect);
 	unlockKinectPixelData(texture);
 
 	releaseKinectFrame(imageFrame, kinectRGBStream, kinectSensor);
@@ -472,19 +415,10 @@ INuiFrameTexture* KinectV1Handler::lockKinectPixelData(NUI_IMAGE_FRAME& imageFra
 	return imageFrame.pFrameTexture;
 }
 
-void KinectV1Handler::copyKinectPixelData(NUI_LOCKED_RECT& LockedRect, GLubyte* dest)
+void KinectV1Handler::copyKinectPixelData(NUI_LOCKED_RECT& LockedRect)
 {
-	int bytesInFrameRow = LockedRect.Pitch;
-	if (bytesInFrameRow != 0)
-	{
-		const BYTE* curr = static_cast<const BYTE*>(LockedRect.pBits);
-		const BYTE* dataEnd = curr + (KinectSettings::kinectWidth * KinectSettings::kinectHeight) * 4;
-
-		while (curr < dataEnd)
-		{
-			*dest++ = *curr++;
-		}
-	}
+	if (LockedRect.Pitch != 0 && LockedRect.pBits)
+		kinectImage.writeBGRX(static_cast<const uint8_t*>(LockedRect.pBits), LockedRect.Pitch);
 }
 
 void KinectV1Handler::unlockKinectPixelData(INuiFrameTexture* texture)
@@ -503,6 +437,9 @@ void KinectV1Handler::updateSkeletalData()
 {
 	if (kinectSensor->NuiSkeletonGetNextFrame(0, &skeletonFrame) >= 0)
 	{
+		KinectSettings::markSkeletonFrame();
+		Latency::ScopedTimer filterTimer(Latency::Stage::SkeletonFilter);
+
 		NUI_TRANSFORM_SMOOTH_PARAMETERS params;
 
 		params.fCorrection = .25f;
@@ -538,148 +475,67 @@ void KinectV1Handler::updateSkeletalData()
 			}
 		}
 
-		KinectSettings::head_position = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::Head)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::Head)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::Head)].z
-		);
-		KinectSettings::left_hand_pose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::HandLeft)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::HandLeft)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::HandLeft)].z
-		);
-		KinectSettings::mHandPose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::HandRight)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::HandRight)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::HandRight)].z
-		);
-		KinectSettings::hElPose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowLeft)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowLeft)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowLeft)].z
-		);
-		KinectSettings::mElPose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowRight)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowRight)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::ElbowRight)].z
-		);
-		KinectSettings::left_foot_raw_pose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].z
-		);
-		KinectSettings::right_foot_raw_pose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].z
-		);
-		KinectSettings::waist_raw_pose = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].z
-		);
-		KinectSettings::left_foot_raw_ori = glm::quat(
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleLeft)].absoluteRotation.rotationQuaternion.w,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleLeft)].absoluteRotation.rotationQuaternion.x,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleLeft)].absoluteRotation.rotationQuaternion.y,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleLeft)].absoluteRotation.rotationQuaternion.z);
-		KinectSettings::right_foot_raw_ori = glm::quat(
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleRight)].absoluteRotation.rotationQuaternion.w,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleRight)].absoluteRotation.rotationQuaternion.x,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleRight)].absoluteRotation.rotationQuaternion.y,
-			boneOrientations[convertJoint(KVR::KinectJointType::AnkleRight)].absoluteRotation.rotationQuaternion.z);
-		KinectSettings::waist_raw_ori = glm::quat(
-			boneOrientations[convertJoint(KVR::KinectJointType::SpineBase)].absoluteRotation.rotationQuaternion.w,
-			boneOrientations[convertJoint(KVR::KinectJointType::SpineBase)].absoluteRotation.rotationQuaternion.x,
-			boneOrientations[convertJoint(KVR::KinectJointType::SpineBase)].absoluteRotation.rotationQuaternion.y,
-			boneOrientations[convertJoint(KVR::KinectJointType::SpineBase)].absoluteRotation.rotationQuaternion.z);
-
-		KinectSettings::lastPose[0][0] = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].z
-		);
-		KinectSettings::lastPose[1][0] = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].z
-		);
-		KinectSettings::lastPose[2][0] = glm::vec3(
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].x,
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].y,
-			jointPositions[convertJoint(KVR::KinectJointType::SpineBase)].z
-		);
+		const Vector4& head = jointPositions[convertJoint(KVR::KinectJointType::Head)];
+		const Vector4& handLeft = jointPositions[convertJoint(KVR::KinectJointType::HandLeft)];
+		const Vector4& handRight = jointPositions[convertJoint(KVR::KinectJointType::HandRight)];
+		const Vector4& elbowLeft = jointPositions[convertJoint(KVR::KinectJointType::ElbowLeft)];
+		const Vector4& elbowRight = jointPositions[convertJoint(KVR::KinectJointType::ElbowRight)];
+		const Vector4& ankleLeft = jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)];
+		const Vector4& ankleRight = jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)];
+		const Vector4& spineBase = jointPositions[convertJoint(KVR::KinectJointType::SpineBase)];
+		const Vector4& ankleLeftRotation = boneOrientations[convertJoint(KVR::KinectJointType::AnkleLeft)].absoluteRotation.rotationQuaternion;
+		const Vector4& ankleRightRotation = boneOrientations[convertJoint(KVR::KinectJointType::AnkleRight)].absoluteRotation.rotationQuaternion;
+		const Vector4& spineBaseRotation = boneOrientations[convertJoint(KVR::KinectJointType::SpineBase)].absoluteRotation.rotationQuaternion;
+
+		KinectSettings::head_position = glm::vec3(head.x, head.y, head.z);
+		KinectSettings::left_hand_pose = glm::vec3(handLeft.x, handLeft.y, handLeft.z);
+		KinectSettings::mHandPose = glm::vec3(handRight.x, handRight.y, handRight.z);
+		KinectSettings::hElPose = glm::vec3(elbowLeft.x, elbowLeft.y, elbowLeft.z);
+		KinectSettings::mElPose = glm::vec3(elbowRight.x, elbowRight.y, elbowRight.z);
+		KinectSettings::left_foot_raw_pose = glm::vec3(ankleLeft.x, ankleLeft.y, ankleLeft.z);
+		KinectSettings::right_foot_raw_pose = glm::vec3(ankleRight.x, ankleRight.y, ankleRight.z);
+		KinectSettings::waist_raw_pose = glm::vec3(spineBase.x, spineBase.y, spineBase.z);
+		KinectSettings::left_foot_raw_ori = glm::quat(ankleLeftRotation.w, ankleLeftRotation.x, ankleLeftRotation.y, ankleLeftRotation.z);
+		KinectSettings::right_foot_raw_ori = glm::quat(ankleRightRotation.w, ankleRightRotation.x, ankleRightRotation.y, ankleRightRotation.z);
+		KinectSettings::waist_raw_ori = glm::quat(spineBaseRotation.w, spineBaseRotation.x, spineBaseRotation.y, spineBaseRotation.z);
+
+		KinectSettings::lastPose[0][0] = glm::vec3(ankleLeft.x, ankleLeft.y, ankleLeft.z);
+		KinectSettings::lastPose[1][0] = glm::vec3(ankleRight.x, ankleRight.y, ankleRight.z);
+		KinectSettings::lastPose[2][0] = glm::vec3(spineBase.x, spineBase.y, spineBase.z);
 
 		/***********************************************************************************************/
 		glm::quat hFootRotF, mFootRotF;
 
-		//calculate direction vectors
-		glm::vec3 up(0, 1, 0),
-		          ankleLeftPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleLeft)].z),
-
-		          ankleRightPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::AnkleRight)].z),
-
-		          footLeftPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::FootLeft)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::FootLeft)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::FootLeft)].z),
-
-		          footRightPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::FootRight)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::FootRight)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::FootRight)].z),
-
-		          kneeLeftPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeLeft)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeLeft)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeLeft)].z),
-
-		          kneeRightPose(
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeRight)].x,
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeRight)].y,
-			          jointPositions[convertJoint(KVR::KinectJointType::KneeRight)].z);
-
-		glm::vec3 feetRot[2] = {
-			eulerAngles(glm::quat(lookAt(footLeftPose, ankleLeftPose, up))),
-			eulerAngles(glm::quat(lookAt(footRightPose, ankleRightPose, up)))
-		};
+		//calculate direction vectors along the leg bones, all six look rotations in one batch:
+		//the feet, the shins seen from the front (z) and the shins seen from the side (x), left then right
+		KMath::Quat::Vector3Array<6> eyes, centers, lookAngles;
+		for (int side = 0; side < 2; ++side)
+		{
+			const KVR::JointBone footBone = KVR::JointMap::sdkBone(KVR::JointMap::k_toV1, KVR::JointMap::k_legBones[side].foot);
+			const KVR::JointBone shinBone = KVR::JointMap::sdkBone(KVR::JointMap::k_toV1, KVR::JointMap::k_legBones[side].shin);
+			const Vector4& foot = jointPositions[footBone.to];
+			const Vector4& ankle = jointPositions[footBone.from];
+			const Vector4& knee = jointPositions[shinBone.from];
+			eyes.set(side, foot.x, foot.y, foot.z);
+			centers.set(side, ankle.x, ankle.y, ankle.z);
+			eyes.set(2 + side, ankle.x, ankle.y, 1);
+			centers.set(2 + side, knee.x, knee.y, 0);
+			eyes.set(4 + side, 1, ankle.y, ankle.z);
+			centers.set(4 + side, 0, knee.y, knee.z);
+		}
 
-		glm::vec3 tibiaRotZ[2] = {
-			eulerAngles(glm::quat(lookAt(
-				glm::vec3(ankleLeftPose.x, ankleLeftPose.y, 1),
-				glm::vec3(kneeLeftPose.x, kneeLeftPose.y, 0), up))),
-			eulerAngles(glm::quat(lookAt(
-				glm::vec3(ankleRightPose.x, ankleRightPose.y, 1),
-				glm::vec3(kneeRightPose.x, kneeRightPose.y, 0), up)))
-		};
-
-		glm::vec3 tibiaRotX[2] = {
-			eulerAngles(glm::quat(lookAt(
-				glm::vec3(1, ankleLeftPose.y, ankleLeftPose.z),
-				glm::vec3(0, kneeLeftPose.y, kneeLeftPose.z), up))),
-			eulerAngles(glm::quat(lookAt(
-				glm::vec3(1, ankleRightPose.y, ankleRightPose.z),
-				glm::vec3(0, kneeRightPose.y, kneeRightPose.z), up)))
-		};
+		// Same as eulerAngles(glm::quat(lookAt(eye, center, up))) for each of them
+		KMath::Quat::lookAtEulerAngles(eyes, centers, 0, 1, 0, lookAngles);
 
 		hFootRotF = glm::vec3(
-			-tibiaRotX[0].x - M_PI / 3,
-			-feetRot[0].y + /*2 */ KinectSettings::calibration_trackers_yaw / 180 * M_PI,
-			-tibiaRotZ[0].z * 15 + M_PI);
+			-lookAngles.x[4] - M_PI / 3,
+			-lookAngles.y[0] + /*2 */ KinectSettings::calibration_trackers_yaw / 180 * M_PI,
+			-lookAngles.z[2] * 15 + M_PI);
 
 		mFootRotF = glm::vec3(
-			-tibiaRotX[1].x - M_PI / 3,
-			-feetRot[1].y + /*2 */ KinectSettings::calibration_trackers_yaw / 180 * M_PI,
-			-tibiaRotZ[1].z * 15 + M_PI);
-
-		normalize(hFootRotF);
-		normalize(mFootRotF);
+			-lookAngles.x[5] - M_PI / 3,
+			-lookAngles.y[1] + /*2 */ KinectSettings::calibration_trackers_yaw / 180 * M_PI,
+			-lookAngles.z[3] * 15 + M_PI);
 		
 		////smooth with lowpass filter
 		/*hFootRotF.w = lowPassFilter[0][0].update(hFootRotF.w);
@@ -718,61 +574,27 @@ void KinectV1Handler::updateSkeletalData()
 
 void KinectV1Handler::DrawSkeleton(const NUI_SKELETON_DATA& skel, sf::RenderWindow& window)
 {
+	SkeletonOverlay::JointState states[NUI_SKELETON_POSITION_COUNT];
 	for (int i = 0; i < NUI_SKELETON_POSITION_COUNT; ++i)
 	{
 		screenSkelePoints[i] = SkeletonToScreen(jointPositions[i], SFMLsettings::m_window_width,
 		                                        SFMLsettings::m_window_height);
-		//std::cerr << "m_points[" << i << "] = " << screenSkelePoints[i].x << ", " << screenSkelePoints[i].y << '\n';
-		// Same with the other cerr, without this, the skeleton flickers
+		states[i] = skel.eSkeletonPositionTrackingState[i] == NUI_SKELETON_POSITION_TRACKED
+			            ? SkeletonOverlay::JointState::Tracked
+			            : skel.eSkeletonPositionTrackingState[i] == NUI_SKELETON_POSITION_INFERRED
+			            ? SkeletonOverlay::JointState::Inferred
+			            : SkeletonOverlay::JointState::NotTracked;
 	}
-	// Render Torso
-	window.clear();
-	DrawBone(skel, NUI_SKELETON_POSITION_HEAD, NUI_SKELETON_POSITION_SHOULDER_CENTER, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SHOULDER_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SHOULDER_RIGHT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SPINE, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_SPINE, NUI_SKELETON_POSITION_HIP_CENTER, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_HIP_CENTER, NUI_SKELETON_POSITION_HIP_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_HIP_CENTER, NUI_SKELETON_POSITION_HIP_RIGHT, window);
-
-	// Left Arm
-	DrawBone(skel, NUI_SKELETON_POSITION_SHOULDER_LEFT, NUI_SKELETON_POSITION_ELBOW_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_ELBOW_LEFT, NUI_SKELETON_POSITION_WRIST_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_WRIST_LEFT, NUI_SKELETON_POSITION_HAND_LEFT, window);
-
-	// Right Arm
-	DrawBone(skel, NUI_SKELETON_POSITION_SHOULDER_RIGHT, NUI_SKELETON_POSITION_ELBOW_RIGHT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_ELBOW_RIGHT, NUI_SKELETON_POSITION_WRIST_RIGHT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_WRIST_RIGHT, NUI_SKELETON_POSITION_HAND_RIGHT, window);
-
-	// Left Leg
-	DrawBone(skel, NUI_SKELETON_POSITION_HIP_LEFT, NUI_SKELETON_POSITION_KNEE_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_KNEE_LEFT, NUI_SKELETON_POSITION_ANKLE_LEFT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_ANKLE_LEFT, NUI_SKELETON_POSITION_FOOT_LEFT, window);
-
-	// Right Leg
-	DrawBone(skel, NUI_SKELETON_POSITION_HIP_RIGHT, NUI_SKELETON_POSITION_KNEE_RIGHT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_KNEE_RIGHT, NUI_SKELETON_POSITION_ANKLE_RIGHT, window);
-	DrawBone(skel, NUI_SKELETON_POSITION_ANKLE_RIGHT, NUI_SKELETON_POSITION_FOOT_RIGHT, window);
-
-	// Draw the joints in a different color
-	for (int i = 0; i < NUI_SKELETON_POSITION_COUNT; ++i)
-	{
-		sf::CircleShape circle{};
-		circle.setRadius(KinectSettings::g_JointThickness);
-		circle.setPosition(screenSkelePoints[i]);
 
-		if (skel.eSkeletonPositionTrackingState[i] == NUI_SKELETON_POSITION_INFERRED)
-		{
-			circle.setFillColor(sf::Color::Red);
-			window.draw(circle);
-		}
-		else if (skel.eSkeletonPositionTrackingState[i] == NUI_SKELETON_POSITION_TRACKED)
-		{
-			circle.setFillColor(sf::Color::Yellow);
-			window.draw(circle);
-		}
-	}
+	SkeletonOverlay::Style style;
+	style.trackedBoneThickness = KinectSettings::g_TrackedBoneThickness;
+	style.inferredBoneThickness = KinectSettings::g_InferredBoneThickness;
+	style.jointRadius = KinectSettings::g_JointThickness;
+
+	window.clear();
+	skeletonOverlay.update(KVR::JointMap::k_v1Bones.data(), KVR::JointMap::k_v1Bones.size(), screenSkelePoints, states,
+	                       NUI_SKELETON_POSITION_COUNT, style);
+	window.draw(skeletonOverlay);
 }
 
 sf::Vector2f KinectV1Handler::SkeletonToScreen(Vector4 skeletonPoint, int _width, int _height)
@@ -792,46 +614,6 @@ sf::Vector2f KinectV1Handler::SkeletonToScreen(Vector4 skeletonPoint, int _width
 	return sf::Vector2f(screenPointX, screenPointY);
 }
 
-void KinectV1Handler::DrawBone(const NUI_SKELETON_DATA& skel, NUI_SKELETON_POSITION_INDEX joint0,
-                               NUI_SKELETON_POSITION_INDEX joint1, sf::RenderWindow& window)
-{
-	NUI_SKELETON_POSITION_TRACKING_STATE joint0State = skel.eSkeletonPositionTrackingState[joint0];
-	NUI_SKELETON_POSITION_TRACKING_STATE joint1State = skel.eSkeletonPositionTrackingState[joint1];
-
-	// If we can't find either of these joints, exit
-	if (joint0State == NUI_SKELETON_POSITION_NOT_TRACKED || joint1State == NUI_SKELETON_POSITION_NOT_TRACKED)
-	{
-		return;
-	}
-
-	// Don't draw if both points are inferred
-	if (joint0State == NUI_SKELETON_POSITION_INFERRED && joint1State == NUI_SKELETON_POSITION_INFERRED)
-	{
-		return;
-	}
-	// Assume all bones are inferred unless BOTH joints are tracked
-	if (joint0State == NUI_SKELETON_POSITION_TRACKED && joint1State == NUI_SKELETON_POSITION_TRACKED)
-	{
-		DrawLine(screenSkelePoints[joint0], screenSkelePoints[joint1], sf::Color::Green,
-		         KinectSettings::g_TrackedBoneThickness, window);
-	}
-	else
-	{
-		DrawLine(screenSkelePoints[joint0], screenSkelePoints[joint1], sf::Color::Red,
-		         KinectSettings::g_InferredBoneThickness, window);
-	}
-}
-
-void KinectV1Handler::DrawLine(sf::Vector2f start, sf::Vector2f end, sf::Color colour, float lineThickness,
-                               sf::RenderWindow& window)
-{
-	sfLine line(start, end);
-	line.setColor(colour);
-	line.setThickness(lineThickness);
-	window.draw(line);
-	//std::cerr << "Line drawn at: " << start.x << ", " << start.y << " to " << end.x << ", " << end.y << "\n";
-}
-
 Vector4 KinectV1Handler::zeroKinectPosition(int trackedSkeletonIndex)
 {
 	return jointPositions[NUI_SKELETON_POSITION_HEAD];
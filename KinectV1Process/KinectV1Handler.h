@@ -3,6 +3,10 @@
 #include "KinectV1Includes.h"
 #include "KinectHandlerBase.h"
 #include "KinectOrientationFilter.h"
+#include <KinectImageStaging.h>
+#include <SkeletonOverlay.h>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
 
 class KinectV1Handler : public KinectHandlerBase
 {
@@ -18,13 +22,17 @@ public:
 	HANDLE kinectDepthStream = nullptr;
 	INuiSensor* kinectSensor = nullptr;
 	RotationalSmoothingFilter rotFilter;
-	GLuint kinectTextureId; // ID of the texture to contain Kinect RGB Data
+	KinectImageStaging kinectImage; // Latest RGB frame, converted to RGBA
+	sf::Texture kinectTexture;
+	sf::Sprite kinectSprite;
+	uint64_t kinectTextureSequence = 0; // Last frame uploaded to kinectTexture
 	NUI_SKELETON_FRAME skeletonFrame = {0};
 
 	Vector4 jointPositions[NUI_SKELETON_POSITION_COUNT];
 	NUI_SKELETON_BONE_ORIENTATION boneOrientations[NUI_SKELETON_POSITION_COUNT];
 
 	sf::Vector2f screenSkelePoints[NUI_SKELETON_POSITION_COUNT];
+	SkeletonOverlay::Renderer skeletonOverlay; // Bones and joints, one draw call
 
 	void initialise() override;
 	void initOpenGL() override;
@@ -53,24 +61,26 @@ public:
 
 	bool getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdVector3d_t& position,
 	                      vr::HmdQuaternion_t& rotation) override;
-	NUI_SKELETON_POSITION_INDEX convertJoint(KVR::KinectJoint joint);
+	bool getBoneDirection(KVR::KinectJointType from, KVR::KinectJointType to,
+	                      vr::HmdVector3d_t& direction) override;
+	// Plain table load, see KinectJointMap.h
+	static NUI_SKELETON_POSITION_INDEX convertJoint(KVR::KinectJoint joint)
+	{
+		return static_cast<NUI_SKELETON_POSITION_INDEX>(KVR::JointMap::toV1(joint.joint));
+	}
 	
 private:
 	bool initKinect();
 	void getKinectRGBData();
 	bool acquireKinectFrame(NUI_IMAGE_FRAME& imageFrame, HANDLE& rgbStream, INuiSensor* & sensor);
 	INuiFrameTexture* lockKinectPixelData(NUI_IMAGE_FRAME& imageFrame, NUI_LOCKED_RECT& LockedRect);
-	void copyKinectPixelData(NUI_LOCKED_RECT& LockedRect, GLubyte* dest);
+	void copyKinectPixelData(NUI_LOCKED_RECT& LockedRect);
 	void unlockKinectPixelData(INuiFrameTexture* texture);
 	void releaseKinectFrame(NUI_IMAGE_FRAME& imageFrame, HANDLE& rgbStream, INuiSensor* & sensor);
 
 	void updateSkeletalData();
 	void DrawSkeleton(const NUI_SKELETON_DATA& skel, sf::RenderWindow& window);
 	sf::Vector2f SkeletonToScreen(Vector4 skeletonPoint, int _width, int _height);
-	void DrawBone(const NUI_SKELETON_DATA& skel, NUI_SKELETON_POSITION_INDEX joint0,
-	              NUI_SKELETON_POSITION_INDEX joint1, sf::RenderWindow& window);
-	void DrawLine(sf::Vector2f start, sf::Vector2f end, sf::Color colour, float lineThickness,
-	              sf::RenderWindow& window);
 	Vector4 zeroKinectPosition(int trackedSkeletonIndex);
 	void setKinectToVRMultiplier(int skeletonIndex);
 
@@ -4,6 +4,7 @@
 #include "stdafx.h"
 #include "KinectV1Handler.h"
 #include <KinectToVR.h>
+#include <ProcessSupervisor.h>
 #include <openvr.h>
 #include <Windows.h>
 
@@ -36,11 +37,8 @@ void init_logging()
 
 int main(int argc, char* argv[])
 {
-	// Set up the 'crash handler'
-	std::thread([] {
-		auto _pid = GetCurrentProcessId();
-		system(std::string("KV1CrashHandler.exe " + std::to_string(_pid)).c_str());
-		}).detach();
+	// Set up the crash handler, or pick up its state if it restarted us
+	Supervision::attach("KV1CrashHandler.exe", argc, argv);
 
 	START_EASYLOGGINGPP(argc, argv);
 	init_logging();
@@ -1,9 +1,11 @@
 #pragma once
 #include "stdafx.h"
 #include "KinectV2Handler.h"
-#include <sfLine.h>
+#include <SkeletonOverlay.h>
 #include <iostream>
 #include <VRHelper.h>
+#include <LatencyStats.h>
+#include <StartupReadiness.h>
 #include "KinectJointFilter.h"
 #include <Eigen/Geometry>
 #include <ppl.h>
@@ -23,6 +25,34 @@
 #include <chrono>
 #include <../LowPassFilter.h>
 
+// KinectJointMap mirrors these without the SDK, keep them in step
+static_assert(JointType_SpineBase == static_cast<int>(KVR::KinectJointType::SpineBase), "v2 joint table out of date");
+static_assert(JointType_SpineMid == static_cast<int>(KVR::KinectJointType::SpineMid), "v2 joint table out of date");
+static_assert(JointType_Neck == static_cast<int>(KVR::KinectJointType::Neck), "v2 joint table out of date");
+static_assert(JointType_Head == static_cast<int>(KVR::KinectJointType::Head), "v2 joint table out of date");
+static_assert(JointType_ShoulderLeft == static_cast<int>(KVR::KinectJointType::ShoulderLeft), "v2 joint table out of date");
+static_assert(JointType_ElbowLeft == static_cast<int>(KVR::KinectJointType::ElbowLeft), "v2 joint table out of date");
+static_assert(JointType_WristLeft == static_cast<int>(KVR::KinectJointType::WristLeft), "v2 joint table out of date");
+static_assert(JointType_HandLeft == static_cast<int>(KVR::KinectJointType::HandLeft), "v2 joint table out of date");
+static_assert(JointType_ShoulderRight == static_cast<int>(KVR::KinectJointType::ShoulderRight), "v2 joint table out of date");
+static_assert(JointType_ElbowRight == static_cast<int>(KVR::KinectJointType::ElbowRight), "v2 joint table out of date");
+static_assert(JointType_WristRight == static_cast<int>(KVR::KinectJointType::WristRight), "v2 joint table out of date");
+static_assert(JointType_HandRight == static_cast<int>(KVR::KinectJointType::HandRight), "v2 joint table out of date");
+static_assert(JointType_HipLeft == static_cast<int>(KVR::KinectJointType::HipLeft), "v2 joint table out of date");
+static_assert(JointType_KneeLeft == static_cast<int>(KVR::KinectJointType::KneeLeft), "v2 joint table out of date");
+static_assert(JointType_AnkleLeft == static_cast<int>(KVR::KinectJointType::AnkleLeft), "v2 joint table out of date");
+static_assert(JointType_FootLeft == static_cast<int>(KVR::KinectJointType::FootLeft), "v2 joint table out of date");
+static_assert(JointType_HipRight == static_cast<int>(KVR::KinectJointType::HipRight), "v2 joint table out of date");
+static_assert(JointType_KneeRight == static_cast<int>(KVR::KinectJointType::KneeRight), "v2 joint table out of date");
+static_assert(JointType_AnkleRight == static_cast<int>(KVR::KinectJointType::AnkleRight), "v2 joint table out of date");
+static_assert(JointType_FootRight == static_cast<int>(KVR::KinectJointType::FootRight), "v2 joint table out of date");
+static_assert(JointType_SpineShoulder == static_cast<int>(KVR::KinectJointType::SpineShoulder), "v2 joint table out of date");
+static_assert(JointType_HandTipLeft == static_cast<int>(KVR::KinectJointType::HandTipLeft), "v2 joint table out of date");
+static_assert(JointType_ThumbLeft == static_cast<int>(KVR::KinectJointType::ThumbLeft), "v2 joint table out of date");
+static_assert(JointType_HandTipRight == static_cast<int>(KVR::KinectJointType::HandTipRight), "v2 joint table out of date");
+static_assert(JointType_ThumbRight == static_cast<int>(KVR::KinectJointType::ThumbRight), "v2 joint table out of date");
+static_assert(JointType_Count == KVR::KinectJointCount, "v2 joint table out of date");
+
 LowPassFilter lowPassFilter[3][4] = {
 	{LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005)},
 	{LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005), LowPassFilter(7.1, 0.005)},
@@ -487,6 +517,7 @@ void KinectV2Handler::updateSkeletalData()
 		//if (frameRef) frameRef->Release();
 		//if (bodyFrameReader) bodyFrameReader->Release();
 		if (!bodyFrame) return;
+		KinectSettings::markSkeletonFrame();
 
 		bodyFrame->GetAndRefreshBodyData(BODY_COUNT, kinectBodies);
 		newBodyFrameArrived = true;
@@ -510,8 +541,9 @@ void KinectV2Handler::updateSkeletalFilters()
 			kinectBodies[i]->GetJointOrientations(JointType_Count, jointOrientations);
 
 			//Smooth
+			Latency::ScopedTimer filterTimer(Latency::Stage::SkeletonFilter);
 			filter.update(joints, newBodyFrameArrived);
-			rotationFilter.UpdateFilter(kinectBodies[i], jointOrientations);
+			rotationFilter.UpdateFilter(joints, jointOrientations);
 
 			newBodyFrameArrived = false;
 
@@ -590,60 +622,26 @@ void KinectV2Handler::updateSkeletalFilters()
 	/***********************************************************************************************/
 	glm::quat hFootRotF, mFootRotF;
 
-	//calculate direction vectors
-	glm::vec3 up(0, 1, 0),
-		ankleLeftPose(
-			joints[JointType_AnkleLeft].Position.X,
-			joints[JointType_AnkleLeft].Position.Y,
-			joints[JointType_AnkleLeft].Position.Z),
-
-		ankleRightPose(
-			joints[JointType_AnkleRight].Position.X,
-			joints[JointType_AnkleRight].Position.Y,
-			joints[JointType_AnkleRight].Position.Z),
-
-		footLeftPose(
-			joints[JointType_FootLeft].Position.X,
-			joints[JointType_FootLeft].Position.Y,
-			joints[JointType_FootLeft].Position.Z),
-
-		footRightPose(
-			joints[JointType_FootRight].Position.X,
-			joints[JointType_FootRight].Position.Y,
-			joints[JointType_FootRight].Position.Z),
-
-		kneeLeftPose(
-			joints[JointType_KneeLeft].Position.X,
-			joints[JointType_KneeLeft].Position.Y,
-			joints[JointType_KneeLeft].Position.Z),
-
-		kneeRightPose(
-			joints[JointType_KneeRight].Position.X,
-			joints[JointType_KneeRight].Position.Y,
-			joints[JointType_KneeRight].Position.Z);
-
-	glm::vec3 feetRot[2] = {
-		eulerAngles(glm::quat(lookAt(footLeftPose, ankleLeftPose, up))),
-		eulerAngles(glm::quat(lookAt(footRightPose, ankleRightPose, up)))
-	};
-
-	glm::vec3 tibiaRotZ[2] = {
-		eulerAngles(glm::quat(lookAt(
-			glm::vec3(ankleLeftPose.x, ankleLeftPose.y, 1),
-			glm::vec3(kneeLeftPose.x, kneeLeftPose.y, 0), up))),
-		eulerAngles(glm::quat(lookAt(
-			glm::vec3(ankleRightPose.x, ankleRightPose.y, 1),
-			glm::vec3(kneeRightPose.x, kneeRightPose.y, 0), up)))
-	};
-
-	glm::vec3 tibiaRotX[2] = {
-		eulerAngles(glm::quat(lookAt(
-			glm::vec3(1, ankleLeftPose.y, ankleLeftPose.z),
-			glm::vec3(0, kneeLeftPose.y, kneeLeftPose.z), up))),
-		eulerAngles(glm::quat(lookAt(
-			glm::vec3(1, ankleRightPose.y, ankleRightPose.z),
-			glm::vec3(0, kneeRightPose.y, kneeRightPose.z), up)))
-	};
+	//calculate direction vectors along the leg bones, left then right
+	glm::vec3 up(0, 1, 0), feetRot[2], tibiaRotZ[2], tibiaRotX[2];
+	for (int side = 0; side < 2; ++side)
+	{
+		const KVR::JointBone footBone = KVR::JointMap::sdkBone(KVR::JointMap::k_toV2, KVR::JointMap::k_legBones[side].foot);
+		const KVR::JointBone shinBone = KVR::JointMap::sdkBone(KVR::JointMap::k_toV2, KVR::JointMap::k_legBones[side].shin);
+		const CameraSpacePoint& foot = joints[footBone.to].Position;
+		const CameraSpacePoint& ankle = joints[footBone.from].Position;
+		const CameraSpacePoint& knee = joints[shinBone.from].Position;
+
+		feetRot[side] = eulerAngles(glm::quat(lookAt(
+			glm::vec3(foot.X, foot.Y, foot.Z),
+			glm::vec3(ankle.X, ankle.Y, ankle.Z), up)));
+		tibiaRotZ[side] = eulerAngles(glm::quat(lookAt(
+			glm::vec3(ankle.X, ankle.Y, 1),
+			glm::vec3(knee.X, knee.Y, 0), up)));
+		tibiaRotX[side] = eulerAngles(glm::quat(lookAt(
+			glm::vec3(1, ankle.Y, ankle.Z),
+			glm::vec3(0, knee.Y, knee.Z), up)));
+	}
 
 	hFootRotF = glm::vec3(
 		-tibiaRotX[0].x - M_PI / 3,
@@ -845,7 +843,8 @@ void KinectV2Handler::updateTrackersWithColorPosition(std::vector<KVR::KinectTra
 bool KinectV2Handler::getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdVector3d_t& position,
                                        vr::HmdQuaternion_t& rotation)
 {
-	sf::Vector3f filteredPos = filter.GetFilteredJoints()[convertJoint(device.joint0)];
+	const JointType joint = convertJoint(device.joint0);
+	sf::Vector3f filteredPos = filter.GetFilteredJoints()[joint];
 	float jointX = filteredPos.x;
 	float jointY = filteredPos.y;
 	float jointZ = filteredPos.z;
@@ -856,10 +855,10 @@ bool KinectV2Handler::getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdV
 	switch (device.rotationFilterOption)
 	{
 	case KVR::JointRotationFilterOption::Unfiltered:
-		kRotation = jointOrientations[convertJoint(device.joint0)].Orientation;
+		kRotation = jointOrientations[joint].Orientation;
 		break;
 	case KVR::JointRotationFilterOption::Filtered:
-		kRotation = rotationFilter.GetFilteredJoints()[convertJoint(device.joint0)];
+		kRotation = rotationFilter.GetFilteredJoints()[joint];
 		break;
 	case KVR::JointRotationFilterOption::HeadLook:
 		{
@@ -887,6 +886,22 @@ bool KinectV2Handler::getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdV
 	return true;
 }
 
+bool KinectV2Handler::getBoneDirection(KVR::KinectJointType from, KVR::KinectJointType to,
+                                       vr::HmdVector3d_t& direction)
+{
+	const JointType fromJoint = convertJoint(from);
+	const JointType toJoint = convertJoint(to);
+	// Inferred joints are guessed from their neighbours, their bones don't point anywhere reliable
+	if (joints[fromJoint].TrackingState != TrackingState_Tracked
+		|| joints[toJoint].TrackingState != TrackingState_Tracked)
+		return false;
+
+	const sf::Vector3f fromPos = filter.GetFilteredJoints()[fromJoint];
+	const sf::Vector3f toPos = filter.GetFilteredJoints()[toJoint];
+	direction = vr::HmdVector3d_t{toPos.x - fromPos.x, toPos.y - fromPos.y, toPos.z - fromPos.z};
+	return true;
+}
+
 bool KinectV2Handler::initKinect()
 {
 	if (FAILED(GetDefaultKinectSensor(&kinectSensor)))
@@ -903,11 +918,22 @@ bool KinectV2Handler::initKinect()
 		//    | FrameSourceTypes::FrameSourceTypes_Color,
 		//   &frameReader);
 		//return frameReader;
-		std::this_thread::sleep_for(std::chrono::seconds(2));
-		// Necessary to allow kinect to become available behind the scenes
 
+		// The kinect becomes available behind the scenes, wait for it to say so
 		BOOLEAN available = false;
-		kinectSensor->get_IsAvailable(&available);
+		WAITABLE_HANDLE availableChanged = 0;
+		if (SUCCEEDED(hr_open) && SUCCEEDED(kinectSensor->SubscribeIsAvailableChanged(&availableChanged)))
+		{
+			Readiness::waitForHandle(reinterpret_cast<HANDLE>(availableChanged), [this, &available, availableChanged]
+			{
+				IIsAvailableChangedEventArgs* args = nullptr;
+				if (SUCCEEDED(kinectSensor->GetIsAvailableChangedEventData(availableChanged, &args)) && args)
+					args->Release();
+				kinectSensor->get_IsAvailable(&available);
+				return available != FALSE;
+			}, std::chrono::seconds(5));
+			kinectSensor->UnsubscribeIsAvailableChanged(availableChanged);
+		}
 
 		if (FAILED(hr_open) || !available)
 		{
@@ -928,104 +954,26 @@ void KinectV2Handler::updateKinectData()
 
 void KinectV2Handler::drawBody(const Joint* pJoints, const sf::Vector2f* pJointPoints, sf::RenderWindow& window)
 {
-	// Draw the bones
 	window.clear();
 
-	// Torso
-	drawBone(pJoints, pJointPoints, JointType_Head, JointType_Neck, window);
-	drawBone(pJoints, pJointPoints, JointType_Neck, JointType_SpineShoulder, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineShoulder, JointType_SpineMid, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineMid, JointType_SpineBase, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineShoulder, JointType_ShoulderRight, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineShoulder, JointType_ShoulderLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineBase, JointType_HipRight, window);
-	drawBone(pJoints, pJointPoints, JointType_SpineBase, JointType_HipLeft, window);
-
-	// Right Arm
-	drawBone(pJoints, pJointPoints, JointType_ShoulderRight, JointType_ElbowRight, window);
-	drawBone(pJoints, pJointPoints, JointType_ElbowRight, JointType_WristRight, window);
-	drawBone(pJoints, pJointPoints, JointType_WristRight, JointType_HandRight, window);
-	drawBone(pJoints, pJointPoints, JointType_HandRight, JointType_HandTipRight, window);
-	drawBone(pJoints, pJointPoints, JointType_WristRight, JointType_ThumbRight, window);
-
-	// Left Arm
-	drawBone(pJoints, pJointPoints, JointType_ShoulderLeft, JointType_ElbowLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_ElbowLeft, JointType_WristLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_WristLeft, JointType_HandLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_HandLeft, JointType_HandTipLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_WristLeft, JointType_ThumbLeft, window);
-
-	// Right Leg
-	drawBone(pJoints, pJointPoints, JointType_HipRight, JointType_KneeRight, window);
-	drawBone(pJoints, pJointPoints, JointType_KneeRight, JointType_AnkleRight, window);
-	drawBone(pJoints, pJointPoints, JointType_AnkleRight, JointType_FootRight, window);
-	// Left Leg
-	drawBone(pJoints, pJointPoints, JointType_HipLeft, JointType_KneeLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_KneeLeft, JointType_AnkleLeft, window);
-	drawBone(pJoints, pJointPoints, JointType_AnkleLeft, JointType_FootLeft, window);
-
-	// Draw the joints
+	SkeletonOverlay::JointState states[JointType_Count];
 	for (int i = 0; i < JointType_Count; ++i)
 	{
-		sf::CircleShape circle{};
-		circle.setRadius(KinectSettings::g_JointThickness);
-		circle.setPosition(pJointPoints[i]);
-
-		if (pJoints[i].TrackingState == TrackingState_Inferred)
-		{
-			circle.setFillColor(sf::Color::Red);
-			window.draw(circle);
-		}
-		else if (pJoints[i].TrackingState == TrackingState_Tracked)
-		{
-			circle.setFillColor(sf::Color::Yellow);
-			window.draw(circle);
-		}
+		states[i] = pJoints[i].TrackingState == TrackingState_Tracked
+			            ? SkeletonOverlay::JointState::Tracked
+			            : pJoints[i].TrackingState == TrackingState_Inferred
+			            ? SkeletonOverlay::JointState::Inferred
+			            : SkeletonOverlay::JointState::NotTracked;
 	}
-}
 
-void KinectV2Handler::drawBone(const Joint* pJoints, const sf::Vector2f* pJointPoints, JointType joint0,
-                               JointType joint1, sf::RenderWindow& window)
-{
-	TrackingState joint0State = pJoints[joint0].TrackingState;
-	TrackingState joint1State = pJoints[joint1].TrackingState;
-
-	// If we can't find either of these joints, exit
-	if ((joint0State == TrackingState_NotTracked) || (joint1State == TrackingState_NotTracked))
-	{
-		return;
-	}
-
-	// Don't draw if both points are inferred
-	if ((joint0State == TrackingState_Inferred) && (joint1State == TrackingState_Inferred))
-	{
-		return;
-	}
-
-	// We assume all drawn bones are inferred unless BOTH joints are tracked
-	if ((joint0State == TrackingState_Tracked) && (joint1State == TrackingState_Tracked))
-	{
-		drawLine(pJointPoints[joint0], pJointPoints[joint1], sf::Color::Green, KinectSettings::g_TrackedBoneThickness,
-		         window);
-	}
-	else
-	{
-		drawLine(pJointPoints[joint0], pJointPoints[joint1], sf::Color::Green, KinectSettings::g_TrackedBoneThickness,
-		         window);
-	}
-}
+	// V2 has always drawn inferred bones like tracked ones
+	SkeletonOverlay::Style style;
+	style.trackedBoneThickness = KinectSettings::g_TrackedBoneThickness;
+	style.inferredBoneThickness = KinectSettings::g_TrackedBoneThickness;
+	style.inferredBone = sf::Color::Green;
+	style.jointRadius = KinectSettings::g_JointThickness;
 
-void KinectV2Handler::drawLine(sf::Vector2f start, sf::Vector2f end, sf::Color colour, float lineThickness,
-                               sf::RenderWindow& window)
-{
-	sfLine line(start, end);
-	line.setColor(colour);
-	line.setThickness(lineThickness);
-	window.draw(line);
-}
-
-JointType KinectV2Handler::convertJoint(KVR::KinectJoint kJoint)
-{
-	// Currently, the v2 SDK id's match my jointtype class 1:1
-	return static_cast<JointType>(kJoint.joint);
+	skeletonOverlay.update(KVR::JointMap::k_v2Bones.data(), KVR::JointMap::k_v2Bones.size(), pJointPoints, states,
+	                       JointType_Count, style);
+	window.draw(skeletonOverlay);
 }
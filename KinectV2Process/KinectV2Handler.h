@@ -4,6 +4,7 @@
 #include <KinectHandlerBase.h>
 #include "KinectJointFilter.h"
 #include "KinectDoubleExponentialRotationFilter.h"
+#include <SkeletonOverlay.h>
 
 #include <opencv2/opencv.hpp>
 // Kinect V2 - directory local due to my win 7 machine being unsupported for actual install
@@ -67,6 +68,8 @@ public:
 
 	bool getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdVector3d_t& position,
 	                      vr::HmdQuaternion_t& rotation) override;
+	bool getBoneDirection(KVR::KinectJointType from, KVR::KinectJointType to,
+	                      vr::HmdVector3d_t& direction) override;
 
 
 	bool convertColorToDepthResolution = false;
@@ -96,7 +99,11 @@ public:
 	void zeroAllTracking(vr::IVRSystem* & m_sys) override;
 	void updateTrackersWithSkeletonPosition(std::vector<KVR::KinectTrackedDevice>& trackers) override;
 	void updateTrackersWithColorPosition(std::vector<KVR::KinectTrackedDevice> trackers, sf::Vector2i pos) override;
-	JointType convertJoint(KVR::KinectJoint joint);
+	// Plain table load, see KinectJointMap.h
+	static JointType convertJoint(KVR::KinectJoint joint)
+	{
+		return static_cast<JointType>(KVR::JointMap::toV2(joint.joint));
+	}
 private:
 	bool initKinect();
 	void updateKinectData();
@@ -123,10 +130,7 @@ private:
 
 	void drawBody(const Joint* pJoints, const sf::Vector2f* pJointPoints, sf::RenderWindow& window);
 	void drawHand(HandState handState, const sf::Vector2f& handPosition, sf::RenderWindow& win);
-	void drawBone(const Joint* pJoints, const sf::Vector2f* pJointPoints, JointType joint0, JointType joint1,
-	              sf::RenderWindow& window);
-	void drawLine(sf::Vector2f start, sf::Vector2f end, sf::Color colour, float lineThickness,
-	              sf::RenderWindow& window);
+	SkeletonOverlay::Renderer skeletonOverlay; // Bones and joints, one draw call
 
 	WAITABLE_HANDLE h_bodyFrameEvent;
 	bool newBodyFrameArrived = false;
@@ -5,6 +5,7 @@
 
 #include "KinectV2Handler.h"
 #include <KinectToVR.h>
+#include <ProcessSupervisor.h>
 #include <sstream>
 #include <string>
 #include <iostream>
@@ -109,11 +110,8 @@ int main(int argc, char* argv[])
 */
 int main(int argc, char* argv[])
 {
-    // Set up the 'crash handler'
-    std::thread([] {
-        auto _pid = GetCurrentProcessId();
-        system(std::string("KV2CrashHandler.exe " + std::to_string(_pid)).c_str());
-        }).detach();
+    // Set up the crash handler, or pick up its state if it restarted us
+    Supervision::attach("KV2CrashHandler.exe", argc, argv);
 	
 	START_EASYLOGGINGPP(argc, argv);
 	init_logging();
@@ -1,5 +1,10 @@
 #include "stdafx.h"
 #include "KinectSettings.h"
+#include "SettingsWriter.h"
+#include "LatencyStats.h"
+#include "PoseActivity.h"
+#include "VRActionInput.h"
+#include "YawDriftCorrector.h"
 #include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <cereal/types/memory.hpp>
@@ -9,6 +14,7 @@
 #include <MathEigen.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include "wtypes.h"
 
 #include <Windows.h>
@@ -32,8 +38,11 @@ namespace KinectSettings
 	bool conActivated = false;
 	bool ignoreInferredPositions = false;
 	bool ignoreRotationSmoothing = false;
+	bool correctIMUYawDrift = false;
 	float ardroffset = 0.f;
 	int positional_tracking_option = 1, headtrackingoption = 1;
+	std::atomic<uint64_t> skeletonFrameId{0}, skeletonFrameMicroseconds{0};
+	SeqLock<SkeletonBones> skeletonBones;
 	// The joints which actually have rotation change based on the kinect
 	// Each kinect type should set these in their process beginning
 	// These would be the defaults for the V1
@@ -43,7 +52,7 @@ namespace KinectSettings
 	KVR::KinectJointType rightFootJointWithoutRotation = KVR::KinectJointType::AnkleRight;
 	bool isCalibrating = false;
 
-	PSMPSMove right_move_controller, left_move_controller, left_foot_psmove, right_foot_psmove, waist_psmove, atamamove;
+	SeqLock<PSMPSMove> right_move_controller, left_move_controller, left_foot_psmove, right_foot_psmove, waist_psmove, atamamove;
 	bool isGripPressed[2] = {false, false}, isTriggerPressed[2] = {false, false}; //0L, 1R
 	bool initialised = false, isKinectPSMS = false;
 	bool userChangingZero = false;
@@ -150,6 +159,26 @@ namespace KinectSettings
 	glm::vec3 joy[2] = {glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
 	glm::quat left_tracker_rot, right_tracker_rot, waist_tracker_rot;
 
+	void markSkeletonFrame()
+	{
+		const uint64_t now = Latency::nowMicroseconds();
+		const uint64_t previous = skeletonFrameMicroseconds.exchange(now);
+		if (previous != 0)
+			Latency::record(Latency::Stage::KinectFrameInterval, now - previous);
+		++skeletonFrameId;
+	}
+
+	// Takes the yaw drift out of a PSMove rotation, a new skeleton frame also feeds the corrector its bone
+	static glm::quat correctPSMoveYaw(YawDriftCorrector& corrector, const glm::quat& rotation,
+	                                  const SkeletonBones& bones, int part, bool newFrame)
+	{
+		const vr::HmdQuaternion_t imu{rotation.w, rotation.x, rotation.y, rotation.z};
+		if (newFrame && bones.valid[part])
+			corrector.addBoneDirection(imu, bones.direction[part], bones.frameSeconds);
+		const vr::HmdQuaternion_t corrected = corrector.correct(imu);
+		return glm::quat(corrected.w, corrected.x, corrected.y, corrected.z);
+	}
+
 	void sendipc()
 	{
 		LowPassFilter lowPassFilter[3][3] = {
@@ -186,6 +215,10 @@ namespace KinectSettings
 			}
 		}
 
+		// Left foot, right foot, waist, like SkeletonBones
+		YawDriftCorrector psmoveYawCorrectors[3];
+		uint64_t lastBonesFrame = 0;
+
 		Eigen::VectorXd y[3][3] = {
 			{Eigen::VectorXd(m), Eigen::VectorXd(m), Eigen::VectorXd(m)},
 			{Eigen::VectorXd(m), Eigen::VectorXd(m), Eigen::VectorXd(m)},
@@ -195,22 +228,33 @@ namespace KinectSettings
 		while (true)
 		{
 			auto loop_start_time = std::chrono::high_resolution_clock::now();
+			const uint64_t transform_start = Latency::nowMicroseconds();
+			const uint64_t frame_id = skeletonFrameId, frame_us = skeletonFrameMicroseconds;
+
+			// One consistent copy per loop, the PSMove handler keeps publishing meanwhile
+			const PSMPSMove left_foot_move = left_foot_psmove.load(), right_foot_move = right_foot_psmove.load(),
+			                waist_move = waist_psmove.load();
+
+			// This loop runs faster than the Kinect, each skeleton frame may only count once
+			const SkeletonBones bones = skeletonBones.load();
+			const bool newBones = bones.frameId != lastBonesFrame;
+			lastBonesFrame = bones.frameId;
 
 			if (positional_tracking_option == k_PSMoveFullTracking)
 			{
-				left_foot_raw_pose = .01f * glm::vec3(left_foot_psmove.Pose.Position.x, left_foot_psmove.Pose.Position.y,
-				                             left_foot_psmove.Pose.Position.z);
-				right_foot_raw_pose = .01f * glm::vec3(right_foot_psmove.Pose.Position.x, right_foot_psmove.Pose.Position.y,
-				                             right_foot_psmove.Pose.Position.z);
-				waist_raw_pose = .01f * glm::vec3(waist_psmove.Pose.Position.x, waist_psmove.Pose.Position.y,
-				                            waist_psmove.Pose.Position.z);
-
-				left_foot_raw_ori = glm::quat(left_foot_psmove.Pose.Orientation.w, left_foot_psmove.Pose.Orientation.x,
-				                     left_foot_psmove.Pose.Orientation.y, left_foot_psmove.Pose.Orientation.z);
-				right_foot_raw_ori = glm::quat(right_foot_psmove.Pose.Orientation.w, right_foot_psmove.Pose.Orientation.x,
-				                     right_foot_psmove.Pose.Orientation.y, right_foot_psmove.Pose.Orientation.z);
-				waist_raw_ori = glm::quat(waist_psmove.Pose.Orientation.w, waist_psmove.Pose.Orientation.x,
-				                    waist_psmove.Pose.Orientation.y, waist_psmove.Pose.Orientation.z);
+				left_foot_raw_pose = .01f * glm::vec3(left_foot_move.Pose.Position.x, left_foot_move.Pose.Position.y,
+				                             left_foot_move.Pose.Position.z);
+				right_foot_raw_pose = .01f * glm::vec3(right_foot_move.Pose.Position.x, right_foot_move.Pose.Position.y,
+				                             right_foot_move.Pose.Position.z);
+				waist_raw_pose = .01f * glm::vec3(waist_move.Pose.Position.x, waist_move.Pose.Position.y,
+				                            waist_move.Pose.Position.z);
+
+				left_foot_raw_ori = glm::quat(left_foot_move.Pose.Orientation.w, left_foot_move.Pose.Orientation.x,
+				                     left_foot_move.Pose.Orientation.y, left_foot_move.Pose.Orientation.z);
+				right_foot_raw_ori = glm::quat(right_foot_move.Pose.Orientation.w, right_foot_move.Pose.Orientation.x,
+				                     right_foot_move.Pose.Orientation.y, right_foot_move.Pose.Orientation.z);
+				waist_raw_ori = glm::quat(waist_move.Pose.Orientation.w, waist_move.Pose.Orientation.x,
+				                    waist_move.Pose.Orientation.y, waist_move.Pose.Orientation.z);
 			}
 
 			kinect_m_positions[2].v[0] = waist_raw_pose.x;
@@ -328,7 +372,7 @@ namespace KinectSettings
 				}
 			}
 
-			const PSMPSMove left_psmove = left_move_controller, right_psmove = right_move_controller;
+			const PSMPSMove left_psmove = left_move_controller.load(), right_psmove = right_move_controller.load();
 
 			//if (KVR_PSMoves.size() >= 1) {
 			//    hidariKontorora = KVR_PSMoves.at(psmh).PSMoveData;
@@ -345,20 +389,27 @@ namespace KinectSettings
 				offset[1] = left_psmove.Pose.Orientation; //quaterion for further offset maths
 
 
-			if (left_foot_psmove.SelectButton == PSMButtonState_DOWN) //recenter left foot move with select button
-				move_ori_offset[0] = glm::quat(left_foot_psmove.Pose.Orientation.w,
-				                              left_foot_psmove.Pose.Orientation.x, left_foot_psmove.Pose.Orientation.y,
-				                              left_foot_psmove.Pose.Orientation.z);
+			// The offset is taken off the tracker rotation, which has the yaw drift taken out when correcting,
+			// so it's recorded the same way or the correction built up so far would stay on the tracker
+			auto recentreOffset = [&](const PSMPSMove& move, int part)
+			{
+				const glm::quat rotation(move.Pose.Orientation.w, move.Pose.Orientation.x, move.Pose.Orientation.y,
+				                         move.Pose.Orientation.z);
+				if (!correctIMUYawDrift)
+					return rotation;
+				const vr::HmdQuaternion_t corrected = psmoveYawCorrectors[part].correct(
+					{rotation.w, rotation.x, rotation.y, rotation.z});
+				return glm::quat(corrected.w, corrected.x, corrected.y, corrected.z);
+			};
 
-			if (right_foot_psmove.SelectButton == PSMButtonState_DOWN) //recenter right foot move with select button
-				move_ori_offset[1] = glm::quat(right_foot_psmove.Pose.Orientation.w,
-				                              right_foot_psmove.Pose.Orientation.x, right_foot_psmove.Pose.Orientation.y,
-				                              right_foot_psmove.Pose.Orientation.z);
+			if (left_foot_move.SelectButton == PSMButtonState_DOWN) //recenter left foot move with select button
+				move_ori_offset[0] = recentreOffset(left_foot_move, 0);
 
-			if (waist_psmove.SelectButton == PSMButtonState_DOWN) //recenter waist move with select button
-				move_ori_offset[2] = glm::quat(waist_psmove.Pose.Orientation.w,
-				                              waist_psmove.Pose.Orientation.x, waist_psmove.Pose.Orientation.y,
-				                              waist_psmove.Pose.Orientation.z);
+			if (right_foot_move.SelectButton == PSMButtonState_DOWN) //recenter right foot move with select button
+				move_ori_offset[1] = recentreOffset(right_foot_move, 1);
+
+			if (waist_move.SelectButton == PSMButtonState_DOWN) //recenter waist move with select button
+				move_ori_offset[2] = recentreOffset(waist_move, 2);
 
 			using PointSet = Eigen::Matrix<float, 3, Eigen::Dynamic>; //create pointset for korejan's transform algo
 			const float yaw = hmdYaw * 180 / M_PI; //get current headset yaw (RAD->DEG)
@@ -398,6 +449,8 @@ namespace KinectSettings
 					flip = true;
 			}
 
+			// Set by the lambda once the poses are final, everything before is transform
+			uint64_t encode_start = 0;
 			std::string tracker_data_string = [&]()-> std::string
 			{
 				std::stringstream S;
@@ -407,8 +460,12 @@ namespace KinectSettings
 					if (positional_tracking_option == k_KinectFullTracking)
 						waist_tracker_rot = waist_raw_ori;
 					else
-						waist_tracker_rot = glm::quat(waist_psmove.Pose.Orientation.w, waist_psmove.Pose.Orientation.x,
-						                        waist_psmove.Pose.Orientation.y, waist_psmove.Pose.Orientation.z);
+					{
+						waist_tracker_rot = glm::quat(waist_move.Pose.Orientation.w, waist_move.Pose.Orientation.x,
+						                        waist_move.Pose.Orientation.y, waist_move.Pose.Orientation.z);
+						if (correctIMUYawDrift)
+							waist_tracker_rot = correctPSMoveYaw(psmoveYawCorrectors[2], waist_tracker_rot, bones, 2, newBones);
+					}
 				}
 				else if (hips_rotation_option == k_DisableHipsOrientationFilter)
 					waist_tracker_rot = glm::quat(0, 0, 0, 0);
@@ -466,10 +523,15 @@ namespace KinectSettings
 					}
 					else
 					{
-						left_tracker_rot = glm::quat(left_foot_psmove.Pose.Orientation.w, left_foot_psmove.Pose.Orientation.x,
-						                        left_foot_psmove.Pose.Orientation.y, left_foot_psmove.Pose.Orientation.z);
-						right_tracker_rot = glm::quat(right_foot_psmove.Pose.Orientation.w, right_foot_psmove.Pose.Orientation.x,
-						                        right_foot_psmove.Pose.Orientation.y, right_foot_psmove.Pose.Orientation.z);
+						left_tracker_rot = glm::quat(left_foot_move.Pose.Orientation.w, left_foot_move.Pose.Orientation.x,
+						                        left_foot_move.Pose.Orientation.y, left_foot_move.Pose.Orientation.z);
+						right_tracker_rot = glm::quat(right_foot_move.Pose.Orientation.w, right_foot_move.Pose.Orientation.x,
+						                        right_foot_move.Pose.Orientation.y, right_foot_move.Pose.Orientation.z);
+						if (correctIMUYawDrift)
+						{
+							left_tracker_rot = correctPSMoveYaw(psmoveYawCorrectors[0], left_tracker_rot, bones, 0, newBones);
+							right_tracker_rot = correctPSMoveYaw(psmoveYawCorrectors[1], right_tracker_rot, bones, 1, newBones);
+						}
 					}
 				}
 				else if (feet_rotation_option == k_EnableOrientationFilter_WithoutYaw)
@@ -493,15 +555,15 @@ namespace KinectSettings
 					}
 					else
 					{
-						glm::vec3 left_ori_with_yaw = eulerAngles(glm::quat(left_foot_psmove.Pose.Orientation.w,
-						                                           left_foot_psmove.Pose.Orientation.x,
-						                                           left_foot_psmove.Pose.Orientation.y,
-						                                           left_foot_psmove.Pose.Orientation.z));
+						glm::vec3 left_ori_with_yaw = eulerAngles(glm::quat(left_foot_move.Pose.Orientation.w,
+						                                           left_foot_move.Pose.Orientation.x,
+						                                           left_foot_move.Pose.Orientation.y,
+						                                           left_foot_move.Pose.Orientation.z));
 						left_tracker_rot = glm::quat(glm::vec3(left_ori_with_yaw.x, 0.f, left_ori_with_yaw.z));
-						glm::vec3 right_ori_with_yaw = eulerAngles(glm::quat(right_foot_psmove.Pose.Orientation.w,
-						                                           right_foot_psmove.Pose.Orientation.x,
-						                                           right_foot_psmove.Pose.Orientation.y,
-						                                           right_foot_psmove.Pose.Orientation.z));
+						glm::vec3 right_ori_with_yaw = eulerAngles(glm::quat(right_foot_move.Pose.Orientation.w,
+						                                           right_foot_move.Pose.Orientation.x,
+						                                           right_foot_move.Pose.Orientation.y,
+						                                           right_foot_move.Pose.Orientation.z));
 						right_tracker_rot = glm::quat(glm::vec3(right_ori_with_yaw.x, 0.f, right_ori_with_yaw.z));
 					}
 				}
@@ -632,6 +694,7 @@ namespace KinectSettings
 					PointSet right_pose_end = (calibration_rotation * (right_foot_pose - calibration_origin)).colwise() + calibration_translation + calibration_origin;
 					PointSet waist_pose_end = (calibration_rotation * (waist_pose - calibration_origin)).colwise() + calibration_translation + calibration_origin;
 
+					encode_start = Latency::nowMicroseconds();
 					S << "HX" << 10000 * (left_pose_end(0) + manual_offsets[0][1].v[0] + kinect_tracker_offsets.v[0]) <<
 						"/HY" << 10000 * (left_pose_end(1) + manual_offsets[0][1].v[1] + kinect_tracker_offsets.v[1]) <<
 						"/HZ" << 10000 * (left_pose_end(2) + manual_offsets[0][1].v[2] + kinect_tracker_offsets.v[2]) <<
@@ -658,6 +721,7 @@ namespace KinectSettings
 				}
 				else
 				{
+					encode_start = Latency::nowMicroseconds();
 					S << "HX" << 10000 * (poseFiltered[0].x + manual_offsets[0][1].v[0] + kinect_tracker_offsets.v[0]) <<
 						"/HY" << 10000 * (poseFiltered[0].y + manual_offsets[0][1].v[1] + kinect_tracker_offsets.v[1]) <<
 						"/HZ" << 10000 * (poseFiltered[0].z + manual_offsets[0][1].v[2] + kinect_tracker_offsets.v[2]) <<
@@ -683,11 +747,17 @@ namespace KinectSettings
 						"/ENABLED" << initialised << "/";
 				}
 
+				// Frame stamp for the driver's end to end histogram
+				S << "FID" << frame_id << "/FT" << frame_us << "/";
+
 				return S.str();
 			}();
 			
 			char tracker_data_char[1024];
 			strcpy_s(tracker_data_char, tracker_data_string.c_str());
+			const uint64_t write_start = Latency::nowMicroseconds();
+			Latency::record(Latency::Stage::TrackerTransform, encode_start - transform_start);
+			Latency::record(Latency::Stage::IpcEncode, write_start - encode_start);
 
 			const HANDLE server_pipe_handle = CreateFile(
 				TEXT("\\\\.\\pipe\\LogPipeTracker"), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0,
@@ -697,6 +767,15 @@ namespace KinectSettings
 			WriteFile(server_pipe_handle, tracker_data_char, sizeof(tracker_data_char), &written, nullptr);
 			CloseHandle(server_pipe_handle);
 
+			// Also while SteamVR is down, so its watchdog can bring it back
+			if (initialised)
+				PoseActivity::notify();
+
+			const uint64_t sent = Latency::nowMicroseconds();
+			Latency::record(Latency::Stage::PipeWrite, sent - write_start);
+			if (frame_us != 0)
+				Latency::record(Latency::Stage::FrameAgeAtSend, sent - frame_us);
+
 			// Wait until certain time has passed
 			auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
 				std::chrono::high_resolution_clock::now() - loop_start_time).count();
@@ -758,45 +837,39 @@ namespace KinectSettings
 
 	void writeKinectSettings()
 	{
-		std::ofstream os(KVR::fileToDirPath(CFG_NAME));
-		if (os.fail())
-		{
-			//FAIL!!!
-			LOG(ERROR) << "ERROR: COULD NOT WRITE TO CONFIG FILE\n";
-		}
-		else
-		{
-			using namespace KinectSettings;
-			using namespace SFMLsettings;
-			float kRotation[3][3] = {
-				{manual_offsets[1][0].v[0], manual_offsets[1][0].v[1], manual_offsets[1][0].v[2]},
-				{manual_offsets[1][1].v[0], manual_offsets[1][1].v[1], manual_offsets[1][1].v[2]},
-				{manual_offsets[1][2].v[0], manual_offsets[1][2].v[1], manual_offsets[1][2].v[2]},
-			};
+		using namespace KinectSettings;
+		using namespace SFMLsettings;
+		float kRotation[3][3] = {
+			{manual_offsets[1][0].v[0], manual_offsets[1][0].v[1], manual_offsets[1][0].v[2]},
+			{manual_offsets[1][1].v[0], manual_offsets[1][1].v[1], manual_offsets[1][1].v[2]},
+			{manual_offsets[1][2].v[0], manual_offsets[1][2].v[1], manual_offsets[1][2].v[2]},
+		};
 
-			float kPosition[3][3] = {
-				{manual_offsets[0][0].v[0], manual_offsets[0][0].v[1], manual_offsets[0][0].v[2]},
-				{manual_offsets[0][1].v[0], manual_offsets[0][1].v[1], manual_offsets[0][1].v[2]},
-				{manual_offsets[0][2].v[0], manual_offsets[0][2].v[1], manual_offsets[0][2].v[2]},
-			};
+		float kPosition[3][3] = {
+			{manual_offsets[0][0].v[0], manual_offsets[0][0].v[1], manual_offsets[0][0].v[2]},
+			{manual_offsets[0][1].v[0], manual_offsets[0][1].v[1], manual_offsets[0][1].v[2]},
+			{manual_offsets[0][2].v[0], manual_offsets[0][2].v[1], manual_offsets[0][2].v[2]},
+		};
 
+		std::ostringstream os;
+		try
+		{
 			cereal::JSONOutputArchive archive(os);
-			LOG(INFO) << "Attempted to save config settings to file";
-			try
-			{
-				archive(
-					CEREAL_NVP(kRotation),
-					CEREAL_NVP(kPosition),
-					CEREAL_NVP(hipRoleHeightAdjust),
-					CEREAL_NVP(globalFontSize),
-					CEREAL_NVP(secondaryTrackingOriginOffset)
-				);
-			}
-			catch (cereal::RapidJSONException& e)
-			{
-				LOG(ERROR) << "CONFIG FILE SAVE JSON ERROR: " << e.what();
-			}
+			archive(
+				CEREAL_NVP(kRotation),
+				CEREAL_NVP(kPosition),
+				CEREAL_NVP(hipRoleHeightAdjust),
+				CEREAL_NVP(globalFontSize),
+				CEREAL_NVP(secondaryTrackingOriginOffset)
+			);
 		}
+		catch (cereal::RapidJSONException& e)
+		{
+			LOG(ERROR) << "CONFIG FILE SAVE JSON ERROR: " << e.what();
+			return;
+		}
+		// Written to disk in the background
+		SettingsWriter::get().queue(KVR::fileToDirPath(CFG_NAME), os.str());
 	}
 }
 
@@ -957,11 +1030,44 @@ namespace VRInput
 
 	vr::InputAnalogActionData_t trackpadpose[2]{};
 	vr::InputDigitalActionData_t confirmdatapose{};
+
+	namespace
+	{
+		// Index 0 is the right hand and 1 the left, like trackpadpose and KinectSettings::isGripPressed
+		const char* const handSourcePaths[2] = {"/user/hand/right", "/user/hand/left"};
+
+		// Every action initialiseVRInput binds, the installed manifest has to declare all of them
+		const char* const requiredActions[] = {
+			"/actions/calibration/in/MoveHorizontally", "/actions/calibration/in/MoveVertically",
+			"/actions/calibration/in/ConfirmCalibration", "/actions/calibration/in/Trigger", "/actions/calibration/in/Grip"
+		};
+
+		VRActionInput actions;
+		VRActionInput::ActionId moveHorizontallyAction = -1, moveVerticallyAction = -1, confirmCalibrationAction = -1;
+		VRActionInput::ActionId triggerActions[2] = {-1, -1}, gripActions[2] = {-1, -1};
+	}
 }
 
 bool VRInput::initialiseVRInput()
 {
+	// Decided once here, the main loop then reads either the actions or the polled controllers, never both
+	legacyInputModeEnabled = true;
+
 	std::string path = KVR::inputDirForOpenVR("action-manifest.json");
+	std::ifstream manifestFile(path);
+	std::stringstream manifest;
+	manifest << manifestFile.rdbuf();
+	for (const char* action : requiredActions)
+	{
+		if (!VRActionInput::manifestDeclares(manifest.str(), action))
+		{
+			// Setting a manifest without bindings for the calibration would leave the controllers unread,
+			// so SteamVR isn't told about it at all and keeps giving legacy input
+			LOG(WARNING) << "Action manifest doesn't declare " << action << ", using legacy controller input";
+			return false;
+		}
+	}
+
 	const char* c_path = path.c_str();
 	vr::EVRInputError iError = vr::VRInput()->SetActionManifestPath(c_path);
 	if (iError == vr::EVRInputError::VRInputError_None)
@@ -974,19 +1080,19 @@ bool VRInput::initialiseVRInput()
 		return false;
 	}
 	// Obtain handles
-	iError = vr::VRInput()->GetActionHandle("/actions/calibration/in/MoveHorizontally", &moveHorizontallyHandle);
-	iError = vr::VRInput()->GetActionHandle("/actions/calibration/in/MoveVertically", &moveVerticallyHandle);
-	iError = vr::VRInput()->GetActionHandle("/actions/calibration/in/ConfirmCalibration", &confirmCalibrationHandle);
-
-	iError = vr::VRInput()->GetActionSetHandle("/actions/calibration", &calibrationSetHandle);
-
-	// Set Actionset Settings
-	activeActionSet.ulActionSet = calibrationSetHandle;
-	activeActionSet.ulRestrictedToDevice = vr::k_ulInvalidInputValueHandle;
-	activeActionSet.unPadding; // Ignored
-	activeActionSet.nPriority = 0;
+	iError = actions.init(vr::VRInput(), "/actions/calibration");
+	moveHorizontallyAction = actions.addAnalog("/actions/calibration/in/MoveHorizontally");
+	moveVerticallyAction = actions.addAnalog("/actions/calibration/in/MoveVertically");
+	confirmCalibrationAction = actions.addDigital("/actions/calibration/in/ConfirmCalibration");
+	for (int hand = 0; hand < 2; ++hand)
+	{
+		triggerActions[hand] = actions.addDigital("/actions/calibration/in/Trigger", handSourcePaths[hand]);
+		gripActions[hand] = actions.addDigital("/actions/calibration/in/Grip", handSourcePaths[hand]);
+	}
 
-	if (iError == vr::EVRInputError::VRInputError_None)
+	if (iError == vr::EVRInputError::VRInputError_None && moveHorizontallyAction >= 0 && moveVerticallyAction >= 0
+		&& confirmCalibrationAction >= 0 && triggerActions[0] >= 0 && triggerActions[1] >= 0 && gripActions[0] >= 0
+		&& gripActions[1] >= 0)
 	{
 		LOG(INFO) << "Input Handles set correctly!";
 	}
@@ -995,50 +1101,84 @@ bool VRInput::initialiseVRInput()
 		LOG(ERROR) << "Input Handle Error, EVRInputError Code: " << static_cast<int>(iError);
 		return false;
 	}
+
+	// SteamVR answers the first update with InvalidHandle when it put the application into legacy mode anyway
+	actions.update();
+	if (actions.isLegacyMode())
+	{
+		LOG(WARNING) << "SteamVR gives legacy input only, using legacy controller input";
+		return false;
+	}
+	moveHorizontallyHandle = actions.getHandle(moveHorizontallyAction);
+	moveVerticallyHandle = actions.getHandle(moveVerticallyAction);
+	confirmCalibrationHandle = actions.getHandle(confirmCalibrationAction);
+	activeActionSet = actions.getActiveSet();
+	calibrationSetHandle = activeActionSet.ulActionSet;
+
+	// A button already held at startup isn't a press for the first frame
+	VRActionInput::DigitalEvent ignored;
+	while (actions.pollEvent(ignored))
+	{
+	}
+
+	LOG(INFO) << "Using SteamVR Input actions for the calibration";
+	legacyInputModeEnabled = false;
 	return true;
 }
 
 void VRInput::updateVRInput()
 {
-	vr::EVRInputError iError = vr::VRInput()->UpdateActionState(&activeActionSet, sizeof(activeActionSet), 1);
-	if (iError != vr::EVRInputError::VRInputError_None)
-	{
-		LOG(ERROR) << "Error when updating input action state, EVRInputError Code: " << static_cast<int>(iError);
+	if (legacyInputModeEnabled)
 		return;
-	}
-	vr::InputAnalogActionData_t moveHorizontallyData{};
-	iError = vr::VRInput()->GetAnalogActionData(
-		moveHorizontallyHandle,
-		&moveHorizontallyData,
-		sizeof(moveHorizontallyData),
-		vr::k_ulInvalidInputValueHandle);
 
-	vr::InputAnalogActionData_t moveVerticallyData{};
-	iError = vr::VRInput()->GetAnalogActionData(
-		moveVerticallyHandle,
-		&moveVerticallyData,
-		sizeof(moveVerticallyData),
-		vr::k_ulInvalidInputValueHandle);
-
-	vr::InputDigitalActionData_t confirmPosData{};
-	iError = vr::VRInput()->GetDigitalActionData(
-		confirmCalibrationHandle,
-		&confirmPosData,
-		sizeof(confirmPosData),
-		vr::k_ulInvalidInputValueHandle);
+	// The one call fetching every action of the set for this frame
+	vr::EVRInputError iError = actions.update();
 
 	// Ugly Hack until Valve fixes this behaviour ---------
-	if (iError == vr::EVRInputError::VRInputError_InvalidHandle)
+	// SteamVR's latest wonderful bug/feature:
+	// Switches to Legacy mode on any application it doesn't recognize
+	// Meaning that the new system isn't used at all...
+	// Why god. Why do you taunt me so?
+	if (actions.isLegacyMode())
 	{
-		// SteamVR's latest wonderful bug/feature:
-		// Switches to Legacy mode on any application it doesn't recognize
-		// Meaning that the new system isn't used at all...
-		// Why god. Why do you taunt me so?
+		// For the rest of the session, the controllers are polled from the next frame on
+		LOG(WARNING) << "SteamVR switched to legacy input, using legacy controller input";
 		legacyInputModeEnabled = true;
+		return;
 	}
-	else
+	// -----------------------------------------------------
+	if (iError != vr::EVRInputError::VRInputError_None)
 	{
-		legacyInputModeEnabled = false;
+		LOG(ERROR) << "Error when updating input action state, EVRInputError Code: " << static_cast<int>(iError);
 	}
-	// -----------------------------------------------------
+
+	bool confirmPressed = false, triggerPressed = false, gripPressed[2] = {false, false};
+	VRActionInput::DigitalEvent event;
+	while (actions.pollEvent(event))
+	{
+		if (!event.pressed)
+			continue;
+		confirmPressed = confirmPressed || event.action == confirmCalibrationAction;
+		for (int hand = 0; hand < 2; ++hand)
+		{
+			triggerPressed = triggerPressed || event.action == triggerActions[hand];
+			gripPressed[hand] = gripPressed[hand] || event.action == gripActions[hand];
+		}
+	}
+
+	// Same meaning as the values the main loop fills from the polled controllers in legacy mode
+	moveHorizontallyData = actions.getAnalog(moveHorizontallyAction);
+	moveVerticallyData = actions.getAnalog(moveVerticallyAction);
+	trackpadpose[0] = moveVerticallyData;
+	trackpadpose[1] = moveHorizontallyData;
+
+	confirmCalibrationData.bActive = actions.isActive(confirmCalibrationAction) || actions.isActive(triggerActions[0])
+		|| actions.isActive(triggerActions[1]);
+	confirmCalibrationData.bState = confirmPressed || triggerPressed;
+	confirmdatapose.bState = triggerPressed;
+
+	KinectSettings::isGripPressed[0] = gripPressed[0];
+	KinectSettings::isGripPressed[1] = actions.getState(gripActions[1]);
+	KinectSettings::isTriggerPressed[0] = actions.getState(triggerActions[0]);
+	KinectSettings::isTriggerPressed[1] = actions.getState(triggerActions[1]);
 }
@@ -4,6 +4,7 @@
 #include "VRHelper.h"
 
 #include "KinectSettings.h"
+#include "AsyncLog.h"
 #include "VRController.h"
 #include "GamepadController.h"
 #include "GUIHandler.h"
@@ -15,6 +16,7 @@
 #include "VRDeviceHandler.h"
 #include "PSMoveHandler.h"
 #include "DeviceHandler.h"
+#include "ProcessSupervisor.h"
 #include <boost/thread.hpp>
 #include <SFML/Audio.hpp>
 
@@ -292,9 +294,81 @@ void updateServerStatus(GUIHandler& guiRef)
 		}).detach();
 }
 
+// Snapshot for the crash handler, a restarted process gets this back
+RecoveryState captureRecoveryState()
+{
+	using namespace KinectSettings;
+	RecoveryState state{};
+	state.valid = 1;
+	state.trackersInitialised = initialised;
+	state.matrixesCalibrated = matrixes_calibrated;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+			state.calibrationRotation[i][j] = calibration_rotation(i, j);
+		state.calibrationTranslation[i] = calibration_translation(i);
+		state.calibrationOrigin[i] = calibration_origin(i);
+	}
+	state.calibrationTrackersYaw = calibration_trackers_yaw;
+	state.calibrationKinectPitch = calibration_kinect_pitch;
+	for (int i = 0; i < 2; ++i)
+		for (int j = 0; j < 3; ++j)
+			for (int k = 0; k < 3; ++k)
+				state.manualOffsets[i][j][k] = manual_offsets[i][j].v[k];
+	state.hipRoleHeightAdjust = hipRoleHeightAdjust;
+	return state;
+}
+
+// Settings on disk may be a few seconds behind what the crashed process had
+void applyRecoveryState(const RecoveryState& state, GUIHandler& guiRef)
+{
+	using namespace VirtualHips;
+	retrieveSettings(); // Loads the file, so it can't overwrite the restored values later
+	{
+		auto lock = lockSettings();
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				settings.rcR_matT(i, j) = state.calibrationRotation[i][j];
+			settings.rcT_matT(i) = state.calibrationTranslation[i];
+			settings.caliborigin(i) = state.calibrationOrigin[i];
+		}
+		settings.tryawst = state.calibrationTrackersYaw;
+		settings.kinpitchst = state.calibrationKinectPitch;
+		settings.rtcalib = state.matrixesCalibrated != 0;
+	}
+	retrieveSettings();
+
+	for (int i = 0; i < 2; ++i)
+		for (int j = 0; j < 3; ++j)
+			for (int k = 0; k < 3; ++k)
+				KinectSettings::manual_offsets[i][j].v[k] = state.manualOffsets[i][j][k];
+	KinectSettings::hipRoleHeightAdjust = state.hipRoleHeightAdjust;
+
+	guiRef.setRestoreTrackers(state.trackersInitialised != 0);
+	LOG(INFO) << "Restarted after a crash, restored calibration" <<
+		(guiRef.getRestoreTrackers() ? " and trackers" : "");
+}
+
 void processLoop(KinectHandlerBase& kinect)
 {
 	LOG(INFO) << "~~~New logging session for main process begins here!~~~";
+	// Hot paths log through ASYNC_LOG, the lines end up here on the log thread
+	AsyncLog::start([](AsyncLog::Level level, const char* line)
+	{
+		switch (level)
+		{
+		case AsyncLog::Level::Warn:
+			LOG(WARNING) << line;
+			break;
+		case AsyncLog::Level::Error:
+			LOG(ERROR) << line;
+			break;
+		default:
+			LOG(INFO) << line;
+			break;
+		}
+	});
 	LOG(INFO) << "Kinect version is V" << static_cast<int>(kinect.kVersion);
 	KinectSettings::kinectVersion = kinect.kVersion; //Set kinect version
 	
@@ -335,6 +409,10 @@ void processLoop(KinectHandlerBase& kinect)
 	GUIHandler guiRef;
 	// ----------------------------------------------------
 
+	RecoveryState recoveredState;
+	if (Supervision::recoveredState(recoveredState))
+		applyRecoveryState(recoveredState, guiRef);
+
 	// Update kinect status
 	guiRef.updateKinectStatusLabel(kinect);
 	// Reconnect Kinect Event Signal
@@ -386,7 +464,7 @@ void processLoop(KinectHandlerBase& kinect)
 		guiRef.setVRSceneChangeButtonSignal(m_VRSystem);
 		updateTrackerInitGuiSignals(guiRef, v_trackers, m_VRSystem);
 		setTrackerRolesInVRSettings();
-		//VRInput::initialiseVRInput();
+		VRInput::initialiseVRInput();
 
 		leftController.Connect(m_VRSystem);
 		rightController.Connect(m_VRSystem);
@@ -454,7 +532,10 @@ void processLoop(KinectHandlerBase& kinect)
 	guiRef.refreshpsms();
 
 	// Select tracking option automatically
-	VirtualHips::settings.bodyTrackingOption = KinectSettings::isKinectPSMS ? k_PSMoveFullTracking : k_KinectFullTracking;
+	{
+		auto lock = VirtualHips::lockSettings();
+		VirtualHips::settings.bodyTrackingOption = KinectSettings::isKinectPSMS ? k_PSMoveFullTracking : k_KinectFullTracking;
+	}
 	bodyTrackingOption_s.trackingOption = static_cast<bodyTrackingOption>(VirtualHips::settings.bodyTrackingOption);
 	KinectSettings::positional_tracking_option = VirtualHips::settings.bodyTrackingOption;
 	
@@ -545,13 +626,28 @@ void processLoop(KinectHandlerBase& kinect)
 
 			guiRef.updateDesktop(deltaT);
 			time_lastGuiDesktopUpdate = timingClock.getElapsedTime();
+
+			Supervision::publish(captureRecoveryState());
 		}
 
 		//Update VR Components
 		if (eError == vr::VRInitError_None)
 		{
-			rightController.update(deltaT);
-			leftController.update(deltaT);
+			vr::VREvent_t vrEvent;
+			while (m_VRSystem->PollNextEvent(&vrEvent, sizeof(vrEvent)))
+			{
+				rightController.handleEvent(vrEvent);
+				leftController.handleEvent(vrEvent);
+			}
+
+			// initialiseVRInput decided which of the two is read, only one of them is queried per frame
+			if (!VRInput::legacyInputModeEnabled)
+				VRInput::updateVRInput();
+			if (VRInput::legacyInputModeEnabled)
+			{
+				rightController.update(deltaT);
+				leftController.update(deltaT);
+			}
 
 			updateHMDPosAndRot(m_VRSystem);
 
@@ -569,20 +665,20 @@ void processLoop(KinectHandlerBase& kinect)
 				<< ' ' << KinectSettings::waist_psmove.Pose.Position.z << "\n\n";
 			***********************************************************************************************/
 
-			VRInput::trackpadpose[0].x = rightController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).x;
-			VRInput::trackpadpose[0].y = rightController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).y;
-			VRInput::trackpadpose[1].x = leftController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).x;
-			VRInput::trackpadpose[1].y = leftController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).y;
-			VRInput::confirmdatapose.bState = leftController.GetTriggerDown() || rightController.GetTriggerDown();
-
-			KinectSettings::isGripPressed[0] = rightController.GetGripDown();
-			KinectSettings::isGripPressed[1] = leftController.GetGrip();
-			KinectSettings::isTriggerPressed[0] = rightController.GetTrigger();
-			KinectSettings::isTriggerPressed[1] = leftController.GetTrigger();
-
 			// EWWWWWWWWW -------------
 			if (VRInput::legacyInputModeEnabled)
 			{
+				VRInput::trackpadpose[0].x = rightController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).x;
+				VRInput::trackpadpose[0].y = rightController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).y;
+				VRInput::trackpadpose[1].x = leftController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).x;
+				VRInput::trackpadpose[1].y = leftController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad).y;
+				VRInput::confirmdatapose.bState = leftController.GetTriggerDown() || rightController.GetTriggerDown();
+
+				KinectSettings::isGripPressed[0] = rightController.GetGripDown();
+				KinectSettings::isGripPressed[1] = leftController.GetGrip();
+				KinectSettings::isTriggerPressed[0] = rightController.GetTrigger();
+				KinectSettings::isTriggerPressed[1] = leftController.GetTrigger();
+
 				using namespace VRInput;
 				moveHorizontallyData.bActive = true;
 				auto leftStickValues = leftController.GetControllerAxisValue(vr::k_EButton_SteamVR_Touchpad);
@@ -613,6 +709,7 @@ void processLoop(KinectHandlerBase& kinect)
 		if (timingClock.getElapsedTime() > time_lastKinectStatusUpdate + sf::seconds(2.0))
 		{
 			guiRef.updateKinectStatusLabel(kinect);
+			guiRef.updateLatencyLabel();
 			time_lastKinectStatusUpdate = timingClock.getElapsedTime();
 		}
 
@@ -650,6 +747,7 @@ void processLoop(KinectHandlerBase& kinect)
 		{
 			footOrientationFilterOption.filterOption = static_cast<footRotationFilterOption>(guiRef.coptbox->
 				GetSelectedItem());
+			auto lock = VirtualHips::lockSettings();
 			VirtualHips::settings.footOption = guiRef.coptbox->GetSelectedItem();
 
 			VirtualHips::saveSettings();
@@ -659,6 +757,7 @@ void processLoop(KinectHandlerBase& kinect)
 		{
 			hipsOrientationFilterOption.filterOption = static_cast<hipsRotationFilterOption>(guiRef.coptbox1->
 				GetSelectedItem());
+			auto lock = VirtualHips::lockSettings();
 			VirtualHips::settings.hipsOption = guiRef.coptbox1->GetSelectedItem();
 
 			VirtualHips::saveSettings();
@@ -666,6 +765,7 @@ void processLoop(KinectHandlerBase& kinect)
 		if (positionFilterOption.filterOption != static_cast<positionalFilterOption>(guiRef.foptbox->GetSelectedItem()))
 		{
 			positionFilterOption.filterOption = static_cast<positionalFilterOption>(guiRef.foptbox->GetSelectedItem());
+			auto lock = VirtualHips::lockSettings();
 			VirtualHips::settings.posOption = guiRef.foptbox->GetSelectedItem();
 
 			VirtualHips::saveSettings();
@@ -675,6 +775,7 @@ void processLoop(KinectHandlerBase& kinect)
 		{
 			controllersTrackingOption_s.trackingOption = static_cast<controllersTrackingOption>(guiRef.contrackingselectbox
 				->GetSelectedItem());
+			auto lock = VirtualHips::lockSettings();
 			VirtualHips::settings.conOption = guiRef.contrackingselectbox->GetSelectedItem();
 
 			VirtualHips::saveSettings();
@@ -694,6 +795,7 @@ void processLoop(KinectHandlerBase& kinect)
 		{
 			headTrackingOption_s.trackingOption = static_cast<headTrackingOption>(guiRef.headtrackingselectbox->
 				GetSelectedItem());
+			auto lock = VirtualHips::lockSettings();
 			VirtualHips::settings.headTrackingOption = guiRef.headtrackingselectbox->GetSelectedItem();
 
 			VirtualHips::saveSettings();
@@ -749,6 +851,8 @@ void processLoop(KinectHandlerBase& kinect)
 	}
 	KinectSettings::writeKinectSettings();
 	VirtualHips::saveSettings();
+	SettingsWriter::get().flush();
+	AsyncLog::stop();
 
 	kinect.terminateColor();
 	kinect.terminateDepth();
@@ -0,0 +1,508 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Deferred printf-style logging for hot threads, shared by the driver and the client
+// ASYNC_LOG copies the call site and the raw arguments into the calling thread's ring,
+// formatting and the actual write happen later on the log thread started by AsyncLog::start
+//
+//		ASYNC_LOG(AsyncLog::Level::Info, 1000, "yaw: %f", yaw); // At most once a second
+//
+// Strings, narrow and wide, are copied on the calling thread (up to k_maxStringLength or k_maxWideStringLength
+// characters), so temporaries like .c_str() are fine. Any other pointer is only good for %p
+namespace AsyncLog
+{
+	enum class Level
+	{
+		Debug,
+		Info,
+		Warn,
+		Error
+	};
+
+	using Sink = std::function<void(Level level, const char* line)>;
+
+	constexpr size_t k_payloadSize = 240;
+	constexpr size_t k_maxStringLength = 64;
+	constexpr size_t k_maxWideStringLength = 48;
+	constexpr size_t k_ringSize = 512; // Records per thread, power of two
+	constexpr size_t k_lineSize = 1024;
+
+	// One per log statement, records point here instead of carrying the format
+	class Site
+	{
+	public:
+		Site(Level level, int minIntervalMs, const char* format)
+			: level(level),
+			  format(format),
+			  m_minIntervalNs(static_cast<int64_t>(minIntervalMs) * 1000000)
+		{
+		}
+
+		const Level level;
+		const char* const format;
+
+		// False if the site logged less than minIntervalMs ago
+		bool admit()
+		{
+			if (m_minIntervalNs <= 0)
+				return true;
+
+			const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			int64_t last = m_lastLoggedNs.load(std::memory_order_relaxed);
+			if ((last != 0 && now - last < m_minIntervalNs) ||
+				!m_lastLoggedNs.compare_exchange_strong(last, now, std::memory_order_relaxed))
+			{
+				m_suppressed.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			return true;
+		}
+
+		uint32_t takeSuppressed()
+		{
+			return m_suppressed.exchange(0, std::memory_order_relaxed);
+		}
+
+	private:
+		const int64_t m_minIntervalNs;
+		std::atomic<int64_t> m_lastLoggedNs{0};
+		std::atomic<uint32_t> m_suppressed{0};
+	};
+
+	using FormatFunction = int (*)(const char* format, const unsigned char* payload, char* out, size_t outSize);
+
+	struct Record
+	{
+		const Site* site;
+		FormatFunction formatter;
+		uint32_t suppressed;
+		bool continued; // The next record carries more of the same line
+		unsigned char payload[k_payloadSize];
+	};
+
+	// Written by its thread, drained by the log thread
+	struct Ring
+	{
+		Record records[k_ringSize];
+		std::atomic<uint32_t> head{0};
+		std::atomic<uint32_t> tail{0};
+		std::atomic<uint32_t> dropped{0};
+		std::atomic<bool> abandoned{false};
+
+		// The first of count consecutive records, nullptr if they don't all fit
+		Record* claim(uint32_t count = 1)
+		{
+			const uint32_t head_ = head.load(std::memory_order_relaxed);
+			if (head_ - tail.load(std::memory_order_acquire) + count > k_ringSize)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			return &records[head_ & (k_ringSize - 1)];
+		}
+
+		Record& claimed(uint32_t index)
+		{
+			return records[(head.load(std::memory_order_relaxed) + index) & (k_ringSize - 1)];
+		}
+
+		// Publishes all claimed records at once, so the log thread never sees half a line
+		void publish(uint32_t count = 1)
+		{
+			head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+	};
+
+	// Argument storage, strings are copied, everything else goes in as is
+	struct StoredString
+	{
+		char text[k_maxStringLength];
+	};
+
+	template <typename T>
+	struct Arg
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+			"ASYNC_LOG arguments have to be numbers, enums, pointers or C strings");
+		using Stored = T;
+
+		static Stored store(T value) { return value; }
+		static T load(const Stored& stored) { return stored; }
+	};
+
+	template <>
+	struct Arg<const char*>
+	{
+		using Stored = StoredString;
+
+		static Stored store(const char* value)
+		{
+			Stored stored;
+			if (value == nullptr)
+				value = "(null)";
+			std::strncpy(stored.text, value, k_maxStringLength - 1);
+			stored.text[k_maxStringLength - 1] = '\0';
+			return stored;
+		}
+
+		static const char* load(const Stored& stored) { return stored.text; }
+	};
+
+	template <>
+	struct Arg<char*> : Arg<const char*>
+	{
+	};
+
+	struct StoredWideString
+	{
+		wchar_t text[k_maxWideStringLength];
+	};
+
+	// For %ls, the caller's buffer may be gone by the time the line is formatted
+	template <>
+	struct Arg<const wchar_t*>
+	{
+		using Stored = StoredWideString;
+
+		static Stored store(const wchar_t* value)
+		{
+			Stored stored;
+			if (value == nullptr)
+				value = L"(null)";
+			std::wcsncpy(stored.text, value, k_maxWideStringLength - 1);
+			stored.text[k_maxWideStringLength - 1] = L'\0';
+			return stored;
+		}
+
+		static const wchar_t* load(const Stored& stored) { return stored.text; }
+	};
+
+	template <>
+	struct Arg<wchar_t*> : Arg<const wchar_t*>
+	{
+	};
+
+	template <typename... Args>
+	int formatRecord(const char* format, const unsigned char* payload, char* out, size_t outSize)
+	{
+		std::tuple<typename Arg<Args>::Stored...> stored;
+		size_t offset = 0;
+		std::apply([&](auto&... value)
+		{
+			((std::memcpy(&value, payload + offset, sizeof(value)), offset += sizeof(value)), ...);
+		}, stored);
+		(void)offset;
+
+		return std::apply([&](const auto&... value)
+		{
+			return std::snprintf(out, outSize, format, Arg<Args>::load(value)...);
+		}, stored);
+	}
+
+	// Already formatted text, payload is a NUL terminated string
+	inline int formatText(const char*, const unsigned char* payload, char* out, size_t outSize)
+	{
+		return std::snprintf(out, outSize, "%s", reinterpret_cast<const char*>(payload));
+	}
+
+	class Backend
+	{
+	public:
+		static Backend& get()
+		{
+			static Backend backend;
+			return backend;
+		}
+
+		// Rings stay alive after their thread exits until the log thread has drained them
+		Ring& threadRing()
+		{
+			struct Owner
+			{
+				std::shared_ptr<Ring> ring;
+
+				~Owner()
+				{
+					if (ring)
+						ring->abandoned = true;
+				}
+			};
+			thread_local Owner owner;
+
+			if (!owner.ring)
+			{
+				owner.ring = std::make_shared<Ring>();
+				std::lock_guard<std::mutex> lock(m_ringsMutex);
+				m_rings.push_back(owner.ring);
+			}
+			return *owner.ring;
+		}
+
+		void start(Sink sink)
+		{
+			stop();
+			m_sink = std::move(sink);
+			m_keepRunning = true;
+			m_thread = std::thread(&Backend::run, this);
+		}
+
+		// Writes out everything logged so far, then stops the log thread
+		void stop()
+		{
+			m_keepRunning = false;
+			wake();
+			if (m_thread.joinable())
+				m_thread.join();
+		}
+
+		// Called after publishing, only costs a fence unless the log thread is asleep
+		void notify()
+		{
+			// Pairs with the fence in waitForRecords: either this sees the log thread asleep,
+			// or the log thread sees the record before it goes to sleep
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_sleeping.load(std::memory_order_relaxed))
+				wake();
+		}
+
+	private:
+		Backend() = default;
+
+		~Backend()
+		{
+			stop();
+		}
+
+		void run()
+		{
+			std::vector<std::shared_ptr<Ring>> rings;
+			char line[k_lineSize];
+
+			while (true)
+			{
+				// Read the flag first, so the last pass still sees everything logged before stop()
+				const bool keepRunning = m_keepRunning;
+				{
+					std::lock_guard<std::mutex> lock(m_ringsMutex);
+					rings = m_rings;
+				}
+
+				size_t written = 0;
+				for (auto& ring : rings)
+					written += drain(*ring, line);
+
+				if (!keepRunning)
+					break;
+
+				releaseAbandoned();
+				if (written == 0)
+					waitForRecords();
+			}
+		}
+
+		void wake()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_wakeMutex);
+				m_woken = true;
+			}
+			m_wake.notify_one();
+		}
+
+		// Blocks until a thread logs something or stop is called
+		void waitForRecords()
+		{
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_sleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!hasRecords())
+				m_wake.wait(lock, [this] { return m_woken || !m_keepRunning; });
+			m_sleeping.store(false, std::memory_order_relaxed);
+			m_woken = false;
+		}
+
+		bool hasRecords()
+		{
+			std::lock_guard<std::mutex> lock(m_ringsMutex);
+			for (auto& ring : m_rings)
+			{
+				if (ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed) ||
+					ring->dropped.load(std::memory_order_relaxed) > 0)
+					return true;
+			}
+			return false;
+		}
+
+		size_t drain(Ring& ring, char* line)
+		{
+			const uint32_t head = ring.head.load(std::memory_order_acquire);
+			uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+			const size_t count = head - tail;
+
+			size_t lineLength = 0;
+			for (; tail != head; ++tail)
+			{
+				const Record& record = ring.records[tail & (k_ringSize - 1)];
+				const int length = record.formatter(record.site->format, record.payload, line + lineLength,
+				                                    k_lineSize - lineLength);
+				if (length < 0)
+				{
+					lineLength = 0;
+					continue;
+				}
+				if (lineLength + length >= k_lineSize)
+				{
+					// Show that the line was cut instead of dropping the end silently
+					lineLength = k_lineSize - 1;
+					std::memcpy(line + lineLength - 3, "...", 3);
+				}
+				else
+					lineLength += length;
+				if (record.continued)
+					continue;
+
+				if (record.suppressed > 0 && lineLength < k_lineSize - 1)
+					std::snprintf(line + lineLength, k_lineSize - lineLength, " (%u similar suppressed)", record.suppressed);
+				m_sink(record.site->level, line);
+				lineLength = 0;
+			}
+			ring.tail.store(tail, std::memory_order_release);
+
+			const uint32_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+			if (dropped > 0)
+			{
+				std::snprintf(line, k_lineSize, "Log ring full, dropped %u messages", dropped);
+				m_sink(Level::Warn, line);
+			}
+			return count;
+		}
+
+		void releaseAbandoned()
+		{
+			std::lock_guard<std::mutex> lock(m_ringsMutex);
+			for (auto it = m_rings.begin(); it != m_rings.end();)
+			{
+				Ring& ring = **it;
+				if (ring.abandoned && ring.head.load(std::memory_order_acquire) == ring.tail.load(std::memory_order_relaxed))
+					it = m_rings.erase(it);
+				else
+					++it;
+			}
+		}
+
+		Sink m_sink;
+		std::thread m_thread;
+		std::atomic<bool> m_keepRunning{false};
+
+		std::atomic<bool> m_sleeping{false};
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wake;
+		bool m_woken = false;
+
+		std::mutex m_ringsMutex;
+		std::vector<std::shared_ptr<Ring>> m_rings;
+	};
+
+	inline void start(Sink sink)
+	{
+		Backend::get().start(std::move(sink));
+	}
+
+	inline void stop()
+	{
+		Backend::get().stop();
+	}
+
+	template <typename... Args>
+	void write(Site& site, Args... args)
+	{
+		static_assert((sizeof(typename Arg<Args>::Stored) + ... + 0) <= k_payloadSize,
+			"Too many ASYNC_LOG arguments");
+
+		if (!site.admit())
+			return;
+
+		Ring& ring = Backend::get().threadRing();
+		Record* record = ring.claim();
+		if (record == nullptr)
+			return;
+
+		record->site = &site;
+		record->formatter = &formatRecord<Args...>;
+		record->suppressed = site.takeSuppressed();
+		record->continued = false;
+
+		size_t offset = 0;
+		((void)[&]
+		{
+			const typename Arg<Args>::Stored stored = Arg<Args>::store(args);
+			std::memcpy(record->payload + offset, &stored, sizeof(stored));
+			offset += sizeof(stored);
+		}(), ...);
+		(void)offset;
+
+		ring.publish();
+		Backend::get().notify();
+	}
+
+	// For callers that only have a va_list, text longer than a record is split over consecutive ones
+	// Lines longer than k_lineSize are cut and end in "..."
+	inline void writeText(Site& site, const char* text)
+	{
+		if (!site.admit())
+			return;
+
+		constexpr size_t chunkSize = k_payloadSize - 1;
+		constexpr size_t maxLength = k_lineSize - 1;
+		const size_t length = std::min(std::strlen(text), maxLength);
+		const bool cut = text[length] != '\0';
+		const uint32_t count = static_cast<uint32_t>(length == 0 ? 1 : (length + chunkSize - 1) / chunkSize);
+
+		Ring& ring = Backend::get().threadRing();
+		if (ring.claim(count) == nullptr)
+			return;
+
+		const uint32_t suppressed = site.takeSuppressed();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Record& record = ring.claimed(i);
+			record.site = &site;
+			record.formatter = &formatText;
+			record.suppressed = suppressed;
+			record.continued = i + 1 < count;
+
+			const size_t offset = i * chunkSize;
+			const size_t size = std::min(chunkSize, length - offset);
+			std::memcpy(record.payload, text + offset, size);
+			record.payload[size] = '\0';
+		}
+		if (cut)
+			std::memcpy(ring.claimed(count - 1).payload + (length - (count - 1) * chunkSize) - 3, "...", 3);
+
+		ring.publish(count);
+		Backend::get().notify();
+	}
+}
+
+#define ASYNC_LOG(level, minIntervalMs, format, ...) \
+	do \
+	{ \
+		static AsyncLog::Site asyncLogSite_(level, minIntervalMs, format); \
+		AsyncLog::write(asyncLogSite_, ##__VA_ARGS__); \
+	} \
+	while (0)
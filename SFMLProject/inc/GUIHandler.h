@@ -11,9 +11,12 @@
 #include "VRHelper.h"
 #include <TlHelp32.h>
 #include "TrackingMethod.h"
+#include "IMU_RotationMethod.h"
 #include "DeviceHandler.h"
 #include "PSMoveHandler.h"
 #include "VRDeviceHandler.h"
+#include "LatencyStats.h"
+#include "StartupReadiness.h"
 #include <ShellAPI.h>
 
 #include <glm/gtc/quaternion.hpp>
@@ -337,6 +340,10 @@ public:
 		{
 			initialisePSMoveHandlerIntoGUI();
 		});
+		DumpLatencyButton->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
+		{
+			dumpLatencyStats();
+		});
 		StopPSMoveHandler->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
 		{
 			if (!psMoveHandler.active)
@@ -1135,6 +1142,11 @@ public:
 		                                t_tracker.data.rotationGlobalDeviceId, t_tracker.data.role);
 		device.positionTrackingOption = t_tracker.positionTrackingOption;
 		device.rotationTrackingOption = t_tracker.rotationTrackingOption;
+		KVR::KinectJointType boneFrom, boneTo;
+		if (KinectSettings::correctIMUYawDrift
+			&& device.rotationTrackingOption == KVR::JointRotationTrackingOption::IMU
+			&& IMU_RotationMethod::boneForRole(device.role, boneFrom, boneTo))
+			device.rotationTrackingOption = KVR::JointRotationTrackingOption::IMUWithSkeletonYaw;
 		device.customModelName = TrackingPoolManager::getDeviceData(t_tracker.data.positionGlobalDeviceId).
 			customModelName;
 		device.init(inputE);
@@ -1153,14 +1165,48 @@ public:
 		return r;
 	}
 
+	static bool inputEmulatorConnects()
+	{
+		try
+		{
+			vrinputemulator::VRInputEmulator inputEmulator;
+			inputEmulator.connect();
+			return inputEmulator.isConnected();
+		}
+		catch (vrinputemulator::vrinputemulator_exception&)
+		{
+			return false;
+		}
+	}
+
 	void ping_InitTrackers()
 	{
 		if (!KinectSettings::initialised && // If not done yet
-			VirtualHips::settings.astartt && KinectSettings::isDriverPresent)
+			(VirtualHips::settings.astartt || restoreTrackers) && KinectSettings::isDriverPresent)
 		{
 			std::thread* st = new std::thread([this]
 				{
-					std::this_thread::sleep_for(std::chrono::seconds(3));
+					// Trackers of a crashed process are still in SteamVR, take them over right away
+					// Otherwise spawn as soon as the driver serves its pipes and the runtime is up
+					if (!restoreTrackers)
+					{
+						Readiness::NamedEvent driverPipes(Readiness::k_driverPipesReady);
+						Readiness::Sequence startup;
+						startup.step("driver pipes", std::chrono::seconds(10), [&driverPipes](Readiness::clock::duration timeout)
+						{
+							return driverPipes.waitFor(timeout);
+						}).step("VR runtime", std::chrono::seconds(10), [](Readiness::clock::duration timeout)
+						{
+							return Readiness::waitUntil([] { return vr::VRSystem() != nullptr; }, timeout);
+						}).step("input emulator", std::chrono::seconds(5), [](Readiness::clock::duration timeout)
+						{
+							// Its IPC queue is created by the driver, connecting is the only way to probe it
+							return Readiness::waitUntil(inputEmulatorConnects, timeout, std::chrono::milliseconds(100));
+						});
+						const bool ready = startup.run();
+						LOG(INFO) << "Tracker startup: " << startup.summary();
+						LOG_IF(!ready, WARNING) << "Spawning trackers without waiting any longer";
+					}
 					TrackerInitButton->SetLabel("Trackers Initialised - Destroy Trackers");
 					spawnDefaultLowerBodyTrackers();
 
@@ -1508,11 +1554,23 @@ public:
 			{
 				KinectSettings::headtracked = true;
 
-				vr::EVRInitError error;
-				vr::TrackedDevicePose_t trackedDevicePose;
-				std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+				// Two seconds for the user to turn and face forward, then the yaw of the first tracked pose
+				std::this_thread::sleep_for(std::chrono::seconds(2));
+				vr::TrackedDevicePose_t trackedDevicePose = {};
+				const bool tracking = Readiness::waitUntil([&trackedDevicePose]
+				{
+					if (!vr::VRSystem())
+						return false;
+					vr::VRSystem()->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0, &trackedDevicePose, 1);
+					return trackedDevicePose.bPoseIsValid &&
+						trackedDevicePose.eTrackingResult == vr::TrackingResult_Running_OK;
+				}, std::chrono::seconds(2));
+				if (!tracking)
+				{
+					LOG(WARNING) << "Head tracking calibration skipped, the headset is not tracking";
+					return;
+				}
 
-				vr::VRSystem()->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0, &trackedDevicePose, 1);
 				double yaw = std::atan2(trackedDevicePose.mDeviceToAbsoluteTracking.m[0][2],
 					trackedDevicePose.mDeviceToAbsoluteTracking.m[2][2]);
 			
@@ -1529,6 +1587,7 @@ public:
 
 				KinectSettings::hroffset = glm::degrees(yaw);
 				DegreeButton->SetValue(static_cast<float>(glm::degrees(yaw)));
+				auto lock = lockSettings();
 				settings.hmdegree = glm::degrees(yaw);
 
 				/*glm::vec3 fixedpos = glm::rotateY(glm::vec4(
@@ -1998,6 +2057,7 @@ public:
 
 		advancedTrackerBox->Pack(box1);
 		advancedTrackerBox->Pack(box2);
+		advancedTrackerBox->Pack(CorrectIMUYawDriftButton);
 
 		advancedTrackerBox->Pack(sfg::Label::Create("Positional filtering options"));
 
@@ -2030,6 +2090,56 @@ public:
 		space_label->Show(false);
 		AutoStartTrackers->Show(false);
 		advancedTrackerBox->Pack(astartbox);
+
+		advancedTrackerBox->Pack(sfg::Label::Create("Tracking latency"));
+		sfg::Box::Ptr latencybox = sfg::Box::Create(sfg::Box::Orientation::HORIZONTAL, 5.f);
+		latencybox->Pack(LatencyLabel);
+		latencybox->Pack(DumpLatencyButton, false, false);
+		advancedTrackerBox->Pack(latencybox);
+	}
+
+	void updateLatencyLabel()
+	{
+		const auto age = Latency::histogram(Latency::Stage::FrameAgeAtSend).summarize();
+		const auto frames = Latency::histogram(Latency::Stage::KinectFrameInterval).summarize();
+		if (age.count == 0)
+		{
+			LatencyLabel->SetText("Frame age at send: no data yet");
+			return;
+		}
+
+		std::stringstream S;
+		S.precision(1);
+		S << std::fixed << "Frame age at send: p50 " << age.p50 / 1000.0 << "ms, p99 " << age.p99 / 1000.0 <<
+			"ms    Kinect frames: p50 " << frames.p50 / 1000.0 << "ms";
+		LatencyLabel->SetText(S.str());
+	}
+
+	// Logs the client histograms, then asks one of our trackers for the driver's
+	// Any generic tracker may be asked, only ours answer with the report header
+	void dumpLatencyStats()
+	{
+		LOG(INFO) << "Client latency:\n" << Latency::report();
+
+		vr::IVRSystem* system = vr::VRSystem();
+		if (!system)
+			return;
+
+		const size_t headerLength = sizeof(Latency::k_driverReportHeader) - 1;
+		for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+		{
+			if (system->GetTrackedDeviceClass(i) != vr::TrackedDeviceClass_GenericTracker)
+				continue;
+
+			char response[2048] = {};
+			system->DriverDebugRequest(i, "latency", response, sizeof(response));
+			if (strncmp(response, Latency::k_driverReportHeader, headerLength) != 0)
+				continue;
+
+			LOG(INFO) << "Driver latency:\n" << response + headerLength;
+			return;
+		}
+		LOG(INFO) << "Driver latency: no K2VR trackers spawned";
 	}
 
 	void packElementsIntoCalibrationBox()
@@ -2309,30 +2419,36 @@ public:
 
 		VirtualHipUseHMDYawButton->GetSignal(sfg::ToggleButton::OnToggle).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.followHmdYawRotation = (VirtualHipUseHMDYawButton->IsActive());
 		});
 		VirtualHipUseHMDPitchButton->GetSignal(sfg::ToggleButton::OnToggle).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.followHmdPitchRotation = (VirtualHipUseHMDPitchButton->IsActive());
 		});
 		VirtualHipUseHMDRollButton->GetSignal(sfg::ToggleButton::OnToggle).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.followHmdRollRotation = (VirtualHipUseHMDRollButton->IsActive());
 		});
 
 		VirtualHipLockToHeadButton->GetSignal(sfg::RadioButton::OnToggle).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.positionAccountsForFootTrackers = !VirtualHipLockToHeadButton->IsActive();
 			}
 		);
 		VirtualHipLockToFeetButton->GetSignal(sfg::RadioButton::OnToggle).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.positionAccountsForFootTrackers = VirtualHipLockToFeetButton->IsActive();
 			}
 		);
 
 		AutoStartTrackers->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.astartt = !settings.astartt;
 			if (settings.astartt)
 			{
@@ -2346,6 +2462,7 @@ public:
 
 		AutoStartKinectToVR->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.astartk = !settings.astartk;
 			if (settings.astartk)
 			{
@@ -2359,6 +2476,7 @@ public:
 
 		AutoStartHeadTracking->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.astarth = !settings.astarth;
 			if (settings.astarth)
 			{
@@ -2372,6 +2490,7 @@ public:
 
 		AutoStartControllers->GetSignal(sfg::Widget::OnLeftClick).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.astarta = !settings.astarta;
 			if (settings.astarta)
 			{
@@ -2509,6 +2628,7 @@ public:
 
 		VirtualHipHeightFromHMDButton->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.heightFromHMD = VirtualHipHeightFromHMDButton->GetValue();
 				KinectSettings::huoffsets.v[0] = VirtualHipHeightFromHMDButton->GetValue();
 			}
@@ -2516,6 +2636,7 @@ public:
 
 		arduhx->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.hauoffset_s(0) = arduhx->GetValue();
 				KinectSettings::hauoffset.v[0] = arduhx->GetValue();
 				saveSettings();
@@ -2523,6 +2644,7 @@ public:
 		);
 		arduhy->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.hauoffset_s(1) = arduhy->GetValue();
 				KinectSettings::hauoffset.v[1] = arduhy->GetValue();
 				saveSettings();
@@ -2530,6 +2652,7 @@ public:
 		);
 		arduhz->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.hauoffset_s(2) = arduhz->GetValue();
 				KinectSettings::hauoffset.v[2] = arduhz->GetValue();
 				saveSettings();
@@ -2538,6 +2661,7 @@ public:
 
 		ardumx->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.mauoffset_s(0) = ardumx->GetValue();
 				KinectSettings::mauoffset.v[0] = ardumx->GetValue();
 				saveSettings();
@@ -2545,6 +2669,7 @@ public:
 		);
 		ardumy->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.mauoffset_s(1) = ardumy->GetValue();
 				KinectSettings::mauoffset.v[1] = ardumy->GetValue();
 				saveSettings();
@@ -2552,6 +2677,7 @@ public:
 		);
 		ardumz->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.mauoffset_s(2) = ardumz->GetValue();
 				KinectSettings::mauoffset.v[2] = ardumz->GetValue();
 				saveSettings();
@@ -2560,29 +2686,42 @@ public:
 
 		DegreeButton->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.hmdegree = DegreeButton->GetValue();
 				KinectSettings::hroffset = DegreeButton->GetValue();
 			}
 		);
 		TDegreeButton->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 			{
+				auto lock = lockSettings();
 				settings.tdegree = TDegreeButton->GetValue();
 				KinectSettings::cpoints = TDegreeButton->GetValue();
 			}
 		);
 		VirtualHipFollowHMDLean->GetSignal(sfg::ToggleButton::OnToggle).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.positionFollowsHMDLean = (VirtualHipFollowHMDLean->IsActive());
 		});
+		CorrectIMUYawDriftButton->GetSignal(sfg::ToggleButton::OnToggle).Connect([this]
+		{
+			// IMU rotated trackers pick it up when they're spawned, PSMove feet and waist right away
+			auto lock = lockSettings();
+			settings.correctIMUYawDrift = CorrectIMUYawDriftButton->IsActive();
+			KinectSettings::correctIMUYawDrift = settings.correctIMUYawDrift;
+			saveSettings();
+		});
 
 		VirtualHipSittingThreshold->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.sittingMaxHeightThreshold = VirtualHipSittingThreshold->GetValue();
 			KinectSettings::huoffsets.v[1] = VirtualHipSittingThreshold->GetValue();
 		});
 
 		VirtualHipLyingThreshold->GetSignal(sfg::SpinButton::OnValueChanged).Connect([this]
 		{
+			auto lock = lockSettings();
 			settings.lyingMaxHeightThreshold = VirtualHipLyingThreshold->GetValue();
 			KinectSettings::huoffsets.v[2] = VirtualHipLyingThreshold->GetValue();
 		});
@@ -2721,6 +2860,7 @@ public:
 
 						std::this_thread::sleep_for(std::chrono::seconds(1));
 						
+						auto lock = lockSettings();
 						if (!KinectSettings::isCalibrating)
 						{
 							settings.caliborigin = KinectSettings::calibration_origin;
@@ -2763,7 +2903,10 @@ public:
 						KinectSettings::ismatrixcalibrated = false;
 						KinectSettings::matrixes_calibrated = false;
 						KinectSettings::calibration_origin = Eigen::Vector3f(0, 0, 0);
-						settings.caliborigin = KinectSettings::calibration_origin;
+						{
+							auto lock = lockSettings();
+							settings.caliborigin = KinectSettings::calibration_origin;
+						}
 
 						for (int ipoint = 1; ipoint <= KinectSettings::cpoints; ipoint++)
 						{
@@ -2876,6 +3019,7 @@ public:
 							KinectSettings::calibration_rotation = ret_R;
 							KinectSettings::calibration_translation = ret_t;
 
+							auto lock = lockSettings();
 							settings.rcR_matT = ret_R;
 							settings.rcT_matT = ret_t;
 						}
@@ -2921,6 +3065,7 @@ public:
 								yaw = 2 * M_PI + yaw;
 							}
 
+							auto lock = lockSettings();
 							KinectSettings::calibration_trackers_yaw = glm::degrees(yaw);
 							settings.tryawst = glm::degrees(yaw);
 
@@ -2931,6 +3076,7 @@ public:
 							settings.caliborigin = KinectSettings::calibration_origin;
 						}
 
+						auto lock = lockSettings();
 						KinectSettings::matrixes_calibrated = true;
 						settings.rtcalib = true;
 
@@ -2986,6 +3132,7 @@ public:
 		ardumz->SetValue(settings.mauoffset_s(2));
 
 		VirtualHipFollowHMDLean->SetActive(settings.positionFollowsHMDLean);
+		CorrectIMUYawDriftButton->SetActive(settings.correctIMUYawDrift);
 
 		VirtualHipSittingThreshold->SetValue(settings.sittingMaxHeightThreshold);
 		VirtualHipLyingThreshold->SetValue(settings.lyingMaxHeightThreshold);
@@ -3069,6 +3216,10 @@ public:
 		virtualHipsBox->Pack(nicebox);
 	}
 
+	// Set when restarted after a crash with trackers up, see applyRecoveryState
+	void setRestoreTrackers(bool restore) { restoreTrackers = restore; }
+	bool getRestoreTrackers() const { return restoreTrackers; }
+
 private:
 	sf::Font mainGUIFont;
 	sfg::SFGUI sfguiRef;
@@ -3256,6 +3407,11 @@ private:
 	sfg::Button::Ptr StopPSMoveHandler = sfg::Button::Create("Stop PS Move Handler");
 	sfg::Label::Ptr PSMoveHandlerLabel = sfg::Label::Create("Status: Off");
 
+	bool restoreTrackers = false;
+
+	sfg::Label::Ptr LatencyLabel = sfg::Label::Create("Frame age at send: no data yet");
+	sfg::Button::Ptr DumpLatencyButton = sfg::Button::Create("Dump latency stats");
+
 	// Virtual Hips Box
 	sfg::CheckButton::Ptr VirtualHipUseHMDYawButton = sfg::CheckButton::Create("Yaw");
 	sfg::CheckButton::Ptr VirtualHipUseHMDPitchButton = sfg::CheckButton::Create("Pitch");
@@ -3267,6 +3423,7 @@ private:
 	sfg::SpinButton::Ptr VirtualHipHeightFromHMDButton = sfg::SpinButton::Create(
 		sfg::Adjustment::Create(VirtualHips::settings.heightFromHMD, -1000.f, 1000.f, 0.01f));
 	sfg::CheckButton::Ptr VirtualHipFollowHMDLean = sfg::CheckButton::Create("Follow HMD Lean");
+	sfg::CheckButton::Ptr CorrectIMUYawDriftButton = sfg::CheckButton::Create("Correct IMU yaw drift with the Kinect skeleton");
 
 	sfg::SpinButton::Ptr arduhx = sfg::SpinButton::Create(
 		sfg::Adjustment::Create(VirtualHips::settings.heightFromHMD, -1000.f, 1000.f, 0.01f));
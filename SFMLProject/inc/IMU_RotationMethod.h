@@ -33,6 +33,7 @@ public:
 		std::vector<KVR::KinectTrackedDevice>& v_trackers
 	) override
 	{
+		publishSkeletonBones(kinect);
 	}
 
 	void updateTrackers(
@@ -43,7 +44,8 @@ public:
 		for (int i = 0; i < v_trackers.size(); ++i)
 		{
 			auto& device = v_trackers[i];
-			if (device.rotationTrackingOption != KVR::JointRotationTrackingOption::IMU)
+			if (device.rotationTrackingOption != KVR::JointRotationTrackingOption::IMU
+				&& device.rotationTrackingOption != KVR::JointRotationTrackingOption::IMUWithSkeletonYaw)
 			{
 				continue;
 			}
@@ -55,8 +57,95 @@ public:
 			{
 				auto deviceData = TrackingPoolManager::getDeviceData(device.rotationDevice_gId);
 
-				device.setRotationForNextUpdate(deviceData.rotation);
+				vr::HmdQuaternion_t rotation = deviceData.rotation;
+				if (device.rotationTrackingOption == KVR::JointRotationTrackingOption::IMUWithSkeletonYaw)
+					rotation = correctYawDrift(kinect, device, rotation);
+
+				device.setRotationForNextUpdate(rotation);
+			}
+		}
+	}
+
+	// Bone the Kinect sees well on each body part a tracker is usually strapped to, out of KVR::JointMap::k_bones
+	static bool boneForRole(KVR::KinectDeviceRole role, KVR::KinectJointType& from, KVR::KinectJointType& to)
+	{
+		using namespace KVR::JointMap;
+		switch (role)
+		{
+		case KVR::KinectDeviceRole::LeftFoot:
+			return jointsOf(k_bones[k_legBones[0].foot], from, to);
+		case KVR::KinectDeviceRole::RightFoot:
+			return jointsOf(k_bones[k_legBones[1].foot], from, to);
+		case KVR::KinectDeviceRole::Hip:
+			// From the left hip to the right one
+			return jointsOf(KVR::JointBone{k_bones[k_hipBones[0]].to, k_bones[k_hipBones[1]].to}, from, to);
+		case KVR::KinectDeviceRole::LeftHand:
+			return jointsOf(k_bones[k_handBones[0]], from, to);
+		case KVR::KinectDeviceRole::RightHand:
+			return jointsOf(k_bones[k_handBones[1]], from, to);
+		default:
+			return false;
+		}
+	}
+
+private:
+	uint64_t publishedBonesFrame = 0;
+
+	static bool jointsOf(const KVR::JointBone& bone, KVR::KinectJointType& from, KVR::KinectJointType& to)
+	{
+		from = static_cast<KVR::KinectJointType>(bone.from);
+		to = static_cast<KVR::KinectJointType>(bone.to);
+		return true;
+	}
+
+	// Hands the bones of the PSMove feet and waist to sendipc, which corrects their yaw with them
+	void publishSkeletonBones(KinectHandlerBase& kinect)
+	{
+		const uint64_t frameId = KinectSettings::skeletonFrameId;
+		if (frameId == publishedBonesFrame)
+			return;
+		publishedBonesFrame = frameId;
+
+		static const KVR::KinectDeviceRole roles[3] = {
+			KVR::KinectDeviceRole::LeftFoot, KVR::KinectDeviceRole::RightFoot, KVR::KinectDeviceRole::Hip
+		};
+		KinectSettings::SkeletonBones bones{};
+		bones.frameId = frameId;
+		bones.frameSeconds = KinectSettings::skeletonFrameMicroseconds / 1e6;
+		for (int i = 0; i < 3; ++i)
+		{
+			KVR::KinectJointType from, to;
+			vr::HmdVector3d_t bone{0, 0, 0};
+			if (boneForRole(roles[i], from, to) && kinect.getBoneDirection(from, to, bone))
+			{
+				bones.valid[i] = true;
+				bones.direction[i] = vrmath::quaternionRotateVector(KinectSettings::kinectRepRotation, bone, false);
+			}
+		}
+		KinectSettings::skeletonBones.store(bones);
+	}
+
+	vr::HmdQuaternion_t correctYawDrift(
+		KinectHandlerBase& kinect,
+		KVR::KinectTrackedDevice& device,
+		const vr::HmdQuaternion_t& imuRotation
+	)
+	{
+		// The GUI loop runs faster than the Kinect, each skeleton frame may only count once
+		const uint64_t frameId = KinectSettings::skeletonFrameId;
+		if (frameId != device.yawDriftFrameId)
+		{
+			device.yawDriftFrameId = frameId;
+			KVR::KinectJointType from, to;
+			vr::HmdVector3d_t bone{0, 0, 0};
+			if (boneForRole(device.role, from, to) && kinect.getBoneDirection(from, to, bone))
+			{
+				// Into VR space like the joint positions, see applyKinectArrowCalibrationToTracker
+				bone = vrmath::quaternionRotateVector(KinectSettings::kinectRepRotation, bone, false);
+				device.yawDriftCorrector.addBoneDirection(imuRotation, bone, KinectSettings::skeletonFrameMicroseconds / 1e6);
 			}
 		}
+		// Between bone samples, or with the skeleton lost, the last correction keeps holding
+		return device.yawDriftCorrector.correct(imuRotation);
 	}
 };
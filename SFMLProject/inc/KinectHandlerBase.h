@@ -67,6 +67,10 @@ public:
 	virtual bool getFilteredJoint(KVR::KinectTrackedDevice device, vr::HmdVector3d_t& position,
 	                              vr::HmdQuaternion_t& rotation) { return false; };
 
+	// Direction from one joint to another in Kinect space, false when either isn't seen well enough
+	virtual bool getBoneDirection(KVR::KinectJointType from, KVR::KinectJointType to,
+	                              vr::HmdVector3d_t& direction) { return false; };
+
 	void update() override
 	{
 	};
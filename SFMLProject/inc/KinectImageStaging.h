@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define KINECT_IMAGE_SSE2 1
+#endif
+
+// Copy/convert kernels for camera frames, plain functions so they can be timed on synthetic frames
+namespace KinectImage
+{
+	// Row by row copy honouring the source pitch, one memcpy when the rows are packed
+	inline void copyRows(const uint8_t* src, int srcPitch, uint8_t* dst, int width, int height)
+	{
+		const size_t rowBytes = static_cast<size_t>(width) * 4;
+		if (static_cast<size_t>(srcPitch) == rowBytes)
+		{
+			std::memcpy(dst, src, rowBytes * height);
+			return;
+		}
+		for (int y = 0; y < height; ++y)
+			std::memcpy(dst + rowBytes * y, src + static_cast<size_t>(srcPitch) * y, rowBytes);
+	}
+
+	// Kinect colour frames are BGRX with an undefined X, SFML textures want RGBA
+	inline void swizzleBGRXToRGBA(const uint8_t* src, int srcPitch, uint8_t* dst, int width, int height)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* in = src + static_cast<size_t>(srcPitch) * y;
+			uint8_t* out = dst + static_cast<size_t>(width) * 4 * y;
+			int x = 0;
+
+#ifdef KINECT_IMAGE_SSE2
+			// Four pixels at a time: keep G, move B and R across, force alpha on
+			const __m128i greenMask = _mm_set1_epi32(0x0000FF00);
+			const __m128i lowMask = _mm_set1_epi32(0x000000FF);
+			const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i bgrx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4));
+				const __m128i red = _mm_and_si128(_mm_srli_epi32(bgrx, 16), lowMask);
+				const __m128i blue = _mm_slli_epi32(_mm_and_si128(bgrx, lowMask), 16);
+				const __m128i rgba = _mm_or_si128(_mm_or_si128(red, blue),
+				                                  _mm_or_si128(_mm_and_si128(bgrx, greenMask), alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), rgba);
+			}
+#endif
+
+			for (; x < width; ++x)
+			{
+				out[x * 4 + 0] = in[x * 4 + 2];
+				out[x * 4 + 1] = in[x * 4 + 1];
+				out[x * 4 + 2] = in[x * 4 + 0];
+				out[x * 4 + 3] = 255;
+			}
+		}
+	}
+}
+
+// Two RGBA frames: the camera side fills the back one and swaps it in,
+// the drawing side only uploads when the sequence number moved
+class KinectImageStaging
+{
+public:
+	void resize(int width, int height)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_width = width;
+		m_height = height;
+		for (auto& buffer : m_buffers)
+			buffer.assign(static_cast<size_t>(width) * height * 4, 0);
+		m_sequence = 0;
+	}
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+
+	// Writer side, only one thread may write at a time
+	void writeBGRX(const uint8_t* src, int srcPitch)
+	{
+		KinectImage::swizzleBGRXToRGBA(src, srcPitch, m_buffers[m_back].data(), m_width, m_height);
+		publish();
+	}
+
+	void writeRGBA(const uint8_t* src, int srcPitch)
+	{
+		KinectImage::copyRows(src, srcPitch, m_buffers[m_back].data(), m_width, m_height);
+		publish();
+	}
+
+	// Calls upload(pixels) with the newest frame if it wasn't handed out yet
+	template <typename Upload>
+	bool consume(uint64_t& lastSequence, Upload&& upload)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_sequence == lastSequence || m_sequence == 0)
+			return false;
+		upload(m_buffers[m_back ^ 1].data());
+		lastSequence = m_sequence;
+		return true;
+	}
+
+private:
+	void publish()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_back ^= 1;
+		++m_sequence;
+	}
+
+	std::mutex m_mutex;
+	std::vector<uint8_t> m_buffers[2];
+	int m_back = 0;
+	uint64_t m_sequence = 0;
+	int m_width = 0;
+	int m_height = 0;
+};
@@ -0,0 +1,348 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Joint ids shared by every tracking method, and compile time tables mapping them
+// onto the SDK joint indices. Free of the SDK headers, the handlers static_assert
+// that the mirrored indices below still match NuiSensor.h and Kinect.h
+namespace KVR
+{
+	const int KinectJointCount = 25;
+
+	enum class KinectJointType
+	{
+		SpineBase = 0,
+		SpineMid = 1,
+
+		Neck = 2,
+		//Not in v1
+
+		Head = 3,
+		ShoulderLeft = 4,
+		ElbowLeft = 5,
+		WristLeft = 6,
+		HandLeft = 7,
+		ShoulderRight = 8,
+		ElbowRight = 9,
+		WristRight = 10,
+		HandRight = 11,
+		HipLeft = 12,
+		KneeLeft = 13,
+		AnkleLeft = 14,
+		FootLeft = 15,
+		HipRight = 16,
+		KneeRight = 17,
+		AnkleRight = 18,
+		FootRight = 19,
+		SpineShoulder = 20,
+
+		HandTipLeft = 21,
+		//Not in v1
+		ThumbLeft = 22,
+		//Not in v1
+		HandTipRight = 23,
+		//Not in v1
+		ThumbRight = 24,
+		//Not in v1
+
+		INVALID = 25,
+		// Indicates device doesn't use Kinect joint
+	};
+
+	// Bone between two joints, indexed in whichever joint space the table is for
+	struct JointBone
+	{
+		int from;
+		int to;
+	};
+
+	namespace JointMap
+	{
+		// NUI_SKELETON_POSITION_INDEX, same values as NuiSensor.h
+		enum V1Joint : uint8_t
+		{
+			V1_HipCenter = 0,
+			V1_Spine,
+			V1_ShoulderCenter,
+			V1_Head,
+			V1_ShoulderLeft,
+			V1_ElbowLeft,
+			V1_WristLeft,
+			V1_HandLeft,
+			V1_ShoulderRight,
+			V1_ElbowRight,
+			V1_WristRight,
+			V1_HandRight,
+			V1_HipLeft,
+			V1_KneeLeft,
+			V1_AnkleLeft,
+			V1_FootLeft,
+			V1_HipRight,
+			V1_KneeRight,
+			V1_AnkleRight,
+			V1_FootRight,
+			V1_Count
+		};
+
+		// Slots for every joint plus INVALID, which lands on the joint the old switch fell back to
+		constexpr size_t k_tableSize = KinectJointCount + 1;
+
+		struct JointPair
+		{
+			KinectJointType joint;
+			uint8_t sdkJoint;
+		};
+
+		constexpr JointPair k_v1Pairs[] = {
+			{KinectJointType::SpineBase, V1_HipCenter},
+			{KinectJointType::SpineMid, V1_Spine},
+			{KinectJointType::Head, V1_Head},
+			{KinectJointType::ShoulderLeft, V1_ShoulderLeft},
+			{KinectJointType::ShoulderRight, V1_ShoulderRight},
+			{KinectJointType::SpineShoulder, V1_ShoulderCenter},
+			{KinectJointType::ElbowLeft, V1_ElbowLeft},
+			{KinectJointType::WristLeft, V1_WristLeft},
+			{KinectJointType::HandLeft, V1_HandLeft},
+			{KinectJointType::ElbowRight, V1_ElbowRight},
+			{KinectJointType::WristRight, V1_WristRight},
+			{KinectJointType::HandRight, V1_HandRight},
+			{KinectJointType::HipLeft, V1_HipLeft},
+			{KinectJointType::HipRight, V1_HipRight},
+			{KinectJointType::KneeLeft, V1_KneeLeft},
+			{KinectJointType::KneeRight, V1_KneeRight},
+			{KinectJointType::AnkleLeft, V1_AnkleLeft},
+			{KinectJointType::AnkleRight, V1_AnkleRight},
+			{KinectJointType::FootLeft, V1_FootLeft},
+			{KinectJointType::FootRight, V1_FootRight},
+
+			// No 1:1 v1 representation, refer to the skeleton images from Microsoft for diffs between v1 and 2
+			{KinectJointType::Neck, V1_ShoulderCenter},
+			{KinectJointType::HandTipLeft, V1_HandLeft},
+			{KinectJointType::HandTipRight, V1_HandRight},
+			{KinectJointType::ThumbLeft, V1_HandLeft},
+			{KinectJointType::ThumbRight, V1_HandRight},
+
+			{KinectJointType::INVALID, V1_WristLeft},
+		};
+
+		template <size_t N>
+		constexpr bool coversEveryJointOnce(const JointPair (&pairs)[N], int sdkJointCount)
+		{
+			for (size_t joint = 0; joint < k_tableSize; ++joint)
+			{
+				int hits = 0;
+				for (size_t i = 0; i < N; ++i)
+				{
+					if (static_cast<size_t>(pairs[i].joint) == joint)
+						++hits;
+					if (pairs[i].sdkJoint >= sdkJointCount)
+						return false;
+				}
+				if (hits != 1)
+					return false;
+			}
+			return true;
+		}
+
+		template <size_t N>
+		constexpr std::array<uint8_t, k_tableSize> makeTable(const JointPair (&pairs)[N])
+		{
+			std::array<uint8_t, k_tableSize> table{};
+			for (size_t i = 0; i < N; ++i)
+				table[static_cast<size_t>(pairs[i].joint)] = pairs[i].sdkJoint;
+			return table;
+		}
+
+		constexpr std::array<uint8_t, k_tableSize> makeV2Table()
+		{
+			std::array<uint8_t, k_tableSize> table{};
+			for (size_t joint = 0; joint < KinectJointCount; ++joint)
+				table[joint] = static_cast<uint8_t>(joint);
+			table[static_cast<size_t>(KinectJointType::INVALID)] = static_cast<uint8_t>(KinectJointType::WristLeft);
+			return table;
+		}
+
+		static_assert(coversEveryJointOnce(k_v1Pairs, V1_Count), "Every KinectJointType needs exactly one v1 joint");
+
+		constexpr std::array<uint8_t, k_tableSize> k_toV1 = makeTable(k_v1Pairs);
+		constexpr std::array<uint8_t, k_tableSize> k_toV2 = makeV2Table();
+
+		constexpr int toV1(KinectJointType joint) { return k_toV1[static_cast<size_t>(joint)]; }
+		constexpr int toV2(KinectJointType joint) { return k_toV2[static_cast<size_t>(joint)]; }
+
+		constexpr JointBone bone(KinectJointType from, KinectJointType to)
+		{
+			return JointBone{static_cast<int>(from), static_cast<int>(to)};
+		}
+
+		// Skeleton topology in KinectJointType ids, the single list every bone walk starts from
+		// Kinect.h JointType is the KinectJointType order, so these are the v2 bones as they are
+		constexpr JointBone k_bones[] = {
+			// Torso
+			bone(KinectJointType::Head, KinectJointType::Neck),
+			bone(KinectJointType::Neck, KinectJointType::SpineShoulder),
+			bone(KinectJointType::SpineShoulder, KinectJointType::SpineMid),
+			bone(KinectJointType::SpineMid, KinectJointType::SpineBase),
+			bone(KinectJointType::SpineShoulder, KinectJointType::ShoulderRight),
+			bone(KinectJointType::SpineShoulder, KinectJointType::ShoulderLeft),
+			bone(KinectJointType::SpineBase, KinectJointType::HipRight),
+			bone(KinectJointType::SpineBase, KinectJointType::HipLeft),
+
+			// Right Arm
+			bone(KinectJointType::ShoulderRight, KinectJointType::ElbowRight),
+			bone(KinectJointType::ElbowRight, KinectJointType::WristRight),
+			bone(KinectJointType::WristRight, KinectJointType::HandRight),
+			bone(KinectJointType::HandRight, KinectJointType::HandTipRight),
+			bone(KinectJointType::WristRight, KinectJointType::ThumbRight),
+
+			// Left Arm
+			bone(KinectJointType::ShoulderLeft, KinectJointType::ElbowLeft),
+			bone(KinectJointType::ElbowLeft, KinectJointType::WristLeft),
+			bone(KinectJointType::WristLeft, KinectJointType::HandLeft),
+			bone(KinectJointType::HandLeft, KinectJointType::HandTipLeft),
+			bone(KinectJointType::WristLeft, KinectJointType::ThumbLeft),
+
+			// Right Leg
+			bone(KinectJointType::HipRight, KinectJointType::KneeRight),
+			bone(KinectJointType::KneeRight, KinectJointType::AnkleRight),
+			bone(KinectJointType::AnkleRight, KinectJointType::FootRight),
+			// Left Leg
+			bone(KinectJointType::HipLeft, KinectJointType::KneeLeft),
+			bone(KinectJointType::KneeLeft, KinectJointType::AnkleLeft),
+			bone(KinectJointType::AnkleLeft, KinectJointType::FootLeft),
+		};
+
+		constexpr size_t k_boneCount = sizeof(k_bones) / sizeof(k_bones[0]);
+
+		// Every joint reached by at most one bone, and one bone less than there are joints
+		constexpr bool formsTree()
+		{
+			int parents[KinectJointCount] = {};
+			for (size_t b = 0; b < k_boneCount; ++b)
+			{
+				if (k_bones[b].from < 0 || k_bones[b].from >= KinectJointCount ||
+					k_bones[b].to < 0 || k_bones[b].to >= KinectJointCount)
+					return false;
+				if (++parents[k_bones[b].to] > 1)
+					return false;
+			}
+			return k_boneCount == KinectJointCount - 1;
+		}
+
+		static_assert(formsTree(), "Bone table has to connect every joint once");
+
+		// Index of the bone from -> to in k_bones, k_boneCount if there is none
+		constexpr size_t findBone(KinectJointType from, KinectJointType to)
+		{
+			for (size_t b = 0; b < k_boneCount; ++b)
+			{
+				if (k_bones[b].from == static_cast<int>(from) && k_bones[b].to == static_cast<int>(to))
+					return b;
+			}
+			return k_boneCount;
+		}
+
+		// The k_bones entries rotation estimation and filtering look along, left then right
+		struct LegBones
+		{
+			size_t shin;
+			size_t foot;
+		};
+
+		constexpr LegBones k_legBones[2] = {
+			{findBone(KinectJointType::KneeLeft, KinectJointType::AnkleLeft), findBone(KinectJointType::AnkleLeft, KinectJointType::FootLeft)},
+			{findBone(KinectJointType::KneeRight, KinectJointType::AnkleRight), findBone(KinectJointType::AnkleRight, KinectJointType::FootRight)},
+		};
+		constexpr size_t k_handBones[2] = {
+			findBone(KinectJointType::WristLeft, KinectJointType::HandLeft),
+			findBone(KinectJointType::WristRight, KinectJointType::HandRight),
+		};
+		// No bone runs between the hips, their direction is across the ends of these two
+		constexpr size_t k_hipBones[2] = {
+			findBone(KinectJointType::SpineBase, KinectJointType::HipLeft),
+			findBone(KinectJointType::SpineBase, KinectJointType::HipRight),
+		};
+
+		constexpr bool legsConnect()
+		{
+			for (size_t side = 0; side < 2; ++side)
+			{
+				const LegBones& leg = k_legBones[side];
+				if (leg.shin == k_boneCount || leg.foot == k_boneCount || k_bones[leg.shin].to != k_bones[leg.foot].from)
+					return false;
+			}
+			return true;
+		}
+
+		static_assert(legsConnect(), "Every leg needs a shin ending where its foot bone starts");
+		static_assert(k_handBones[0] < k_boneCount && k_handBones[1] < k_boneCount, "Hand bones missing from k_bones");
+		static_assert(k_hipBones[0] < k_boneCount && k_hipBones[1] < k_boneCount, "Hip bones missing from k_bones");
+
+		// The joints at the end of the foot bones, the noisiest ones the sensors track
+		constexpr bool isFoot(KinectJointType joint)
+		{
+			for (size_t side = 0; side < 2; ++side)
+			{
+				if (k_bones[k_legBones[side].foot].to == static_cast<int>(joint))
+					return true;
+			}
+			return false;
+		}
+
+		// A k_bones entry in the joint indices of the given table
+		template <size_t TableSize>
+		constexpr JointBone sdkBone(const std::array<uint8_t, TableSize>& table, size_t b)
+		{
+			return JointBone{table[k_bones[b].from], table[k_bones[b].to]};
+		}
+
+		// Bones as the given joint table sees them, dropping the ones that collapse into
+		// a single joint or repeat an earlier bone (v1 has no neck, thumbs or hand tips)
+		template <size_t TableSize>
+		constexpr bool keepsBone(const std::array<uint8_t, TableSize>& table, size_t b)
+		{
+			const int from = table[k_bones[b].from];
+			const int to = table[k_bones[b].to];
+			if (from == to)
+				return false;
+			for (size_t earlier = 0; earlier < b; ++earlier)
+			{
+				if (table[k_bones[earlier].from] == from && table[k_bones[earlier].to] == to)
+					return false;
+			}
+			return true;
+		}
+
+		template <size_t TableSize>
+		constexpr size_t mappedBoneCount(const std::array<uint8_t, TableSize>& table)
+		{
+			size_t count = 0;
+			for (size_t b = 0; b < k_boneCount; ++b)
+			{
+				if (keepsBone(table, b))
+					++count;
+			}
+			return count;
+		}
+
+		template <size_t Count, size_t TableSize>
+		constexpr std::array<JointBone, Count> mapBones(const std::array<uint8_t, TableSize>& table)
+		{
+			std::array<JointBone, Count> bones{};
+			size_t count = 0;
+			for (size_t b = 0; b < k_boneCount; ++b)
+			{
+				if (keepsBone(table, b))
+					bones[count++] = sdkBone(table, b);
+			}
+			return bones;
+		}
+
+		constexpr auto k_v1Bones = mapBones<mappedBoneCount(k_toV1)>(k_toV1);
+		constexpr auto k_v2Bones = mapBones<mappedBoneCount(k_toV2)>(k_toV2);
+
+		static_assert(k_v1Bones.size() == V1_Count - 1, "v1 bones have to connect all 20 v1 joints");
+		static_assert(k_v2Bones.size() == k_boneCount, "v2 keeps every bone");
+	}
+}
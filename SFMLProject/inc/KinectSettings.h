@@ -9,8 +9,10 @@
 #include <glm/detail/type_vec2.hpp>
 #include <string>
 #include <sstream>
+#include <atomic>
 #include <Eigen/Geometry>
 #include "KinectJoint.h"
+#include "SeqLock.h"
 #include <PSMoveClient_CAPI.h>
 
 enum KinectVersion
@@ -116,8 +118,26 @@ namespace KinectSettings
 
 	static std::vector<K2VR_PSMoveData> KVR_PSMoves;
 	extern bool isCalibrating, isKinectPSMS;
+
+	// Latest skeleton frame, sent along with the poses so the driver can measure end to end latency
+	extern std::atomic<uint64_t> skeletonFrameId, skeletonFrameMicroseconds;
+	void markSkeletonFrame();
+
+	// Kinect bones of the PSMove left foot, right foot and waist in VR space, for their yaw correction in sendipc
+	// Published once per skeleton frame from the GUI loop, read by the IPC thread
+	struct SkeletonBones
+	{
+		uint64_t frameId;
+		double frameSeconds; // Steady clock, like skeletonFrameMicroseconds
+		bool valid[3];
+		vr::HmdVector3d_t direction[3];
+	};
+
+	extern SeqLock<SkeletonBones> skeletonBones;
 	extern int K2Drivercode, kinectVersion;
-	extern PSMPSMove right_move_controller, left_move_controller, left_foot_psmove, right_foot_psmove, waist_psmove, atamamove;
+	// Written by the PSMove handler, read by the IPC thread
+	extern SeqLock<PSMPSMove> right_move_controller, left_move_controller, left_foot_psmove, right_foot_psmove, waist_psmove,
+	                          atamamove;
 	extern glm::quat left_tracker_rot, right_tracker_rot, waist_tracker_rot;
 	extern glm::quat trackerSoftRot[2]; //Software-calculated
 	extern bool isGripPressed[2], isTriggerPressed[2]; //0L, 1R
@@ -126,6 +146,7 @@ namespace KinectSettings
 	extern bool isSkeletonDrawn;
 	extern bool ignoreInferredPositions;
 	extern bool ignoreRotationSmoothing;
+	extern bool correctIMUYawDrift; // Take IMU yaw drift out with the Kinect bones, PSMove feet/waist and IMU rotated trackers
 	extern std::string opt;
 	extern KVR::KinectJointType leftFootJointWithRotation;
 	extern KVR::KinectJointType rightFootJointWithRotation;
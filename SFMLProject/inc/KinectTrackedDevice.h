@@ -12,6 +12,7 @@
 #include <SFML/System/Vector3.hpp>
 #include <openvr_math.h>
 #include "VectorMath.h"
+#include "YawDriftCorrector.h"
 
 namespace KVR
 {
@@ -62,7 +63,8 @@ namespace KVR
 	{
 		Skeleton,
 		IMU,
-		Headlook
+		Headlook,
+		IMUWithSkeletonYaw // IMU rotation, yaw drift corrected by the Kinect bone of the role
 	};
 
 
@@ -441,6 +443,9 @@ namespace KVR
 		uint32_t positionDevice_gId = 404;
 		uint32_t rotationDevice_gId = 404;
 
+		YawDriftCorrector yawDriftCorrector; // Only used with JointRotationTrackingOption::IMUWithSkeletonYaw
+		uint64_t yawDriftFrameId = 0; // Skeleton frame last fed to yawDriftCorrector
+
 
 		KinectDeviceRole role;
 	private:
@@ -0,0 +1,234 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Per-stage latency histograms for the tracking path
+// Recording is a couple of relaxed atomic adds, so timers can stay in hot loops
+// Both the client and the driver keep their own set, each process only fills the stages it runs
+namespace Latency
+{
+	enum class Stage
+	{
+		KinectFrameInterval, // Time between two skeleton frames
+		SkeletonFilter,
+		TrackerTransform, // Filters, orientation options and calibration in the IPC thread
+		IpcEncode,
+		PipeWrite,
+		FrameAgeAtSend, // Kinect frame arrival -> packet written
+		DriverDecode,
+		PoseUpdate, // TrackedDevicePoseUpdated call
+		EndToEnd, // Kinect frame arrival -> first TrackedDevicePoseUpdated with it
+		Count
+	};
+
+	inline const char* stageName(Stage stage)
+	{
+		switch (stage)
+		{
+		case Stage::KinectFrameInterval: return "Kinect frame interval";
+		case Stage::SkeletonFilter: return "Skeleton filter";
+		case Stage::TrackerTransform: return "Tracker transform";
+		case Stage::IpcEncode: return "IPC encode";
+		case Stage::PipeWrite: return "Pipe write";
+		case Stage::FrameAgeAtSend: return "Frame age at send";
+		case Stage::DriverDecode: return "Driver decode";
+		case Stage::PoseUpdate: return "Pose update";
+		case Stage::EndToEnd: return "End to end";
+		default: return "Unknown";
+		}
+	}
+
+	// steady_clock is QueryPerformanceCounter on Windows, so stamps compare across processes
+	inline uint64_t nowMicroseconds()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	// Log-linear buckets in microseconds: exact below 16us, then 8 buckets per power of two
+	// (within 12.5%) up to ~67s, anything longer lands in the last bucket
+	class Histogram
+	{
+	public:
+		static constexpr int k_linearBuckets = 16;
+		static constexpr int k_subBucketBits = 3;
+		static constexpr int k_maxExponent = 26;
+		static constexpr int k_bucketCount =
+			k_linearBuckets + (k_maxExponent - 4 + 1) * (1 << k_subBucketBits);
+
+		struct Summary
+		{
+			uint64_t count = 0;
+			uint64_t p50 = 0;
+			uint64_t p99 = 0;
+			uint64_t max = 0;
+		};
+
+		void record(uint64_t microseconds)
+		{
+			m_buckets[bucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+			m_count.fetch_add(1, std::memory_order_relaxed);
+
+			uint64_t max = m_max.load(std::memory_order_relaxed);
+			while (microseconds > max &&
+				!m_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		// Percentiles report the upper edge of their bucket
+		Summary summarize() const
+		{
+			uint32_t buckets[k_bucketCount];
+			Summary summary;
+			for (int i = 0; i < k_bucketCount; ++i)
+			{
+				buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+				summary.count += buckets[i];
+			}
+			summary.max = m_max.load(std::memory_order_relaxed);
+			if (summary.count == 0)
+				return summary;
+
+			const uint64_t p50Rank = (summary.count * 50 + 99) / 100;
+			const uint64_t p99Rank = (summary.count * 99 + 99) / 100;
+			uint64_t seen = 0;
+			for (int i = 0; i < k_bucketCount; ++i)
+			{
+				const uint64_t before = seen;
+				seen += buckets[i];
+				if (before < p50Rank && seen >= p50Rank)
+					summary.p50 = bucketUpperBound(i);
+				if (before < p99Rank && seen >= p99Rank)
+				{
+					summary.p99 = bucketUpperBound(i);
+					break;
+				}
+			}
+			// The last bucket is open ended
+			if (summary.p50 > summary.max)
+				summary.p50 = summary.max;
+			if (summary.p99 > summary.max)
+				summary.p99 = summary.max;
+			return summary;
+		}
+
+		void reset()
+		{
+			for (auto& bucket : m_buckets)
+				bucket.store(0, std::memory_order_relaxed);
+			m_count.store(0, std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static int highestBit(uint64_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return static_cast<int>(index);
+#else
+			return 63 - __builtin_clzll(value);
+#endif
+		}
+
+		static int bucketIndex(uint64_t value)
+		{
+			if (value < k_linearBuckets)
+				return static_cast<int>(value);
+
+			int exponent = highestBit(value);
+			if (exponent > k_maxExponent)
+				return k_bucketCount - 1;
+			const int subBucket = static_cast<int>(value >> (exponent - k_subBucketBits)) & ((1 << k_subBucketBits) - 1);
+			return k_linearBuckets + (exponent - 4) * (1 << k_subBucketBits) + subBucket;
+		}
+
+		static uint64_t bucketUpperBound(int index)
+		{
+			if (index < k_linearBuckets)
+				return static_cast<uint64_t>(index);
+
+			const int exponent = 4 + (index - k_linearBuckets) / (1 << k_subBucketBits);
+			const int subBucket = (index - k_linearBuckets) % (1 << k_subBucketBits);
+			const uint64_t lower = static_cast<uint64_t>((1 << k_subBucketBits) + subBucket) << (exponent - k_subBucketBits);
+			return lower + (1ull << (exponent - k_subBucketBits)) - 1;
+		}
+
+		std::atomic<uint32_t> m_buckets[k_bucketCount]{};
+		std::atomic<uint64_t> m_count{0};
+		std::atomic<uint64_t> m_max{0};
+	};
+
+	inline Histogram& histogram(Stage stage)
+	{
+		static Histogram histograms[static_cast<int>(Stage::Count)];
+		return histograms[static_cast<int>(stage)];
+	}
+
+	inline void record(Stage stage, uint64_t microseconds)
+	{
+		histogram(stage).record(microseconds);
+	}
+
+	// Records the lifetime of the scope into a stage
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(Stage stage)
+			: m_stage(stage),
+			  m_start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~ScopedTimer()
+		{
+			record(m_stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - m_start).count()));
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		Stage m_stage;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	// One line per stage that has samples
+	inline std::string report()
+	{
+		std::string text;
+		char line[160];
+		for (int i = 0; i < static_cast<int>(Stage::Count); ++i)
+		{
+			const Histogram::Summary summary = histogram(static_cast<Stage>(i)).summarize();
+			if (summary.count == 0)
+				continue;
+
+			std::snprintf(line, sizeof(line), "%s: p50 %.2fms, p99 %.2fms, max %.2fms (%llu samples)\n",
+				stageName(static_cast<Stage>(i)),
+				summary.p50 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0,
+				static_cast<unsigned long long>(summary.count));
+			text += line;
+		}
+		return text;
+	}
+
+	// Our trackers start their "latency" debug response with this, other drivers' trackers answer without it
+	constexpr char k_driverReportHeader[] = "K2VR driver latency\n";
+
+	inline void resetAll()
+	{
+		for (int i = 0; i < static_cast<int>(Stage::Count); ++i)
+			histogram(static_cast<Stage>(i)).reset();
+	}
+}
@@ -4,6 +4,7 @@
 #include <iomanip>
 #include <chrono>
 #include <cstring>
+#include <memory>
 #include <thread>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -24,15 +25,13 @@
 #include <openvr.h>
 
 #include "DeviceHandler.h"
+#include "PSMoveLedEffects.h"
+#include "PSMovePoller.h"
 #include "TrackingPoolManager.h"
 #include "TrackedDeviceInputData.h"
 
 #define M_PI_2 1.57079632679
 
-int r = 0;
-int g = 0;
-int b = 0;
-
 class PSMoveHandler : public DeviceHandler
 {
 	// Heavily based off of the example template program
@@ -84,69 +83,11 @@ public:
 		if (on)
 			rumbleIntensity = .9f;
 
-		PSM_SetControllerRumble(controllerId, PSMControllerRumbleChannel_All, rumbleIntensity);
-		LOG(INFO) << "Set rumble identify to " << on << "for controller " << controllerId;
-	}
-
-	static void flashRainbow(int id)
-	{
-		int red, green, blue;
-		for (int color = 0; color < 6; color++)
+		m_poller->post([controllerId, rumbleIntensity]
 		{
-			switch (color)
-			{
-			case 0:
-				red = 255;
-				green = 0;
-				blue = 0;
-				break;
-
-			case 1:
-				red = 255;
-				green = 255;
-				blue = 0;
-				break;
-
-			case 2:
-				red = 0;
-				green = 255;
-				blue = 0;
-				break;
-
-			case 3:
-				red = 0;
-				green = 255;
-				blue = 255;
-				break;
-
-			case 4:
-				red = 0;
-				green = 0;
-				blue = 255;
-				break;
-
-			case 5:
-				red = 255;
-				green = 0;
-				blue = 255;
-				break;
-			}
-			while (r != red || g != green || b != blue)
-			{
-				if (r < red) r += 1;
-				if (r > red) r -= 1;
-
-				if (g < green) g += 1;
-				if (g > green) g -= 1;
-
-				if (b < blue) b += 1;
-				if (b > blue) b -= 1;
-
-				PSM_SetControllerLEDOverrideColor(id, r, g, b);
-				std::this_thread::sleep_for(std::chrono::microseconds(1));
-			}
-		}
-		PSM_SetControllerLEDOverrideColor(id, 0, 0, 0);
+			PSM_SetControllerRumble(controllerId, PSMControllerRumbleChannel_All, rumbleIntensity);
+		});
+		LOG(INFO) << "Set rumble identify to " << on << "for controller " << controllerId;
 	}
 
 	void flashControllerBulb(int controllerId, bool on)
@@ -164,7 +105,7 @@ public:
 			r = 0;
 		}
 
-		PSM_SetControllerLEDOverrideColor(controllerId, r, g, b);
+		m_ledEffects->setColor(controllerId, r, g, b);
 	}
 
 	std::string PSMResultToString(PSMResult result)
@@ -197,6 +138,14 @@ public:
 
 	void shutdown() override
 	{
+		// Nothing may touch the client while it's being torn down
+		// The LED-off commands are queued first, the poller sends them before it stops
+		m_ledEffects->stop();
+		m_poller->stop();
+		m_poller->copyLists(controllerList, trackerList);
+		m_pendingAlignment.active = false;
+		LOG(INFO) << "PSMove handler worst update on the tracking loop: " << m_worstUpdateMicroseconds / 1000.0 << "ms";
+
 		if (!PSM_GetIsConnected())
 		{
 			LOG(ERROR) << "Attempted PSM shutdown on disconnected PSMoveService!";
@@ -237,9 +186,10 @@ public:
 
 	vr::HmdQuaternion_t getMoveOrientation(int localControllerId)
 	{
-		if (localControllerId < v_controllers.size())
+		PSMController controller;
+		if (localControllerId < v_controllers.size() && readSnapshot(v_controllers[localControllerId], controller))
 		{
-			auto controllerState = v_controllers[localControllerId].controller->ControllerState.PSMoveState;
+			auto controllerState = controller.ControllerState.PSMoveState;
 			if (controllerState.bIsOrientationValid)
 			{
 				vr::HmdQuaternion_t q;
@@ -258,9 +208,10 @@ public:
 
 	vr::HmdVector3d_t getMovePosition(int localControllerId)
 	{
-		if (localControllerId < v_controllers.size())
+		PSMController controller;
+		if (localControllerId < v_controllers.size() && readSnapshot(v_controllers[localControllerId], controller))
 		{
-			auto controllerState = v_controllers[localControllerId].controller->ControllerState.PSMoveState;
+			auto controllerState = controller.ControllerState.PSMoveState;
 			if (controllerState.bIsPositionValid)
 			{
 				vr::HmdVector3d_t pos;
@@ -411,7 +362,7 @@ public:
 		return yaw_quaternion;
 	}
 
-	void alignPSMoveAndHMDTrackingSpace(PSMController* controller)
+	void alignPSMoveAndHMDTrackingSpace(const PSMController& controller)
 	{
 		if (m_bDisableHMDAlignmentGesture)
 		{
@@ -426,7 +377,7 @@ public:
 		// Make the HMD orientation only contain a yaw
 		hmd_pose_meters.Orientation = ExtractHMDYawQuaternion(hmd_pose_meters.Orientation);
 
-		auto m_PSMControllerType = controller->ControllerType;
+		auto m_PSMControllerType = controller.ControllerType;
 		// We have the transform of the HMD in world space. 
 		// However the HMD and the controller aren't quite aligned depending on the controller type:
 		PSMQuatf controllerOrientationInHmdSpaceQuat = *k_psm_quaternion_identity;
@@ -464,11 +415,13 @@ public:
 	driver_pose_to_world_pose = psmove_pose_meters.inverse() * controller_world_space_pose
 	*/
 
-		// Get the current pose from the controller view instead of using the driver's cached
-		// value because the user may have triggered a pose reset, in which case the driver's
-		// cached pose might not yet be up to date by the time this callback is triggered.
+		// Use the latest published snapshot of the controller view, the polling thread
+		// owns the client so PSM_GetControllerPose can't be called from here
 		PSMPosef controller_pose_meters = *k_psm_pose_identity;
-		PSM_GetControllerPose(controller->ControllerID, &controller_pose_meters);
+		if (m_PSMControllerType == PSMController_Move)
+			controller_pose_meters = controller.ControllerState.PSMoveState.Pose;
+		else if (m_PSMControllerType == PSMController_Virtual)
+			controller_pose_meters = controller.ControllerState.VirtualController.Pose;
 
 		// PSMove Position is in cm, but OpenVR stores position in meters
 		controller_pose_meters.Position =
@@ -522,7 +475,7 @@ public:
 
 	vr::HmdVector3d_t getPSMovePosition(int controllerId)
 	{
-		const PSMPSMove& view = v_controllers[controllerId].controller->ControllerState.PSMoveState;
+		const PSMPSMove& view = v_controllers[controllerId].controller.ControllerState.PSMoveState;
 		// Set position
 		vr::HmdVector3d_t raw_position{};
 
@@ -538,7 +491,7 @@ public:
 
 	vr::HmdQuaternion_t getPSMoveRotation(int controllerId)
 	{
-		const PSMPSMove& view = v_controllers[controllerId].controller->ControllerState.PSMoveState;
+		const PSMPSMove& view = v_controllers[controllerId].controller.ControllerState.PSMoveState;
 
 		vr::HmdQuaternion_t qRotation{};
 
@@ -632,12 +585,12 @@ public:
 
 	vr::DriverPose_t getDriverPose(int controllerId)
 	{
-		auto controller = v_controllers[controllerId].controller;
-		switch (controller->ControllerType)
+		const auto& controller = v_controllers[controllerId].controller;
+		switch (controller.ControllerType)
 		{
 		case PSMController_Virtual:
 			{
-				const PSMVirtualController& view = v_controllers[controllerId].controller->ControllerState.
+				const PSMVirtualController& view = v_controllers[controllerId].controller.ControllerState.
 				                                                               VirtualController;
 				auto const& pos = view.Pose.Position;
 				auto const& rot = view.Pose.Orientation;
@@ -648,7 +601,7 @@ public:
 			}
 		case PSMController_Move:
 			{
-				const PSMPSMove& view = v_controllers[controllerId].controller->ControllerState.PSMoveState;
+				const PSMPSMove& view = v_controllers[controllerId].controller.ControllerState.PSMoveState;
 				const auto& pos = view.Pose.Position;
 				const auto& rot = view.Pose.Orientation;
 				const auto& physics = view.PhysicsData;
@@ -695,7 +648,7 @@ public:
 
 		m_Pose.result = vr::TrackingResult_Running_OK;
 
-		m_Pose.deviceIsConnected = v_controllers[controllerId].controller->IsConnected;
+		m_Pose.deviceIsConnected = v_controllers[controllerId].controller.IsConnected;
 
 		// These should always be false from any modern driver.  These are for Oculus DK1-like
 		// rotation-only tracking.  Support for that has likely rotted in vrserver.
@@ -861,6 +814,10 @@ private:
 						success = false;
 					}
 				}
+				// From here on the client belongs to the polling thread
+				m_poller->start(controllerList, trackerList);
+				m_listGeneration = m_poller->copyLists(controllerList, trackerList);
+
 				rebuildPSMovesForPool();
 				rebuildPSEyesForPool();
 			}
@@ -883,11 +840,36 @@ private:
 
 	void update()
 	{
-		rebuildPSMoveLists();
+		if (!m_poller->isPolling())
+		{
+			m_keepRunning = false;
+			return;
+		}
+		const auto updateStart = std::chrono::steady_clock::now();
+		m_keepRunning = m_poller->isConnected();
+
+		// Checked before the snapshots are read, so they are at least as new as the answered reset
+		const bool alignmentReady = m_pendingAlignment.active &&
+			(m_poller->hasPublishedAfterReset(m_pendingAlignment.resetTicket) ||
+				updateStart - m_pendingAlignment.requested > k_alignmentResetTimeout);
+
+		// Lists are refreshed on the polling thread, only the pool has to be rebuilt here
+		if (m_poller->listGeneration() != m_listGeneration)
+		{
+			m_listGeneration = m_poller->copyLists(controllerList, trackerList);
+			rebuildPSMovesForPool();
+			rebuildPSEyesForPool();
+		}
 
 		// Get the controller data for each controller
 		if (m_keepRunning)
 		{
+			for (MoveWrapper_PSM& wrapper : v_controllers)
+			{
+				readSnapshot(wrapper, wrapper.controller);
+			}
+			if (alignmentReady)
+				finishHMDAlignment();
 			processKeyInputs();
 			for (int i = 0; i < v_controllers.size(); ++i)
 			{
@@ -922,6 +904,28 @@ private:
 				TrackingPoolManager::updatePoolWithDevice(data, data.deviceId);
 			}
 		}
+
+		const long long updateMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - updateStart).count();
+		if (updateMicroseconds > m_worstUpdateMicroseconds)
+			m_worstUpdateMicroseconds = updateMicroseconds;
+	}
+
+	// Aligns with the controller's first snapshot after its orientation reset went through
+	void finishHMDAlignment()
+	{
+		m_pendingAlignment.active = false;
+		if (!m_poller->hasPublishedAfterReset(m_pendingAlignment.resetTicket))
+			LOG(WARNING) << "PSMove orientation reset wasn't answered in time, aligning with the last pose";
+
+		for (const MoveWrapper_PSM& wrapper : v_controllers)
+		{
+			if (wrapper.controllerId == m_pendingAlignment.controllerId)
+			{
+				alignPSMoveAndHMDTrackingSpace(wrapper.controller);
+				return;
+			}
+		}
 	}
 
 	bool rb = false;
@@ -932,7 +936,7 @@ private:
 		bool inputAvailable = false;
 		for (MoveWrapper_PSM& wrapper : v_controllers)
 		{
-			if (wrapper.controller->ControllerType == PSMController_Move)
+			if (wrapper.controller.ControllerType == PSMController_Move)
 			{
 				inputAvailable = true;
 			}
@@ -943,7 +947,7 @@ private:
 			{
 				continue;
 			}
-			auto& controller = wrapper.controller->ControllerState.PSMoveState;
+			auto& controller = wrapper.controller.ControllerState.PSMoveState;
 			bool bStartRealignHMDTriggered =
 			(controller.StartButton == PSMButtonState_PRESSED
 				|| controller.StartButton == PSMButtonState_DOWN) && (controller.SelectButton == PSMButtonState_PRESSED
@@ -955,94 +959,96 @@ private:
 				(controller.CircleButton == PSMButtonState_PRESSED
 				);
 
-			KinectSettings::KVRPSMoveData[wrapper.controller->ControllerID].PSMoveData = controller;
-			KinectSettings::KVRPSMoveData[wrapper.controller->ControllerID].isValidController = true;
+			KinectSettings::KVRPSMoveData[wrapper.controller.ControllerID].PSMoveData = controller;
+			KinectSettings::KVRPSMoveData[wrapper.controller.ControllerID].isValidController = true;
 
 			for (int psmid = 0; psmid < KinectSettings::psmindexidpsm[0].size(); psmid++)
 			{
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmh
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::left_move_controller = controller;
+					KinectSettings::left_move_controller.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmm
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::right_move_controller = controller;
+					KinectSettings::right_move_controller.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmhidari
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::left_foot_psmove = controller;
+					KinectSettings::left_foot_psmove.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmmigi
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::right_foot_psmove = controller;
+					KinectSettings::right_foot_psmove.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmyobu
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::waist_psmove = controller;
+					KinectSettings::waist_psmove.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 
 				if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::psmatama
-					&& wrapper.controller->ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
+					&& wrapper.controller.ControllerID == KinectSettings::psmindexidpsm[1].at(psmid))
 				{
-					KinectSettings::atamamove = controller;
+					KinectSettings::atamamove.store(controller);
 					if (KinectSettings::psmindexidpsm[0].at(psmid) == KinectSettings::flashnow[0] &&
 						KinectSettings::flashnow[1])
 					{
-						std::thread* rb = new std::thread(flashRainbow, wrapper.controller->ControllerID);
+						m_ledEffects->flashRainbow(wrapper.controller.ControllerID);
 						KinectSettings::flashnow[1] = false;
 					}
 				}
 			}
 
-			if (bStartRealignHMDTriggered)
+			// The alignment needs the reset orientation, so it's finished from update once that arrived
+			if (bStartRealignHMDTriggered && !m_pendingAlignment.active)
 			{
 				PSMVector3f controllerBallPointedUpEuler = {static_cast<float>(M_PI_2), 0.0f, 0.0f};
 
 				PSMQuatf controllerBallPointedUpQuat = PSM_QuatfCreateFromAngles(&controllerBallPointedUpEuler);
 
-				PSM_ResetControllerOrientationAsync(wrapper.controller->ControllerID, &controllerBallPointedUpQuat,
-				                                    nullptr);
-
-				alignPSMoveAndHMDTrackingSpace(wrapper.controller);
+				m_pendingAlignment.active = true;
+				m_pendingAlignment.controllerId = wrapper.controller.ControllerID;
+				m_pendingAlignment.resetTicket = m_poller->postOrientationReset(wrapper.controller.ControllerID,
+				                                                               controllerBallPointedUpQuat);
+				m_pendingAlignment.requested = std::chrono::steady_clock::now();
 			}
 			bool enabledRatioCalibration = false;
 			if (bStartVRRatioCalibrationTriggered && enabledRatioCalibration)
@@ -1190,13 +1196,14 @@ private:
 		v_controllers.clear(); // All old controllers must be gone
 		for (int i = 0; i < controllerList.count; ++i)
 		{
-			auto controller = PSM_GetController(controllerList.controller_id[i]);
+			MoveWrapper_PSM wrapper;
+			wrapper.listIndex = i;
+			wrapper.controllerId = controllerList.controller_id[i];
 			// Check that it's actually a Psmove/Virtual, as there could be dualshock's connected
-			if (controller->ControllerType == PSMController_Move ||
-				controller->ControllerType == PSMController_Virtual)
+			if (readSnapshot(wrapper, wrapper.controller) &&
+				(wrapper.controller.ControllerType == PSMController_Move ||
+					wrapper.controller.ControllerType == PSMController_Virtual))
 			{
-				MoveWrapper_PSM wrapper;
-				wrapper.controller = controller;
 				v_controllers.push_back(wrapper);
 			}
 		}
@@ -1211,86 +1218,15 @@ private:
 			TrackingPoolManager::addDeviceToPool(data, gID);
 			v_controllers[i].id.globalID = gID;
 
-			if (v_controllers[i].controller->ControllerType == PSMController_Move)
+			if (v_controllers[i].controller.ControllerType == PSMController_Move)
 			{
-				auto value = v_controllers[i].controller->ControllerState.PSMoveState.BatteryValue;
+				auto value = v_controllers[i].controller.ControllerState.PSMoveState.BatteryValue;
 
 				LOG(INFO) << "Controller " << i << " has battery level: " << batteryValueString(value);
 			}
 		}
 	}
 
-	void rebuildPSMoveLists()
-	{
-		// Unneccessary holdover from inspiration for implementation
-		//std::chrono::milliseconds now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
-		//std::chrono::milliseconds diff = now - last_report_fps_timestamp;
-
-		// Polls events and updates controller state
-		if (PSM_Update() == PSMResult_Success)
-		{
-			m_keepRunning = true;
-		}
-		else
-		{
-			m_keepRunning = false;
-		}
-
-		// See if we need to rebuild the controller list
-		if (m_keepRunning && PSM_HasControllerListChanged())
-		{
-			unsigned int data_stream_flags =
-				PSMStreamFlags_includePositionData |
-				PSMStreamFlags_includePhysicsData |
-				PSMStreamFlags_includeCalibratedSensorData |
-				PSMStreamFlags_includeRawTrackerData;
-
-			// Stop all controller streams
-			for (int i = 0; i < controllerList.count; ++i)
-			{
-				PSM_StopControllerDataStream(controllerList.controller_id[i], PSM_DEFAULT_TIMEOUT);
-			}
-
-			// Get the current controller list
-			rebuildControllerList();
-
-			// Restart the controller streams
-			if (controllerList.count > 0)
-			{
-				for (int i = 0; i < controllerList.count; ++i)
-				{
-					if (PSM_StartControllerDataStream(controllerList.controller_id[i], data_stream_flags,
-					                                  PSM_DEFAULT_TIMEOUT) != PSMResult_Success)
-					{
-						m_keepRunning = false;
-						LOG(ERROR) << "Controller stream " << i << " failed to start!";
-					}
-				}
-				// Rebuild K2VR Controller List for Trackers
-				rebuildPSMovesForPool();
-				// Here, because of timing issue, where controllers will report as 'None' occasionally when uninitialised properly
-			}
-			else
-			{
-				LOG(INFO) << "PSMoveConsoleClient::startup() - No controllers found.";
-				m_keepRunning = false;
-			}
-		}
-
-		// See if we need to rebuild the tracker list
-		if (m_keepRunning && PSM_HasTrackerListChanged())
-		{
-			rebuildTrackerList();
-			rebuildPSEyesForPool();
-		}
-
-		// See if we need to rebuild the hmd list
-		if (m_keepRunning && PSM_HasHMDListChanged())
-		{
-			rebuildTrackerList();
-		}
-	}
-
 	void rebuildControllerList()
 	{
 		memset(&controllerList, 0, sizeof(PSMControllerList));
@@ -1377,12 +1313,23 @@ private:
 
 	struct MoveWrapper_PSM
 	{
-		PSMController* controller = nullptr;
+		PSMController controller{}; // Last snapshot taken from the polling thread
+		int listIndex = -1;
+		PSMControllerID controllerId = -1;
 		TrackerIDs id;
 	};
 
 	std::vector<MoveWrapper_PSM> v_controllers;
 
+	bool readSnapshot(const MoveWrapper_PSM& wrapper, PSMController& out) const
+	{
+		PSMController snapshot;
+		if (!m_poller->readController(wrapper.listIndex, wrapper.controllerId, snapshot))
+			return false;
+		out = snapshot;
+		return true;
+	}
+
 	struct TrackerWrapper_PSM
 	{
 		PSMClientTrackerInfo trackerInfo;
@@ -1397,6 +1344,32 @@ private:
 	bool m_started;
 	bool m_keepRunning;
 
+	// Shared, as the GUI keeps its own copy of the handler next to the one in the device list
+	std::shared_ptr<PSMovePoller> m_poller = std::make_shared<PSMovePoller>();
+	// LED commands are queued on the poller like any other PSM_* call
+	std::shared_ptr<PSMoveLedEffects> m_ledEffects = std::make_shared<PSMoveLedEffects>(
+		[poller = m_poller](int controllerId, unsigned char r, unsigned char g, unsigned char b)
+		{
+			poller->post([controllerId, r, g, b]
+			{
+				PSM_SetControllerLEDOverrideColor(controllerId, r, g, b);
+			});
+		});
+	uint32_t m_listGeneration = 0;
+
+	struct PendingAlignment
+	{
+		bool active = false;
+		PSMControllerID controllerId = -1;
+		uint64_t resetTicket = 0;
+		std::chrono::steady_clock::time_point requested;
+	};
+
+	PendingAlignment m_pendingAlignment;
+	const std::chrono::milliseconds k_alignmentResetTimeout{500};
+	// Longest the GUI/tracking loop spent in update, compare with the poller's worst gap
+	long long m_worstUpdateMicroseconds = 0;
+
 	//Vars
 	bool m_bDisableHMDAlignmentGesture = false;
 	float m_fControllerMetersInFrontOfHmdAtCalibration = 0.06f;
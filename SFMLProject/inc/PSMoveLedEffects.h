@@ -0,0 +1,180 @@
+#pragma once
+#include "stdafx.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Plays every PSMove LED animation from one thread
+// Each controller has at most one effect, a new request for the same controller
+// either joins the running one (same effect) or replaces it (solid colours),
+// and the thread sleeps until the earliest pending keyframe
+// The sink is only ever called with the lock held, so colours reach it in the order they were decided
+class PSMoveLedEffects
+{
+public:
+	using clock = std::chrono::steady_clock;
+	using LedSink = std::function<void(int controllerId, unsigned char r, unsigned char g, unsigned char b)>;
+
+	explicit PSMoveLedEffects(LedSink sink)
+		: m_sink(std::move(sink))
+	{
+		// Lives as long as the scheduler, idle it just waits for the next effect
+		m_thread = std::thread(&PSMoveLedEffects::run, this);
+	}
+
+	~PSMoveLedEffects()
+	{
+		stop();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_keepRunning = false;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	PSMoveLedEffects(const PSMoveLedEffects&) = delete;
+	PSMoveLedEffects& operator=(const PSMoveLedEffects&) = delete;
+
+	// Fades through red, yellow, green, cyan, blue, magenta and back to off
+	void flashRainbow(int controllerId)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Effect& effect = m_effects[controllerId];
+		if (effect.kind == EffectKind::Rainbow)
+			return; // Already flashing, pressing the combo again changes nothing
+
+		effect.kind = EffectKind::Rainbow;
+		effect.started = clock::now();
+		effect.nextKeyframe = effect.started;
+		m_wake.notify_one();
+	}
+
+	// Cancels whatever is playing on the controller and holds a solid colour
+	void setColor(int controllerId, unsigned char r, unsigned char g, unsigned char b)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_effects.erase(controllerId);
+		m_sink(controllerId, r, g, b);
+	}
+
+	// Drops pending animations and turns their LEDs off
+	void stop()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& effect : m_effects)
+			m_sink(effect.first, 0, 0, 0);
+		m_effects.clear();
+	}
+
+private:
+	enum class EffectKind
+	{
+		None,
+		Rainbow,
+	};
+
+	struct Effect
+	{
+		EffectKind kind = EffectKind::None;
+		clock::time_point started;
+		clock::time_point nextKeyframe;
+	};
+
+	struct Color
+	{
+		unsigned char r, g, b;
+	};
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_keepRunning)
+		{
+			if (m_effects.empty())
+			{
+				// Nothing to animate, sleep until someone asks for an effect
+				m_wake.wait(lock, [this] { return !m_keepRunning || !m_effects.empty(); });
+				continue;
+			}
+
+			const auto now = clock::now();
+			auto wakeAt = clock::time_point::max();
+
+			for (auto it = m_effects.begin(); it != m_effects.end();)
+			{
+				Effect& effect = it->second;
+				if (effect.nextKeyframe <= now)
+				{
+					bool finished = false;
+					const Color color = rainbowColor(now - effect.started, finished);
+					m_sink(it->first, color.r, color.g, color.b);
+					if (finished)
+					{
+						it = m_effects.erase(it);
+						continue;
+					}
+					effect.nextKeyframe += k_frameInterval;
+					if (effect.nextKeyframe < now)
+						effect.nextKeyframe = now + k_frameInterval; // Don't replay frames we slept through
+				}
+				if (effect.nextKeyframe < wakeAt)
+					wakeAt = effect.nextKeyframe;
+				++it;
+			}
+
+			if (wakeAt != clock::time_point::max())
+				m_wake.wait_until(lock, wakeAt);
+		}
+	}
+
+	// Linear fade between the rainbow stops, finishes on black
+	static Color rainbowColor(clock::duration elapsed, bool& finished)
+	{
+		static const Color stops[] = {
+			{0, 0, 0},
+			{255, 0, 0},
+			{255, 255, 0},
+			{0, 255, 0},
+			{0, 255, 255},
+			{0, 0, 255},
+			{255, 0, 255},
+			{0, 0, 0},
+		};
+		const int segments = sizeof(stops) / sizeof(stops[0]) - 1;
+
+		const float t = std::chrono::duration<float>(elapsed).count() /
+			std::chrono::duration<float>(k_segmentDuration).count();
+		const int segment = static_cast<int>(t);
+		if (segment >= segments)
+		{
+			finished = true;
+			return stops[segments];
+		}
+
+		const float blend = t - segment;
+		const Color& from = stops[segment];
+		const Color& to = stops[segment + 1];
+		return {
+			static_cast<unsigned char>(from.r + (to.r - from.r) * blend),
+			static_cast<unsigned char>(from.g + (to.g - from.g) * blend),
+			static_cast<unsigned char>(from.b + (to.b - from.b) * blend),
+		};
+	}
+
+	static constexpr std::chrono::milliseconds k_frameInterval{20};
+	static constexpr std::chrono::milliseconds k_segmentDuration{250};
+
+	// Only queues the command, cheap enough to call under the lock
+	LedSink m_sink;
+
+	std::thread m_thread;
+	bool m_keepRunning = true;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::map<int, Effect> m_effects;
+};
@@ -0,0 +1,399 @@
+#pragma once
+#include "stdafx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <PSMoveClient_CAPI.h>
+#include <ClientConstants.h>
+#include <SharedConstants.h>
+
+#include "SeqLock.h"
+
+// Owns the PSMoveService client once the handler has started it up:
+// PSM_Update, controller/tracker list rebuilds and controller commands
+// all run on one thread, so the GUI/tracking loop never waits on the service
+// and only ever reads the published controller snapshots
+class PSMovePoller
+{
+public:
+	PSMovePoller()
+	{
+		std::memset(&m_controllerList, 0, sizeof(PSMControllerList));
+		std::memset(&m_trackerList, 0, sizeof(PSMTrackerList));
+		std::memset(&m_pollControllerList, 0, sizeof(PSMControllerList));
+	}
+
+	~PSMovePoller()
+	{
+		stop();
+	}
+
+	PSMovePoller(const PSMovePoller&) = delete;
+	PSMovePoller& operator=(const PSMovePoller&) = delete;
+
+	// Lists must already have their listeners allocated and streams started
+	void start(const PSMControllerList& controllers, const PSMTrackerList& trackers)
+	{
+		stop();
+
+		m_pollControllerList = controllers;
+		{
+			std::lock_guard<std::mutex> lock(m_listMutex);
+			m_controllerList = controllers;
+			m_trackerList = trackers;
+			++m_listGeneration;
+		}
+
+		// Publish once from here, so the caller can build its wrappers straight away
+		m_connected = PSM_Update() == PSMResult_Success;
+		publishControllers();
+
+		m_pendingResets.clear();
+		m_worstStallMicroseconds = 0;
+		m_keepPolling = true;
+		m_thread = std::thread(&PSMovePoller::pollLoop, this);
+	}
+
+	void stop()
+	{
+		m_keepPolling = false;
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+			LOG(INFO) << "PSMove polling stopped, worst tracking stall: " <<
+				m_worstStallMicroseconds / 1000.0 << "ms";
+		}
+		// Only posts that raced stop are left, they would target a dead connection
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		m_commands.clear();
+	}
+
+	bool isPolling() const
+	{
+		return m_keepPolling;
+	}
+
+	// Mirrors the last PSM_Update result
+	bool isConnected() const
+	{
+		return m_connected;
+	}
+
+	uint32_t listGeneration() const
+	{
+		std::lock_guard<std::mutex> lock(m_listMutex);
+		return m_listGeneration;
+	}
+
+	// Copies the latest lists, returns the generation they belong to
+	uint32_t copyLists(PSMControllerList& controllers, PSMTrackerList& trackers) const
+	{
+		std::lock_guard<std::mutex> lock(m_listMutex);
+		controllers = m_controllerList;
+		trackers = m_trackerList;
+		return m_listGeneration;
+	}
+
+	// Slot is the controller's index in the controller list
+	// Returns false if the slot is empty or already holds another controller
+	bool readController(int listIndex, PSMControllerID expectedId, PSMController& out) const
+	{
+		if (listIndex < 0 || listIndex >= PSMOVESERVICE_MAX_CONTROLLER_COUNT)
+			return false;
+
+		out = m_controllers[listIndex].load();
+		return out.bValid && out.ControllerID == expectedId;
+	}
+
+	// Queues a PSM_* call (LEDs, rumble, orientation resets...) for the polling thread
+	void post(std::function<void()> command)
+	{
+		if (!m_keepPolling)
+			return;
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		m_commands.push_back(std::move(command));
+	}
+
+	// Queues PSM_ResetControllerOrientationAsync, returns a ticket for hasPublishedAfterReset
+	uint64_t postOrientationReset(PSMControllerID controllerId, const PSMQuatf& orientation)
+	{
+		const uint64_t ticket = ++m_resetTickets;
+		post([this, controllerId, orientation, ticket]
+		{
+			PSMRequestID request;
+			if (PSM_ResetControllerOrientationAsync(controllerId, &orientation, &request) == PSMResult_RequestSent)
+			{
+				m_pendingResets.push_back({request, ticket});
+				PSM_RegisterCallback(request, onResetResponse, this);
+			}
+			else
+			{
+				LOG(ERROR) << "PSMove orientation reset for controller " << controllerId << " couldn't be sent";
+				m_resetsAnswered = ticket;
+			}
+		});
+		return ticket;
+	}
+
+	// True once the service answered the reset and a snapshot taken after that answer was published
+	// Snapshots read after this returned true already contain the reset orientation
+	bool hasPublishedAfterReset(uint64_t ticket) const
+	{
+		return m_resetsPublished.load(std::memory_order_acquire) >= ticket;
+	}
+
+	// Longest gap between two published snapshots since start()
+	long long worstStallMicroseconds() const
+	{
+		return m_worstStallMicroseconds;
+	}
+
+private:
+	void pollLoop()
+	{
+		using clock = std::chrono::steady_clock;
+		auto lastTick = clock::now();
+		auto nextTick = lastTick;
+
+		while (m_keepPolling)
+		{
+			// Answers that arrived before this update are older than the data it brings in
+			const uint64_t resetsAnswered = m_resetsAnswered;
+			m_connected = PSM_Update() == PSMResult_Success;
+
+			if (m_connected)
+			{
+				// List changes are requested asynchronously, replies land in PSM_Update
+				if (PSM_HasControllerListChanged())
+					requestControllerList();
+				if (PSM_HasTrackerListChanged() || PSM_HasHMDListChanged())
+					requestTrackerList();
+
+				runCommands();
+				publishControllers();
+				m_resetsPublished.store(resetsAnswered, std::memory_order_release);
+			}
+
+			const auto now = clock::now();
+			const long long stall = std::chrono::duration_cast<std::chrono::microseconds>(now - lastTick).count();
+			if (stall > m_worstStallMicroseconds)
+				m_worstStallMicroseconds = stall;
+			lastTick = now;
+
+			nextTick += pollInterval();
+			if (nextTick < now)
+				nextTick = now; // Don't try to catch up on missed ticks
+			std::this_thread::sleep_until(nextTick);
+		}
+
+		// Whatever was posted before stop still goes out, the LED-off commands on shutdown among them
+		if (m_connected)
+		{
+			runCommands();
+			PSM_Update();
+		}
+	}
+
+	// Follows the rate the service is actually streaming at
+	std::chrono::microseconds pollInterval() const
+	{
+		float fps = 0.f;
+		for (int i = 0; i < m_pollControllerList.count; ++i)
+		{
+			const PSMController* controller = PSM_GetController(m_pollControllerList.controller_id[i]);
+			if (controller != nullptr)
+				fps = std::max(fps, controller->DataFrameAverageFPS);
+		}
+		if (fps <= 0.f)
+			fps = k_defaultPollRate;
+		fps = std::min(std::max(fps, k_minPollRate), k_maxPollRate);
+
+		return std::chrono::microseconds(static_cast<long long>(1000000.0 / fps));
+	}
+
+	void publishControllers()
+	{
+		for (int i = 0; i < m_pollControllerList.count; ++i)
+		{
+			const PSMController* controller = PSM_GetController(m_pollControllerList.controller_id[i]);
+			if (controller != nullptr)
+				m_controllers[i].store(*controller);
+		}
+	}
+
+	void runCommands()
+	{
+		std::vector<std::function<void()>> commands;
+		{
+			std::lock_guard<std::mutex> lock(m_commandMutex);
+			commands.swap(m_commands);
+		}
+		for (auto& command : commands)
+			command();
+	}
+
+	void requestControllerList()
+	{
+		if (m_controllerListRequested)
+			return;
+
+		PSMRequestID request;
+		if (PSM_GetControllerListAsync(&request) == PSMResult_RequestSent)
+		{
+			PSM_RegisterCallback(request, onControllerListResponse, this);
+			m_controllerListRequested = true;
+		}
+	}
+
+	void requestTrackerList()
+	{
+		if (m_trackerListRequested)
+			return;
+
+		PSMRequestID request;
+		if (PSM_GetTrackerListAsync(&request) == PSMResult_RequestSent)
+		{
+			PSM_RegisterCallback(request, onTrackerListResponse, this);
+			m_trackerListRequested = true;
+		}
+	}
+
+	static void onControllerListResponse(const PSMResponseMessage* response, void* userdata)
+	{
+		auto poller = static_cast<PSMovePoller*>(userdata);
+		poller->m_controllerListRequested = false;
+
+		if (response->result_code != PSMResult_Success ||
+			response->payload_type != PSMResponseMessage::_responsePayloadType_ControllerList)
+		{
+			LOG(ERROR) << "PSMove controller list request failed with PSMResult " << response->result_code;
+			return;
+		}
+		poller->applyControllerList(response->payload.controller_list);
+	}
+
+	static void onTrackerListResponse(const PSMResponseMessage* response, void* userdata)
+	{
+		auto poller = static_cast<PSMovePoller*>(userdata);
+		poller->m_trackerListRequested = false;
+
+		if (response->result_code != PSMResult_Success ||
+			response->payload_type != PSMResponseMessage::_responsePayloadType_TrackerList)
+		{
+			LOG(ERROR) << "PSMove tracker list request failed with PSMResult " << response->result_code;
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(poller->m_listMutex);
+		poller->m_trackerList = response->payload.tracker_list;
+		++poller->m_listGeneration;
+	}
+
+	static void onResetResponse(const PSMResponseMessage* response, void* userdata)
+	{
+		auto poller = static_cast<PSMovePoller*>(userdata);
+		auto& pending = poller->m_pendingResets;
+		for (auto it = pending.begin(); it != pending.end(); ++it)
+		{
+			if (it->request != response->request_id)
+				continue;
+			if (response->result_code != PSMResult_Success)
+				LOG(ERROR) << "PSMove orientation reset failed with PSMResult " << response->result_code;
+			// Failed resets count as answered too, nobody should wait on them forever
+			if (it->ticket > poller->m_resetsAnswered)
+				poller->m_resetsAnswered = it->ticket;
+			pending.erase(it);
+			return;
+		}
+	}
+
+	static bool listContains(const PSMControllerList& list, PSMControllerID id)
+	{
+		for (int i = 0; i < list.count; ++i)
+		{
+			if (list.controller_id[i] == id)
+				return true;
+		}
+		return false;
+	}
+
+	void applyControllerList(const PSMControllerList& newList)
+	{
+		const unsigned int data_stream_flags =
+			PSMStreamFlags_includePositionData |
+			PSMStreamFlags_includePhysicsData |
+			PSMStreamFlags_includeCalibratedSensorData |
+			PSMStreamFlags_includeRawTrackerData;
+
+		LOG(INFO) << "PSMove controller list changed, found " << newList.count << " controllers.";
+
+		PSMRequestID request;
+		for (int i = 0; i < m_pollControllerList.count; ++i)
+		{
+			const PSMControllerID id = m_pollControllerList.controller_id[i];
+			if (PSM_StopControllerDataStreamAsync(id, &request) == PSMResult_RequestSent)
+				PSM_EatResponse(request);
+			if (!listContains(newList, id))
+				PSM_FreeControllerListener(id);
+		}
+		for (int i = 0; i < newList.count; ++i)
+		{
+			const PSMControllerID id = newList.controller_id[i];
+			if (!listContains(m_pollControllerList, id))
+				PSM_AllocateControllerListener(id);
+			if (PSM_StartControllerDataStreamAsync(id, data_stream_flags, &request) == PSMResult_RequestSent)
+				PSM_EatResponse(request);
+			else
+				LOG(ERROR) << "Controller stream " << i << " failed to start!";
+		}
+
+		m_pollControllerList = newList;
+		publishControllers();
+
+		std::lock_guard<std::mutex> lock(m_listMutex);
+		m_controllerList = newList;
+		++m_listGeneration;
+	}
+
+	static constexpr float k_defaultPollRate = 120.f;
+	static constexpr float k_minPollRate = 30.f;
+	static constexpr float k_maxPollRate = 240.f;
+
+	std::thread m_thread;
+	std::atomic<bool> m_keepPolling{false};
+	std::atomic<bool> m_connected{false};
+	std::atomic<long long> m_worstStallMicroseconds{0};
+
+	// Polling thread only
+	PSMControllerList m_pollControllerList;
+	bool m_controllerListRequested = false;
+	bool m_trackerListRequested = false;
+
+	struct PendingReset
+	{
+		PSMRequestID request;
+		uint64_t ticket;
+	};
+
+	std::vector<PendingReset> m_pendingResets;
+	uint64_t m_resetsAnswered = 0;
+
+	std::atomic<uint64_t> m_resetTickets{0};
+	std::atomic<uint64_t> m_resetsPublished{0};
+
+	SeqLock<PSMController> m_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+
+	mutable std::mutex m_listMutex;
+	PSMControllerList m_controllerList;
+	PSMTrackerList m_trackerList;
+	uint32_t m_listGeneration = 0;
+
+	std::mutex m_commandMutex;
+	std::vector<std::function<void()>> m_commands;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <Windows.h>
+
+// Raised by the KinectToVR client while it sends enabled tracker poses
+// The driver's watchdog sleeps on it and wakes SteamVR while somebody is tracking,
+// which only matters while SteamVR (and with it the pose decoder) isn't running
+namespace PoseActivity
+{
+	// Auto reset, shared by the client and the watchdog host
+	constexpr const wchar_t* k_eventName = L"Local\\K2VR_PoseActivity";
+
+	// Poses go out at ~110Hz, the watchdog doesn't need more than a few signals a second
+	constexpr std::chrono::milliseconds k_notifyInterval{250};
+
+	// Creates it or opens the one the other process already made
+	inline HANDLE openEvent()
+	{
+		return CreateEventW(nullptr, FALSE, FALSE, k_eventName);
+	}
+
+	// Cheap enough to call for every pose message, only every k_notifyInterval actually signals
+	inline void notify()
+	{
+		static HANDLE activity_event = openEvent();
+		static std::atomic<int64_t> last_notify_ms{0};
+
+		const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		int64_t last_ms = last_notify_ms.load(std::memory_order_relaxed);
+		if (now_ms - last_ms < k_notifyInterval.count() ||
+			!last_notify_ms.compare_exchange_strong(last_ms, now_ms, std::memory_order_relaxed))
+			return;
+
+		if (activity_event)
+			SetEvent(activity_event);
+	}
+}
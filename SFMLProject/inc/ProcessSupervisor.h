@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <Windows.h>
+
+#include "SeqLock.h"
+#include "SupervisionLoop.h"
+
+// Last known calibration and tracker state, kept alive by the supervisor
+// so a restarted Kinect process comes back where the crashed one was
+struct RecoveryState
+{
+	uint32_t valid;
+	uint32_t trackersInitialised;
+	uint32_t matrixesCalibrated;
+	float calibrationRotation[3][3];
+	float calibrationTranslation[3];
+	float calibrationOrigin[3];
+	float calibrationTrackersYaw;
+	float calibrationKinectPitch;
+	double manualOffsets[2][3][3];
+	double hipRoleHeightAdjust;
+};
+
+namespace Supervision
+{
+	// Passed to restarted processes, followed by the recovery channel name
+	constexpr const char* k_supervisedFlag = "--supervised";
+
+	// Named shared memory holding one RecoveryState slot
+	// Written by the Kinect process, kept open by the supervisor across crashes
+	class RecoveryChannel
+	{
+	public:
+		RecoveryChannel() = default;
+
+		~RecoveryChannel()
+		{
+			if (m_slot)
+				UnmapViewOfFile(m_slot);
+			if (m_mapping)
+				CloseHandle(m_mapping);
+		}
+
+		RecoveryChannel(const RecoveryChannel&) = delete;
+		RecoveryChannel& operator=(const RecoveryChannel&) = delete;
+
+		bool create(const std::string& name)
+		{
+			m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+			                               sizeof(SeqLock<RecoveryState>), name.c_str());
+			if (!m_mapping || !map())
+				return false;
+			new(m_slot) SeqLock<RecoveryState>();
+			return true;
+		}
+
+		bool open(const std::string& name)
+		{
+			m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+			return m_mapping && map();
+		}
+
+		void publish(const RecoveryState& state)
+		{
+			if (m_slot)
+				m_slot->store(state);
+		}
+
+		bool read(RecoveryState& state) const
+		{
+			if (!m_slot)
+				return false;
+			state = m_slot->load();
+			return state.valid != 0;
+		}
+
+	private:
+		bool map()
+		{
+			m_slot = static_cast<SeqLock<RecoveryState>*>(
+				MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SeqLock<RecoveryState>)));
+			return m_slot != nullptr;
+		}
+
+		HANDLE m_mapping = nullptr;
+		SeqLock<RecoveryState>* m_slot = nullptr;
+	};
+
+	// The process a supervisor watches, either attached by pid or started by it
+	// The Win32 side of superviseLoop, which decides when to wait on and relaunch it
+	class SupervisedProcess
+	{
+	public:
+		~SupervisedProcess()
+		{
+			close();
+		}
+
+		bool attach(DWORD pid)
+		{
+			close();
+			m_process = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+			return m_process != nullptr;
+		}
+
+		bool launch(const std::wstring& image, const std::wstring& arguments)
+		{
+			close();
+			std::wstring commandLine = L"\"" + image + L"\" " + arguments;
+			STARTUPINFOW startupInfo{};
+			startupInfo.cb = sizeof(startupInfo);
+			PROCESS_INFORMATION processInfo{};
+			if (!CreateProcessW(image.c_str(), &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr,
+			                    &startupInfo, &processInfo))
+				return false;
+			CloseHandle(processInfo.hThread);
+			m_process = processInfo.hProcess;
+			return true;
+		}
+
+		std::wstring imagePath() const
+		{
+			wchar_t path[MAX_PATH];
+			DWORD size = MAX_PATH;
+			if (!m_process || !QueryFullProcessImageNameW(m_process, 0, path, &size))
+				return L"";
+			return std::wstring(path, size);
+		}
+
+		// Blocks on the process handle until it exits, no polling
+		DWORD waitForExit() const
+		{
+			DWORD exitCode = 0;
+			if (m_process && WaitForSingleObject(m_process, INFINITE) == WAIT_OBJECT_0)
+				GetExitCodeProcess(m_process, &exitCode);
+			return exitCode;
+		}
+
+	private:
+		void close()
+		{
+			if (m_process)
+				CloseHandle(m_process);
+			m_process = nullptr;
+		}
+
+		HANDLE m_process = nullptr;
+	};
+
+	inline RecoveryChannel& channel()
+	{
+		static RecoveryChannel recoveryChannel;
+		return recoveryChannel;
+	}
+
+	inline RecoveryState& startupState()
+	{
+		static RecoveryState state{};
+		return state;
+	}
+
+	// First thing in main of the Kinect processes
+	// Started by a supervisor: reopens its channel and reads what the last process left
+	// Started by the user: creates the channel and starts supervisorExe on this process
+	inline void attach(const char* supervisorExe, int argc, char* argv[])
+	{
+		for (int i = 1; i + 1 < argc; ++i)
+		{
+			if (std::strcmp(argv[i], k_supervisedFlag) == 0)
+			{
+				if (channel().open(argv[i + 1]))
+					channel().read(startupState());
+				return;
+			}
+		}
+
+		const std::string pid = std::to_string(GetCurrentProcessId());
+		const std::string name = "Local\\K2VR_Recovery_" + pid;
+		if (!channel().create(name))
+			return;
+
+		std::string commandLine = std::string(supervisorExe) + " " + pid + " " + name;
+		STARTUPINFOA startupInfo{};
+		startupInfo.cb = sizeof(startupInfo);
+		PROCESS_INFORMATION processInfo{};
+		if (CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr,
+		                   &startupInfo, &processInfo))
+		{
+			CloseHandle(processInfo.hThread);
+			CloseHandle(processInfo.hProcess);
+		}
+	}
+
+	inline void publish(const RecoveryState& state)
+	{
+		channel().publish(state);
+	}
+
+	// True if this process was restarted after a crash and there is state to restore
+	inline bool recoveredState(RecoveryState& state)
+	{
+		state = startupState();
+		return state.valid != 0;
+	}
+}
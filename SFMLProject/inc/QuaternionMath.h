@@ -1,15 +1,336 @@
 #pragma once
-#include "stdafx.h"
-
-//Forward declare to preserve neutrality of KVRlib
-struct Vector4
-{
-	float x;
-	float y;
-	float z;
-	float w;
-};
+#include <cmath>
+#include <initializer_list>
 
+// Quaternion maths shared by the Kinect orientation filters and handlers
+//
+// The single quaternion functions take any type with float x, y, z, w members that can be brace
+// initialised in that order (the Kinect SDKs' Vector4, KMath::Quat::Quaternion). They do the same
+// operations in the same order as the helpers the filters used to carry around, so results are bit for bit the same.
+//
+// QuaternionArray and Vector3Array keep a whole skeleton with the components split into plain float arrays.
+// The batched multiply and normalise loops only do arithmetic and selects, so the compiler vectorises them
+// without any intrinsics (MSVC at /O2, gcc at -O3, which also wants -fno-math-errno -fno-trapping-math
+// for the square roots in normalise). lookAtEulerAngles needs the trigonometric functions per element,
+// batching it saves the conversions in between
+//
+// Only depends on the standard library, so it builds and runs on any platform
 namespace KMath
 {
-};
+	namespace Quat
+	{
+		struct Quaternion
+		{
+			float x;
+			float y;
+			float z;
+			float w;
+		};
+
+		template <typename Q>
+		Q identity()
+		{
+			return Q{0, 0, 0, 1};
+		}
+
+		// lhs * rhs, lhs applied after rhs
+		template <typename Q>
+		Q multiply(const Q& lhs, const Q& rhs)
+		{
+			return Q{
+				(lhs.w * rhs.x) + (lhs.x * rhs.w) + (lhs.y * rhs.z) - (lhs.z * rhs.y),
+				(lhs.w * rhs.y) + (lhs.y * rhs.w) + (lhs.z * rhs.x) - (lhs.x * rhs.z),
+				(lhs.w * rhs.z) + (lhs.z * rhs.w) + (lhs.x * rhs.y) - (lhs.y * rhs.x),
+				(lhs.w * rhs.w) - (lhs.x * rhs.x) - (lhs.y * rhs.y) - (lhs.z * rhs.z)
+			};
+		}
+
+		template <typename Q>
+		float dot(const Q& a, const Q& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+		}
+
+		template <typename Q>
+		float lengthSquared(const Q& q)
+		{
+			return q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z;
+		}
+
+		template <typename Q>
+		float length(const Q& q)
+		{
+			return std::sqrt(lengthSquared(q));
+		}
+
+		template <typename Q>
+		Q conjugate(const Q& q)
+		{
+			return Q{-q.x, -q.y, -q.z, q.w};
+		}
+
+		// Divides by the squared length, like the filters' normalisedQ always did. Only quaternions
+		// already close to unit length come out normalised, use normalise for anything else
+		template <typename Q>
+		Q divideBySquaredLength(const Q& q)
+		{
+			const float magnitude = std::pow(length(q), 2);
+			return Q{q.x / magnitude, q.y / magnitude, q.z / magnitude, q.w / magnitude};
+		}
+
+		template <typename Q>
+		Q normalise(const Q& q)
+		{
+			const float qLength = length(q);
+			const float scale = qLength > 0.f ? 1.0f / qLength : 0.f;
+			return Q{q.x * scale, q.y * scale, q.z * scale, q.w * scale};
+		}
+
+		// Spherical interpolation from a (t = 0) to b (t = 1) along the shorter way around, linear when the
+		// two are too close for the angle to be accurate. Both are scaled by divideBySquaredLength first,
+		// the angle is worked out in double and only the linear case is scaled again, as the V2 filter always did
+		template <typename Q>
+		Q slerp(const Q& q1, const Q& q2, float t)
+		{
+			const Q a = divideBySquaredLength(q1);
+			Q b = divideBySquaredLength(q2);
+
+			double cosTheta = dot(a, b);
+			if (cosTheta < 0.0f)
+			{
+				b = Q{-b.x, -b.y, -b.z, -b.w};
+				cosTheta = -cosTheta;
+			}
+			if (cosTheta > 0.9995)
+				return divideBySquaredLength(Q{
+					a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * (b.z - a.z), a.w + t * (b.w - a.w)
+				});
+
+			const double theta0 = std::acos(cosTheta);
+			const double theta = theta0 * t;
+			// cos(theta) - cosTheta * sin(theta) / sin(theta0) == sin(theta0 - theta) / sin(theta0)
+			const float s0 = static_cast<float>(std::cos(theta) - cosTheta * std::sin(theta) / std::sin(theta0));
+			const float s1 = static_cast<float>(std::sin(theta) / std::sin(theta0));
+			return Q{s0 * a.x + s1 * b.x, s0 * a.y + s1 * b.y, s0 * a.z + s1 * b.z, s0 * a.w + s1 * b.w};
+		}
+
+		// Shortest rotation turning the direction from onto the direction to
+		template <typename Q>
+		Q fromToRotation(float fromX, float fromY, float fromZ, float toX, float toY, float toZ)
+		{
+			float v0[3] = {fromX, fromY, fromZ};
+			float v1[3] = {toX, toY, toZ};
+			for (float* v : {v0, v1})
+			{
+				const float vLengthSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+				if (vLengthSquared == 0)
+					continue;
+				const float scale = static_cast<float>(1.0 / std::sqrt(vLengthSquared));
+				v[0] *= scale;
+				v[1] *= scale;
+				v[2] *= scale;
+			}
+
+			const float d = v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2];
+			if (d >= 1.0f)
+				return identity<Q>();
+			if (d <= -1.0f) //Exactly opposite, turn half way around any axis perpendicular to from
+			{
+				Q axis{0.f, -v0[2], v0[1], 0.f}; // (1, 0, 0) x from
+				if (axis.y == 0 && axis.z == 0)
+					axis = Q{v0[2], 0.f, -v0[0], 0.f}; // (0, 1, 0) x from
+				return divideBySquaredLength(axis);
+			}
+
+			const float s = std::sqrt((1 + d) * 2);
+			const float invs = 1.f / s;
+			return divideBySquaredLength(Q{
+				(v0[1] * v1[2] - v0[2] * v1[1]) * invs,
+				-(v0[0] * v1[2] - v0[2] * v1[0]) * invs,
+				(v0[0] * v1[1] - v0[1] * v1[0]) * invs,
+				s * .5f
+			});
+		}
+
+		template <int N>
+		struct QuaternionArray
+		{
+			float x[N];
+			float y[N];
+			float z[N];
+			float w[N];
+
+			template <typename Q>
+			Q get(int i) const { return Q{x[i], y[i], z[i], w[i]}; }
+
+			template <typename Q>
+			void set(int i, const Q& q)
+			{
+				x[i] = q.x;
+				y[i] = q.y;
+				z[i] = q.z;
+				w[i] = q.w;
+			}
+		};
+
+		template <int N>
+		struct Vector3Array
+		{
+			float x[N];
+			float y[N];
+			float z[N];
+
+			void set(int i, float vx, float vy, float vz)
+			{
+				x[i] = vx;
+				y[i] = vy;
+				z[i] = vz;
+			}
+		};
+
+		// out[i] = lhs[i] * rhs for every element, out may be lhs
+		template <int N, typename Q>
+		void multiply(const QuaternionArray<N>& lhs, const Q& rhs, QuaternionArray<N>& out)
+		{
+			for (int i = 0; i < N; ++i)
+			{
+				const float x = lhs.x[i], y = lhs.y[i], z = lhs.z[i], w = lhs.w[i];
+				out.x[i] = (w * rhs.x) + (x * rhs.w) + (y * rhs.z) - (z * rhs.y);
+				out.y[i] = (w * rhs.y) + (y * rhs.w) + (z * rhs.x) - (x * rhs.z);
+				out.z[i] = (w * rhs.z) + (z * rhs.w) + (x * rhs.y) - (y * rhs.x);
+				out.w[i] = (w * rhs.w) - (x * rhs.x) - (y * rhs.y) - (z * rhs.z);
+			}
+		}
+
+		// out[i] = lhs[i] * rhs[i] for every element, out may be either of them
+		template <int N>
+		void multiply(const QuaternionArray<N>& lhs, const QuaternionArray<N>& rhs, QuaternionArray<N>& out)
+		{
+			for (int i = 0; i < N; ++i)
+			{
+				const float lx = lhs.x[i], ly = lhs.y[i], lz = lhs.z[i], lw = lhs.w[i];
+				const float rx = rhs.x[i], ry = rhs.y[i], rz = rhs.z[i], rw = rhs.w[i];
+				out.x[i] = (lw * rx) + (lx * rw) + (ly * rz) - (lz * ry);
+				out.y[i] = (lw * ry) + (ly * rw) + (lz * rx) - (lx * rz);
+				out.z[i] = (lw * rz) + (lz * rw) + (lx * ry) - (ly * rx);
+				out.w[i] = (lw * rw) - (lx * rx) - (ly * ry) - (lz * rz);
+			}
+		}
+
+		// Scales every element to unit length, zero length quaternions stay zero
+		template <int N>
+		void normalise(QuaternionArray<N>& q)
+		{
+			for (int i = 0; i < N; ++i)
+			{
+				const float qLength = std::sqrt(q.x[i] * q.x[i] + q.y[i] * q.y[i] + q.z[i] * q.z[i] + q.w[i] * q.w[i]);
+				// Divide first and select after, a branch would keep the loop from vectorising
+				const float inverseLength = 1.0f / qLength;
+				const float scale = qLength > 0.f ? inverseLength : 0.f;
+				q.x[i] *= scale;
+				q.y[i] *= scale;
+				q.z[i] *= scale;
+				q.w[i] *= scale;
+			}
+		}
+
+		// Pitch (x), yaw (y) and roll (z) of the rotation looking from eye[i] at center[i] with the
+		// given up. Same operations in the same order as glm 0.9.9's
+		// eulerAngles(quat(lookAt(eye, center, up))) with the default right handed lookAt, without
+		// building the matrix and quaternion in between. out may be eye or center
+		template <int N>
+		void lookAtEulerAngles(const Vector3Array<N>& eye, const Vector3Array<N>& center,
+		                       float upX, float upY, float upZ, Vector3Array<N>& out)
+		{
+			for (int i = 0; i < N; ++i)
+			{
+				// Forward, side and up axes of the view, as lookAtRH
+				float fx = center.x[i] - eye.x[i], fy = center.y[i] - eye.y[i], fz = center.z[i] - eye.z[i];
+				const float fScale = 1.f / std::sqrt(fx * fx + fy * fy + fz * fz);
+				fx *= fScale;
+				fy *= fScale;
+				fz *= fScale;
+
+				float sx = fy * upZ - upY * fz, sy = fz * upX - upZ * fx, sz = fx * upY - upX * fy;
+				const float sScale = 1.f / std::sqrt(sx * sx + sy * sy + sz * sz);
+				sx *= sScale;
+				sy *= sScale;
+				sz *= sScale;
+
+				const float ux = sy * fz - fy * sz, uy = sz * fx - fz * sx, uz = sx * fy - fx * sy;
+
+				// Matrix to quaternion from its biggest component, as quat_cast. m[column][row] is
+				// m00 = s.x, m11 = u.y, m22 = -f.z, m12 = -f.y, m21 = u.z, m20 = s.z, m02 = -f.x, m01 = u.x, m10 = s.y
+				const float m00 = sx, m11 = uy, m22 = -fz;
+				const float fourXSquaredMinus1 = m00 - m11 - m22;
+				const float fourYSquaredMinus1 = m11 - m00 - m22;
+				const float fourZSquaredMinus1 = m22 - m00 - m11;
+				const float fourWSquaredMinus1 = m00 + m11 + m22;
+
+				int biggestIndex = 0;
+				float fourBiggestSquaredMinus1 = fourWSquaredMinus1;
+				if (fourXSquaredMinus1 > fourBiggestSquaredMinus1)
+				{
+					fourBiggestSquaredMinus1 = fourXSquaredMinus1;
+					biggestIndex = 1;
+				}
+				if (fourYSquaredMinus1 > fourBiggestSquaredMinus1)
+				{
+					fourBiggestSquaredMinus1 = fourYSquaredMinus1;
+					biggestIndex = 2;
+				}
+				if (fourZSquaredMinus1 > fourBiggestSquaredMinus1)
+				{
+					fourBiggestSquaredMinus1 = fourZSquaredMinus1;
+					biggestIndex = 3;
+				}
+
+				const float biggestVal = std::sqrt(fourBiggestSquaredMinus1 + 1.f) * 0.5f;
+				const float mult = 0.25f / biggestVal;
+				const float m12MinusM21 = (-fy - uz) * mult, m20MinusM02 = (sz - -fx) * mult,
+				            m01MinusM10 = (ux - sy) * mult;
+				float qx, qy, qz, qw;
+				switch (biggestIndex)
+				{
+				case 0:
+					qw = biggestVal;
+					qx = m12MinusM21;
+					qy = m20MinusM02;
+					qz = m01MinusM10;
+					break;
+				case 1:
+					qw = m12MinusM21;
+					qx = biggestVal;
+					qy = (ux + sy) * mult;
+					qz = (sz + -fx) * mult;
+					break;
+				case 2:
+					qw = m20MinusM02;
+					qx = (ux + sy) * mult;
+					qy = biggestVal;
+					qz = (-fy + uz) * mult;
+					break;
+				default:
+					qw = m01MinusM10;
+					qx = (sz + -fx) * mult;
+					qy = (-fy + uz) * mult;
+					qz = biggestVal;
+					break;
+				}
+
+				// Euler angles, as glm's pitch, yaw and roll
+				const float pitchY = 2.f * (qy * qz + qw * qx);
+				const float pitchX = qw * qw - qx * qx - qy * qy + qz * qz;
+				const float epsilon = 1.1920928955078125e-07f; // std::numeric_limits<float>::epsilon()
+				out.x[i] = std::fabs(pitchX) <= epsilon && std::fabs(pitchY) <= epsilon
+					           ? 2.f * std::atan2(qx, qw) // Avoid atan2(0, 0)
+					           : std::atan2(pitchY, pitchX);
+
+				const float sinYaw = -2.f * (qx * qz - qw * qy);
+				out.y[i] = std::asin(sinYaw < -1.f ? -1.f : sinYaw > 1.f ? 1.f : sinYaw);
+
+				out.z[i] = std::atan2(2.f * (qx * qy + qw * qz), qw * qw + qx * qx - qy * qy - qz * qz);
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+// Decides whether (and when) to bring a crashed process back
+// Each crash in the window doubles the delay, too many crashes and it stays down
+class RestartPolicy
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit RestartPolicy(int maxRestarts = 5,
+	                       clock::duration window = std::chrono::minutes(2),
+	                       clock::duration firstDelay = std::chrono::milliseconds(500),
+	                       clock::duration maxDelay = std::chrono::seconds(8))
+		: m_maxRestarts(maxRestarts),
+		  m_window(window),
+		  m_firstDelay(firstDelay),
+		  m_maxDelay(maxDelay)
+	{
+	}
+
+	// False once the process crashed maxRestarts times within the window
+	bool onCrash(clock::time_point now, clock::duration& delay)
+	{
+		while (!m_crashes.empty() && now - m_crashes.front() > m_window)
+			m_crashes.pop_front();
+		if (static_cast<int>(m_crashes.size()) >= m_maxRestarts)
+			return false;
+
+		delay = std::min<clock::duration>(m_firstDelay * (1 << m_crashes.size()), m_maxDelay);
+		m_crashes.push_back(now);
+		return true;
+	}
+
+private:
+	const int m_maxRestarts;
+	const clock::duration m_window;
+	const clock::duration m_firstDelay;
+	const clock::duration m_maxDelay;
+	std::deque<clock::time_point> m_crashes;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer, many-reader snapshot slot
+// The writer never blocks, readers retry if they raced a store
+// Only meant for plain C structs (PSMPSMove, PSMController...) which are copied as bytes
+template <typename T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload has to be trivially copyable");
+
+public:
+	SeqLock()
+	{
+		std::memset(&m_value, 0, sizeof(T));
+	}
+
+	SeqLock(const SeqLock&) = delete;
+	SeqLock& operator=(const SeqLock&) = delete;
+
+	void store(const T& value)
+	{
+		const uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(seq + 1, std::memory_order_relaxed); // Odd = write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+
+		std::memcpy(&m_value, &value, sizeof(T));
+
+		std::atomic_thread_fence(std::memory_order_release);
+		m_sequence.store(seq + 2, std::memory_order_relaxed);
+	}
+
+	T load() const
+	{
+		T value;
+		uint32_t before, after;
+		do
+		{
+			before = m_sequence.load(std::memory_order_acquire);
+			std::memcpy(&value, &m_value, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = m_sequence.load(std::memory_order_relaxed);
+		}
+		while (before != after || (before & 1));
+		return value;
+	}
+
+	// Increments on every store, lets readers skip unchanged data
+	uint32_t version() const
+	{
+		return m_sequence.load(std::memory_order_acquire) >> 1;
+	}
+
+private:
+	std::atomic<uint32_t> m_sequence{0};
+	T m_value;
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// Writes config files off the GUI/tracking thread
+// Callers serialize in memory and queue the result, only the newest contents of
+// each file get written once things have been quiet for a moment. Files are
+// written next to the target and renamed over it, so a crash never leaves half a config
+class SettingsWriter
+{
+public:
+	using clock = std::chrono::steady_clock;
+	// Returns false if the file couldn't be replaced
+	using FileSink = std::function<bool(const std::wstring& path, const std::string& contents)>;
+
+	static SettingsWriter& get()
+	{
+		static SettingsWriter writer;
+		return writer;
+	}
+
+	explicit SettingsWriter(FileSink sink = writeFile)
+		: m_sink(std::move(sink))
+	{
+	}
+
+	~SettingsWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_keepRunning = false;
+		}
+		m_wake.notify_one();
+		if (m_thread.joinable())
+			m_thread.join();
+		flush();
+	}
+
+	SettingsWriter(const SettingsWriter&) = delete;
+	SettingsWriter& operator=(const SettingsWriter&) = delete;
+
+	// Replaces anything still waiting to be written to the same file
+	void queue(const std::wstring& path, std::string contents)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			const auto now = clock::now();
+			if (m_pending.empty())
+				m_firstQueued = now;
+			m_lastQueued = now;
+			m_pending[path] = std::move(contents);
+
+			if (!m_thread.joinable() && m_keepRunning)
+				m_thread = std::thread(&SettingsWriter::run, this);
+		}
+		m_wake.notify_one();
+	}
+
+	// Writes everything queued so far before returning, use before exiting
+	void flush()
+	{
+		std::lock_guard<std::mutex> writeLock(m_writeMutex);
+		writePending();
+	}
+
+	// Writes next to the target, then renames over it
+	static bool writeFile(const std::wstring& path, const std::string& contents)
+	{
+		const std::wstring tempPath = path + L".tmp";
+		{
+			std::ofstream os(std::filesystem::path(tempPath), std::ios::binary | std::ios::trunc);
+			if (os.fail())
+			{
+				LOG(ERROR) << "ERROR: COULD NOT WRITE TO SETTINGS FILE " << path;
+				return false;
+			}
+			os.write(contents.data(), contents.size());
+			os.flush();
+			if (os.fail())
+			{
+				LOG(ERROR) << "ERROR: COULD NOT WRITE TO SETTINGS FILE " << path;
+				return false;
+			}
+		}
+
+#ifdef _WIN32
+		if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			LOG(ERROR) << "ERROR: COULD NOT REPLACE SETTINGS FILE " << path << ", error " << GetLastError();
+			return false;
+		}
+#else
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			LOG(ERROR) << "ERROR: COULD NOT REPLACE SETTINGS FILE " << path << ", error " << error.value();
+			return false;
+		}
+#endif
+		LOG(INFO) << "Saved settings to " << path;
+		return true;
+	}
+
+private:
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_keepRunning)
+		{
+			if (m_pending.empty())
+			{
+				m_wake.wait(lock);
+				continue;
+			}
+
+			// Wait for the user to stop clicking around, but not forever
+			const auto due = std::min(m_lastQueued + k_quietPeriod, m_firstQueued + k_maxDelay);
+			if (clock::now() < due)
+			{
+				m_wake.wait_until(lock, due);
+				continue;
+			}
+
+			lock.unlock();
+			flush();
+			lock.lock();
+		}
+	}
+
+	// Caller holds m_writeMutex, so contents are taken and written in order
+	void writePending()
+	{
+		std::map<std::wstring, std::string> files;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			files.swap(m_pending);
+		}
+		for (const auto& file : files)
+			m_sink(file.first, file.second);
+	}
+
+	static constexpr std::chrono::milliseconds k_quietPeriod{500};
+	static constexpr std::chrono::milliseconds k_maxDelay{3000};
+
+	FileSink m_sink;
+	std::thread m_thread;
+	bool m_keepRunning = true;
+
+	std::mutex m_writeMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::map<std::wstring, std::string> m_pending;
+	clock::time_point m_firstQueued;
+	clock::time_point m_lastQueued;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "KinectJointMap.h"
+
+// Skeleton overlay for the Kinect handlers: bones and joints go into one
+// persistent vertex array and reach the window in a single draw call
+// The geometry builder has no window or SDK dependency, handlers map their
+// own tracking states and bone lists onto it
+namespace SkeletonOverlay
+{
+	enum class JointState : uint8_t
+	{
+		NotTracked,
+		Inferred,
+		Tracked
+	};
+
+	// Bone tables come from KinectJointMap.h, in the handler's own joint indices
+	using Bone = KVR::JointBone;
+
+	struct Style
+	{
+		float trackedBoneThickness = 6.f;
+		float inferredBoneThickness = 1.5f;
+		float jointRadius = 4.f;
+		sf::Color trackedBone = sf::Color::Green;
+		sf::Color inferredBone = sf::Color::Red;
+		sf::Color trackedJoint = sf::Color::Yellow;
+		sf::Color inferredJoint = sf::Color::Red;
+
+		bool operator==(const Style& other) const
+		{
+			return trackedBoneThickness == other.trackedBoneThickness &&
+				inferredBoneThickness == other.inferredBoneThickness &&
+				jointRadius == other.jointRadius &&
+				trackedBone == other.trackedBone && inferredBone == other.inferredBone &&
+				trackedJoint == other.trackedJoint && inferredJoint == other.inferredJoint;
+		}
+
+		bool operator!=(const Style& other) const { return !(*this == other); }
+	};
+
+	class Renderer : public sf::Drawable
+	{
+	public:
+		// Same tessellation sf::CircleShape uses by default
+		static constexpr int k_circleSegments = 30;
+
+		Renderer()
+			: m_vertices(sf::Triangles)
+		{
+			const float pi = 3.141592654f;
+			for (int i = 0; i < k_circleSegments; ++i)
+			{
+				const float angle = i * 2.f * pi / k_circleSegments - pi / 2.f;
+				m_unitCircle[i] = sf::Vector2f(std::cos(angle), std::sin(angle));
+			}
+		}
+
+		// The bone table has to outlive the renderer, the handlers pass static tables
+		// Rebuilds the geometry only if a point, a state, the bones or the style changed since the last call
+		// Returns true if it did
+		bool update(const Bone* bones, size_t boneCount,
+		            const sf::Vector2f* points, const JointState* states, size_t jointCount, const Style& style)
+		{
+			if (m_valid && bones == m_bones && boneCount == m_boneCount && style == m_style &&
+				jointCount == m_points.size() &&
+				std::memcmp(points, m_points.data(), jointCount * sizeof(sf::Vector2f)) == 0 &&
+				std::memcmp(states, m_states.data(), jointCount * sizeof(JointState)) == 0)
+				return false;
+
+			m_bones = bones;
+			m_boneCount = boneCount;
+			m_points.assign(points, points + jointCount);
+			m_states.assign(states, states + jointCount);
+			m_style = style;
+			m_valid = true;
+			rebuild();
+			return true;
+		}
+
+		void clear()
+		{
+			m_vertices.clear();
+			m_valid = false;
+		}
+
+		const sf::VertexArray& vertices() const { return m_vertices; }
+
+		void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+		{
+			if (m_vertices.getVertexCount() > 0)
+				target.draw(m_vertices, states);
+		}
+
+	private:
+		void rebuild()
+		{
+			m_vertices.clear();
+
+			for (size_t b = 0; b < m_boneCount; ++b)
+			{
+				const Bone& bone = m_bones[b];
+				if (bone.from < 0 || bone.to < 0 ||
+					bone.from >= static_cast<int>(m_points.size()) || bone.to >= static_cast<int>(m_points.size()))
+					continue;
+
+				const JointState from = m_states[bone.from];
+				const JointState to = m_states[bone.to];
+				// Nothing for lost joints or bones with both ends guessed
+				if (from == JointState::NotTracked || to == JointState::NotTracked ||
+					(from == JointState::Inferred && to == JointState::Inferred))
+					continue;
+
+				// Inferred unless both ends are tracked
+				if (from == JointState::Tracked && to == JointState::Tracked)
+					appendBone(m_points[bone.from], m_points[bone.to], m_style.trackedBoneThickness, m_style.trackedBone);
+				else
+					appendBone(m_points[bone.from], m_points[bone.to], m_style.inferredBoneThickness, m_style.inferredBone);
+			}
+
+			for (size_t i = 0; i < m_points.size(); ++i)
+			{
+				if (m_states[i] == JointState::Tracked)
+					appendJoint(m_points[i], m_style.trackedJoint);
+				else if (m_states[i] == JointState::Inferred)
+					appendJoint(m_points[i], m_style.inferredJoint);
+			}
+		}
+
+		void appendBone(sf::Vector2f start, sf::Vector2f end, float thickness, sf::Color colour)
+		{
+			const sf::Vector2f direction = end - start;
+			const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+			if (length <= 0.f)
+				return;
+
+			const sf::Vector2f offset = sf::Vector2f(-direction.y, direction.x) * (thickness / 2.f / length);
+			const sf::Vertex quad[4] = {
+				{start + offset, colour}, {end + offset, colour}, {end - offset, colour}, {start - offset, colour}
+			};
+			m_vertices.append(quad[0]);
+			m_vertices.append(quad[1]);
+			m_vertices.append(quad[2]);
+			m_vertices.append(quad[0]);
+			m_vertices.append(quad[2]);
+			m_vertices.append(quad[3]);
+		}
+
+		// Positioned like sf::CircleShape: the point is the top left of the bounding box
+		void appendJoint(sf::Vector2f position, sf::Color colour)
+		{
+			const float radius = m_style.jointRadius;
+			const sf::Vector2f centre = position + sf::Vector2f(radius, radius);
+			for (int i = 0; i < k_circleSegments; ++i)
+			{
+				m_vertices.append(sf::Vertex(centre, colour));
+				m_vertices.append(sf::Vertex(centre + m_unitCircle[i] * radius, colour));
+				m_vertices.append(sf::Vertex(centre + m_unitCircle[(i + 1) % k_circleSegments] * radius, colour));
+			}
+		}
+
+		sf::VertexArray m_vertices;
+		sf::Vector2f m_unitCircle[k_circleSegments];
+		const Bone* m_bones = nullptr;
+		size_t m_boneCount = 0;
+		std::vector<sf::Vector2f> m_points;
+		std::vector<JointState> m_states;
+		Style m_style;
+		bool m_valid = false;
+	};
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// Startup waits on what it depends on instead of sleeping for a fixed time
+// Each subsystem reports ready through a gate, an event or a condition that can be asked,
+// and a sequence waits on them in order, each step with its own timeout
+namespace Readiness
+{
+	using clock = std::chrono::steady_clock;
+
+	// Latch for subsystems living in this process
+	class Gate
+	{
+	public:
+		void signal()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_ready = true;
+			}
+			m_changed.notify_all();
+		}
+
+		void reset()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_ready = false;
+		}
+
+		bool isSet() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_ready;
+		}
+
+		bool waitFor(clock::duration timeout) const
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_changed.wait_for(lock, timeout, [this] { return m_ready; });
+		}
+
+	private:
+		mutable std::mutex m_mutex;
+		mutable std::condition_variable m_changed;
+		bool m_ready = false;
+	};
+
+	// For state that can only be asked, not waited on: asks again every pollInterval
+	template <typename Predicate>
+	bool waitUntil(Predicate ready, clock::duration timeout,
+	               clock::duration pollInterval = std::chrono::milliseconds(10))
+	{
+		const clock::time_point deadline = clock::now() + timeout;
+		while (!ready())
+		{
+			const clock::time_point now = clock::now();
+			if (now >= deadline)
+				return false;
+			std::this_thread::sleep_for(deadline - now < pollInterval ? deadline - now : pollInterval);
+		}
+		return true;
+	}
+
+	class Sequence
+	{
+	public:
+		// Gets the step's timeout, returns whether the subsystem came up in time
+		using Wait = std::function<bool(clock::duration timeout)>;
+
+		struct StepResult
+		{
+			std::string name;
+			bool ready;
+			clock::duration elapsed;
+		};
+
+		Sequence& step(std::string name, clock::duration timeout, Wait wait)
+		{
+			m_steps.push_back({std::move(name), timeout, std::move(wait)});
+			return *this;
+		}
+
+		// Waits on the steps in order and stops at the first one that times out
+		bool run()
+		{
+			m_results.clear();
+			for (const Step& step : m_steps)
+			{
+				const clock::time_point start = clock::now();
+				const bool ready = step.wait(step.timeout);
+				m_results.push_back({step.name, ready, clock::now() - start});
+				if (!ready)
+					return false;
+			}
+			return true;
+		}
+
+		const std::vector<StepResult>& results() const { return m_results; }
+
+		// "driver pipes 12ms, VR runtime timed out after 10000ms"
+		std::string summary() const
+		{
+			std::string text;
+			for (const StepResult& result : m_results)
+			{
+				if (!text.empty())
+					text += ", ";
+				const long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(result.elapsed).count();
+				text += result.name + (result.ready ? " " : " timed out after ") + std::to_string(ms) + "ms";
+			}
+			return text;
+		}
+
+	private:
+		struct Step
+		{
+			std::string name;
+			clock::duration timeout;
+			Wait wait;
+		};
+
+		std::vector<Step> m_steps;
+		std::vector<StepResult> m_results;
+	};
+
+#ifdef _WIN32
+	// Set by the driver while it serves its pipes
+	constexpr const wchar_t* k_driverPipesReady = L"Local\\K2VR_DriverPipesReady";
+
+	inline DWORD timeoutMilliseconds(clock::duration timeout)
+	{
+		const long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count();
+		return ms <= 0 ? 0 : ms >= INFINITE ? INFINITE - 1 : static_cast<DWORD>(ms);
+	}
+
+	// Manual reset event shared across processes
+	// Both sides create it, so it doesn't matter which one comes up first
+	class NamedEvent
+	{
+	public:
+		explicit NamedEvent(const wchar_t* name)
+			: m_event(CreateEventW(nullptr, TRUE, FALSE, name))
+		{
+		}
+
+		~NamedEvent()
+		{
+			if (m_event)
+				CloseHandle(m_event);
+		}
+
+		NamedEvent(const NamedEvent&) = delete;
+		NamedEvent& operator=(const NamedEvent&) = delete;
+
+		void signal()
+		{
+			if (m_event)
+				SetEvent(m_event);
+		}
+
+		void reset()
+		{
+			if (m_event)
+				ResetEvent(m_event);
+		}
+
+		bool waitFor(clock::duration timeout) const
+		{
+			return m_event && WaitForSingleObject(m_event, timeoutMilliseconds(timeout)) == WAIT_OBJECT_0;
+		}
+
+	private:
+		HANDLE m_event;
+	};
+
+	// Waits on a change notification handle until ready() holds, ready() is asked first
+	// and after every signal, so it can also consume whatever the signal carries
+	template <typename Predicate>
+	bool waitForHandle(HANDLE handle, Predicate ready, clock::duration timeout)
+	{
+		const clock::time_point deadline = clock::now() + timeout;
+		while (!ready())
+		{
+			const clock::time_point now = clock::now();
+			if (now >= deadline || WaitForSingleObject(handle, timeoutMilliseconds(deadline - now)) != WAIT_OBJECT_0)
+				return ready();
+		}
+		return true;
+	}
+#endif
+}
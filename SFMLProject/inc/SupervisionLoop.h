@@ -0,0 +1,41 @@
+#pragma once
+#include "RestartPolicy.h"
+
+namespace Supervision
+{
+	// Why a supervision loop stopped
+	enum class LoopEnd
+	{
+		Closed, // The process exited with 0
+		NoRestart, // It crashed with nothing to restart it with
+		CrashLoop, // It crashed too often for the policy
+		LaunchFailed, // Starting it again failed
+	};
+
+	// Waits for the process to exit, calls onExit, and restarts it after each crash for as long as the policy lets
+	// it. Free of the OS handles: waitForExit blocks until the process is gone and returns its exit code, relaunch
+	// starts the next one, false if it couldn't, and sleep waits out the policy's delay before that
+	template <typename WaitForExit, typename OnExit, typename Relaunch, typename Sleep>
+	LoopEnd superviseLoop(RestartPolicy& policy, bool canRestart, WaitForExit waitForExit, OnExit onExit,
+	                      Relaunch relaunch, Sleep sleep)
+	{
+		while (true)
+		{
+			const auto exitCode = waitForExit();
+			onExit();
+
+			if (exitCode == 0)
+				return LoopEnd::Closed;
+			if (!canRestart)
+				return LoopEnd::NoRestart;
+
+			RestartPolicy::clock::duration delay{};
+			if (!policy.onCrash(RestartPolicy::clock::now(), delay))
+				return LoopEnd::CrashLoop; // Leave it down
+
+			sleep(delay);
+			if (!relaunch())
+				return LoopEnd::LaunchFailed;
+		}
+	}
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <openvr.h>
+
+// The SteamVR Input actions of one action set, updated together once per frame
+//
+// update() makes the one UpdateActionState call for the set, then reads every bound action from the state
+// that fetched. Digital actions whose state changed since the last update are also queued as events, so
+// presses and releases between two frames of the caller aren't lost and nobody needs to keep the previous state.
+// An action can be bound more than once, restricted to different input sources (/user/hand/left, ...)
+//
+// Takes the IVRInput to use instead of calling vr::VRInput(), so it can be driven by a mock
+class VRActionInput
+{
+public:
+	typedef int ActionId; // Index of a binding, -1 when it couldn't be set up
+
+	static constexpr size_t k_maxQueuedEvents = 64; // Oldest are dropped when nobody polls them
+
+	struct DigitalEvent
+	{
+		ActionId action;
+		bool pressed; // False on release
+		float updateTime; // Seconds relative to now, as in InputDigitalActionData_t
+	};
+
+	// Returns the error from looking up the action set, the manifest has to be set before
+	vr::EVRInputError init(vr::IVRInput* input, const char* actionSetPath)
+	{
+		m_input = input;
+		bindings.clear();
+		events.clear();
+		legacyMode = false;
+		activeSet = {};
+		activeSet.ulRestrictedToDevice = vr::k_ulInvalidInputValueHandle;
+		activeSet.nPriority = 0;
+		return m_input->GetActionSetHandle(actionSetPath, &activeSet.ulActionSet);
+	}
+
+	ActionId addDigital(const char* actionPath, const char* restrictToSourcePath = nullptr)
+	{
+		return add(Binding::Type::Digital, actionPath, restrictToSourcePath);
+	}
+
+	ActionId addAnalog(const char* actionPath, const char* restrictToSourcePath = nullptr)
+	{
+		return add(Binding::Type::Analog, actionPath, restrictToSourcePath);
+	}
+
+	// Returns the first error, InvalidHandle means SteamVR put the application into legacy input mode
+	vr::EVRInputError update()
+	{
+		if (m_input == nullptr)
+			return vr::VRInputError_InvalidHandle;
+
+		vr::EVRInputError error = m_input->UpdateActionState(&activeSet, sizeof(activeSet), 1);
+		if (error != vr::VRInputError_None)
+		{
+			for (auto& binding : bindings)
+			{
+				binding.digital = {};
+				binding.analog = {};
+			}
+			legacyMode = error == vr::VRInputError_InvalidHandle;
+			return error;
+		}
+
+		for (size_t i = 0; i < bindings.size(); ++i)
+		{
+			Binding& binding = bindings[i];
+			vr::EVRInputError actionError;
+			if (binding.type == Binding::Type::Digital)
+			{
+				actionError = m_input->GetDigitalActionData(binding.action, &binding.digital, sizeof(binding.digital),
+				                                            binding.restrictToSource);
+				if (actionError == vr::VRInputError_None && binding.digital.bActive && binding.digital.bChanged)
+				{
+					if (events.size() == k_maxQueuedEvents)
+						events.pop_front();
+					events.push_back({static_cast<ActionId>(i), binding.digital.bState, binding.digital.fUpdateTime});
+				}
+			}
+			else
+			{
+				actionError = m_input->GetAnalogActionData(binding.action, &binding.analog, sizeof(binding.analog),
+				                                           binding.restrictToSource);
+			}
+			if (actionError != vr::VRInputError_None)
+			{
+				binding.digital = {};
+				binding.analog = {};
+				if (error == vr::VRInputError_None)
+					error = actionError;
+			}
+		}
+		legacyMode = error == vr::VRInputError_InvalidHandle;
+		return error;
+	}
+
+	// Takes the oldest queued press or release, false when there is none
+	bool pollEvent(DigitalEvent& event)
+	{
+		if (events.empty())
+			return false;
+		event = events.front();
+		events.pop_front();
+		return true;
+	}
+
+	// Not bound to anything, the device isn't there, or the last update failed
+	bool isActive(ActionId id) const
+	{
+		if (!isValid(id))
+			return false;
+		return bindings[id].type == Binding::Type::Digital ? bindings[id].digital.bActive : bindings[id].analog.bActive;
+	}
+
+	bool getState(ActionId id) const
+	{
+		return isValid(id) && bindings[id].digital.bActive && bindings[id].digital.bState;
+	}
+
+	const vr::InputAnalogActionData_t& getAnalog(ActionId id) const
+	{
+		static const vr::InputAnalogActionData_t inactive = {};
+		return isValid(id) ? bindings[id].analog : inactive;
+	}
+
+	bool isLegacyMode() const { return legacyMode; }
+
+	// Whether the text of an action manifest names the action. SteamVR matches action paths without
+	// regard to case, so this does too; a manifest missing one leaves that action unbound whatever the user does
+	static bool manifestDeclares(const std::string& manifest, const char* actionPath)
+	{
+		const std::string quoted = '"' + std::string(actionPath) + '"';
+		auto equalIgnoringCase = [](char a, char b)
+		{
+			return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+		};
+		return std::search(manifest.begin(), manifest.end(), quoted.begin(), quoted.end(), equalIgnoringCase)
+			!= manifest.end();
+	}
+
+	vr::VRActionHandle_t getHandle(ActionId id) const
+	{
+		return isValid(id) ? bindings[id].action : vr::k_ulInvalidActionHandle;
+	}
+
+	const vr::VRActiveActionSet_t& getActiveSet() const { return activeSet; }
+
+private:
+	struct Binding
+	{
+		enum class Type { Digital, Analog };
+
+		Type type;
+		vr::VRActionHandle_t action;
+		vr::VRInputValueHandle_t restrictToSource;
+		vr::InputDigitalActionData_t digital;
+		vr::InputAnalogActionData_t analog;
+	};
+
+	ActionId add(Binding::Type type, const char* actionPath, const char* restrictToSourcePath)
+	{
+		if (m_input == nullptr)
+			return -1;
+
+		Binding binding = {};
+		binding.type = type;
+		binding.restrictToSource = vr::k_ulInvalidInputValueHandle;
+		if (m_input->GetActionHandle(actionPath, &binding.action) != vr::VRInputError_None)
+			return -1;
+		if (restrictToSourcePath != nullptr
+			&& m_input->GetInputSourceHandle(restrictToSourcePath, &binding.restrictToSource) != vr::VRInputError_None)
+			return -1;
+
+		bindings.push_back(binding);
+		return static_cast<ActionId>(bindings.size() - 1);
+	}
+
+	bool isValid(ActionId id) const
+	{
+		return id >= 0 && static_cast<size_t>(id) < bindings.size();
+	}
+
+	vr::IVRInput* m_input = nullptr;
+	vr::VRActiveActionSet_t activeSet = {};
+	std::vector<Binding> bindings;
+	std::deque<DigitalEvent> events;
+	bool legacyMode = false;
+};
@@ -35,6 +35,26 @@ public:
 		return false;
 	}
 
+	// Give every event from PollNextEvent here, the device for the role is only looked up again when
+	// SteamVR says the roles or the devices changed instead of every frame
+	void handleEvent(const vr::VREvent_t& event)
+	{
+		if (m_HMDSystem == nullptr)
+			return;
+		switch (event.eventType)
+		{
+		case vr::VREvent_TrackedDeviceRoleChanged:
+		case vr::VREvent_TrackedDeviceActivated:
+		case vr::VREvent_TrackedDeviceDeactivated:
+			controllerID = m_HMDSystem->GetTrackedDeviceIndexForControllerRole(controllerType);
+			if (controllerID == vr::k_unTrackedDeviceIndexInvalid)
+				lastStateValid = false;
+			break;
+		default:
+			break;
+		}
+	}
+
 	bool isConnected()
 	{
 		if (m_HMDSystem != nullptr)
@@ -51,36 +71,25 @@ public:
 	void update(float delta)
 	{
 		deltaTime = delta;
-		if (m_HMDSystem != nullptr)
+		if (m_HMDSystem != nullptr && controllerID != vr::k_unTrackedDeviceIndexInvalid)
 		{
-			if (controllerID == vr::k_unTrackedDeviceIndexInvalid)
+			// The one call per frame, the state comes with the pose
+			const vr::VRControllerState_t previousState = state_;
+			lastStateValid = m_HMDSystem->GetControllerStateWithPose(
+				vr::ETrackingUniverseOrigin::TrackingUniverseStanding, controllerID, &state_, sizeof(state_),
+				&controllerPose);
+			if (lastStateValid)
 			{
-				controllerID = m_HMDSystem->GetTrackedDeviceIndexForControllerRole(controllerType);
+				prevState_ = previousState;
 			}
-			else
-			{
-				lastStateValid = m_HMDSystem->GetControllerStateWithPose(
-					vr::ETrackingUniverseOrigin::TrackingUniverseStanding, controllerID, &state_, sizeof(state_),
-					&controllerPose);
-				if (lastStateValid)
-				{
-					prevState_ = state_;
-				}
-
-				if (m_HMDSystem->GetControllerRoleForTrackedDeviceIndex(controllerID) ==
-					vr::TrackedControllerRole_LeftHand)
-				{
-					vr::TrackedDevicePose_t trackedDevicePose[vr::k_unMaxTrackedDeviceCount];
-					m_HMDSystem->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0, trackedDevicePose,
-					                                             vr::k_unMaxTrackedDeviceCount);
-					//std::cout << trackedDevicePose[hID].mDeviceToAbsoluteTracking.m[0][3] << ' ' << trackedDevicePose[hID].mDeviceToAbsoluteTracking.m[1][3] << ' ' << trackedDevicePose[hID].mDeviceToAbsoluteTracking.m[2][3] << '\n';
 
-					KinectSettings::controllersPose[0] = trackedDevicePose[controllerID];
-				}
-
-				UpdateTrigger();
-				//UpdateHapticPulse();
+			if (controllerType == vr::TrackedControllerRole_LeftHand && lastStateValid)
+			{
+				KinectSettings::controllersPose[0] = controllerPose;
 			}
+
+			UpdateTrigger();
+			//UpdateHapticPulse();
 		}
 	}
 
@@ -274,10 +283,10 @@ public:
 	}
 
 private:
-	vr::TrackedDeviceIndex_t controllerID;
-	vr::TrackedDevicePose_t controllerPose;
-	vr::VRControllerState_t state_;
-	vr::VRControllerState_t prevState_;
+	vr::TrackedDeviceIndex_t controllerID = vr::k_unTrackedDeviceIndexInvalid;
+	vr::TrackedDevicePose_t controllerPose = {};
+	vr::VRControllerState_t state_ = {};
+	vr::VRControllerState_t prevState_ = {};
 
 
 	float lerp(float start, float finish, float alpha)
@@ -300,16 +309,16 @@ private:
 	HapticPulse controllerPulse;
 
 	bool triggerOn;
-	bool triggerPrevOn;
+	bool triggerPrevOn = false;
 	float triggerDeadzone;
 	float triggerLimit;
 
-	bool gripOn;
-	bool gripPrevOn;
+	bool gripOn = false;
+	bool gripPrevOn = false;
 
-	bool lastStateValid;
-	float deltaTime;
-	vr::IVRSystem* m_HMDSystem;
+	bool lastStateValid = false;
+	float deltaTime = 0;
+	vr::IVRSystem* m_HMDSystem = nullptr;
 	vr::ETrackedControllerRole controllerType;
 
 	bool OverrideTrackedPosWithKinect = false;
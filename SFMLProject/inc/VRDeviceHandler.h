@@ -15,19 +15,18 @@
 #include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <KinectSettings.h>
+#include "SettingsWriter.h"
+#include "VirtualHipsSolver.h"
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
 
 #include <cereal/cereal.hpp>
 #include <cereal/archives/binary.hpp>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/split_free.hpp>
 
-enum class VirtualHipMode
-{
-	Standing,
-	Sitting,
-	Lying
-};
-
 struct VirtualHipSettings
 {
 	bool followHmdYawRotation = true;
@@ -80,6 +79,9 @@ struct VirtualHipSettings
 	// Meters. Essentially how wide the hips are, so that when lying down, they are put slightly above the ground
 	double lyingMaxHeightThreshold = 0.00; // Meters. Under this height, mode is lying
 
+	// Take the IMU yaw drift of PSMove feet/waist and IMU rotated trackers out with the Kinect bones
+	bool correctIMUYawDrift = false;
+
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
@@ -120,6 +122,14 @@ struct VirtualHipSettings
 			CEREAL_NVP(rcR_matT_S),
 			CEREAL_NVP(rcT_matT_S)
 		);
+		try
+		{
+			archive(CEREAL_NVP(correctIMUYawDrift));
+		}
+		catch (cereal::Exception&)
+		{
+			// Configs from before it was added don't have it, they keep the default
+		}
 	}
 };
 
@@ -154,22 +164,28 @@ namespace VirtualHips
 	VirtualHipSettings settings;
 	static const std::wstring settingsConfig = L"ConfigSettings.cfg";
 
-	void saveSettings()
+	// Saves also come from the calibration threads, so every change to settings holds this
+	// and the writer never serializes a half-updated struct. Recursive, so a change can save before it unlocks
+	static std::recursive_mutex settingsMutex;
+
+	inline std::unique_lock<std::recursive_mutex> lockSettings()
 	{
-		decomposeEigen(settings);
+		return std::unique_lock<std::recursive_mutex>(settingsMutex);
+	}
+	// The file is parsed once, afterwards settings is the authoritative copy
+	static bool settingsLoaded = false;
+	static bool settingsUsable = false;
 
-		std::ofstream os(KVR::fileToDirPath(settingsConfig));
-		if (os.fail())
-		{
-			//FAIL!!!
-			LOG(ERROR) << "ERROR: COULD NOT WRITE TO SETTINGS FILE\n";
-		}
-		else
+	void saveSettings()
+	{
+		std::ostringstream os;
 		{
-			cereal::JSONOutputArchive archive(os);
-			LOG(INFO) << "Attempted to save settings to file";
+			std::lock_guard<std::recursive_mutex> lock(settingsMutex);
+			decomposeEigen(settings);
+
 			try
 			{
+				cereal::JSONOutputArchive archive(os);
 				archive(
 					CEREAL_NVP(settings)
 				);
@@ -177,11 +193,13 @@ namespace VirtualHips
 			catch (cereal::RapidJSONException e)
 			{
 				LOG(ERROR) << "CONFIG FILE SAVE JSON ERROR: " << e.what();
+				return;
 			}
 		}
+		SettingsWriter::get().queue(KVR::fileToDirPath(settingsConfig), os.str());
 	}
 
-	void retrieveSettings()
+	bool loadSettingsFile()
 	{
 		std::ifstream is(KVR::fileToDirPath(settingsConfig));
 		LOG(INFO) << "Attempted to load settings at " << KVR::fileToDirPath(settingsConfig);
@@ -190,55 +208,74 @@ namespace VirtualHips
 		{
 			LOG(ERROR) << "Settings file could not be found, generating a new one...";
 			saveSettings();
+			settingsUsable = true;
+			return false;
 		}
-		else
+
+		LOG(INFO) << settingsConfig << " load attempted!";
+		try
 		{
-			LOG(INFO) << settingsConfig << " load attempted!";
-			try
-			{
-				cereal::JSONInputArchive archive(is);
-				archive(CEREAL_NVP(settings));
+			std::lock_guard<std::recursive_mutex> lock(settingsMutex);
+			cereal::JSONInputArchive archive(is);
+			archive(CEREAL_NVP(settings));
 
-				recomposeEigen(settings);
+			recomposeEigen(settings);
+		}
+		catch (cereal::Exception e)
+		{
+			LOG(ERROR) << settingsConfig << "SETTINGS FILE LOAD JSON ERROR: " << e.what();
+			return false;
+		}
+		settingsUsable = true;
+		return true;
+	}
+
+	void retrieveSettings()
+	{
+		if (!settingsLoaded)
+		{
+			settingsLoaded = true;
+			if (!loadSettingsFile())
+				return;
+		}
+		else if (!settingsUsable)
+			return;
 
-				KinectSettings::hroffset = settings.hmdegree;
-				KinectSettings::cpoints = settings.tdegree;
+		std::lock_guard<std::recursive_mutex> lock(settingsMutex);
 
-				KinectSettings::calibration_rotation = settings.rcR_matT;
-				KinectSettings::calibration_translation = settings.rcT_matT;
+		KinectSettings::hroffset = settings.hmdegree;
+		KinectSettings::cpoints = settings.tdegree;
 
-				KinectSettings::huoffsets.v[0] = settings.heightFromHMD;
-				KinectSettings::huoffsets.v[1] = settings.sittingMaxHeightThreshold;
-				KinectSettings::huoffsets.v[2] = settings.lyingMaxHeightThreshold;
+		KinectSettings::calibration_rotation = settings.rcR_matT;
+		KinectSettings::calibration_translation = settings.rcT_matT;
 
-				KinectSettings::matrixes_calibrated = settings.rtcalib;
-				KinectSettings::calibration_trackers_yaw = settings.tryawst;
-				KinectSettings::calibration_kinect_pitch = settings.kinpitchst;
+		KinectSettings::huoffsets.v[0] = settings.heightFromHMD;
+		KinectSettings::huoffsets.v[1] = settings.sittingMaxHeightThreshold;
+		KinectSettings::huoffsets.v[2] = settings.lyingMaxHeightThreshold;
 
-				KinectSettings::hauoffset.v[0] = settings.hauoffset_s(0);
-				KinectSettings::hauoffset.v[1] = settings.hauoffset_s(1);
-				KinectSettings::hauoffset.v[2] = settings.hauoffset_s(2);
+		KinectSettings::matrixes_calibrated = settings.rtcalib;
+		KinectSettings::calibration_trackers_yaw = settings.tryawst;
+		KinectSettings::calibration_kinect_pitch = settings.kinpitchst;
 
-				KinectSettings::mauoffset.v[0] = settings.mauoffset_s(0);
-				KinectSettings::mauoffset.v[1] = settings.mauoffset_s(1);
-				KinectSettings::mauoffset.v[2] = settings.mauoffset_s(2);
+		KinectSettings::hauoffset.v[0] = settings.hauoffset_s(0);
+		KinectSettings::hauoffset.v[1] = settings.hauoffset_s(1);
+		KinectSettings::hauoffset.v[2] = settings.hauoffset_s(2);
 
-				footOrientationFilterOption.filterOption = static_cast<footRotationFilterOption>(settings.footOption);
-				hipsOrientationFilterOption.filterOption = static_cast<hipsRotationFilterOption>(settings.hipsOption);
-				positionFilterOption.filterOption = static_cast<positionalFilterOption>(settings.posOption);
-				controllersTrackingOption_s.trackingOption = static_cast<controllersTrackingOption>(settings.conOption);
-				bodyTrackingOption_s.trackingOption = static_cast<bodyTrackingOption>(settings.bodyTrackingOption);
+		KinectSettings::mauoffset.v[0] = settings.mauoffset_s(0);
+		KinectSettings::mauoffset.v[1] = settings.mauoffset_s(1);
+		KinectSettings::mauoffset.v[2] = settings.mauoffset_s(2);
 
-				KinectSettings::calibration_origin = settings.caliborigin;
+		footOrientationFilterOption.filterOption = static_cast<footRotationFilterOption>(settings.footOption);
+		hipsOrientationFilterOption.filterOption = static_cast<hipsRotationFilterOption>(settings.hipsOption);
+		positionFilterOption.filterOption = static_cast<positionalFilterOption>(settings.posOption);
+		controllersTrackingOption_s.trackingOption = static_cast<controllersTrackingOption>(settings.conOption);
+		bodyTrackingOption_s.trackingOption = static_cast<bodyTrackingOption>(settings.bodyTrackingOption);
 
-				LOG(INFO) << settings.tryawst << '\n' << settings.rcR_matT << '\n' << KinectSettings::calibration_trackers_yaw << '\n' <<
-					KinectSettings::calibration_rotation << '\n';
-			}
-			catch (cereal::Exception e)
-			{
-				LOG(ERROR) << settingsConfig << "SETTINGS FILE LOAD JSON ERROR: " << e.what();
-			}
-		}
+		KinectSettings::calibration_origin = settings.caliborigin;
+		KinectSettings::correctIMUYawDrift = settings.correctIMUYawDrift;
+
+		LOG(INFO) << settings.tryawst << '\n' << settings.rcR_matT << '\n' << KinectSettings::calibration_trackers_yaw << '\n' <<
+			KinectSettings::calibration_rotation << '\n';
 	}
 }
 
@@ -351,6 +388,8 @@ private:
 	TrackerIDs vrDeviceToPoolIds[vr::k_unMaxTrackedDeviceCount]{};
 	TrackerIDs virtualHipsIds{};
 	uint32_t virtualHipsLocalId = 420;
+	VirtualHipsSolver virtualHipsSolver;
+	std::chrono::steady_clock::time_point lastVirtualHipsUpdate;
 
 	void initVirtualHips()
 	{
@@ -375,17 +414,6 @@ private:
 			TrackingPoolManager::rightFootDeviceRotGID != k_invalidTrackerID;
 	}
 
-	void calculateHipMode()
-	{
-		// Determine user mode from HMD position
-		if (KinectSettings::hmdPosition.v[1] <= VirtualHips::settings.lyingMaxHeightThreshold)
-			VirtualHips::settings.hipMode = VirtualHipMode::Lying;
-		else if (KinectSettings::hmdPosition.v[1] <= VirtualHips::settings.sittingMaxHeightThreshold)
-			VirtualHips::settings.hipMode = VirtualHipMode::Sitting;
-		else
-			VirtualHips::settings.hipMode = VirtualHipMode::Standing;
-	}
-
 	vr::HmdVector3d_t getAverageFootPosition()
 	{
 		// Get average of feet controller positions
@@ -403,228 +431,52 @@ private:
 		};
 	}
 
-	void calculateStandingPosition(vr::HmdVector3d_t& hipPosition)
-	{
-		// Initially use head position, project downwards
-		hipPosition = KinectSettings::hmdPosition;
-		hipPosition.v[1] -= VirtualHips::settings.heightFromHMD;
-
-		if (VirtualHips::settings.positionAccountsForFootTrackers &&
-			footTrackersAvailable())
-		{
-			vr::HmdVector3d_t averageFeetPos = getAverageFootPosition();
-
-			// Use their X and Z
-			hipPosition.v[0] = averageFeetPos.v[0];
-			hipPosition.v[2] = averageFeetPos.v[2];
-		}
-	}
-
-	void calculateSittingPosition(vr::HmdVector3d_t& hipPosition)
-	{
-		// Initially use head position, project downwards
-		hipPosition = KinectSettings::hmdPosition;
-		hipPosition.v[1] -= VirtualHips::settings.heightFromHMD;
-
-		// Prevents sinking when head gets closer to ground
-		if (hipPosition.v[1] <= VirtualHips::settings.hipThickness)
-		{
-			hipPosition.v[1] = VirtualHips::settings.hipThickness + 0.20;
-		}
-
-		// Use the x,z average of all tracked points - for now, turned off as it didn't have the desired result
-		/*
-		if (VirtualHips::settings.positionAccountsForFootTrackers &&
-		    footTrackersAvailable()) {
-		    const vr::HmdVector3d_t & headPos = KinectSettings::hmdPosition;
-
-		    vr::HmdVector3d_t averageFeetPos = getAverageFootPosition();
-		    
-		    vr::HmdVector3d_t averageHipPos{
-		        (averageFeetPos.v[0] + headPos.v[0]) * 0.5,
-		        (averageFeetPos.v[1] + headPos.v[1]) * 0.5,
-		        (averageFeetPos.v[2] + headPos.v[2]) * 0.5
-		    };
-
-		    // Use their X and Z
-		    hipPosition.v[0] = averageFeetPos.v[0];
-		    hipPosition.v[2] = averageFeetPos.v[2];
-		}
-		else {
-		    // Stays only under the HMD
-		}
-		*/
-	}
-
-	void calculateLyingPosition(vr::HmdVector3d_t& hipPosition)
-	{
-		// Initially use head position, project downwards
-		hipPosition = KinectSettings::hmdPosition;
-		hipPosition.v[1] -= VirtualHips::settings.heightFromHMD;
-
-		// Prevents sinking when head gets closer to ground
-		if (hipPosition.v[1] <= VirtualHips::settings.hipThickness)
-		{
-			hipPosition.v[1] = VirtualHips::settings.hipThickness;
-		}
-
-		// Move the tracker horizontally to simulate hip position when lying down
-		// https://math.stackexchange.com/questions/83404/finding-a-point-along-a-line-in-three-dimensions-given-two-points
-
-		if (footTrackersAvailable())
-		{
-			// Get the point 'd' units along the line from point 'A' to 'B'
-			vr::HmdVector3d_t A = KinectSettings::hmdPosition;
-			vr::HmdVector3d_t B = getAverageFootPosition();
-			double ratio = 0.5; // Ratio for how far from the head to the feet the hips are
-			double distanceAB = sqrt(
-				(B.v[0] - A.v[0]) * (B.v[0] - A.v[0]) +
-				(B.v[1] - A.v[1]) * (B.v[1] - A.v[1]) +
-				(B.v[2] - A.v[2]) * (B.v[2] - A.v[2])
-			);
-			//double d = VirtualHips::settings.heightFromHMD
-			double d = distanceAB * ratio;
-
-			vr::HmdVector3d_t BA = B - A;
-
-			// Normalise
-			double length = sqrt(
-				BA.v[0] * BA.v[0] +
-				BA.v[1] * BA.v[1] +
-				BA.v[2] * BA.v[2]);
-			vr::HmdVector3d_t unitVector = (BA) / length;
-
-			// Scale towards B
-			vr::HmdVector3d_t desiredHipPosition = A + (unitVector * d);
-			hipPosition.v[0] = desiredHipPosition.v[0];
-			hipPosition.v[2] = desiredHipPosition.v[2];
-		}
-	}
-
 	void updateVirtualHips()
 	{
 		// Has access to head point directly, (and controllers if necessary)
 		// Needs feet points to be supplied in order to properly predict the hips
-
-		calculateHipMode();
-
-		// Calculate Position
-		vr::HmdVector3d_t hipPosition{0};
-
-		switch (VirtualHips::settings.hipMode)
+		const auto now = std::chrono::steady_clock::now();
+
+		VirtualHipsSolver::Snapshot frame;
+		frame.hmdPosition = KinectSettings::hmdPosition;
+		frame.hmdRotation = KinectSettings::hmdRotation;
+		frame.feetTracked = footTrackersAvailable();
+		if (frame.feetTracked)
+			frame.averageFootPosition = getAverageFootPosition();
+		if (lastVirtualHipsUpdate != std::chrono::steady_clock::time_point())
+			frame.deltaSeconds = std::chrono::duration<double>(now - lastVirtualHipsUpdate).count();
+		lastVirtualHipsUpdate = now;
+
+		VirtualHipsSolver::Params params;
 		{
-		case VirtualHipMode::Standing:
-			{
-				calculateStandingPosition(hipPosition);
-				//LOG(INFO) << "Standing";
-				break;
-			}
-		case VirtualHipMode::Sitting:
-			{
-				calculateSittingPosition(hipPosition);
-				//LOG(INFO) << "Sitting";
-				break;
-			}
-		case VirtualHipMode::Lying:
-			{
-				calculateLyingPosition(hipPosition);
-				//LOG(INFO) << "Lying";
-				break;
-			}
-		default:
-			{
-				LOG(ERROR) << "Virtual Hip mode invalid!!!";
-			}
+			auto lock = VirtualHips::lockSettings();
+			params.followHmdYawRotation = VirtualHips::settings.followHmdYawRotation;
+			params.followHmdPitchRotation = VirtualHips::settings.followHmdPitchRotation;
+			params.followHmdRollRotation = VirtualHips::settings.followHmdRollRotation;
+			params.positionAccountsForFootTrackers = VirtualHips::settings.positionAccountsForFootTrackers;
+			params.heightFromHMD = VirtualHips::settings.heightFromHMD;
+			params.hipThickness = VirtualHips::settings.hipThickness;
+			params.sittingMaxHeightThreshold = VirtualHips::settings.sittingMaxHeightThreshold;
+			params.lyingMaxHeightThreshold = VirtualHips::settings.lyingMaxHeightThreshold;
 		}
 
-		// Calculate Rotation
-		vr::HmdQuaternion_t rotation{1, 0, 0, 0};
-		double yaw = 0;
-		double pitch = 0;
-		double roll = 0;
-		toEulerAngle(KinectSettings::hmdRotation, pitch, yaw, roll);
-
-		vr::HmdQuaternion_t yawRotation = {1, 0, 0, 0};
-		vr::HmdQuaternion_t pitchRotation = {1, 0, 0, 0};
-		vr::HmdQuaternion_t rollRotation = {1, 0, 0, 0};
-
-		switch (VirtualHips::settings.hipMode)
+		const VirtualHipsSolver::Result hips = virtualHipsSolver.solve(frame, params);
+		if (hips.mode != VirtualHips::settings.hipMode)
 		{
-		case VirtualHipMode::Standing:
-			{
-				if (VirtualHips::settings.followHmdYawRotation)
-					yawRotation = vrmath::quaternionFromRotationY(yaw);
-				if (VirtualHips::settings.followHmdPitchRotation)
-					pitchRotation = vrmath::quaternionFromRotationX(pitch);
-				if (VirtualHips::settings.followHmdRollRotation)
-					rollRotation = vrmath::quaternionFromRotationZ(roll);
-				break;
-			}
-		case VirtualHipMode::Sitting:
-			{
-				// As the hip tracker sinks further into the ground, rotate the hip upwards
-				// Apply yaw first, then pitch
-
-				if (VirtualHips::settings.followHmdYawRotation)
-				{
-					yawRotation = vrmath::quaternionFromRotationY(yaw);
-				}
-
-				// Adjust up/down
-
-				const double maxRotation = M_PI / 4.0; // 45 degrees up
-
-				double rotationRatio = (
-						KinectSettings::hmdPosition.v[1] - VirtualHips::settings.heightFromHMD)
-					/ (VirtualHips::settings.sittingMaxHeightThreshold - VirtualHips::settings.heightFromHMD);
-				double radiansToRotatePitch = -(maxRotation * rotationRatio);
-				pitchRotation = vrmath::quaternionFromRotationX(radiansToRotatePitch);
-				break;
-			}
-		case VirtualHipMode::Lying:
-			{
-				// Follows HMD roll now, and yaw is based on lookat from HMD to feet
-				//rollRotation = vrmath::quaternionFromRotationZ(roll);
-				pitchRotation = vrmath::quaternionFromRotationX(M_PI_2);
-				yawRotation = {1, 0, 0, 0};
-
-				if (footTrackersAvailable())
-				{
-					// rotation between
-					auto rawQ = vrmath::get_rotation_between(KinectSettings::hmdPosition, getAverageFootPosition());
-					double lookAtYaw = 0;
-					double lookAtPitch = 0;
-					double lookAtRoll = 0;
-
-					toEulerAngle(rawQ, lookAtPitch, lookAtYaw, lookAtRoll);
-					LOG(INFO) << lookAtYaw;
-					yawRotation = vrmath::quaternionFromRotationY(lookAtYaw);
-					pitchRotation = vrmath::quaternionFromRotationX(lookAtPitch);
-					rollRotation = vrmath::quaternionFromRotationZ(lookAtRoll);
-					//yawRotation = vrmath::quaternionFromRotationY(lookAtYaw) * vrmath::quaternionFromRotationY(yaw);
-					//pitchRotation = vrmath::quaternionFromRotationX(lookAtPitch) * vrmath::quaternionFromRotationX(pitch);
-					//rollRotation = vrmath::quaternionFromRotationZ(lookAtRoll) * vrmath::quaternionFromRotationZ(roll);
-				}
-				break;
-			}
-		default:
-			{
-				LOG(ERROR) << "Virtual Hip mode invalid!!!";
-			}
+			auto lock = VirtualHips::lockSettings();
+			VirtualHips::settings.hipMode = hips.mode;
 		}
 
-		rotation = yawRotation * pitchRotation * rollRotation; // Right side applied first
-
 		KVR::TrackedDeviceInputData data = defaultDeviceData(virtualHipsLocalId);
 		data.deviceId = virtualHipsIds.globalID;
-		data.position = hipPosition;
-		data.rotation = rotation;
+		data.position = hips.position;
+		data.rotation = hips.rotation;
 
 		data.pose = defaultReadyDriverPose();
-		data.pose.vecPosition[0] = hipPosition.v[0];
-		data.pose.vecPosition[1] = hipPosition.v[1];
-		data.pose.vecPosition[2] = hipPosition.v[2];
-		data.pose.qRotation = rotation;
+		data.pose.vecPosition[0] = hips.position.v[0];
+		data.pose.vecPosition[1] = hips.position.v[1];
+		data.pose.vecPosition[2] = hips.position.v[2];
+		data.pose.qRotation = hips.rotation;
 
 		TrackingPoolManager::updatePoolWithDevice(data, virtualHipsIds.globalID);
 	}
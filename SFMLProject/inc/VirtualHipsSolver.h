@@ -0,0 +1,277 @@
+#pragma once
+#include <cmath>
+#include <openvr.h>
+
+enum class VirtualHipMode
+{
+	Standing,
+	Sitting,
+	Lying
+};
+
+// Places the virtual hips from the HMD, and the feet when they are tracked
+// Works on a per-frame snapshot without touching SteamVR, the tracking pool or the log,
+// so recorded HMD/foot trajectories can be replayed through it
+class VirtualHipsSolver
+{
+public:
+	struct Params
+	{
+		bool followHmdYawRotation = true;
+		bool followHmdPitchRotation = false;
+		bool followHmdRollRotation = false;
+		bool positionAccountsForFootTrackers = false;
+		double heightFromHMD = 0.0;
+		double hipThickness = 0.0;
+		double sittingMaxHeightThreshold = 0.0;
+		double lyingMaxHeightThreshold = 0.0;
+
+		// Meters the HMD has to rise above a threshold before leaving the lower mode
+		double modeHysteresis = 0.05;
+		// Seconds a mode change takes to fully blend in, 0 switches instantly
+		double modeBlendSeconds = 0.3;
+	};
+
+	struct Snapshot
+	{
+		vr::HmdVector3d_t hmdPosition{};
+		vr::HmdQuaternion_t hmdRotation{1, 0, 0, 0};
+		bool feetTracked = false;
+		vr::HmdVector3d_t averageFootPosition{};
+		double deltaSeconds = 0.0;
+	};
+
+	struct Result
+	{
+		vr::HmdVector3d_t position{};
+		vr::HmdQuaternion_t rotation{1, 0, 0, 0};
+		VirtualHipMode mode = VirtualHipMode::Standing; // The mode being blended towards
+	};
+
+	Result solve(const Snapshot& frame, const Params& params)
+	{
+		const VirtualHipMode target = targetMode(frame.hmdPosition.v[1], params);
+		blendTowards(target, frame.deltaSeconds, params.modeBlendSeconds);
+		m_mode = target;
+		updateHmdAngles(frame.hmdRotation);
+
+		Result result;
+		result.mode = target;
+
+		vr::HmdQuaternion_t reference = modeRotation(target, frame, params);
+		vr::HmdQuaternion_t rotationSum{0, 0, 0, 0};
+		for (int i = 0; i < k_modeCount; ++i)
+		{
+			const double weight = m_weights[i];
+			if (weight <= 0.0)
+				continue;
+
+			const VirtualHipMode mode = static_cast<VirtualHipMode>(i);
+			const vr::HmdVector3d_t position = modePosition(mode, frame, params);
+			for (int axis = 0; axis < 3; ++axis)
+				result.position.v[axis] += position.v[axis] * weight;
+
+			vr::HmdQuaternion_t rotation = mode == target ? reference : modeRotation(mode, frame, params);
+			// Keep every quaternion on the reference's hemisphere before summing
+			if (dot(rotation, reference) < 0.0)
+				rotation = {-rotation.w, -rotation.x, -rotation.y, -rotation.z};
+			rotationSum.w += rotation.w * weight;
+			rotationSum.x += rotation.x * weight;
+			rotationSum.y += rotation.y * weight;
+			rotationSum.z += rotation.z * weight;
+		}
+		result.rotation = normalized(rotationSum, reference);
+		return result;
+	}
+
+	// Forget the blend state, the next solve starts fully in its mode
+	void reset()
+	{
+		m_initialised = false;
+	}
+
+private:
+	static constexpr int k_modeCount = 3;
+	static constexpr double k_pi = 3.14159265358979323846;
+
+	VirtualHipMode targetMode(double hmdHeight, const Params& params) const
+	{
+		const double margin = m_initialised ? params.modeHysteresis : 0.0;
+		if (hmdHeight <= params.lyingMaxHeightThreshold ||
+			(m_mode == VirtualHipMode::Lying && hmdHeight <= params.lyingMaxHeightThreshold + margin))
+			return VirtualHipMode::Lying;
+		if (hmdHeight <= params.sittingMaxHeightThreshold ||
+			(m_mode != VirtualHipMode::Standing && hmdHeight <= params.sittingMaxHeightThreshold + margin))
+			return VirtualHipMode::Sitting;
+		return VirtualHipMode::Standing;
+	}
+
+	void blendTowards(VirtualHipMode target, double deltaSeconds, double blendSeconds)
+	{
+		const int targetIndex = static_cast<int>(target);
+		if (!m_initialised || blendSeconds <= 0.0)
+		{
+			for (int i = 0; i < k_modeCount; ++i)
+				m_weights[i] = i == targetIndex ? 1.0 : 0.0;
+			m_initialised = true;
+			return;
+		}
+
+		const double step = deltaSeconds > 0.0 ? deltaSeconds / blendSeconds : 0.0;
+		double sum = 0.0;
+		for (int i = 0; i < k_modeCount; ++i)
+		{
+			const double goal = i == targetIndex ? 1.0 : 0.0;
+			const double change = goal - m_weights[i];
+			m_weights[i] += change > step ? step : change < -step ? -step : change;
+			sum += m_weights[i];
+		}
+		for (double& weight : m_weights)
+			weight /= sum;
+	}
+
+	// The HMD decomposition every mode's rotation is built from, once per frame.
+	// A tracked HMD never reports the same rotation twice, so it isn't worth caching across frames
+	void updateHmdAngles(const vr::HmdQuaternion_t& q)
+	{
+		double pitch = 0, yaw = 0, roll = 0;
+		eulerAngles(q, pitch, yaw, roll);
+		m_hmdYawRotation = rotationY(yaw);
+		m_hmdPitchRotation = rotationX(pitch);
+		m_hmdRollRotation = rotationZ(roll);
+	}
+
+	static vr::HmdVector3d_t modePosition(VirtualHipMode mode, const Snapshot& frame, const Params& params)
+	{
+		// Projected down from the head to start with
+		vr::HmdVector3d_t position = frame.hmdPosition;
+		position.v[1] -= params.heightFromHMD;
+
+		switch (mode)
+		{
+		case VirtualHipMode::Standing:
+			if (params.positionAccountsForFootTrackers && frame.feetTracked)
+			{
+				position.v[0] = frame.averageFootPosition.v[0];
+				position.v[2] = frame.averageFootPosition.v[2];
+			}
+			break;
+		case VirtualHipMode::Sitting:
+			// Prevents sinking when head gets closer to ground
+			if (position.v[1] <= params.hipThickness)
+				position.v[1] = params.hipThickness + 0.20;
+			break;
+		case VirtualHipMode::Lying:
+			if (position.v[1] <= params.hipThickness)
+				position.v[1] = params.hipThickness;
+			// Half way from the head to the feet
+			if (frame.feetTracked)
+			{
+				position.v[0] = (frame.hmdPosition.v[0] + frame.averageFootPosition.v[0]) * 0.5;
+				position.v[2] = (frame.hmdPosition.v[2] + frame.averageFootPosition.v[2]) * 0.5;
+			}
+			break;
+		}
+		return position;
+	}
+
+	vr::HmdQuaternion_t modeRotation(VirtualHipMode mode, const Snapshot& frame, const Params& params) const
+	{
+		const vr::HmdQuaternion_t identity{1, 0, 0, 0};
+		switch (mode)
+		{
+		case VirtualHipMode::Standing:
+			return multiply(multiply(params.followHmdYawRotation ? m_hmdYawRotation : identity,
+			                         params.followHmdPitchRotation ? m_hmdPitchRotation : identity),
+			                params.followHmdRollRotation ? m_hmdRollRotation : identity);
+		case VirtualHipMode::Sitting:
+			{
+				// As the hips sink towards the ground, rotate them up, 45 degrees at most
+				const double range = params.sittingMaxHeightThreshold - params.heightFromHMD;
+				const double ratio = range != 0.0 ? (frame.hmdPosition.v[1] - params.heightFromHMD) / range : 0.0;
+				return multiply(params.followHmdYawRotation ? m_hmdYawRotation : identity,
+				                rotationX(-(k_pi / 4.0 * ratio)));
+			}
+		case VirtualHipMode::Lying:
+			{
+				if (!frame.feetTracked)
+					return rotationX(k_pi / 2.0);
+
+				// Yaw, pitch and roll from the look-at from the HMD to the feet
+				double pitch = 0, yaw = 0, roll = 0;
+				eulerAngles(rotationBetween(frame.hmdPosition, frame.averageFootPosition), pitch, yaw, roll);
+				return multiply(multiply(rotationY(yaw), rotationX(pitch)), rotationZ(roll));
+			}
+		}
+		return identity;
+	}
+
+	// Same decomposition as toEulerAngle, but the poles report their angles instead of zeros
+	static void eulerAngles(const vr::HmdQuaternion_t& q, double& pitch, double& yaw, double& roll)
+	{
+		const double test = q.x * q.y + q.z * q.w;
+		if (test > 0.499 || test < -0.499)
+		{
+			const double sign = test > 0 ? 1.0 : -1.0;
+			roll = sign * k_pi / 2;
+			yaw = sign * 2 * std::atan2(q.x, q.w);
+			pitch = 0;
+			return;
+		}
+		roll = std::asin(2 * test);
+		yaw = std::atan2(2 * q.y * q.w - 2 * q.x * q.z, 1 - 2 * q.y * q.y - 2 * q.z * q.z);
+		pitch = std::atan2(2 * q.x * q.w - 2 * q.y * q.z, 1 - 2 * q.x * q.x - 2 * q.z * q.z);
+	}
+
+	static vr::HmdQuaternion_t rotationBetween(const vr::HmdVector3d_t& u, const vr::HmdVector3d_t& v)
+	{
+		const double cosTheta = u.v[0] * v.v[0] + u.v[1] * v.v[1] + u.v[2] * v.v[2];
+		const double k = std::sqrt((u.v[0] * u.v[0] + u.v[1] * u.v[1] + u.v[2] * u.v[2]) *
+			(v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2]));
+		if (k == 0.0 || cosTheta / k == -1)
+			return {1, 0, 0, 0};
+
+		const vr::HmdQuaternion_t q{
+			cosTheta + k,
+			u.v[1] * v.v[2] - u.v[2] * v.v[1],
+			u.v[2] * v.v[0] - u.v[0] * v.v[2],
+			u.v[0] * v.v[1] - u.v[1] * v.v[0]
+		};
+		return normalized(q, {1, 0, 0, 0});
+	}
+
+	static vr::HmdQuaternion_t rotationX(double angle) { return {std::cos(angle / 2), std::sin(angle / 2), 0, 0}; }
+	static vr::HmdQuaternion_t rotationY(double angle) { return {std::cos(angle / 2), 0, std::sin(angle / 2), 0}; }
+	static vr::HmdQuaternion_t rotationZ(double angle) { return {std::cos(angle / 2), 0, 0, std::sin(angle / 2)}; }
+
+	static vr::HmdQuaternion_t multiply(const vr::HmdQuaternion_t& lhs, const vr::HmdQuaternion_t& rhs)
+	{
+		return {
+			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
+			lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.w * rhs.y + lhs.y * rhs.w + lhs.z * rhs.x - lhs.x * rhs.z,
+			lhs.w * rhs.z + lhs.z * rhs.w + lhs.x * rhs.y - lhs.y * rhs.x
+		};
+	}
+
+	static double dot(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b)
+	{
+		return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static vr::HmdQuaternion_t normalized(const vr::HmdQuaternion_t& q, const vr::HmdQuaternion_t& fallback)
+	{
+		const double length = std::sqrt(dot(q, q));
+		if (length < 1e-12)
+			return fallback;
+		return {q.w / length, q.x / length, q.y / length, q.z / length};
+	}
+
+	bool m_initialised = false;
+	VirtualHipMode m_mode = VirtualHipMode::Standing;
+	double m_weights[k_modeCount] = {1.0, 0.0, 0.0};
+
+	vr::HmdQuaternion_t m_hmdYawRotation{1, 0, 0, 0};
+	vr::HmdQuaternion_t m_hmdPitchRotation{1, 0, 0, 0};
+	vr::HmdQuaternion_t m_hmdRollRotation{1, 0, 0, 0};
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <openvr.h>
+#include <openvr_math.h>
+
+// Complementary filter taking out the yaw drift of an IMU rotation (PSMove, or anything else
+// feeding IMU_RotationMethod) with the direction of a Kinect bone on the same body part
+//
+// The IMU stays in charge of the rotation at its own rate, the bone only has to say where the
+// part is heading now and then. While settling, the bone direction is learnt in the IMU's frame,
+// which takes care of however the device is strapped on. After that every bone sample gives the
+// yaw between where the IMU thinks that direction points and where the Kinect sees it. The
+// correction follows that error like a critically damped spring, and also learns how fast the IMU
+// drifts so a steady drift doesn't leave a steady lag behind. Turning is rate limited, large errors are only
+// trusted once they persist, so mislabelled or flipped skeleton frames can't swing the tracker around
+//
+// Only depends on the OpenVR math types, so it builds and runs on any platform
+class YawDriftCorrector
+{
+public:
+	struct Settings
+	{
+		double timeConstant = 4.0; // Seconds, about how long the correction takes to catch up with a yaw error
+		double maxCorrectionRate = 0.35; // Radians per second the correction may turn at most
+		double maxDriftRate = 0.05; // Radians per second of drift the correction learns at most
+		double minHorizontalLength = 0.5; // Bones steeper than ~60deg from the floor have no usable heading
+		int settleSamples = 30; // Bone samples averaged before the first correction
+		double maxSampleGap = 1.0; // Longer gaps between bone samples only count as this long
+		double outlierAngle = 0.5; // Errors above this are glitches, unless they keep coming...
+		int outlierSamples = 15; // ...for this many bone samples in a row
+	};
+
+	YawDriftCorrector() = default;
+
+	explicit YawDriftCorrector(const Settings& settings) :
+		settings(settings)
+	{
+	}
+
+	void reset()
+	{
+		settledSamples = 0;
+		settlingBones.clear();
+		boneInImuFrame = {0, 0, 0};
+		correctionYaw = 0;
+		driftRate = 0;
+		correction = {1, 0, 0, 0};
+		lastSampleTime = 0;
+		outliersInARow = 0;
+	}
+
+	void setSettings(const Settings& value) { settings = value; }
+	const Settings& getSettings() const { return settings; }
+
+	bool isSettled() const { return settledSamples >= settings.settleSamples; }
+	double getCorrectionYaw() const { return correctionYaw; }
+	double getDriftRate() const { return driftRate; }
+
+	// The IMU rotation with the drift taken out, call for every IMU sample
+	vr::HmdQuaternion_t correct(const vr::HmdQuaternion_t& imuRotation) const
+	{
+		return correction * imuRotation;
+	}
+
+	// Feeds one bone direction (any length, same space as the IMU rotation) measured together with
+	// imuRotation. sampleTime is in seconds on a steady clock. Returns false when the sample was unusable
+	bool addBoneDirection(const vr::HmdQuaternion_t& imuRotation, const vr::HmdVector3d_t& boneDirection,
+	                      double sampleTime)
+	{
+		const double length = std::sqrt(dot(boneDirection, boneDirection));
+		if (!(length > 1e-6))
+			return false;
+		const vr::HmdVector3d_t bone = {
+			boneDirection.v[0] / length, boneDirection.v[1] / length, boneDirection.v[2] / length
+		};
+		const vr::HmdQuaternion_t corrected = correct(normalised(imuRotation));
+
+		if (!isSettled())
+		{
+			// Average the bone in the (corrected) IMU frame, the drift during settling is negligible
+			settlingBones.push_back(vrmath::quaternionRotateVector(corrected, bone, true));
+			lastSampleTime = sampleTime;
+			if (++settledSamples == settings.settleSamples)
+			{
+				// A wild skeleton frame in there would skew the learnt direction for good,
+				// so the samples far from the plain average are left out of a second one
+				const vr::HmdVector3d_t average = averageDirection(settlingBones, {0, 0, 0}, -2);
+				boneInImuFrame = averageDirection(settlingBones, average, std::cos(settings.outlierAngle));
+				settlingBones.clear();
+				if (!(dot(boneInImuFrame, boneInImuFrame) > 0))
+				{
+					// The samples cancelled out, nothing sensible was learnt
+					reset();
+					return false;
+				}
+			}
+			return true;
+		}
+
+		double dt = std::min(sampleTime - lastSampleTime, settings.maxSampleGap);
+		if (!(dt > 0))
+			return false;
+
+		// Where the bone points according to the IMU, against where the Kinect sees it, seen from above
+		const vr::HmdVector3d_t predicted = vrmath::quaternionRotateVector(corrected, boneInImuFrame, false);
+		const double predictedHorizontal = std::sqrt(predicted.v[0] * predicted.v[0] + predicted.v[2] * predicted.v[2]);
+		const double boneHorizontal = std::sqrt(bone.v[0] * bone.v[0] + bone.v[2] * bone.v[2]);
+		if (predictedHorizontal < settings.minHorizontalLength || boneHorizontal < settings.minHorizontalLength)
+			return false;
+		lastSampleTime = sampleTime;
+
+		// Yaw turning predicted onto the bone, +ve turns +x towards -z like quaternionFromRotationY
+		const double error = std::atan2(
+			predicted.v[2] * bone.v[0] - predicted.v[0] * bone.v[2],
+			predicted.v[0] * bone.v[0] + predicted.v[2] * bone.v[2]);
+
+		if (std::fabs(error) > settings.outlierAngle && ++outliersInARow < settings.outlierSamples)
+			return false;
+		outliersInARow = 0;
+
+		// Natural frequency 1 / timeConstant, critically damped
+		const double frequency = 1 / std::max(settings.timeConstant, dt);
+		driftRate = clamp(driftRate + frequency * frequency * error * dt, settings.maxDriftRate);
+		const double step = clamp((2 * frequency * error + driftRate) * dt, settings.maxCorrectionRate * dt);
+
+		correctionYaw = wrapAngle(correctionYaw + step);
+		correction = vrmath::quaternionFromRotationY(correctionYaw);
+		return true;
+	}
+
+private:
+	static double dot(const vr::HmdVector3d_t& a, const vr::HmdVector3d_t& b)
+	{
+		return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+	}
+
+	// Unit average of the directions within acos(minCosine) of around, zero when they cancel out
+	static vr::HmdVector3d_t averageDirection(const std::vector<vr::HmdVector3d_t>& directions,
+	                                          const vr::HmdVector3d_t& around, double minCosine)
+	{
+		vr::HmdVector3d_t sum = {0, 0, 0};
+		for (const vr::HmdVector3d_t& direction : directions)
+		{
+			if (dot(direction, around) < minCosine)
+				continue;
+			sum = {sum.v[0] + direction.v[0], sum.v[1] + direction.v[1], sum.v[2] + direction.v[2]};
+		}
+		const double length = std::sqrt(dot(sum, sum));
+		if (!(length > 1e-6))
+			return {0, 0, 0};
+		return {sum.v[0] / length, sum.v[1] / length, sum.v[2] / length};
+	}
+
+	static double clamp(double value, double limit)
+	{
+		return std::max(-limit, std::min(limit, value));
+	}
+
+	static vr::HmdQuaternion_t normalised(const vr::HmdQuaternion_t& q)
+	{
+		const double length = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+		if (!(length > 0))
+			return {1, 0, 0, 0};
+		return {q.w / length, q.x / length, q.y / length, q.z / length};
+	}
+
+	static double wrapAngle(double angle)
+	{
+		const double pi = 3.14159265358979323846;
+		return angle - 2 * pi * std::floor((angle + pi) / (2 * pi));
+	}
+
+	Settings settings;
+
+	int settledSamples = 0;
+	std::vector<vr::HmdVector3d_t> settlingBones; // In the IMU frame, until settled
+	vr::HmdVector3d_t boneInImuFrame = {0, 0, 0};
+	double correctionYaw = 0;
+	double driftRate = 0; // Radians per second the correction turns by itself
+	vr::HmdQuaternion_t correction = {1, 0, 0, 0};
+	double lastSampleTime = 0;
+	int outliersInARow = 0;
+};
@@ -6,6 +6,7 @@
 #include <thread>
 #include <Eigen/Dense>
 #include "soft_knuckles_device.h"
+#include <LatencyStats.h>
 
 DriverPose_t BodyTracker::dlpose;
 DriverPose_t dlposeh, dlposem, dlposep;
@@ -140,21 +141,38 @@ void BodyTracker::poseset(BodyTracker* pthis)
 	while (true)
 	{
 		auto t1 = std::chrono::high_resolution_clock::now();
+		const soft_knuckles::TrackerPoses poses = soft_knuckles::trackerPoses.load();
+		const uint64_t frame_id = poses.frame_id;
+		const uint64_t frame_us = poses.frame_us;
 
-		if (pthis->dest == "LFOOT")
 		{
-			VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, soft_knuckles::hposet,
-			                                               sizeof(soft_knuckles::hposet));
+			Latency::ScopedTimer timer(Latency::Stage::PoseUpdate);
+			if (pthis->dest == "LFOOT")
+			{
+				VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, poses.left_foot,
+				                                               sizeof(poses.left_foot));
+			}
+			else if (pthis->dest == "RFOOT")
+			{
+				VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, poses.right_foot,
+				                                               sizeof(poses.right_foot));
+			}
+			else if (pthis->dest == "HIP")
+			{
+				VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, poses.hip,
+				                                               sizeof(poses.hip));
+			}
 		}
-		else if (pthis->dest == "RFOOT")
-		{
-			VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, soft_knuckles::mposet,
-			                                               sizeof(soft_knuckles::mposet));
-		}
-		else if (pthis->dest == "HIP")
+
+		// All three trackers run this loop, only the first one to publish a frame counts it
+		static std::atomic<uint64_t> last_reported_frame{0};
+		uint64_t last_frame = last_reported_frame;
+		if (frame_id > last_frame && frame_us != 0 &&
+			last_reported_frame.compare_exchange_strong(last_frame, frame_id))
 		{
-			VRServerDriverHost()->TrackedDevicePoseUpdated(pthis->_index, soft_knuckles::pposet,
-			                                               sizeof(soft_knuckles::pposet));
+			const uint64_t now = Latency::nowMicroseconds();
+			if (now > frame_us)
+				Latency::record(Latency::Stage::EndToEnd, now - frame_us);
 		}
 
 		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -319,9 +337,16 @@ void* BodyTracker::GetComponent(const char* component)
 
 void BodyTracker::DebugRequest(const char* request, char* response_buffer, uint32_t response_buffer_size)
 {
-	// No custom debug requests defined
-	if (response_buffer_size >= 1)
-		response_buffer[0] = 0;
+	if (response_buffer_size < 1)
+		return;
+	response_buffer[0] = 0;
+
+	// "latency" returns the driver side stage histograms, "latency_reset" clears them
+	if (strcmp(request, "latency") == 0)
+		strncpy_s(response_buffer, response_buffer_size,
+		          (Latency::k_driverReportHeader + Latency::report()).c_str(), _TRUNCATE);
+	else if (strcmp(request, "latency_reset") == 0)
+		Latency::resetAll();
 }
 
 DriverPose_t BodyTracker::GetPose()
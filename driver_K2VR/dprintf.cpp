@@ -7,23 +7,19 @@
 #include <openvr_driver.h>
 #include <chrono>
 #include <ctime>
+#include <mutex>
+
+#include "dprintf.h"
 
 #if defined(_WIN32)
 #include <windows.h>
 // disable vc fopen warning
 #pragma warning(disable : 4996)
-#define vsprintf vsprintf_s
 #endif
 
-void dprintf(const char* fmt, ...)
+// Runs on the log thread
+static void write_line(AsyncLog::Level, const char* buffer)
 {
-	va_list args;
-	char buffer[2048];
-
-	va_start(args, fmt);
-	vsprintf(buffer, fmt, args);
-	va_end(args);
-
 #if !defined(NDEBUG)
     static FILE *factory_log;
     if (factory_log == 0)
@@ -52,3 +48,22 @@ void dprintf(const char* fmt, ...)
 		vr::VRDriverLog()->Log(buffer);
 	}
 }
+
+// The server and watchdog providers each start the log, and may share a process
+static std::mutex log_users_mutex;
+static int log_users = 0;
+
+void StartDriverLog()
+{
+	std::lock_guard<std::mutex> lock(log_users_mutex);
+	if (log_users++ == 0)
+		AsyncLog::start(write_line);
+}
+
+// Has to run before the driver gets unloaded, the log thread can't be joined from DllMain
+void StopDriverLog()
+{
+	std::lock_guard<std::mutex> lock(log_users_mutex);
+	if (log_users > 0 && --log_users == 0)
+		AsyncLog::stop();
+}
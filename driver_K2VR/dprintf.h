@@ -4,5 +4,15 @@
 // In debug builds, logs to a file as well as to vr::VRDriverLog and outputdebugstring
 // In release builds, logs only to vr::VRDriverLog
 //
+// Calls only queue the arguments (see AsyncLog.h), the lines are written by
+// the log thread between StartDriverLog and StopDriverLog
+//
 #pragma once
-extern void dprintf(const char* fmt, ...);
+#include <AsyncLog.h>
+
+#define dprintf(fmt, ...) ASYNC_LOG(AsyncLog::Level::Info, 0, fmt, ##__VA_ARGS__)
+// Same as dprintf, but logs at most once every interval_ms from this call site
+#define dprintf_every(interval_ms, fmt, ...) ASYNC_LOG(AsyncLog::Level::Info, interval_ms, fmt, ##__VA_ARGS__)
+
+extern void StartDriverLog();
+extern void StopDriverLog();
@@ -0,0 +1,128 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// input_state
+//	* numeric button state -> IVRDriverInput, changed components only
+//
+
+#include <cmath>
+#include <cstring>
+#include "dprintf.h"
+#include "input_state.h"
+
+namespace soft_knuckles
+{
+	// Booleans from a button value press above PRESS and release below RELEASE
+	static const float PRESS_THRESHOLD = 0.75f;
+	static const float RELEASE_THRESHOLD = 0.25f;
+	// Touch turns on once the value leaves TOUCH_ON and off once it is back inside TOUCH_OFF
+	static const float TOUCH_ON_DEADBAND = 0.05f;
+	static const float TOUCH_OFF_DEADBAND = 0.02f;
+	// Smallest scalar change worth submitting, the ends of the range always go out
+	static const float SCALAR_DEADBAND = 0.002f;
+
+	struct InputStateTracker::Binding
+	{
+		const char* full_path;
+		ButtonSource source;
+		ButtonSource touch_source; // BS_COUNT unless this is a touch from two axes
+		bool touch;
+	};
+
+	static const InputStateTracker::Binding s_bindings[] = {
+		{"/input/thumbstick/x", BS_THUMBSTICK_X, BS_COUNT, false},
+		{"/input/thumbstick/y", BS_THUMBSTICK_Y, BS_COUNT, false},
+		{"/input/thumbstick/touch", BS_THUMBSTICK_X, BS_THUMBSTICK_Y, true},
+		{"/input/system/click", BS_SYSTEM, BS_COUNT, false},
+		{"/input/trigger/value", BS_TRIGGER, BS_COUNT, false},
+		{"/input/trigger/touch", BS_TRIGGER, BS_COUNT, true},
+		{"/input/a/click", BS_A, BS_COUNT, false},
+		{"/input/b/click", BS_B, BS_COUNT, false},
+		{"/input/grip/click", BS_GRIP, BS_COUNT, false},
+		{"/input/grip/touch", BS_GRIP, BS_COUNT, false},
+	};
+
+	void InputStateTracker::Bind(const KnuckleComponentDefinition* component_definitions,
+	                             uint32_t num_component_definitions,
+	                             const VRInputComponentHandle_t* component_handles)
+	{
+		m_num_slots = 0;
+		for (const Binding& binding : s_bindings)
+		{
+			for (uint32_t i = 0; i < num_component_definitions && m_num_slots < MAX_BINDINGS; i++)
+			{
+				const ComponentType type = component_definitions[i].component_type;
+				if (strcmp(component_definitions[i].full_path, binding.full_path) != 0 ||
+					(type != CT_BOOLEAN && type != CT_SCALAR))
+					continue;
+
+				Slot& slot = m_slots[m_num_slots++];
+				slot.binding = &binding;
+				slot.handle = component_handles[i];
+				slot.type = type;
+				slot.submitted = false;
+				slot.last_bool = false;
+				slot.last_scalar = 0.f;
+				break;
+			}
+		}
+	}
+
+	int InputStateTracker::Submit(const float* buttons, IVRDriverInput* input)
+	{
+		int submitted = 0;
+		for (int i = 0; i < m_num_slots; i++)
+		{
+			Slot& slot = m_slots[i];
+			const Binding& binding = *slot.binding;
+			const float value = buttons[binding.source];
+
+			if (slot.type == CT_BOOLEAN)
+			{
+				bool state = slot.last_bool;
+				if (binding.touch)
+				{
+					float magnitude = fabsf(value);
+					if (binding.touch_source != BS_COUNT)
+						magnitude = fmaxf(magnitude, fabsf(buttons[binding.touch_source]));
+					if (magnitude > TOUCH_ON_DEADBAND)
+						state = true;
+					else if (magnitude < TOUCH_OFF_DEADBAND)
+						state = false;
+				}
+				else if (value >= PRESS_THRESHOLD)
+					state = true;
+				else if (value <= RELEASE_THRESHOLD)
+					state = false;
+
+				if (slot.submitted && state == slot.last_bool)
+					continue;
+
+				const EVRInputError err = input->UpdateBooleanComponent(slot.handle, state, 0);
+				if (err != VRInputError_None)
+				{
+					dprintf("error %d\n", err);
+					continue;
+				}
+				slot.last_bool = state;
+			}
+			else
+			{
+				const bool at_end = value == 0.f || fabsf(value) == 1.f;
+				if (slot.submitted && (fabsf(value - slot.last_scalar) < SCALAR_DEADBAND &&
+					!(at_end && value != slot.last_scalar)))
+					continue;
+
+				const EVRInputError err = input->UpdateScalarComponent(slot.handle, value, 0);
+				if (err != VRInputError_None)
+				{
+					dprintf("error %d\n", err);
+					continue;
+				}
+				slot.last_scalar = value;
+			}
+
+			slot.submitted = true;
+			submitted++;
+		}
+		return submitted;
+	}
+}
@@ -0,0 +1,56 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// input_state.h
+//
+// keeps the last button/axis values submitted to IVRDriverInput and only
+// submits components whose value actually moved
+// 
+// booleans switch with hysteresis and scalars ignore changes inside a
+// deadband, so a noisy trigger doesn't flood SteamVR with updates
+#pragma once
+#include <openvr_driver.h>
+#include "soft_knuckles_config.h"
+
+namespace soft_knuckles
+{
+	// Slots of the mplacMBUT/mplacHBUT button arrays
+	enum ButtonSource
+	{
+		BS_THUMBSTICK_X,
+		BS_THUMBSTICK_Y,
+		BS_SYSTEM,
+		BS_TRIGGER,
+		BS_A,
+		BS_B,
+		BS_GRIP,
+		BS_COUNT
+	};
+
+	class InputStateTracker
+	{
+	public:
+		static const int MAX_BINDINGS = 16;
+		struct Binding;
+
+		// Resolves the bound paths to component handles, call again if the handles change
+		void Bind(const KnuckleComponentDefinition* component_definitions, uint32_t num_component_definitions,
+		          const VRInputComponentHandle_t* component_handles);
+		bool IsBound() const { return m_num_slots > 0; }
+
+		// Submits the components that changed since the last call, returns how many went out
+		int Submit(const float* buttons, IVRDriverInput* input);
+
+	private:
+		struct Slot
+		{
+			const Binding* binding;
+			VRInputComponentHandle_t handle;
+			ComponentType type;
+			bool submitted;
+			bool last_bool;
+			float last_scalar;
+		};
+
+		Slot m_slots[MAX_BINDINGS];
+		int m_num_slots = 0;
+	};
+}
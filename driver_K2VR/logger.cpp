@@ -1,6 +1,8 @@
 //========= Copyright Valve Corporation ============//
 #include "logger.h"
 
+#include <AsyncLog.h>
+
 #include <stdio.h>
 #include <stdarg.h>
 
@@ -44,8 +46,10 @@ namespace soft_knuckles
 		vsnprintf(buf, sizeof(buf), pMsgFormat, args);
 #endif
 
+		// Written out by the driver's log thread
+		static AsyncLog::Site site(AsyncLog::Level::Info, 0, "%s");
 		if (s_pLogFile)
-			s_pLogFile->Log((logLevel + buf).c_str());
+			AsyncLog::writeText(site, (logLevel + buf).c_str());
 	}
 
 	/** Logs a printf-style info line logging.
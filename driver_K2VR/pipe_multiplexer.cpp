@@ -0,0 +1,190 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// pipe_multiplexer
+//	* one thread waiting on every channel's overlapped event at once
+//
+
+#include <string>
+#include "dprintf.h"
+#include "pipe_multiplexer.h"
+
+static const DWORD PIPE_BUFFER_SIZE = 1024;
+
+struct PipeMultiplexer::Channel
+{
+	std::wstring name;
+	Handler handler;
+	HANDLE pipe = INVALID_HANDLE_VALUE;
+	OVERLAPPED overlapped = {};
+	bool reading = false; // false while waiting for a client
+	char buffer[PIPE_BUFFER_SIZE];
+
+	enum class Step
+	{
+		Listen,
+		Read
+	};
+
+	void Open()
+	{
+		overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		pipe = CreateNamedPipe(
+			name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+			PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE, 1, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 120 * 1000, nullptr);
+		if (pipe == INVALID_HANDLE_VALUE)
+			dprintf("CreateNamedPipe failed on %ls: %lu\n", name.c_str(), GetLastError());
+		else
+			Run(Step::Listen);
+	}
+
+	void Close()
+	{
+		if (pipe != INVALID_HANDLE_VALUE)
+		{
+			CancelIo(pipe);
+			CloseHandle(pipe);
+			pipe = INVALID_HANDLE_VALUE;
+		}
+		CloseHandle(overlapped.hEvent);
+		overlapped.hEvent = nullptr;
+	}
+
+	// Issues operations until one is left pending on the event
+	// Operations that finish or fail straight away go round the loop, so a client
+	// that keeps connecting and dropping can't grow the stack
+	void Run(Step step)
+	{
+		while (true)
+		{
+			if (step == Step::Read)
+			{
+				// Clients may write any number of messages before closing their end
+				reading = true;
+				if (ReadFile(pipe, buffer, PIPE_BUFFER_SIZE, nullptr, &overlapped) || GetLastError() == ERROR_IO_PENDING)
+					return;
+				DisconnectNamedPipe(pipe);
+			}
+
+			reading = false;
+			if (ConnectNamedPipe(pipe, &overlapped))
+				return;
+
+			switch (GetLastError())
+			{
+			case ERROR_IO_PENDING:
+				return;
+			case ERROR_PIPE_CONNECTED:
+				// the client beat us to it, nothing will signal the event
+				step = Step::Read;
+				break;
+			default:
+				dprintf("ConnectNamedPipe failed on %ls: %lu\n", name.c_str(), GetLastError());
+				return;
+			}
+		}
+	}
+
+	// Called when the event fired, picks up where the last Run left off
+	void Complete()
+	{
+		DWORD transferred = 0;
+		if (!GetOverlappedResult(pipe, &overlapped, &transferred, FALSE))
+		{
+			// ERROR_MORE_DATA: oversized message, the rest is not worth waiting for
+			// ERROR_BROKEN_PIPE: client closed, get ready for the next one
+			DisconnectNamedPipe(pipe);
+			Run(Step::Listen);
+			return;
+		}
+
+		if (reading)
+			handler(buffer, transferred);
+		Run(Step::Read);
+	}
+};
+
+PipeMultiplexer::PipeMultiplexer()
+	: m_stop_event(CreateEvent(nullptr, TRUE, FALSE, nullptr))
+{
+}
+
+PipeMultiplexer::~PipeMultiplexer()
+{
+	Stop();
+	CloseHandle(m_stop_event);
+}
+
+void PipeMultiplexer::AddChannel(const wchar_t* name, Handler handler)
+{
+	auto channel = std::make_unique<Channel>();
+	channel->name = name;
+	channel->handler = std::move(handler);
+	if (m_running)
+	{
+		channel->Open();
+		m_channels_added = true;
+	}
+	m_channels.push_back(std::move(channel));
+}
+
+void PipeMultiplexer::Start()
+{
+	if (m_thread.joinable())
+		return;
+
+	ResetEvent(m_stop_event);
+	for (auto& channel : m_channels)
+		channel->Open();
+	m_running = true;
+	m_channels_added = false;
+	m_thread = std::thread(serve_thread, this);
+}
+
+void PipeMultiplexer::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+
+	SetEvent(m_stop_event);
+	m_thread.join();
+	m_running = false;
+	for (auto& channel : m_channels)
+		channel->Close();
+}
+
+void PipeMultiplexer::serve_thread(PipeMultiplexer* pthis)
+{
+#ifdef _WIN32
+	HRESULT hr = SetThreadDescription(GetCurrentThread(), L"pipe_multiplexer_thread");
+#endif
+
+	// Stop event first so shutdown wins over a busy channel
+	std::vector<HANDLE> events;
+	std::vector<Channel*> channels;
+	pthis->m_channels_added = true;
+
+	while (true)
+	{
+		if (pthis->m_channels_added)
+		{
+			pthis->m_channels_added = false;
+			events.assign(1, pthis->m_stop_event);
+			channels.clear();
+			for (auto& channel : pthis->m_channels)
+			{
+				if (channel->pipe == INVALID_HANDLE_VALUE)
+					continue;
+				events.push_back(channel->overlapped.hEvent);
+				channels.push_back(channel.get());
+			}
+		}
+
+		const DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE,
+		                                              INFINITE);
+		if (signaled == WAIT_OBJECT_0 || signaled == WAIT_FAILED)
+			return;
+
+		const DWORD index = signaled - WAIT_OBJECT_0 - 1;
+		if (index < channels.size())
+			channels[index]->Complete();
+	}
+}
@@ -0,0 +1,39 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// pipe_multiplexer.h
+//
+// serves any number of named pipe channels from a single thread
+// 
+// each channel keeps one overlapped pipe instance which is reconnected
+// in place after its client goes away, handlers run on the pipe thread
+// and may open further channels, e.g. once what they feed exists
+#pragma once
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+
+class PipeMultiplexer
+{
+public:
+	using Handler = std::function<void(const char* message, size_t length)>;
+
+	PipeMultiplexer();
+	~PipeMultiplexer();
+
+	// from any thread before Start, afterwards only from a handler
+	void AddChannel(const wchar_t* name, Handler handler);
+	void Start();
+	void Stop();
+
+private:
+	struct Channel;
+
+	static void serve_thread(PipeMultiplexer* pthis);
+
+	std::vector<std::unique_ptr<Channel>> m_channels;
+	bool m_running = false;
+	bool m_channels_added = false; // the pipe thread rebuilds its wait list
+	HANDLE m_stop_event;
+	std::thread m_thread;
+};
@@ -18,6 +18,7 @@
 #include <Windows.h>
 #include <Eigen/Dense>
 #include <cmath>
+#include <algorithm>
 #include <string>
 #include "SimpleSerial.h"
 #include <boost/thread.hpp>
@@ -27,15 +28,16 @@
 #include <glm/detail/type_vec3.hpp>
 #include <glm/detail/type_vec4.hpp>
 #include <glm/detail/type_vec2.hpp>
-#include "boost/lexical_cast.hpp"
 
 #include <openvr_driver.h>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <string.h>
 #include <vector>
 #include <string>
 #include "dprintf.h"
+#include <LatencyStats.h>
 
 #include <mutex>          // std::mutex
 
@@ -79,6 +81,35 @@ float rCX, rCY, rCZ;
 float lCX, lCY, lCZ;
 float mplacM[6], mplacMOF[8], mplacMF[5], mplacMROT[4], mplacMBUT[12];
 float mplacH[6], mplacHOF[8], mplacHF[5], mplacHROT[4], mplacHBUT[12];
+// Latest button message of one hand, the BUT thread sleeps until the pipe thread publishes a new one
+struct ButtonMessages
+{
+	std::mutex mutex;
+	std::condition_variable published;
+	uint32_t version = 0;
+	float buttons[12] = {};
+
+	void publish(const float* latest)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::copy(latest, latest + 12, buttons);
+			++version;
+		}
+		published.notify_all();
+	}
+
+	// Blocks until there is a message newer than last_version, returns its version
+	uint32_t waitForNewer(uint32_t last_version, float* out)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		published.wait(lock, [&] { return version != last_version; });
+		std::copy(buttons, buttons + 12, out);
+		return version;
+	}
+};
+
+ButtonMessages mbutMessages, hbutMessages;
 
 float in1 = 0;
 float abend = 100;
@@ -162,6 +193,7 @@ namespace soft_knuckles
 {
 	DriverPose_t pos, hposex, mposex;
 	DriverPose_t mposet, hposet, pposet;
+	SeqLock<TrackerPoses> trackerPoses;
 	TrackedDeviceIndex_t hmdid = 0;
 
 	BaseStation* m_station1 = new BaseStation(static_cast<int>(1));
@@ -351,102 +383,78 @@ namespace soft_knuckles
 		return (rpfingers->bendl);
 	}
 
-	void dlPipeTR()
+	// One '/' separated KEYvalue token per field, e.g. HX12345/HRW9999/ENABLED1/FID42/
+	// Values are scaled by 10000, fields the message doesn't carry read as 0
+	void decodeTrackerMessage(const char* message, size_t length)
 	{
-#ifdef _WIN32
-		HRESULT hr = SetThreadDescription(GetCurrentThread(), L"update_pipe_thread");
-#endif
-		using namespace Eigen;
+		const uint64_t decode_start = Latency::nowMicroseconds();
 
-		while (true)
+		DriverPose_t* poses[3] = {&hposet, &mposet, &pposet};
+		double position[3][3] = {}, offset[3][3] = {}, rotation[3][4] = {};
+		int enabled = -1;
+		uint64_t frame_id = 0, frame_us = 0;
+
+		const char* end = message + strnlen(message, length);
+		for (const char* token = message; token < end;)
 		{
-			HANDLE pipeOf = CreateNamedPipe(
-				TEXT("\\\\.\\pipe\\LogPipeTracker"), PIPE_ACCESS_INBOUND | PIPE_ACCESS_OUTBOUND,
-				PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE, 1, 1024, 1024, 120 * 1000, nullptr);
-
-			char OfD[1024];
-			DWORD Of = DWORD();
-
-			ConnectNamedPipe(pipeOf, nullptr);
-			ReadFile(pipeOf, OfD, 1024, &Of, nullptr);
-
-			//DisconnectNamedPipe(pipeOf);
-			CloseHandle(pipeOf);
-			std::string OfS = OfD;
-
-			hposet.vecPosition[0] = static_cast<float>(nstrn(OfS, "HX")) / static_cast<float>(10000);
-			hposet.vecPosition[1] = static_cast<float>(nstrn(OfS, "HY")) / static_cast<float>(10000);
-			hposet.vecPosition[2] = static_cast<float>(nstrn(OfS, "HZ")) / static_cast<float>(10000);
-			mposet.vecPosition[0] = static_cast<float>(nstrn(OfS, "MX")) / static_cast<float>(10000);
-			mposet.vecPosition[1] = static_cast<float>(nstrn(OfS, "MY")) / static_cast<float>(10000);
-			mposet.vecPosition[2] = static_cast<float>(nstrn(OfS, "MZ")) / static_cast<float>(10000);
-			pposet.vecPosition[0] = static_cast<float>(nstrn(OfS, "PX")) / static_cast<float>(10000);
-			pposet.vecPosition[1] = static_cast<float>(nstrn(OfS, "PY")) / static_cast<float>(10000);
-			pposet.vecPosition[2] = static_cast<float>(nstrn(OfS, "PZ")) / static_cast<float>(10000);
-
-			float vhrotw = static_cast<float>(nstrn(OfS, "HRW")) / static_cast<float>(10000);
-			float vhrotx = static_cast<float>(nstrn(OfS, "HRX")) / static_cast<float>(10000);
-			float vhroty = static_cast<float>(nstrn(OfS, "HRY")) / static_cast<float>(10000);
-			float vhrotz = static_cast<float>(nstrn(OfS, "HRZ")) / static_cast<float>(10000);
-
-			float vmrotw = static_cast<float>(nstrn(OfS, "MRW")) / static_cast<float>(10000);
-			float vmrotx = static_cast<float>(nstrn(OfS, "MRX")) / static_cast<float>(10000);
-			float vmroty = static_cast<float>(nstrn(OfS, "MRY")) / static_cast<float>(10000);
-			float vmrotz = static_cast<float>(nstrn(OfS, "MRZ")) / static_cast<float>(10000);
-
-			float vprotw = static_cast<float>(nstrn(OfS, "PRW")) / static_cast<float>(10000);
-			float vprotx = static_cast<float>(nstrn(OfS, "PRX")) / static_cast<float>(10000);
-			float vproty = static_cast<float>(nstrn(OfS, "PRY")) / static_cast<float>(10000);
-			float vprotz = static_cast<float>(nstrn(OfS, "PRZ")) / static_cast<float>(10000);
-
-			std::string en = ExtractString(OfS, "ENABLED", "/");
-
-			if (en == "0")
-			{
-				hposet.poseIsValid = false;
-				hposet.deviceIsConnected = false;
-				mposet.poseIsValid = false;
-				mposet.deviceIsConnected = false;
-				pposet.poseIsValid = false;
-				pposet.deviceIsConnected = false;
-			}
-			else if (en == "1")
-			{
-				hposet.poseIsValid = true;
-				hposet.deviceIsConnected = true;
-				mposet.poseIsValid = true;
-				mposet.deviceIsConnected = true;
-				pposet.poseIsValid = true;
-				pposet.deviceIsConnected = true;
-			}
+			const char* token_end = static_cast<const char*>(memchr(token, '/', end - token));
+			if (token_end == nullptr)
+				token_end = end;
+
+			const char* value = token;
+			while (value < token_end && *value >= 'A' && *value <= 'Z')
+				++value;
+			const size_t key_length = value - token;
 
-			hposet.qRotation.w = vhrotw;
-			hposet.qRotation.x = vhrotx;
-			hposet.qRotation.y = vhroty;
-			hposet.qRotation.z = vhrotz;
+			// Copied out so the number parsers can't run past the message
+			char number[32];
+			const size_t value_length = (std::min)(static_cast<size_t>(token_end - value), sizeof(number) - 1);
+			memcpy(number, value, value_length);
+			number[value_length] = '\0';
 
-			mposet.qRotation.w = vmrotw;
-			mposet.qRotation.x = vmrotx;
-			mposet.qRotation.y = vmroty;
-			mposet.qRotation.z = vmrotz;
+			const int pose = token[0] == 'H' ? 0 : token[0] == 'M' ? 1 : token[0] == 'P' ? 2 : -1;
+			if (pose >= 0 && key_length == 2 && token[1] >= 'X' && token[1] <= 'Z')
+				position[pose][token[1] - 'X'] = strtod(number, nullptr);
+			else if (pose >= 0 && key_length == 3 && token[1] == 'O' && token[2] >= 'X' && token[2] <= 'Z')
+				offset[pose][token[2] - 'X'] = strtod(number, nullptr);
+			else if (pose >= 0 && key_length == 3 && token[1] == 'R' && token[2] == 'W')
+				rotation[pose][0] = strtod(number, nullptr);
+			else if (pose >= 0 && key_length == 3 && token[1] == 'R' && token[2] >= 'X' && token[2] <= 'Z')
+				rotation[pose][1 + token[2] - 'X'] = strtod(number, nullptr);
+			else if (key_length == 7 && strncmp(token, "ENABLED", 7) == 0 && value_length == 1)
+				enabled = number[0] == '1' ? 1 : number[0] == '0' ? 0 : -1;
+			else if (key_length == 3 && strncmp(token, "FID", 3) == 0)
+				frame_id = strtoull(number, nullptr, 10);
+			else if (key_length == 2 && strncmp(token, "FT", 2) == 0)
+				frame_us = strtoull(number, nullptr, 10);
+
+			token = token_end + 1;
+		}
 
-			pposet.qRotation.w = vprotw;
-			pposet.qRotation.x = vprotx;
-			pposet.qRotation.y = vproty;
-			pposet.qRotation.z = vprotz;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				poses[i]->vecPosition[axis] = static_cast<float>((position[i][axis] + offset[i][axis]) / 10000);
 
-			hposet.vecPosition[0] += static_cast<float>(nstrn(OfS, "HOX")) / static_cast<float>(10000);
-			hposet.vecPosition[1] += static_cast<float>(nstrn(OfS, "HOY")) / static_cast<float>(10000);
-			hposet.vecPosition[2] += static_cast<float>(nstrn(OfS, "HOZ")) / static_cast<float>(10000);
-			mposet.vecPosition[0] += static_cast<float>(nstrn(OfS, "MOX")) / static_cast<float>(10000);
-			mposet.vecPosition[1] += static_cast<float>(nstrn(OfS, "MOY")) / static_cast<float>(10000);
-			mposet.vecPosition[2] += static_cast<float>(nstrn(OfS, "MOZ")) / static_cast<float>(10000);
-			pposet.vecPosition[0] += static_cast<float>(nstrn(OfS, "POX")) / static_cast<float>(10000);
-			pposet.vecPosition[1] += static_cast<float>(nstrn(OfS, "POY")) / static_cast<float>(10000);
-			pposet.vecPosition[2] += static_cast<float>(nstrn(OfS, "POZ")) / static_cast<float>(10000);
+			poses[i]->qRotation.w = static_cast<float>(rotation[i][0] / 10000);
+			poses[i]->qRotation.x = static_cast<float>(rotation[i][1] / 10000);
+			poses[i]->qRotation.y = static_cast<float>(rotation[i][2] / 10000);
+			poses[i]->qRotation.z = static_cast<float>(rotation[i][3] / 10000);
 
-			std::this_thread::sleep_for(std::chrono::milliseconds(3));
+			if (enabled >= 0)
+			{
+				poses[i]->poseIsValid = enabled == 1;
+				poses[i]->deviceIsConnected = enabled == 1;
+			}
 		}
+
+		publishTrackerPoses(frame_id, frame_us);
+		Latency::record(Latency::Stage::DriverDecode, Latency::nowMicroseconds() - decode_start);
+	}
+
+	void publishTrackerPoses(uint64_t frame_id, uint64_t frame_us)
+	{
+		trackerPoses.store({hposet, mposet, pposet, frame_id, frame_us});
 	}
 
 	void dlPipeM()
@@ -626,112 +634,26 @@ namespace soft_knuckles
 
 	void SoftKnucklesDevice::dlPipeMBUT(SoftKnucklesDevice* pthis)
 	{
+		if (pthis->m_role != TrackedControllerRole_RightHand)
+			return;
+
+		uint32_t version = 0;
+		float buttons[12];
 		while (true)
 		{
-			if (pthis->m_role == TrackedControllerRole_RightHand)
-			{
-				for (int component = 0; component <= 9; component++)
-				{
-					string inpath, val;
-
-					switch (component)
-					{
-					case 0:
-						inpath = "/input/thumbstick/x";
-						val = boost::lexical_cast<std::string>(mplacMBUT[0]);
-						break;
-
-					case 1:
-						inpath = "/input/thumbstick/y";
-						val = boost::lexical_cast<std::string>(mplacMBUT[1]);
-						break;
-
-					case 2:
-						inpath = "/input/thumbstick/touch";
-						if (mplacMBUT[0] != 0.f || mplacMBUT[1] != 0.f)
-						{
-							val = "1";
-						}
-						else
-						{
-							val = "0";
-						}
-						break;
-
-					case 3:
-						inpath = "/input/system/click";
-						val = boost::lexical_cast<std::string>(mplacMBUT[2]);
-						break;
-
-					case 4:
-						inpath = "/input/trigger/value";
-						val = boost::lexical_cast<std::string>(mplacMBUT[3]);
-						break;
-
-					case 5:
-						inpath = "/input/trigger/touch";
-						mplacMBUT[3] != 0.f ? val = "1" : val = "0";
-						break;
-
-					case 6:
-						inpath = "/input/a/click";
-						val = boost::lexical_cast<std::string>(mplacMBUT[4]);
-						break;
-
-					case 7:
-						inpath = "/input/b/click";
-						val = boost::lexical_cast<std::string>(mplacMBUT[5]);
-						break;
-
-					case 8:
-						inpath = "/input/grip/click";
-						val = boost::lexical_cast<std::string>(mplacMBUT[6]);
-						break;
-
-					case 9:
-						inpath = "/input/grip/touch";
-						val = boost::lexical_cast<std::string>(mplacMBUT[6]);
-						break;
-					}
-
-					if (inputstring2index.size() == 0)
-					{
-						inputstring2index.reserve(pthis->m_num_component_definitions);
-						for (uint32_t i = 0; i < pthis->m_num_component_definitions; i++)
-						{
-							inputstring2index[pthis->m_component_definitions[i].full_path] = i;
-						}
-					}
+			version = mbutMessages.waitForNewer(version, buttons);
+			pthis->SubmitButtons(buttons);
+		}
+	}
 
-					string input_state_path = inpath;
-					auto iter = inputstring2index.find(input_state_path);
-					if (iter != inputstring2index.end())
-					{
-						uint32_t index = (*iter).second;
-						VRInputComponentHandle_t component_handle = pthis->m_component_handles[index];
-						ComponentType component_type = pthis->m_component_definitions[index].component_type;
-						if (component_type == CT_BOOLEAN)
-						{
-							bool new_value = (val == "1");
-							EVRInputError err = VRDriverInput()->UpdateBooleanComponent(component_handle, new_value, 0);
-							if (err != VRInputError_None)
-							{
-								dprintf("error %d\n", err);
-							}
-						}
-						else if (component_type == CT_SCALAR)
-						{
-							float new_value = static_cast<float>(atof(val.c_str()));
-							EVRInputError err = VRDriverInput()->UpdateScalarComponent(component_handle, new_value, 0);
-							if (err != VRInputError_None)
-							{
-								dprintf("error %d\n", err);
-							}
-						}
-					}
-				}
-			}
+	void SoftKnucklesDevice::SubmitButtons(const float* buttons)
+	{
+		// Handles only exist once Activate created the components
+		if (!m_input_state.IsBound() && m_component_handles.size() == m_num_component_definitions)
+		{
+			m_input_state.Bind(m_component_definitions, m_num_component_definitions, m_component_handles.data());
 		}
+		m_input_state.Submit(buttons, VRDriverInput());
 	}
 
 	void mbutpipe()
@@ -762,6 +684,7 @@ namespace soft_knuckles
 			mplacMBUT[4] = static_cast<float>(nstrn(ichiS, "AB")) / static_cast<float>(10000);
 			mplacMBUT[5] = static_cast<float>(nstrn(ichiS, "BB")) / static_cast<float>(10000);
 			mplacMBUT[6] = static_cast<float>(nstrn(ichiS, "GR")) / static_cast<float>(10000);
+			mbutMessages.publish(mplacMBUT);
 
 			DisconnectNamedPipe(hPipe);
 		}
@@ -946,111 +869,15 @@ namespace soft_knuckles
 
 	void SoftKnucklesDevice::dlPipeHBUT(SoftKnucklesDevice* pthis)
 	{
+		if (pthis->m_role != TrackedControllerRole_LeftHand)
+			return;
+
+		uint32_t version = 0;
+		float buttons[12];
 		while (true)
 		{
-			if (pthis->m_role == TrackedControllerRole_LeftHand)
-			{
-				for (int component = 0; component <= 9; component++)
-				{
-					string inpath, val;
-
-					switch (component)
-					{
-					case 0:
-						inpath = "/input/thumbstick/x";
-						val = boost::lexical_cast<std::string>(mplacHBUT[0]);
-						break;
-
-					case 1:
-						inpath = "/input/thumbstick/y";
-						val = boost::lexical_cast<std::string>(mplacHBUT[1]);
-						break;
-
-					case 2:
-						inpath = "/input/thumbstick/touch";
-						if (mplacHBUT[0] != 0.f || mplacHBUT[1] != 0.f)
-						{
-							val = "1";
-						}
-						else
-						{
-							val = "0";
-						}
-						break;
-
-					case 3:
-						inpath = "/input/system/click";
-						val = boost::lexical_cast<std::string>(mplacHBUT[2]);
-						break;
-
-					case 4:
-						inpath = "/input/trigger/value";
-						val = boost::lexical_cast<std::string>(mplacHBUT[3]);
-						break;
-
-					case 5:
-						inpath = "/input/trigger/touch";
-						mplacHBUT[3] != 0.f ? val = "1" : val = "0";
-						break;
-
-					case 6:
-						inpath = "/input/a/click";
-						val = boost::lexical_cast<std::string>(mplacHBUT[4]);
-						break;
-
-					case 7:
-						inpath = "/input/b/click";
-						val = boost::lexical_cast<std::string>(mplacHBUT[5]);
-						break;
-
-					case 8:
-						inpath = "/input/grip/click";
-						val = boost::lexical_cast<std::string>(mplacHBUT[6]);
-						break;
-
-					case 9:
-						inpath = "/input/grip/touch";
-						val = boost::lexical_cast<std::string>(mplacHBUT[6]);
-						break;
-					}
-
-					if (inputstring2index.size() == 0)
-					{
-						inputstring2index.reserve(pthis->m_num_component_definitions);
-						for (uint32_t i = 0; i < pthis->m_num_component_definitions; i++)
-						{
-							inputstring2index[pthis->m_component_definitions[i].full_path] = i;
-						}
-					}
-
-					string input_state_path = inpath;
-					auto iter = inputstring2index.find(input_state_path);
-					if (iter != inputstring2index.end())
-					{
-						uint32_t index = (*iter).second;
-						VRInputComponentHandle_t component_handle = pthis->m_component_handles[index];
-						ComponentType component_type = pthis->m_component_definitions[index].component_type;
-						if (component_type == CT_BOOLEAN)
-						{
-							bool new_value = (val == "1");
-							EVRInputError err = VRDriverInput()->UpdateBooleanComponent(component_handle, new_value, 0);
-							if (err != VRInputError_None)
-							{
-								dprintf("error %d\n", err);
-							}
-						}
-						else if (component_type == CT_SCALAR)
-						{
-							float new_value = static_cast<float>(atof(val.c_str()));
-							EVRInputError err = VRDriverInput()->UpdateScalarComponent(component_handle, new_value, 0);
-							if (err != VRInputError_None)
-							{
-								dprintf("error %d\n", err);
-							}
-						}
-					}
-				}
-			}
+			version = hbutMessages.waitForNewer(version, buttons);
+			pthis->SubmitButtons(buttons);
 		}
 	}
 
@@ -1082,6 +909,7 @@ namespace soft_knuckles
 			mplacHBUT[4] = static_cast<float>(nstrn(ichiS, "AB")) / static_cast<float>(10000);
 			mplacHBUT[5] = static_cast<float>(nstrn(ichiS, "BB")) / static_cast<float>(10000);
 			mplacHBUT[6] = static_cast<float>(nstrn(ichiS, "GR")) / static_cast<float>(10000);
+			hbutMessages.publish(mplacHBUT);
 
 			DisconnectNamedPipe(hPipe);
 		}
@@ -1118,7 +946,8 @@ namespace soft_knuckles
 		if (m_inputstring2index.size() == 0)
 			InitializeLookupTable();
 
-		dprintf("device_id %d received request: %s\n", m_device->m_id, request);
+		// Requests come in at tracking rate
+		dprintf_every(1000, "device_id %d received request: %s\n", m_device->m_id, request);
 
 		vector<string> tokens;
 		tokenize(request, " \r\t\n,", &tokens);
@@ -1905,6 +1734,7 @@ namespace soft_knuckles
 		pposet.vecPosition[0] = 0;
 		pposet.vecPosition[1] = 0;
 		pposet.vecPosition[2] = 0;
+		publishTrackerPoses(0, 0);
 
 		transformleftthumb(bendt);
 		transformleftindex(bendi);
@@ -3467,6 +3297,8 @@ namespace soft_knuckles
 		//m_pipeHROT_thread = boost::thread(dlPipeHROT);
 		//m_pipeHROT_thread.detach();
 
+		// The BUT threads are the only callers of SubmitButtons, while they stay off
+		// no button state reaches SteamVR through m_input_state
 		//if (this->m_role == TrackedControllerRole_LeftHand)
 		//{
 		//	m_pipeHBUT_thread = boost::thread(dlPipeHBUT, this);
@@ -17,6 +17,8 @@
 #include "soft_knuckles_config.h"
 #include <boost/thread.hpp>
 #include "BaseStation.h"
+#include "input_state.h"
+#include <SeqLock.h>
 
 using namespace vr;
 using namespace std;
@@ -40,6 +42,16 @@ namespace soft_knuckles
 	extern float hidari[62][4];
 	extern DriverPose_t mposet, hposet, pposet;
 
+	// Everything one LogPipeTracker message carries, published as a whole
+	// so the trackers never see half of an update
+	struct TrackerPoses
+	{
+		DriverPose_t left_foot, right_foot, hip;
+		// Kinect frame the poses came from, see Latency::Stage::EndToEnd
+		uint64_t frame_id, frame_us;
+	};
+	extern SeqLock<TrackerPoses> trackerPoses;
+
 	void transformleftroot(float bend);
 	void transformleftwrist(float bend);
 	void transformleftthumb(float bend);
@@ -55,7 +67,9 @@ namespace soft_knuckles
 	void transformrightmiddle(float bend);
 	void transformrightring(float bend);
 	void transformrightpinky(float bend);
-	void dlPipeTR();
+	// LogPipeTracker handler, fills mposet/hposet/pposet and publishes them
+	void decodeTrackerMessage(const char* message, size_t length);
+	void publishTrackerPoses(uint64_t frame_id, uint64_t frame_us);
 
 	void transformallleft(float bend);
 	void transformallright(float bend);
@@ -106,6 +120,8 @@ namespace soft_knuckles
 		boost::thread m_pipeHBUUT_thread;
 		boost::thread m_pipeMBUUT_thread;
 
+		InputStateTracker m_input_state;
+
 		boost::thread bt;
 
 
@@ -147,6 +163,7 @@ namespace soft_knuckles
 		void SetProperty(ETrackedDeviceProperty prop_key, const char* prop_value);
 		void SetInt32Property(ETrackedDeviceProperty prop_key, int32_t value);
 		void SetBoolProperty(ETrackedDeviceProperty prop_key, int32_t value);
+		void SubmitButtons(const float* buttons);
 	};
 }
 
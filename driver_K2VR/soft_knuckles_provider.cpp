@@ -22,14 +22,18 @@
 
 #include <Windows.h>
 #include <thread>
+#include <memory>
 #include <string.h>
 #include <string>
 #include <openvr_driver.h>
 #include "soft_knuckles_device.h"
 #include "soft_knuckles_debug_handler.h"
 #include "socket_notifier.h"
+#include "pipe_multiplexer.h"
+#include "watchdog_policy.h"
 #include "BodyTracker.h"
 #include "dprintf.h"
+#include <StartupReadiness.h>
 #include <boost/interprocess/managed_shared_memory.hpp>
 #pragma comment(lib, "Ws2_32.lib")
 
@@ -59,6 +63,8 @@ namespace soft_knuckles
 		SoftKnucklesDevice m_knuckles[NUM_DEVICES];
 		SoftKnucklesDebugHandler m_debug_handler[NUM_DEVICES];
 		SoftKnucklesSocketNotifier m_notifier;
+		PipeMultiplexer m_pipes; // TrackersInitPipe, LogPipeTracker once the trackers are added
+		Readiness::NamedEvent m_pipes_ready{Readiness::k_driverPipesReady}; // Clients wait on this instead of a fixed delay
 		BodyTracker *trh = new BodyTracker("RFOOT"), *trm = new BodyTracker("LFOOT"), *trp = new BodyTracker("HIP");
 
 	public:
@@ -72,6 +78,7 @@ namespace soft_knuckles
 		{
 			// NOTE 1: use the driver context.  Sets up a big set of globals
 			VR_INIT_SERVER_DRIVER_CONTEXT(pDriverContext);
+			StartDriverLog();
 			dprintf("Initializing...\n");
 
 			/*if constexpr (NUM_DEVICES > 0)
@@ -89,39 +96,25 @@ namespace soft_knuckles
 
 			m_notifier.StartListening(listen_address, listen_port);
 
-			std::thread* inittrackers = new std::thread([&]
-				{
-					while (true) //don't need to wait - pipe's ReadFile already does it
-					{
-						HANDLE pipeInit = CreateNamedPipe(
-							TEXT("\\\\.\\pipe\\TrackersInitPipe"), PIPE_ACCESS_INBOUND | PIPE_ACCESS_OUTBOUND,
-							PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE, 1, 1024, 1024, 120 * 1000, nullptr);
-
-						char InitD[1024];
-						DWORD Init = DWORD();
-
-						ConnectNamedPipe(pipeInit, nullptr);
-						ReadFile(pipeInit, InitD, 1024, &Init, nullptr);
-						CloseHandle(pipeInit);
-
-						std::string InitS = InitD;
-
-						if (InitS.find("Initialize Trackers!") != std::string::npos)
-						{
-							VRServerDriverHost()->TrackedDeviceAdded(trp->get_serial().c_str(),
-								TrackedDeviceClass_GenericTracker, trp);
-							VRServerDriverHost()->TrackedDeviceAdded(trm->get_serial().c_str(),
-								TrackedDeviceClass_GenericTracker, trm);
-							VRServerDriverHost()->TrackedDeviceAdded(trh->get_serial().c_str(),
-								TrackedDeviceClass_GenericTracker, trh);
-
-							boost::thread m_pipeTR_thread = boost::thread(dlPipeTR);
-							m_pipeTR_thread.detach();
-							activatedSpawned = true;
-							return;
-						}
-					}
-				});
+			m_pipes.AddChannel(L"\\\\.\\pipe\\TrackersInitPipe", [this](const char* message, size_t length)
+			{
+				if (activatedSpawned || std::string(message, strnlen(message, length)).find("Initialize Trackers!") ==
+					std::string::npos)
+					return;
+
+				VRServerDriverHost()->TrackedDeviceAdded(trp->get_serial().c_str(),
+				                                         TrackedDeviceClass_GenericTracker, trp);
+				VRServerDriverHost()->TrackedDeviceAdded(trm->get_serial().c_str(),
+				                                         TrackedDeviceClass_GenericTracker, trm);
+				VRServerDriverHost()->TrackedDeviceAdded(trh->get_serial().c_str(),
+				                                         TrackedDeviceClass_GenericTracker, trh);
+				activatedSpawned = true;
+
+				// Poses only have somewhere to go now
+				m_pipes.AddChannel(L"\\\\.\\pipe\\LogPipeTracker", decodeTrackerMessage);
+			});
+			m_pipes.Start();
+			m_pipes_ready.signal();
 
 			std::thread* serverstatus = new std::thread([&]
 				{
@@ -180,10 +173,13 @@ namespace soft_knuckles
 		{
 			dprintf("Cleaning...\n");
 			m_notifier.StopListening();
+			m_pipes_ready.reset();
+			m_pipes.Stop();
 			for (int i = 0; i < NUM_DEVICES; i++)
 			{
 				m_knuckles[i].Deactivate();
 			}
+			StopDriverLog();
 		}
 
 		const char* const * GetInterfaceVersions() override
@@ -234,56 +230,41 @@ namespace soft_knuckles
 	}
 } // end of namespace 
 
-bool g_bExiting = false;
-
 class CWatchdogDriver_Sample : public IVRWatchdogProvider
 {
 public:
-	CWatchdogDriver_Sample()
-	{
-		m_pWatchdogThread = nullptr;
-	}
-
 	EVRInitError Init(IVRDriverContext* pDriverContext) override;
 	void Cleanup() override;
 
 private:
-	thread* m_pWatchdogThread;
+	std::unique_ptr<WatchdogPolicy> m_policy;
 };
 
-void WatchdogThreadFunction()
-{
-	while (!g_bExiting)
-	{
-#if defined( _WINDOWS )
-		// on windows send the event when the Y key is pressed.
-		//if ((0x01 & GetAsyncKeyState('Y')) != 0)
-		{
-			// Y key was pressed. 
-			VRWatchdogHost()->WatchdogWakeUp(TrackedDeviceClass_HMD);
-		}
-		this_thread::sleep_for(chrono::microseconds(500));
-#else
-        // for the other platforms, just send one every five seconds
-        this_thread::sleep_for(chrono::seconds(5));
-        vr::VRWatchdogHost()->WatchdogWakeUp(vr::TrackedDeviceClass_HMD);
-#endif
-	}
-}
-
 EVRInitError CWatchdogDriver_Sample::Init(IVRDriverContext* pDriverContext)
 {
 	VR_INIT_WATCHDOG_DRIVER_CONTEXT(pDriverContext);
+	// The watchdog runs in its own process, without the server provider's log thread
+	StartDriverLog();
 	dprintf("Watchdog started...\n");
 
-	// Watchdog mode on Windows starts a thread that listens for the 'Y' key on the keyboard to 
-	// be pressed. A real driver should wait for a system button event or something else from the 
-	// the hardware that signals that the VR system should start up.
-	g_bExiting = false;
-	m_pWatchdogThread = new thread(WatchdogThreadFunction);
-	if (!m_pWatchdogThread)
+	// SteamVR is only woken while a K2VR client is actually sending poses,
+	// see PoseActivity::notify in the client's sendipc
+	WatchdogPolicy::Settings settings;
+	EVRSettingsError error = VRSettingsError_None;
+	const int32_t wake_interval_ms = VRSettings()->GetInt32(soft_knuckles::kSettingsSection,
+	                                                        "watchdogWakeIntervalMs", &error);
+	if (error == VRSettingsError_None && wake_interval_ms > 0)
+		settings.wake_interval_ms = static_cast<uint32_t>(wake_interval_ms);
+
+	m_policy = std::make_unique<WatchdogPolicy>([]
+	{
+		VRWatchdogHost()->WatchdogWakeUp(TrackedDeviceClass_HMD);
+	}, settings);
+	if (!m_policy->Start())
 	{
 		dprintf("N/P cannot create!\n");
+		// Cleanup isn't called after a failed Init
+		StopDriverLog();
 		return VRInitError_Driver_Failed;
 	}
 
@@ -293,13 +274,8 @@ EVRInitError CWatchdogDriver_Sample::Init(IVRDriverContext* pDriverContext)
 
 void CWatchdogDriver_Sample::Cleanup()
 {
-	g_bExiting = true;
-	if (m_pWatchdogThread)
-	{
-		m_pWatchdogThread->join();
-		delete m_pWatchdogThread;
-		m_pWatchdogThread = nullptr;
-	}
+	m_policy.reset();
+	StopDriverLog();
 }
 
 #if defined(_WIN32)
@@ -0,0 +1,70 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// watchdog_policy
+//	* waits on the pose activity event instead of spinning
+//
+
+#include <PoseActivity.h>
+#include "dprintf.h"
+#include "watchdog_policy.h"
+
+WatchdogPolicy::WatchdogPolicy(WakeUp wake_up, const Settings& settings)
+	: m_wake_up(std::move(wake_up)),
+	  m_settings(settings),
+	  m_stop_event(CreateEvent(nullptr, TRUE, FALSE, nullptr)),
+	  m_activity_event(PoseActivity::openEvent())
+{
+}
+
+WatchdogPolicy::~WatchdogPolicy()
+{
+	Stop();
+	if (m_activity_event)
+		CloseHandle(m_activity_event);
+	CloseHandle(m_stop_event);
+}
+
+bool WatchdogPolicy::Start()
+{
+	if (!m_activity_event)
+	{
+		dprintf("Watchdog activity event failed: %lu\n", GetLastError());
+		return false;
+	}
+	if (!m_thread.joinable())
+	{
+		ResetEvent(m_stop_event);
+		m_thread = std::thread(watchdog_thread, this);
+	}
+	return true;
+}
+
+void WatchdogPolicy::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+	SetEvent(m_stop_event);
+	m_thread.join();
+}
+
+void WatchdogPolicy::watchdog_thread(WatchdogPolicy* pthis)
+{
+#ifdef _WIN32
+	HRESULT hr = SetThreadDescription(GetCurrentThread(), L"watchdog_thread");
+#endif
+
+	const HANDLE events[] = {pthis->m_stop_event, pthis->m_activity_event};
+	while (true)
+	{
+		// Stop event first so shutdown wins
+		if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+			return;
+
+		dprintf("Pose activity, waking SteamVR\n");
+		pthis->m_wake_up();
+
+		// Rate limit: hold off for the interval, a signal raised meanwhile
+		// stays set and wakes the host again right after
+		if (WaitForSingleObject(pthis->m_stop_event, pthis->m_settings.wake_interval_ms) == WAIT_OBJECT_0)
+			return;
+	}
+}
@@ -0,0 +1,40 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+// watchdog_policy.h
+//
+// decides when the watchdog driver wakes SteamVR
+// 
+// the KinectToVR client raises a named event while it is sending poses (see
+// PoseActivity.h), the watchdog thread sleeps on it and wakes the host at most
+// once per wake interval, nothing runs while nobody is tracking
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <Windows.h>
+
+class WatchdogPolicy
+{
+public:
+	using WakeUp = std::function<void()>;
+
+	struct Settings
+	{
+		uint32_t wake_interval_ms = 5000;
+	};
+
+	// wake_up is VRWatchdogHost()->WatchdogWakeUp in the driver
+	WatchdogPolicy(WakeUp wake_up, const Settings& settings);
+	~WatchdogPolicy();
+
+	bool Start();
+	void Stop();
+
+private:
+	static void watchdog_thread(WatchdogPolicy* pthis);
+
+	WakeUp m_wake_up;
+	Settings m_settings;
+	HANDLE m_stop_event;
+	HANDLE m_activity_event;
+	std::thread m_thread;
+};
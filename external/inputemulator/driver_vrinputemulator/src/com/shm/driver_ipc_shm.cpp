@@ -630,51 +630,53 @@ void IpcShmCommunicator::_ipcThreadFunc(IpcShmCommunicator* _this, ServerDriver
 										resp.status = ipc::ReplyStatus::NotFound;
 									} else {
 										resp.status = ipc::ReplyStatus::Ok;
+										auto offsets = info->poseOffsets();
 										if (message.msg.dm_DeviceOffsets.enableOffsets > 0) {
-											info->enableOffsets(message.msg.dm_DeviceOffsets.enableOffsets == 1 ? true : false);
+											offsets.enabled = message.msg.dm_DeviceOffsets.enableOffsets == 1 ? true : false;
 										}
 										switch (message.msg.dm_DeviceOffsets.offsetOperation) {
 										case 0:
 											if (message.msg.dm_DeviceOffsets.worldFromDriverRotationOffsetValid) {
-												info->worldFromDriverRotationOffset() = message.msg.dm_DeviceOffsets.worldFromDriverRotationOffset;
+												offsets.worldFromDriverRotation = message.msg.dm_DeviceOffsets.worldFromDriverRotationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffsetValid) {
-												info->worldFromDriverTranslationOffset() = message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffset;
+												offsets.worldFromDriverTranslation = message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.driverFromHeadRotationOffsetValid) {
-												info->driverFromHeadRotationOffset() = message.msg.dm_DeviceOffsets.driverFromHeadRotationOffset;
+												offsets.driverFromHeadRotation = message.msg.dm_DeviceOffsets.driverFromHeadRotationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffsetValid) {
-												info->driverFromHeadTranslationOffset() = message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffset;
+												offsets.driverFromHeadTranslation = message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.deviceRotationOffsetValid) {
-												info->deviceRotationOffset() = message.msg.dm_DeviceOffsets.deviceRotationOffset;
+												offsets.deviceRotation = message.msg.dm_DeviceOffsets.deviceRotationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.deviceTranslationOffsetValid) {
-												info->deviceTranslationOffset() = message.msg.dm_DeviceOffsets.deviceTranslationOffset;
+												offsets.deviceTranslation = message.msg.dm_DeviceOffsets.deviceTranslationOffset;
 											}
 											break;
 										case 1:
 											if (message.msg.dm_DeviceOffsets.worldFromDriverRotationOffsetValid) {
-												info->worldFromDriverRotationOffset() =  message.msg.dm_DeviceOffsets.worldFromDriverRotationOffset * info->worldFromDriverRotationOffset();
+												offsets.worldFromDriverRotation = message.msg.dm_DeviceOffsets.worldFromDriverRotationOffset * offsets.worldFromDriverRotation;
 											}
 											if (message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffsetValid) {
-												info->worldFromDriverTranslationOffset() = info->worldFromDriverTranslationOffset() + message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffset;
+												offsets.worldFromDriverTranslation = offsets.worldFromDriverTranslation + message.msg.dm_DeviceOffsets.worldFromDriverTranslationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.driverFromHeadRotationOffsetValid) {
-												info->driverFromHeadRotationOffset() = message.msg.dm_DeviceOffsets.driverFromHeadRotationOffset * info->driverFromHeadRotationOffset();
+												offsets.driverFromHeadRotation = message.msg.dm_DeviceOffsets.driverFromHeadRotationOffset * offsets.driverFromHeadRotation;
 											}
 											if (message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffsetValid) {
-												info->driverFromHeadTranslationOffset() = info->driverFromHeadTranslationOffset() + message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffset;
+												offsets.driverFromHeadTranslation = offsets.driverFromHeadTranslation + message.msg.dm_DeviceOffsets.driverFromHeadTranslationOffset;
 											}
 											if (message.msg.dm_DeviceOffsets.deviceRotationOffsetValid) {
-												info->deviceRotationOffset() = message.msg.dm_DeviceOffsets.deviceRotationOffset * info->deviceRotationOffset();
+												offsets.deviceRotation = message.msg.dm_DeviceOffsets.deviceRotationOffset * offsets.deviceRotation;
 											}
 											if (message.msg.dm_DeviceOffsets.deviceTranslationOffsetValid) {
-												info->deviceTranslationOffset() = info->deviceTranslationOffset() + message.msg.dm_DeviceOffsets.deviceTranslationOffset;
+												offsets.deviceTranslation = offsets.deviceTranslation + message.msg.dm_DeviceOffsets.deviceTranslationOffset;
 											}
 											break;
 										}
+										info->setPoseOffsets(offsets);
 									}
 								}
 								if (resp.status != ipc::ReplyStatus::Ok) {
@@ -893,6 +895,31 @@ void IpcShmCommunicator::_ipcThreadFunc(IpcShmCommunicator* _this, ServerDriver
 							}
 							break;
 
+						case ipc::RequestType::DeviceManipulation_SetPoseFilterTuning:
+							{
+								ipc::Reply resp(ipc::ReplyType::GenericReply);
+								resp.messageId = message.msg.dm_SetPoseFilterTuning.messageId;
+								if (message.msg.dm_SetPoseFilterTuning.deviceId >= vr::k_unMaxTrackedDeviceCount) {
+									resp.status = ipc::ReplyStatus::InvalidId;
+								} else {
+									DeviceManipulationHandle* info = driver->getDeviceManipulationHandleById(message.msg.dm_SetPoseFilterTuning.deviceId);
+									if (!info) {
+										resp.status = ipc::ReplyStatus::NotFound;
+									} else {
+										auto tuning = message.msg.dm_SetPoseFilterTuning.useDefaultTuning ? nullptr : &message.msg.dm_SetPoseFilterTuning.tuning;
+										driver->motionCompensation().setDevicePoseKalmanTuning(info, tuning);
+										resp.status = ipc::ReplyStatus::Ok;
+									}
+								}
+								if (resp.status != ipc::ReplyStatus::Ok) {
+									LOG(ERROR) << "Error while setting pose filter tuning: Error code " << (int)resp.status;
+								}
+								if (resp.messageId != 0) {
+									_this->sendReply(message.msg.dm_SetPoseFilterTuning.clientId, resp);
+								}
+							}
+							break;
+
 						case ipc::RequestType::InputRemapping_SetTouchpadEmulationFixEnabled: {
 							DeviceManipulationHandle::setTouchpadEmulationFixFlag(message.msg.ir_SetTouchPadEmulationFixEnabled.enable);
 						} break;
@@ -1,5 +1,7 @@
 #include "DeviceManipulationHandle.h"
 
+#include <algorithm>
+#include <iterator>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 #include "../driver/ServerDriver.h"
@@ -20,12 +22,6 @@ namespace vrinputemulator {
 namespace driver {
 
 
-#define VECTOR_ADD(lhs, rhs) \
-		lhs[0] += rhs.v[0]; \
-		lhs[1] += rhs.v[1]; \
-		lhs[2] += rhs.v[2];
-
-
 bool DeviceManipulationHandle::touchpadEmulationEnabledFlag = true;
 
 
@@ -36,12 +32,56 @@ DeviceManipulationHandle::DeviceManipulationHandle(const char* serial, vr::ETrac
 }
 
 
+void DeviceManipulationHandle::setPoseOffsets(const PoseOffsets& offsets) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	m_offsets = offsets;
+	_publishPoseConfig();
+}
+
+
+PoseKalmanFilter& DeviceManipulationHandle::poseKalmanFilter() {
+	const PoseConfig* config = m_poseConfig.load();
+	if (m_poseKalmanFilterGeneration != config->poseFilterGeneration) {
+		m_poseKalmanFilter.reset();
+		m_poseKalmanFilterGeneration = config->poseFilterGeneration;
+	}
+	m_poseKalmanFilter.setTuning(config->poseFilterTuning);
+	return m_poseKalmanFilter;
+}
+
+
+void DeviceManipulationHandle::setPoseFilterTuning(const PoseFilterTuning* tuning, const PoseFilterTuning& defaultTuning) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	m_customPoseFilterTuning = tuning != nullptr;
+	m_poseFilterTuning = tuning ? *tuning : defaultTuning;
+	_publishPoseConfig();
+}
+
+
+void DeviceManipulationHandle::setDefaultPoseFilterTuning(const PoseFilterTuning& defaultTuning) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if (!m_customPoseFilterTuning) {
+		m_poseFilterTuning = defaultTuning;
+		_publishPoseConfig();
+	}
+}
+
+
+void DeviceManipulationHandle::resetPoseFilter() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	++m_poseFilterGeneration;
+	_publishPoseConfig();
+}
+
+
 void DeviceManipulationHandle::setDigitalInputRemapping(uint32_t buttonId, const DigitalInputRemapping& remapping) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
 	if (remapping.valid) {
 		m_digitalInputRemapping[buttonId].remapping = remapping;
 	} else {
 		auto it = m_digitalInputRemapping.find(buttonId);
 		if (it != m_digitalInputRemapping.end()) {
+			_cancelInputTimers(it->second);
 			m_digitalInputRemapping.erase(it);
 		}
 	}
@@ -74,23 +114,10 @@ AnalogInputRemapping DeviceManipulationHandle::getAnalogInputRemapping(uint32_t
 }
 
 bool DeviceManipulationHandle::handlePoseUpdate(uint32_t& unWhichDevice, vr::DriverPose_t& newPose, uint32_t unPoseStructSize) {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-
-	if (m_deviceMode == 1) { // fake disconnect mode
-		if (!_disconnectedMsgSend) {
-			newPose.poseIsValid = false;
-			newPose.deviceIsConnected = false;
-			newPose.result = vr::TrackingResult_Uninitialized;
-			_disconnectedMsgSend = true;
-			return true;
-		} else {
-			return false;
-		}
-
-	} else if (m_deviceMode == 3 && !m_redirectSuspended) { // redirect target
-		return false;
+	// No lock here, the settings come from the last published snapshot
+	const PoseConfig* config = m_poseConfig.load();
 
-	} else if (m_deviceMode == 5) { // motion compensation mode
+	if (config->deviceMode == 5) { // motion compensation mode
 		auto serverDriver = ServerDriver::getInstance();
 		if (serverDriver) {
 			if (newPose.poseIsValid && newPose.result == vr::TrackingResult_Running_OK) {
@@ -113,46 +140,9 @@ bool DeviceManipulationHandle::handlePoseUpdate(uint32_t& unWhichDevice, vr::Dri
 		return true;
 
 	} else {
-		if (m_offsetsEnabled) {
-			if (m_worldFromDriverRotationOffset.w != 1.0 || m_worldFromDriverRotationOffset.x != 0.0
-				|| m_worldFromDriverRotationOffset.y != 0.0 || m_worldFromDriverRotationOffset.z != 0.0) {
-				newPose.qWorldFromDriverRotation = m_worldFromDriverRotationOffset * newPose.qWorldFromDriverRotation;
-			}
-			if (m_worldFromDriverTranslationOffset.v[0] != 0.0 || m_worldFromDriverTranslationOffset.v[1] != 0.0 || m_worldFromDriverTranslationOffset.v[2] != 0.0) {
-				VECTOR_ADD(newPose.vecWorldFromDriverTranslation, m_worldFromDriverTranslationOffset);
-			}
-			if (m_driverFromHeadRotationOffset.w != 1.0 || m_driverFromHeadRotationOffset.x != 0.0
-				|| m_driverFromHeadRotationOffset.y != 0.0 || m_driverFromHeadRotationOffset.z != 0.0) {
-				newPose.qDriverFromHeadRotation = m_driverFromHeadRotationOffset * newPose.qDriverFromHeadRotation;
-			}
-			if (m_driverFromHeadTranslationOffset.v[0] != 0.0 || m_driverFromHeadTranslationOffset.v[1] != 0.0 || m_driverFromHeadTranslationOffset.v[2] != 0.0) {
-				VECTOR_ADD(newPose.vecDriverFromHeadTranslation, m_driverFromHeadTranslationOffset);
-			}
-			if (m_deviceRotationOffset.w != 1.0 || m_deviceRotationOffset.x != 0.0
-				|| m_deviceRotationOffset.y != 0.0 || m_deviceRotationOffset.z != 0.0) {
-				newPose.qRotation = m_deviceRotationOffset * newPose.qRotation;
-			}
-			if (m_deviceTranslationOffset.v[0] != 0.0 || m_deviceTranslationOffset.v[1] != 0.0 || m_deviceTranslationOffset.v[2] != 0.0) {
-				VECTOR_ADD(newPose.vecPosition, m_deviceTranslationOffset);
-			}
-		}
-		
-		m_motionCompensationManager._applyMotionCompensation(newPose, this);
-		
-		if (m_deviceMode == 2 && !m_redirectSuspended) { // redirect source
-			m_redirectRef->ll_sendPoseUpdate(newPose);
-			if (!_disconnectedMsgSend) {
-				newPose.poseIsValid = false;
-				newPose.deviceIsConnected = false;
-				newPose.result = vr::TrackingResult_Uninitialized;
-				_disconnectedMsgSend = true;
-			} else {
-				return false;
-			}
-		} else if (m_deviceMode == 4) { // swap mode
-			unWhichDevice = m_redirectRef->openvrId();
-		}
-		return true;
+		return routePose(*config, _disconnectedMsgSend, unWhichDevice, newPose, [this](vr::DriverPose_t& pose) {
+			m_motionCompensationManager._applyMotionCompensation(pose, this);
+		});
 	}
 }
 
@@ -355,7 +345,7 @@ bool DeviceManipulationHandle::handleButtonEvent(uint32_t& unWhichDevice, Button
 						sendDigitalBinding(buttonInfo.remapping.binding, unWhichDevice, eventType, eButtonId, eventTimeOffset, &buttonInfo.bindings[0]);
 					} else if (eventType == ButtonEventType::ButtonPressed) {
 						if (buttonInfo.remapping.longPressEnabled) {
-							buttonInfo.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(buttonInfo.remapping.longPressThreshold);
+							_scheduleInputTimer(buttonInfo.timer, eButtonId, TimerWheel<>::now() + std::chrono::milliseconds(buttonInfo.remapping.longPressThreshold));
 						}
 						buttonInfo.state = 1;
 						//LOG(INFO) << "buttonInfo.state = 0: => 1";
@@ -364,12 +354,12 @@ bool DeviceManipulationHandle::handleButtonEvent(uint32_t& unWhichDevice, Button
 				case 1: {
 					if (eventType == ButtonEventType::ButtonUnpressed) {
 						if (buttonInfo.remapping.doublePressEnabled) {
-							buttonInfo.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(buttonInfo.remapping.doublePressThreshold);
+							_scheduleInputTimer(buttonInfo.timer, eButtonId, TimerWheel<>::now() + std::chrono::milliseconds(buttonInfo.remapping.doublePressThreshold));
 							buttonInfo.state = 3;
 							//LOG(INFO) << "buttonInfo.state = 1: => 3";
 						} else {
 							sendDigitalBinding(buttonInfo.remapping.binding, m_openvrId, ButtonEventType::ButtonPressed, eButtonId, 0.0, &buttonInfo.bindings[0]);
-							buttonInfo.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
+							_scheduleInputTimer(buttonInfo.timer, eButtonId, TimerWheel<>::now() + std::chrono::milliseconds(100));
 							buttonInfo.state = 4;
 							//LOG(INFO) << "buttonInfo.state = 1: => 4";
 						}
@@ -378,6 +368,7 @@ bool DeviceManipulationHandle::handleButtonEvent(uint32_t& unWhichDevice, Button
 				case 2: {
 					if (eventType == ButtonEventType::ButtonUnpressed) {
 						sendDigitalBinding(buttonInfo.remapping.longPressBinding, unWhichDevice, eventType, eButtonId, eventTimeOffset, &buttonInfo.bindings[1]);
+						_cancelInputTimer(buttonInfo.timer);
 						buttonInfo.state = 0;
 						//LOG(INFO) << "buttonInfo.state = 2: sendDigitalBinding, => 0";
 					}
@@ -386,7 +377,9 @@ bool DeviceManipulationHandle::handleButtonEvent(uint32_t& unWhichDevice, Button
 					if (eventType == ButtonEventType::ButtonPressed) {
 						sendDigitalBinding(buttonInfo.remapping.doublePressBinding, unWhichDevice, eventType, eButtonId, eventTimeOffset, &buttonInfo.bindings[2]);
 						if (buttonInfo.remapping.doublePressImmediateRelease) {
-							buttonInfo.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
+							_scheduleInputTimer(buttonInfo.timer, eButtonId, TimerWheel<>::now() + std::chrono::milliseconds(100));
+						} else {
+							_cancelInputTimer(buttonInfo.timer);
 						}
 						buttonInfo.state = 5;
 						//LOG(INFO) << "buttonInfo.state = 3: sendDigitalBinding, => 5";
@@ -395,6 +388,7 @@ bool DeviceManipulationHandle::handleButtonEvent(uint32_t& unWhichDevice, Button
 				case 5: {
 					if (eventType == ButtonEventType::ButtonUnpressed) {
 						sendDigitalBinding(buttonInfo.remapping.doublePressBinding, unWhichDevice, eventType, eButtonId, eventTimeOffset, &buttonInfo.bindings[2]);
+						_cancelInputTimer(buttonInfo.timer);
 						buttonInfo.state = 0;
 						//LOG(INFO) << "buttonInfo.state = 5: sendDigitalBinding, => 0";
 					}
@@ -433,98 +427,125 @@ void DeviceManipulationHandle::suspendRedirectMode() {
 		_disconnectedMsgSend = false;
 		m_redirectRef->m_redirectSuspended = m_redirectSuspended;
 		m_redirectRef->_disconnectedMsgSend = false;
+		_publishPoseConfig();
+		m_redirectRef->_publishPoseConfig();
 	}
 }
 
 
-void DeviceManipulationHandle::RunFrame() {
-	for (auto& r : m_digitalInputRemapping) {
-		switch (r.second.state) {
-		case 1: {
-			if (r.second.remapping.longPressEnabled) {
-				auto now = std::chrono::system_clock::now();
-				if (r.second.timeout <= now) {
-					sendDigitalBinding(r.second.remapping.longPressBinding, m_openvrId, ButtonEventType::ButtonPressed, (vr::EVRButtonId)r.first, 0.0, &r.second.bindings[1]);
-					if (r.second.remapping.longPressImmediateRelease) {
-						r.second.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
-					}
-					r.second.state = 2;
-					//LOG(INFO) << "buttonInfo.state = 1: sendDigitalBinding, => 2";
-				}
-			}
-		} break;
-		case 2: {
-			if (r.second.remapping.longPressImmediateRelease) {
-				auto now = std::chrono::system_clock::now();
-				if (r.second.timeout <= now) {
-					sendDigitalBinding(r.second.remapping.longPressBinding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)r.first, 0.0, &r.second.bindings[1]);
-					r.second.state = 6;
-					//LOG(INFO) << "buttonInfo.state = 2: sendDigitalBinding, => 6";
-				}
-			}
-		} break;
-		case 3: {
-			auto now = std::chrono::system_clock::now();
-			if (r.second.timeout <= now) {
-				sendDigitalBinding(r.second.remapping.binding, m_openvrId, ButtonEventType::ButtonPressed, (vr::EVRButtonId)r.first, 0.0, &r.second.bindings[0]);
-				r.second.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
-				r.second.state = 4;
-				//LOG(INFO) << "buttonInfo.state = 3: sendDigitalBinding, => 4";
-			}
-		} break;
-		case 4: {
-			auto now = std::chrono::system_clock::now();
-			if (r.second.timeout <= now) {
-				sendDigitalBinding(r.second.remapping.binding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)r.first, 0.0, &r.second.bindings[0]);
-				r.second.state = 0;
-				//LOG(INFO) << "buttonInfo.state = 4: sendDigitalBinding, => 0";
-			}
-		} break;
-		case 5: {
-			if (r.second.remapping.doublePressImmediateRelease) {
-				auto now = std::chrono::system_clock::now();
-				if (r.second.timeout <= now) {
-					sendDigitalBinding(r.second.remapping.doublePressBinding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)r.first, 0.0, &r.second.bindings[2]);
-					r.second.state = 6;
-					//LOG(INFO) << "buttonInfo.state = 5: sendDigitalBinding, => 6";
-				}
+void DeviceManipulationHandle::_scheduleInputTimer(InputTimerId& timer, uint32_t buttonId, TimerWheel<>::time_point due) {
+	auto& timers = m_parent->inputTimers();
+	timers.cancel(timer);
+	timer = timers.schedule(due, [this, buttonId](InputTimerId firedId, TimerWheel<>::time_point firedDue) {
+		_inputTimerFired(buttonId, firedId, firedDue);
+	});
+}
+
+
+void DeviceManipulationHandle::_cancelInputTimer(InputTimerId& timer) {
+	m_parent->inputTimers().cancel(timer);
+	timer = 0;
+}
+
+
+void DeviceManipulationHandle::_cancelInputTimers(DigitalInputRemappingInfo& info) {
+	_cancelInputTimer(info.timer);
+	for (auto& bindingInfo : info.bindings) {
+		_cancelInputTimer(bindingInfo.timer);
+		_cancelInputTimer(bindingInfo.autoTriggerTimer);
+	}
+}
+
+
+// Timers only carry the button id, so a timer whose remapping was removed or which got replaced in the meantime finds nothing to do
+void DeviceManipulationHandle::_inputTimerFired(uint32_t buttonId, InputTimerId id, TimerWheel<>::time_point due) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	auto it = m_digitalInputRemapping.find(buttonId);
+	if (it == m_digitalInputRemapping.end()) {
+		return;
+	}
+	auto& info = it->second;
+	if (info.timer == id) {
+		info.timer = 0;
+		_buttonTimeout(buttonId, info, due);
+		return;
+	}
+	vrinputemulator::DigitalBinding* bindings[3] = { &info.remapping.binding, &info.remapping.longPressBinding, &info.remapping.doublePressBinding };
+	for (int i = 0; i < 3; i++) {
+		auto& bindingInfo = info.bindings[i];
+		if (bindingInfo.timer == id) {
+			bindingInfo.timer = 0;
+			if (bindingInfo.state == 1 && bindings[i]->toggleEnabled) {
+				bindingInfo.state = 2;
 			}
-		} break;
-		default:
-			break;
+			return;
+		} else if (bindingInfo.autoTriggerTimer == id) {
+			bindingInfo.autoTriggerTimer = 0;
+			_autoTriggerTimeout(*bindings[i], (vr::EVRButtonId)buttonId, bindingInfo, due);
+			return;
 		}
-		RunFrameDigitalBinding(r.second.remapping.binding, (vr::EVRButtonId)r.first, r.second.bindings[0]);
-		RunFrameDigitalBinding(r.second.remapping.longPressBinding, (vr::EVRButtonId)r.first, r.second.bindings[1]);
-		RunFrameDigitalBinding(r.second.remapping.doublePressBinding, (vr::EVRButtonId)r.first, r.second.bindings[2]);
 	}
 }
 
 
-void DeviceManipulationHandle::RunFrameDigitalBinding(vrinputemulator::DigitalBinding& binding, vr::EVRButtonId eButtonId, DeviceManipulationHandle::DigitalInputRemappingInfo::BindingInfo& bindingInfo) {
-	if (bindingInfo.autoTriggerEnabled) {
-		auto now = std::chrono::system_clock::now();
-		if (bindingInfo.autoTriggerState && bindingInfo.autoTriggerUnpressTimeout < now) {
-			bindingInfo.autoTriggerState = false;
-			sendDigitalBinding(binding, m_openvrId, ButtonEventType::ButtonUnpressed, eButtonId, 0.0);
-		} else if (!bindingInfo.autoTriggerState && bindingInfo.autoTriggerTimeout < now) {
-			bindingInfo.autoTriggerState = true;
-			auto now = std::chrono::system_clock::now();
-			bindingInfo.autoTriggerUnpressTimeout = now + std::chrono::milliseconds(10);
-			bindingInfo.autoTriggerTimeout = now + std::chrono::milliseconds(bindingInfo.autoTriggerTimeoutTime);
-			sendDigitalBinding(binding, m_openvrId, ButtonEventType::ButtonPressed, eButtonId, 0.0);
+void DeviceManipulationHandle::_buttonTimeout(uint32_t buttonId, DigitalInputRemappingInfo& info, TimerWheel<>::time_point due) {
+	switch (info.state) {
+	case 1: {
+		if (info.remapping.longPressEnabled) {
+			sendDigitalBinding(info.remapping.longPressBinding, m_openvrId, ButtonEventType::ButtonPressed, (vr::EVRButtonId)buttonId, 0.0, &info.bindings[1]);
+			if (info.remapping.longPressImmediateRelease) {
+				_scheduleInputTimer(info.timer, buttonId, TimerWheel<>::next(due, std::chrono::milliseconds(100)));
+			}
+			info.state = 2;
+			//LOG(INFO) << "buttonInfo.state = 1: sendDigitalBinding, => 2";
+		}
+	} break;
+	case 2: {
+		if (info.remapping.longPressImmediateRelease) {
+			sendDigitalBinding(info.remapping.longPressBinding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)buttonId, 0.0, &info.bindings[1]);
+			info.state = 6;
+			//LOG(INFO) << "buttonInfo.state = 2: sendDigitalBinding, => 6";
 		}
+	} break;
+	case 3: {
+		sendDigitalBinding(info.remapping.binding, m_openvrId, ButtonEventType::ButtonPressed, (vr::EVRButtonId)buttonId, 0.0, &info.bindings[0]);
+		_scheduleInputTimer(info.timer, buttonId, TimerWheel<>::next(due, std::chrono::milliseconds(100)));
+		info.state = 4;
+		//LOG(INFO) << "buttonInfo.state = 3: sendDigitalBinding, => 4";
+	} break;
+	case 4: {
+		sendDigitalBinding(info.remapping.binding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)buttonId, 0.0, &info.bindings[0]);
+		info.state = 0;
+		//LOG(INFO) << "buttonInfo.state = 4: sendDigitalBinding, => 0";
+	} break;
+	case 5: {
+		if (info.remapping.doublePressImmediateRelease) {
+			sendDigitalBinding(info.remapping.doublePressBinding, m_openvrId, ButtonEventType::ButtonUnpressed, (vr::EVRButtonId)buttonId, 0.0, &info.bindings[2]);
+			info.state = 6;
+			//LOG(INFO) << "buttonInfo.state = 5: sendDigitalBinding, => 6";
+		}
+	} break;
+	default:
+		break;
 	}
-	switch (bindingInfo.state) {
-		case 1: {
-			if (binding.toggleEnabled) {
-				auto now = std::chrono::system_clock::now();
-				if (bindingInfo.timeout <= now) {
-					bindingInfo.state = 2;
-				}
-			}
-		} break;
-		default: {
-		} break;
+}
+
+
+// Presses follow each other at autoTriggerTimeoutTime counted from when the previous one was due, each released 10 ms later.
+// After a stall they carry on from now, the presses that were missed are skipped rather than sent in a burst
+void DeviceManipulationHandle::_autoTriggerTimeout(vrinputemulator::DigitalBinding& binding, vr::EVRButtonId eButtonId, DigitalInputRemappingInfo::BindingInfo& bindingInfo, TimerWheel<>::time_point due) {
+	if (!bindingInfo.autoTriggerEnabled) {
+		return;
+	}
+	if (bindingInfo.autoTriggerState) {
+		bindingInfo.autoTriggerState = false;
+		sendDigitalBinding(binding, m_openvrId, ButtonEventType::ButtonUnpressed, eButtonId, 0.0);
+		_scheduleInputTimer(bindingInfo.autoTriggerTimer, eButtonId, std::max(bindingInfo.autoTriggerNextPress, TimerWheel<>::now()));
+	} else {
+		bindingInfo.autoTriggerState = true;
+		bindingInfo.autoTriggerNextPress = TimerWheel<>::next(due, std::chrono::milliseconds(bindingInfo.autoTriggerTimeoutTime));
+		_scheduleInputTimer(bindingInfo.autoTriggerTimer, eButtonId, TimerWheel<>::next(due, std::chrono::milliseconds(10)));
+		sendDigitalBinding(binding, m_openvrId, ButtonEventType::ButtonPressed, eButtonId, 0.0);
 	}
 }
 
@@ -547,48 +568,34 @@ bool DeviceManipulationHandle::handleAxisUpdate(uint32_t& unWhichDevice, uint32_
 }
 
 
-bool DeviceManipulationHandle::handleBooleanComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, bool& bNewValue, double& fTimeOffset) {
-	LOG(DEBUG) << "DeviceManipulationHandle::handleBooleanComponentUpdate(" << ulComponent << ", " << bNewValue << ", " << fTimeOffset << ")";
-	auto it = _componentHandleToButtonIdMap.find(ulComponent);
-	if (it != _componentHandleToButtonIdMap.end()) {
-		ButtonEventType eventType;
-		if (it->second.second == 0) { // touch
-			eventType = bNewValue ? ButtonEventType::ButtonTouched : ButtonEventType::ButtonUntouched;
-		} else { // press
-			eventType = bNewValue ? ButtonEventType::ButtonPressed : ButtonEventType::ButtonUnpressed;
-		}
-		return handleButtonEvent(m_openvrId, eventType, it->second.first, fTimeOffset);
-	} else {
-		LOG(INFO) << "No mapping from boolean component handle " << ulComponent << " to button id";
+bool DeviceManipulationHandle::handleBooleanComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, vr::EVRButtonId buttonId, uint32_t buttonType, bool& bNewValue, double& fTimeOffset) {
+	LOG_HOT_PATH(DEBUG) << "DeviceManipulationHandle::handleBooleanComponentUpdate(" << ulComponent << ", " << bNewValue << ", " << fTimeOffset << ")";
+	ButtonEventType eventType;
+	if (buttonType == 0) { // touch
+		eventType = bNewValue ? ButtonEventType::ButtonTouched : ButtonEventType::ButtonUntouched;
+	} else { // press
+		eventType = bNewValue ? ButtonEventType::ButtonPressed : ButtonEventType::ButtonUnpressed;
 	}
-	return true;
+	return handleButtonEvent(m_openvrId, eventType, buttonId, fTimeOffset);
 }
 
 
-bool DeviceManipulationHandle::handleScalarComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, float& fNewValue, double& fTimeOffset) {
-	LOG(DEBUG) << "DeviceManipulationHandle::handleScalarComponentUpdate(" << ulComponent << ", " << fNewValue << ", " << fTimeOffset << ")";
-	auto it = _componentHandleToAxisIdMap.find(ulComponent);
-	if (it != _componentHandleToAxisIdMap.end()) {
-		std::lock_guard<std::recursive_mutex> lock(_mutex);
-		AnalogInputRemappingInfo* axisInfo = nullptr;
-		unsigned unWhichAxis = it->second.first;
-		unsigned unWhichAxisDim = it->second.second;
-		if (unWhichAxis < 5) {
-			axisInfo = m_analogInputRemapping + unWhichAxis;
-		}
-		if (m_deviceMode == 1 || (m_deviceMode == 3 && !m_redirectSuspended) /*|| m_deviceMode == 5*/) {
-			return false;
-		}
-		if (axisInfo && axisInfo->remapping.valid) {
-			sendAnalogBinding(axisInfo->remapping.binding, m_openvrId, unWhichAxis, unWhichAxisDim, ulComponent, fNewValue, fTimeOffset);
-		} else {
-			sendScalarComponentUpdate(m_openvrId, unWhichAxis, unWhichAxisDim, ulComponent, fNewValue, fTimeOffset);
-		}
+bool DeviceManipulationHandle::handleScalarComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, uint32_t unWhichAxis, uint32_t unWhichAxisDim, float& fNewValue, double& fTimeOffset) {
+	LOG_HOT_PATH(DEBUG) << "DeviceManipulationHandle::handleScalarComponentUpdate(" << ulComponent << ", " << fNewValue << ", " << fTimeOffset << ")";
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	AnalogInputRemappingInfo* axisInfo = nullptr;
+	if (unWhichAxis < 5) {
+		axisInfo = m_analogInputRemapping + unWhichAxis;
+	}
+	if (m_deviceMode == 1 || (m_deviceMode == 3 && !m_redirectSuspended) /*|| m_deviceMode == 5*/) {
 		return false;
+	}
+	if (axisInfo && axisInfo->remapping.valid) {
+		sendAnalogBinding(axisInfo->remapping.binding, m_openvrId, unWhichAxis, unWhichAxisDim, ulComponent, fNewValue, fTimeOffset);
 	} else {
-		LOG(INFO) << "No mapping from scalar component handle " << ulComponent << " to axis id";
+		sendScalarComponentUpdate(m_openvrId, unWhichAxis, unWhichAxisDim, ulComponent, fNewValue, fTimeOffset);
 	}
-	return true;
+	return false;
 }
 
 bool DeviceManipulationHandle::handleHapticPulseEvent(float& fDurationSeconds, float& fFrequency, float& fAmplitude) {
@@ -631,11 +638,15 @@ bool _matchInputComponentName(const char* name, std::string& segment0, std::stri
 	}
 }
 
-std::map<std::string, vr::EVRButtonId> _inputComponentNameToButtonId = {
+// Only looked at when a component gets created, updates are routed by component handle
+static const struct {
+	const char* name;
+	vr::EVRButtonId buttonId;
+} _inputComponentNameToButtonId[] = {
 	{ "system", vr::k_EButton_System },
 	{ "application_menu", vr::k_EButton_ApplicationMenu },
 	{ "grip", vr::k_EButton_Grip },
-	{ "dpad_left/", vr::k_EButton_DPad_Left },
+	{ "dpad_left", vr::k_EButton_DPad_Left },
 	{ "dpad_up", vr::k_EButton_DPad_Up },
 	{ "dpad_right", vr::k_EButton_DPad_Right },
 	{ "dpad_down", vr::k_EButton_DPad_Down },
@@ -648,13 +659,16 @@ std::map<std::string, vr::EVRButtonId> _inputComponentNameToButtonId = {
 	{ "trigger", vr::k_EButton_SteamVR_Trigger },
 };
 
-std::map<std::string, uint32_t> _inputComponentNameToAxisId = {
+static const struct {
+	const char* name;
+	uint32_t axisId;
+} _inputComponentNameToAxisId[] = {
 	{ "trackpad", 0 },
 	{ "joystick", 0 },
 	{ "trigger", 1 },
 };
 
-void DeviceManipulationHandle::inputAddBooleanComponent(const char *pchName, uint64_t pHandle) {
+bool DeviceManipulationHandle::inputAddBooleanComponent(const char *pchName, uint64_t pHandle, uint32_t& mappedButtonId, uint32_t& mappedButtonType) {
 	std::string sg0, sg1, sg2, sg3;
 	if (_matchInputComponentName(pchName, sg0, sg1, sg2, sg3)) {
 		LOG(DEBUG) << "Device Component Name Segments: \"" << sg0 << "\", \"" << sg1 << "\", \"" << sg2 << "\", \"" << sg3 << "\"";
@@ -663,14 +677,16 @@ void DeviceManipulationHandle::inputAddBooleanComponent(const char *pchName, uin
 		bool errorFlag = false;
 		if (!sg3.empty()) {
 			LOG(ERROR) << "Device input component name \"" << pchName << "\" has too many segments.";
+			errorFlag = true;
 		} else {
 			if (boost::iequals(sg0, "proximity")) { // proximity sensor
 				buttonId = vr::k_EButton_ProximitySensor;
 			} else if (boost::iequals(sg0, "input")) { // digital button
-				boost::algorithm::to_lower(sg1);
-				auto it = _inputComponentNameToButtonId.find(sg1);
-				if (it != _inputComponentNameToButtonId.end()) {
-					buttonId = it->second;
+				auto it = std::find_if(std::begin(_inputComponentNameToButtonId), std::end(_inputComponentNameToButtonId), [&sg1](const auto& entry) {
+					return boost::iequals(sg1, entry.name);
+				});
+				if (it != std::end(_inputComponentNameToButtonId)) {
+					buttonId = it->buttonId;
 					if (boost::iequals(sg2, "touch")) {
 						buttonType = 0;
 					}
@@ -684,20 +700,23 @@ void DeviceManipulationHandle::inputAddBooleanComponent(const char *pchName, uin
 			}
 		}
 		if (!errorFlag) {
-			_componentHandleToButtonIdMap.emplace(pHandle, std::make_pair(buttonId, buttonType));
 			if (buttonType == 0) {
 				_ButtonIdToComponentHandleMap[buttonId].first = pHandle;
 			} else {
 				_ButtonIdToComponentHandleMap[buttonId].second = pHandle;
 			}
 			LOG(INFO) << "Mapped input component \"" << pchName << "\" to button id (" << (int)buttonId << ", " << buttonType << ")";
+			mappedButtonId = buttonId;
+			mappedButtonType = buttonType;
+			return true;
 		}
 	} else {
 		LOG(ERROR) << "Could not parse input component name \"" << pchName << "\".";
 	}
+	return false;
 }
 
-void DeviceManipulationHandle::inputAddScalarComponent(const char *pchName, uint64_t pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits) {
+bool DeviceManipulationHandle::inputAddScalarComponent(const char *pchName, uint64_t pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits, uint32_t& mappedAxisId, uint32_t& mappedAxisDim) {
 	std::string sg0, sg1, sg2, sg3;
 	if (_matchInputComponentName(pchName, sg0, sg1, sg2, sg3)) {
 		LOG(DEBUG) << "Device Component Name Segments: \"" << sg0 << "\", \"" << sg1 << "\", \"" << sg2 << "\", \"" << sg3 << "\"";
@@ -706,12 +725,14 @@ void DeviceManipulationHandle::inputAddScalarComponent(const char *pchName, uint
 		bool errorFlag = false;
 		if (!sg3.empty()) {
 			LOG(ERROR) << "Device input component name \"" << pchName << "\" has too many segments.";
+			errorFlag = true;
 		} else {
 			if (boost::iequals(sg0, "input")) { // analog input
-				boost::algorithm::to_lower(sg1);
-				auto it = _inputComponentNameToAxisId.find(sg1);
-				if (it != _inputComponentNameToAxisId.end()) {
-					axisId = it->second;
+				auto it = std::find_if(std::begin(_inputComponentNameToAxisId), std::end(_inputComponentNameToAxisId), [&sg1](const auto& entry) {
+					return boost::iequals(sg1, entry.name);
+				});
+				if (it != std::end(_inputComponentNameToAxisId)) {
+					axisId = it->axisId;
 					if (boost::iequals(sg2, "x")) {
 						axisDim = 0;
 					} else if (boost::iequals(sg2, "y")) {
@@ -734,10 +755,14 @@ void DeviceManipulationHandle::inputAddScalarComponent(const char *pchName, uint
 				_AxisIdToComponentHandleMap[axisId].second = pHandle;
 			}
 			LOG(INFO) << "Mapped input component \"" << pchName << "\" to axis id (" << axisId << ", " << axisDim << ")";
+			mappedAxisId = axisId;
+			mappedAxisDim = axisDim;
+			return true;
 		}
 	} else {
 		LOG(ERROR) << "Could not parse input component name \"" << pchName << "\".";
 	}
+	return false;
 }
 
 void DeviceManipulationHandle::inputAddHapticComponent(const char * pchName, uint64_t pHandle) {
@@ -766,16 +791,16 @@ void DeviceManipulationHandle::sendDigitalBinding(vrinputemulator::DigitalBindin
 							if (binding.toggleDelay == 0) {
 								newState = 2;
 							} else {
-								bindingInfo->timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(binding.toggleDelay);
+								_scheduleInputTimer(bindingInfo->timer, eButtonId, TimerWheel<>::now() + std::chrono::milliseconds(binding.toggleDelay));
 							}
 						}
 						bindingInfo->autoTriggerEnabled = binding.autoTriggerEnabled;
 						if (bindingInfo->autoTriggerEnabled) {
 							bindingInfo->autoTriggerState = true;
 							bindingInfo->autoTriggerTimeoutTime = (uint32_t)(1000.0 / ((float)binding.autoTriggerFrequency / 100.0));
-							auto now = std::chrono::system_clock::now();
-							bindingInfo->autoTriggerUnpressTimeout = now + std::chrono::milliseconds(10);
-							bindingInfo->autoTriggerTimeout = now + std::chrono::milliseconds(bindingInfo->autoTriggerTimeoutTime);
+							auto now = TimerWheel<>::now();
+							bindingInfo->autoTriggerNextPress = now + std::chrono::milliseconds(bindingInfo->autoTriggerTimeoutTime);
+							_scheduleInputTimer(bindingInfo->autoTriggerTimer, eButtonId, now + std::chrono::milliseconds(10));
 						}
 						bindingInfo->state = newState;
 					}
@@ -785,10 +810,12 @@ void DeviceManipulationHandle::sendDigitalBinding(vrinputemulator::DigitalBindin
 						sendEvent = true;
 						if (bindingInfo->autoTriggerEnabled) {
 							bindingInfo->autoTriggerEnabled = false;
+							_cancelInputTimer(bindingInfo->autoTriggerTimer);
 							if (!bindingInfo->autoTriggerState) {
 								bindingInfo->pressedState = false;
 							}
 						}
+						_cancelInputTimer(bindingInfo->timer);
 						bindingInfo->state = 0;
 					}
 				} break;
@@ -803,6 +830,7 @@ void DeviceManipulationHandle::sendDigitalBinding(vrinputemulator::DigitalBindin
 						if (bindingInfo->autoTriggerEnabled) {
 							bindingInfo->autoTriggerEnabled = false;
 							bindingInfo->autoTriggerState = false;
+							_cancelInputTimer(bindingInfo->autoTriggerTimer);
 						}
 						bindingInfo->state = 0;
 					}
@@ -869,34 +897,29 @@ void DeviceManipulationHandle::_audioCue() {
 }
 
 
+// Ten pulses 10 ms apart, the first one right away and the others as timers on the input timer wheel
 void DeviceManipulationHandle::_vibrationCue() {
-	if (_vibrationCueTheadHandle != NULL) {
-		DWORD threadExitCode = 0;
-		if (GetExitCodeThread(_vibrationCueTheadHandle, &threadExitCode) != 0 && threadExitCode == STILL_ACTIVE) {
-			return;
-		}
-		CloseHandle(_vibrationCueTheadHandle);
-		_vibrationCueTheadHandle = NULL;
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if (_vibrationCueTimer != 0) {
+		return;
+	}
+	_vibrationCuePulsesLeft = 10;
+	_vibrationCuePulse(0, TimerWheel<>::now());
+}
+
+
+void DeviceManipulationHandle::_vibrationCuePulse(InputTimerId id, TimerWheel<>::time_point due) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if (id != _vibrationCueTimer) {
+		return;
+	}
+	_vibrationCueTimer = 0;
+	ll_triggerHapticPulse(0, 1000);
+	if (--_vibrationCuePulsesLeft > 0) {
+		_vibrationCueTimer = m_parent->inputTimers().schedule(TimerWheel<>::next(due, std::chrono::milliseconds(10)), [this](InputTimerId firedId, TimerWheel<>::time_point firedDue) {
+			_vibrationCuePulse(firedId, firedDue);
+		});
 	}
-	static struct _vibrationCueThreadArgs {
-		DeviceManipulationHandle* deviceInfo;
-	} threadArgs;
-	threadArgs.deviceInfo = this;
-	_vibrationCueTheadHandle = CreateThread(
-		NULL,                   // default security attributes
-		0,                      // use default stack size  
-		[](LPVOID lpParam)->DWORD {
-			_vibrationCueThreadArgs* args = (_vibrationCueThreadArgs*)lpParam;
-			for (unsigned i = 0; i < 10; ++i) {
-				args->deviceInfo->ll_triggerHapticPulse(0, 1000);
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-			}
-			return 0;
-		},
-		&threadArgs,			// argument to thread function 
-		0,                      // use default creation flags 
-		NULL
-	);
 }
 
 
@@ -1365,6 +1388,7 @@ int DeviceManipulationHandle::setDefaultMode() {
 	auto res = _disableOldMode(0);
 	if (res == 0) {
 		m_deviceMode = 0;
+		_publishPoseConfig();
 	}
 	return 0; 
 }
@@ -1380,6 +1404,7 @@ int DeviceManipulationHandle::setRedirectMode(bool target, DeviceManipulationHan
 		} else {
 			m_deviceMode = 2;
 		}
+		_publishPoseConfig();
 	}
 	return 0; 
 }
@@ -1390,6 +1415,7 @@ int DeviceManipulationHandle::setSwapMode(DeviceManipulationHandle* ref) {
 	if (res == 0) {
 		m_redirectRef = ref;
 		m_deviceMode = 4;
+		_publishPoseConfig();
 	}
 	return 0;
 }
@@ -1403,6 +1429,7 @@ int DeviceManipulationHandle::setMotionCompensationMode() {
 		m_motionCompensationManager.setMotionCompensationRefDevice(this);
 		m_motionCompensationManager._setMotionCompensationStatus(MotionCompensationStatus::WaitingForZeroRef);
 		m_deviceMode = 5;
+		_publishPoseConfig();
 	}
 	return 0;
 }
@@ -1413,6 +1440,7 @@ int DeviceManipulationHandle::setFakeDisconnectedMode() {
 	if (res == 0) {
 		_disconnectedMsgSend = false;
 		m_deviceMode = 1;
+		_publishPoseConfig();
 	}
 	return 0;
 }
@@ -1427,6 +1455,7 @@ int DeviceManipulationHandle::_disableOldMode(int newMode) {
 			}
 		} else if (m_deviceMode == 3 || m_deviceMode == 2 || m_deviceMode == 4) {
 			m_redirectRef->m_deviceMode = 0;
+			m_redirectRef->_publishPoseConfig();
 		}
 		if (newMode == 5) {
 			auto serverDriver = ServerDriver::getInstance();
@@ -1440,6 +1469,26 @@ int DeviceManipulationHandle::_disableOldMode(int newMode) {
 	return 0;
 }
 
+void DeviceManipulationHandle::_publishPoseConfig() {
+	std::unique_ptr<PoseConfig> config(new PoseConfig());
+	config->deviceMode = m_deviceMode;
+	config->redirectSuspended = m_redirectSuspended;
+	config->redirectRef = m_redirectRef;
+	config->poseFilterTuning = m_poseFilterTuning;
+	config->poseFilterGeneration = m_poseFilterGeneration;
+	if (m_offsets.enabled) {
+		PoseTransform& transform = config->poseTransform;
+		transform.worldFromDriverRotation = m_offsets.worldFromDriverRotation;
+		transform.worldFromDriverTranslation = m_offsets.worldFromDriverTranslation;
+		transform.driverFromHeadRotation = m_offsets.driverFromHeadRotation;
+		transform.driverFromHeadTranslation = m_offsets.driverFromHeadTranslation;
+		transform.deviceRotation = m_offsets.deviceRotation;
+		transform.deviceTranslation = m_offsets.deviceTranslation;
+		config->transformPose = transform.changesPose();
+	}
+	m_poseConfig.publish(std::move(config));
+}
+
 
 
 } // end namespace driver
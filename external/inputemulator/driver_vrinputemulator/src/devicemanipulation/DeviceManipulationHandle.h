@@ -1,11 +1,15 @@
 #pragma once
 #pragma once
 
+#include <atomic>
 #include <openvr_driver.h>
 #include <vrinputemulator_types.h>
 #include <openvr_math.h>
 #include "utils/KalmanFilter.h"
+#include "utils/PoseKalmanFilter.h"
+#include "utils/PoseConfig.h"
 #include "utils/MovingAverageRingBuffer.h"
+#include "utils/TimerWheel.h"
 #include "../logging.h"
 #include "../hooks/common.h"
 
@@ -24,7 +28,22 @@ class MotionCompensationManager;
 
 // Stores manipulation information about an openvr device
 class DeviceManipulationHandle {
+public:
+	struct PoseOffsets {
+		bool enabled = false;
+		vr::HmdQuaternion_t worldFromDriverRotation = { 1.0, 0.0, 0.0, 0.0 };
+		vr::HmdVector3d_t worldFromDriverTranslation = { 0.0, 0.0, 0.0 };
+		vr::HmdQuaternion_t driverFromHeadRotation = { 1.0, 0.0, 0.0, 0.0 };
+		vr::HmdVector3d_t driverFromHeadTranslation = { 0.0, 0.0, 0.0 };
+		vr::HmdQuaternion_t deviceRotation = { 1.0, 0.0, 0.0, 0.0 };
+		vr::HmdVector3d_t deviceTranslation = { 0.0, 0.0, 0.0 };
+	};
+
 private:
+	// What handlePoseUpdate needs to know. The pose hook runs for every pose of every device,
+	// so it reads this instead of taking _mutex
+	typedef vrinputemulator::driver::PoseConfig<DeviceManipulationHandle> PoseConfig;
+
 	bool m_isValid = false;
 	ServerDriver* m_parent;
 	MotionCompensationManager& m_motionCompensationManager;
@@ -41,29 +60,29 @@ private:
 	std::shared_ptr<InterfaceHooks> m_controllerComponentHooks;
 
 	int m_deviceMode = 0; // 0 .. default, 1 .. disabled, 2 .. redirect source, 3 .. redirect target, 4 .. swap mode, 5 .. motion compensation
-	bool _disconnectedMsgSend = false;
+	std::atomic<bool> _disconnectedMsgSend { false };
 
-	bool m_offsetsEnabled = false;
-	vr::HmdQuaternion_t m_worldFromDriverRotationOffset = { 1.0, 0.0, 0.0, 0.0 };
-	vr::HmdVector3d_t m_worldFromDriverTranslationOffset = { 0.0, 0.0, 0.0 };
-	vr::HmdQuaternion_t m_driverFromHeadRotationOffset = { 1.0, 0.0, 0.0, 0.0 };
-	vr::HmdVector3d_t m_driverFromHeadTranslationOffset = { 0.0, 0.0, 0.0 };
-	vr::HmdQuaternion_t m_deviceRotationOffset = { 1.0, 0.0, 0.0, 0.0 };
-	vr::HmdVector3d_t m_deviceTranslationOffset = { 0.0, 0.0, 0.0 };
+	PoseOffsets m_offsets;
 
+	// Republished under _mutex by _publishPoseConfig, read without a lock
+	PublishedConfig<PoseConfig> m_poseConfig;
+
+	typedef TimerWheel<>::TimerId InputTimerId;
+
+	// Timeouts are timers on the server driver's input timer wheel, 0 when none is pending
 	struct DigitalInputRemappingInfo {
 		int state = 0;
-		std::chrono::system_clock::time_point timeout;
+		InputTimerId timer = 0;
 		struct BindingInfo {
 			int state = 0;
-			std::chrono::system_clock::time_point timeout;
+			InputTimerId timer = 0;
 			bool pressedState = false;
 			bool touchedState = false;
 			bool touchedAutoset = false;
 			bool autoTriggerEnabled = false;
 			bool autoTriggerState = false;
-			std::chrono::system_clock::time_point autoTriggerTimeout;
-			std::chrono::system_clock::time_point autoTriggerUnpressTimeout;
+			InputTimerId autoTriggerTimer = 0; // pending release while autoTriggerState is set, else pending press
+			TimerWheel<>::time_point autoTriggerNextPress;
 			uint32_t autoTriggerTimeoutTime;
 		} bindings[3]; // 0 .. normal, 1 .. long press, 2 .. double press
 		DigitalInputRemapping remapping;
@@ -92,25 +111,39 @@ private:
 	MovingAverageRingBuffer m_velMovingAverageBuffer;
 	double m_lastPoseTimeOffset = 0.0;
 	PosKalmanFilter m_kalmanFilter;
+	// Tuning and restarts are published with the pose config, the filter itself belongs to the pose hook
+	PoseFilterTuning m_poseFilterTuning;
+	bool m_customPoseFilterTuning = false;
+	unsigned m_poseFilterGeneration = 0;
+	PoseKalmanFilter m_poseKalmanFilter;
+	unsigned m_poseKalmanFilterGeneration = 0;
 
 	vr::PropertyContainerHandle_t m_propertyContainerHandle = vr::k_ulInvalidPropertyContainer;
 	uint64_t m_inputHapticComponentHandle = 0; // Let's assume for now that there is only one haptic component
-	std::map<uint64_t, std::pair<vr::EVRButtonId, int>> _componentHandleToButtonIdMap;
 	std::map<vr::EVRButtonId, std::pair<uint64_t, uint64_t>> _ButtonIdToComponentHandleMap;
 	std::map<uint64_t, std::pair<unsigned, unsigned>> _componentHandleToAxisIdMap;
 	std::pair<uint64_t, uint64_t> _AxisIdToComponentHandleMap[5];
 
-	HANDLE _vibrationCueTheadHandle = NULL;
+	InputTimerId _vibrationCueTimer = 0;
+	unsigned _vibrationCuePulsesLeft = 0;
 
 	void sendDigitalBinding(vrinputemulator::DigitalBinding& binding, uint32_t unWhichDevice, ButtonEventType eventType, vr::EVRButtonId eButtonId, double eventTimeOffset, DigitalInputRemappingInfo::BindingInfo* bindingInfo = nullptr);
 	void sendAnalogBinding(vrinputemulator::AnalogBinding& binding, uint32_t unWhichDevice, uint32_t axisId, const vr::VRControllerAxis_t& axisState, AnalogInputRemappingInfo::BindingInfo* bindingInfo = nullptr);
 	void sendAnalogBinding(vrinputemulator::AnalogBinding& binding, uint32_t unWhichDevice, uint32_t unWhichAxis, uint32_t unAxisDim, vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset);
 
 	void _buttonPressDeadzoneFix(vr::EVRButtonId eButtonId);
+	void _scheduleInputTimer(InputTimerId& timer, uint32_t buttonId, TimerWheel<>::time_point due);
+	void _cancelInputTimer(InputTimerId& timer);
+	void _cancelInputTimers(DigitalInputRemappingInfo& info);
+	void _inputTimerFired(uint32_t buttonId, InputTimerId id, TimerWheel<>::time_point due);
+	void _buttonTimeout(uint32_t buttonId, DigitalInputRemappingInfo& info, TimerWheel<>::time_point due);
+	void _autoTriggerTimeout(vrinputemulator::DigitalBinding& binding, vr::EVRButtonId eButtonId, DigitalInputRemappingInfo::BindingInfo& bindingInfo, TimerWheel<>::time_point due);
 	void _vibrationCue();
+	void _vibrationCuePulse(InputTimerId id, TimerWheel<>::time_point due);
 	void _audioCue();
 
 	int _disableOldMode(int newMode);
+	void _publishPoseConfig();
 
 public:
 	DeviceManipulationHandle(const char* serial, vr::ETrackedDeviceClass eDeviceClass, void* driverPtr, void* driverHostPtr, int driverInterfaceVersion);
@@ -135,20 +168,16 @@ public:
 	int setMotionCompensationMode();
 	int setFakeDisconnectedMode();
 
-	bool areOffsetsEnabled() const { return m_offsetsEnabled; }
-	void enableOffsets(bool enable) { m_offsetsEnabled = enable; }
-	const vr::HmdQuaternion_t& worldFromDriverRotationOffset() const { return m_worldFromDriverRotationOffset; }
-	vr::HmdQuaternion_t& worldFromDriverRotationOffset() { return m_worldFromDriverRotationOffset; }
-	const vr::HmdVector3d_t& worldFromDriverTranslationOffset() const { return m_worldFromDriverTranslationOffset; }
-	vr::HmdVector3d_t& worldFromDriverTranslationOffset() { return m_worldFromDriverTranslationOffset; }
-	const vr::HmdQuaternion_t& driverFromHeadRotationOffset() const { return m_driverFromHeadRotationOffset; }
-	vr::HmdQuaternion_t& driverFromHeadRotationOffset() { return m_driverFromHeadRotationOffset; }
-	const vr::HmdVector3d_t& driverFromHeadTranslationOffset() const { return m_driverFromHeadTranslationOffset; }
-	vr::HmdVector3d_t& driverFromHeadTranslationOffset() { return m_driverFromHeadTranslationOffset; }
-	const vr::HmdQuaternion_t& deviceRotationOffset() const { return m_deviceRotationOffset; }
-	vr::HmdQuaternion_t& deviceRotationOffset() { return m_deviceRotationOffset; }
-	const vr::HmdVector3d_t& deviceTranslationOffset() const { return m_deviceTranslationOffset; }
-	vr::HmdVector3d_t& deviceTranslationOffset() { return m_deviceTranslationOffset; }
+	bool areOffsetsEnabled() const { return m_offsets.enabled; }
+	const vr::HmdQuaternion_t& worldFromDriverRotationOffset() const { return m_offsets.worldFromDriverRotation; }
+	const vr::HmdVector3d_t& worldFromDriverTranslationOffset() const { return m_offsets.worldFromDriverTranslation; }
+	const vr::HmdQuaternion_t& driverFromHeadRotationOffset() const { return m_offsets.driverFromHeadRotation; }
+	const vr::HmdVector3d_t& driverFromHeadTranslationOffset() const { return m_offsets.driverFromHeadTranslation; }
+	const vr::HmdQuaternion_t& deviceRotationOffset() const { return m_offsets.deviceRotation; }
+	const vr::HmdVector3d_t& deviceTranslationOffset() const { return m_offsets.deviceTranslation; }
+	const PoseOffsets& poseOffsets() const { return m_offsets; }
+	// Replaces all offsets at once, so the pose hook never sees half of an update
+	void setPoseOffsets(const PoseOffsets& offsets);
 
 	void setDigitalInputRemapping(uint32_t buttonId, const DigitalInputRemapping& remapping);
 	DigitalInputRemapping getDigitalInputRemapping(uint32_t buttonId);
@@ -169,8 +198,9 @@ public:
 	bool handlePoseUpdate(uint32_t& unWhichDevice, vr::DriverPose_t& newPose, uint32_t unPoseStructSize);
 	bool handleButtonEvent(uint32_t& unWhichDevice, ButtonEventType eventType, vr::EVRButtonId& eButtonId, double& eventTimeOffset);
 	bool handleAxisUpdate(uint32_t& unWhichDevice, uint32_t& unWhichAxis, vr::VRControllerAxis_t& axisState);
-	bool handleBooleanComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, bool& bNewValue, double& fTimeOffset);
-	bool handleScalarComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, float& fNewValue, double& fTimeOffset);
+	// Button and axis come with the update, the server driver resolved them when the component was created
+	bool handleBooleanComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, vr::EVRButtonId buttonId, uint32_t buttonType, bool& bNewValue, double& fTimeOffset);
+	bool handleScalarComponentUpdate(vr::VRInputComponentHandle_t& ulComponent, uint32_t unWhichAxis, uint32_t unWhichAxisDim, float& fNewValue, double& fTimeOffset);
 	bool handleHapticPulseEvent(float& fDurationSeconds, float& fFrequency, float& fAmplitude);
 
 	void sendButtonEvent(uint32_t unWhichDevice, ButtonEventType eventType, vr::EVRButtonId eButtonId, double eventTimeOffset, bool directMode = false, DigitalInputRemappingInfo::BindingInfo* binding = nullptr);
@@ -182,11 +212,19 @@ public:
 
 	bool triggerHapticPulse(uint32_t unAxisId, uint16_t usPulseDurationMicroseconds, bool directMode = false);
 
-	void inputAddBooleanComponent(const char *pchName, uint64_t pHandle);
-	void inputAddScalarComponent(const char *pchName, uint64_t pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits);
+	// Return false when the name could not be mapped, else what it was mapped to
+	bool inputAddBooleanComponent(const char *pchName, uint64_t pHandle, uint32_t& mappedButtonId, uint32_t& mappedButtonType);
+	bool inputAddScalarComponent(const char *pchName, uint64_t pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits, uint32_t& mappedAxisId, uint32_t& mappedAxisDim);
 	void inputAddHapticComponent(const char * pchName, uint64_t pHandle);
 
 	PosKalmanFilter& kalmanFilter() { return m_kalmanFilter; }
+	// Only for the pose hook, catches the filter up with the last published tuning and restart
+	PoseKalmanFilter& poseKalmanFilter();
+	// The device's own tuning, or nullptr to follow defaultTuning
+	void setPoseFilterTuning(const PoseFilterTuning* tuning, const PoseFilterTuning& defaultTuning);
+	// Ignored while the device has its own tuning
+	void setDefaultPoseFilterTuning(const PoseFilterTuning& defaultTuning);
+	void resetPoseFilter();
 	MovingAverageRingBuffer& velMovingAverage() { return m_velMovingAverageBuffer; }
 	long long getLastPoseTime() { return m_lastPoseTime; }
 	void setLastPoseTime(long long time) { m_lastPoseTime = time; }
@@ -204,9 +242,6 @@ public:
 	void setPropertyContainer(vr::PropertyContainerHandle_t container) { m_propertyContainerHandle = container; }
 	vr::PropertyContainerHandle_t propertyContainer() { return m_propertyContainerHandle; }
 
-	void RunFrame();
-	void RunFrameDigitalBinding(vrinputemulator::DigitalBinding& binding, vr::EVRButtonId eButtonId, DigitalInputRemappingInfo::BindingInfo& bindingInfo);
-
 	void suspendRedirectMode();
 
 	static bool getTouchpadEmulationFixFlag() {
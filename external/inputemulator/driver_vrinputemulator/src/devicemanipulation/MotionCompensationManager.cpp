@@ -18,6 +18,10 @@ void MotionCompensationManager::enableMotionCompensation(bool enable) {
 		m_parent->executeCodeForEachDeviceManipulationHandle([](DeviceManipulationHandle* handle) {
 			handle->setLastPoseTime(-1);
 		});
+	} else if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::PoseKalmanFilter) {
+		m_parent->executeCodeForEachDeviceManipulationHandle([](DeviceManipulationHandle* handle) {
+			handle->resetPoseFilter();
+		});
 	}
 }
 
@@ -37,6 +41,8 @@ void MotionCompensationManager::setMotionCompensationVelAccMode(MotionCompensati
 			handle->kalmanFilter().setProcessNoise(m_motionCompensationKalmanProcessVariance);
 			handle->kalmanFilter().setObservationNoise(m_motionCompensationKalmanObservationVariance);
 			handle->velMovingAverage().resize(m_motionCompensationMovingAverageWindow);
+			handle->resetPoseFilter();
+			handle->setDefaultPoseFilterTuning(m_poseKalmanTuning);
 		});
 		_motionCompensationVelAccMode = velAccMode;
 	}
@@ -44,19 +50,29 @@ void MotionCompensationManager::setMotionCompensationVelAccMode(MotionCompensati
 
 void MotionCompensationManager::setMotionCompensationKalmanProcessVariance(double variance) {
 	m_motionCompensationKalmanProcessVariance = variance;
+	m_poseKalmanTuning.positionProcessNoise = variance;
 	if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::KalmanFilter) {
 		m_parent->executeCodeForEachDeviceManipulationHandle([variance](DeviceManipulationHandle* handle) {
 			handle->kalmanFilter().setProcessNoise(variance);
 		});
+	} else if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::PoseKalmanFilter) {
+		m_parent->executeCodeForEachDeviceManipulationHandle([this](DeviceManipulationHandle* handle) {
+			handle->setDefaultPoseFilterTuning(m_poseKalmanTuning);
+		});
 	}
 }
 
 void MotionCompensationManager::setMotionCompensationKalmanObservationVariance(double variance) {
 	m_motionCompensationKalmanObservationVariance = variance;
+	m_poseKalmanTuning.positionObservationNoise = variance;
 	if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::KalmanFilter) {
 		m_parent->executeCodeForEachDeviceManipulationHandle([variance](DeviceManipulationHandle* handle) {
 			handle->kalmanFilter().setObservationNoise(variance);
 		});
+	} else if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::PoseKalmanFilter) {
+		m_parent->executeCodeForEachDeviceManipulationHandle([this](DeviceManipulationHandle* handle) {
+			handle->setDefaultPoseFilterTuning(m_poseKalmanTuning);
+		});
 	}
 }
 
@@ -69,6 +85,10 @@ void MotionCompensationManager::setMotionCompensationMovingAverageWindow(unsigne
 	}
 }
 
+void MotionCompensationManager::setDevicePoseKalmanTuning(DeviceManipulationHandle* device, const PoseFilterTuning* tuning) {
+	device->setPoseFilterTuning(tuning, m_poseKalmanTuning);
+}
+
 void MotionCompensationManager::_disableMotionCompensationOnAllDevices() {
 	m_parent->executeCodeForEachDeviceManipulationHandle([](DeviceManipulationHandle* handle) {
 		if (handle->deviceMode() == 5) {
@@ -128,6 +148,8 @@ bool MotionCompensationManager::_applyMotionCompensation(vr::DriverPose_t& pose,
 		// Velocity / Acceleration Compensation
 		vr::HmdVector3d_t compensatedPoseWorldVel;
 		bool compensatedPoseWorldVelValid = false;
+		vr::HmdVector3d_t compensatedPoseWorldAngVel;
+		bool compensatedPoseWorldAngVelValid = false;
 		bool setVelToZero = false;
 		bool setAccToZero = false;
 		bool setAngVelToZero = false;
@@ -208,6 +230,21 @@ bool MotionCompensationManager::_applyMotionCompensation(vr::DriverPose_t& pose,
 				setAngAccToZero = true;
 			}
 
+		} else if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::PoseKalmanFilter) {
+			// The pose Kalman filter uses app space coordinates and steady clock time
+			// A pose is measured poseTimeOffset seconds away from when it was handed to us
+			auto sampleTime = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() + pose.poseTimeOffset;
+			auto& filter = deviceInfo->poseKalmanFilter();
+			// On the first pose, after a gap or on too small time steps the filter keeps its last estimate (zero after a restart)
+			filter.update(compensatedPoseWorldPos, compensatedPoseWorldRot, sampleTime);
+			compensatedPoseWorldVel = filter.getUpdatedVelocityEstimate();
+			compensatedPoseWorldVelValid = true;
+			compensatedPoseWorldAngVel = filter.getUpdatedAngularVelocityEstimate();
+			compensatedPoseWorldAngVelValid = true;
+			// Constant velocity model, so no acceleration
+			setAccToZero = true;
+			setAngAccToZero = true;
+
 		} else if (_motionCompensationVelAccMode == MotionCompensationVelAccMode::LinearApproximation) {
 			// Linear approximation uses driver space coordinates
 			if (deviceInfo->lastDriverPoseValid()) {
@@ -278,6 +315,14 @@ bool MotionCompensationManager::_applyMotionCompensation(vr::DriverPose_t& pose,
 			pose.vecVelocity[1] = 0.0;
 			pose.vecVelocity[2] = 0.0;
 		}
+		if (compensatedPoseWorldAngVelValid) {
+			// DriverPose_t wants angular velocity in the device's own frame
+			auto driverAngVel = vrmath::quaternionRotateVector(pose.qWorldFromDriverRotation, tmpConj, compensatedPoseWorldAngVel);
+			auto deviceAngVel = vrmath::quaternionRotateVector(pose.qRotation, driverAngVel, true);
+			pose.vecAngularVelocity[0] = deviceAngVel.v[0];
+			pose.vecAngularVelocity[1] = deviceAngVel.v[1];
+			pose.vecAngularVelocity[2] = deviceAngVel.v[2];
+		}
 		if (setAccToZero) {
 			pose.vecAcceleration[0] = 0.0;
 			pose.vecAcceleration[1] = 0.0;
@@ -40,6 +40,9 @@ public:
 	void setMotionCompensationKalmanObservationVariance(double variance);
 	double motionCompensationMovingAverageWindow() { return m_motionCompensationMovingAverageWindow; }
 	void setMotionCompensationMovingAverageWindow(unsigned window);
+	const PoseFilterTuning& poseKalmanTuning() { return m_poseKalmanTuning; }
+	// Own tuning for one device, nullptr makes it follow the default tuning again
+	void setDevicePoseKalmanTuning(DeviceManipulationHandle* device, const PoseFilterTuning* tuning);
 	void _disableMotionCompensationOnAllDevices();
 	bool _isMotionCompensationZeroPoseValid();
 	void _setMotionCompensationZeroPose(const vr::DriverPose_t& pose);
@@ -60,6 +63,8 @@ private:
 	double m_motionCompensationKalmanProcessVariance = 0.1;
 	double m_motionCompensationKalmanObservationVariance = 0.1;
 	unsigned m_motionCompensationMovingAverageWindow = 3;
+	// Position noise follows the kalman variances above, rotation noise keeps its default
+	PoseFilterTuning m_poseKalmanTuning;
 
 	bool _motionCompensationZeroPoseValid = false;
 	vr::HmdVector3d_t _motionCompensationZeroPos;
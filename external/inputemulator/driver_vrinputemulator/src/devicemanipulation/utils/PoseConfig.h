@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <openvr_driver.h>
+#include <openvr_math.h>
+#include <vrinputemulator_types.h>
+
+// driver namespace
+namespace vrinputemulator {
+namespace driver {
+
+
+// All offsets folded into what the pose hook does to a pose: three rotations and three translations,
+// unused parts stay identity so applying it takes no per-offset checks
+struct PoseTransform {
+	vr::HmdQuaternion_t worldFromDriverRotation = { 1.0, 0.0, 0.0, 0.0 };
+	vr::HmdVector3d_t worldFromDriverTranslation = { 0.0, 0.0, 0.0 };
+	vr::HmdQuaternion_t driverFromHeadRotation = { 1.0, 0.0, 0.0, 0.0 };
+	vr::HmdVector3d_t driverFromHeadTranslation = { 0.0, 0.0, 0.0 };
+	vr::HmdQuaternion_t deviceRotation = { 1.0, 0.0, 0.0, 0.0 };
+	vr::HmdVector3d_t deviceTranslation = { 0.0, 0.0, 0.0 };
+
+	// Identity rotations and zero translations leave their fields unchanged, so nothing needs skipping
+	void applyTo(vr::DriverPose_t& pose) const {
+		pose.qWorldFromDriverRotation = worldFromDriverRotation * pose.qWorldFromDriverRotation;
+		_add(pose.vecWorldFromDriverTranslation, worldFromDriverTranslation);
+		pose.qDriverFromHeadRotation = driverFromHeadRotation * pose.qDriverFromHeadRotation;
+		_add(pose.vecDriverFromHeadTranslation, driverFromHeadTranslation);
+		pose.qRotation = deviceRotation * pose.qRotation;
+		_add(pose.vecPosition, deviceTranslation);
+	}
+
+	// False when applying it would change nothing
+	bool changesPose() const {
+		return !_isIdentity(worldFromDriverRotation) || !_isZero(worldFromDriverTranslation)
+			|| !_isIdentity(driverFromHeadRotation) || !_isZero(driverFromHeadTranslation)
+			|| !_isIdentity(deviceRotation) || !_isZero(deviceTranslation);
+	}
+
+private:
+	static void _add(double(&lhs)[3], const vr::HmdVector3d_t& rhs) {
+		lhs[0] += rhs.v[0];
+		lhs[1] += rhs.v[1];
+		lhs[2] += rhs.v[2];
+	}
+	static bool _isIdentity(const vr::HmdQuaternion_t& q) {
+		return q.w == 1.0 && q.x == 0.0 && q.y == 0.0 && q.z == 0.0;
+	}
+	static bool _isZero(const vr::HmdVector3d_t& v) {
+		return v.v[0] == 0.0 && v.v[1] == 0.0 && v.v[2] == 0.0;
+	}
+};
+
+
+// What the pose hook needs to know about a device, rebuilt whenever one of it changes and never modified afterwards.
+// Device is whatever the redirect and swap modes hand poses to (DeviceManipulationHandle in the driver)
+template <typename Device>
+struct PoseConfig {
+	int deviceMode = 0; // 0 .. default, 1 .. disabled, 2 .. redirect source, 3 .. redirect target, 4 .. swap mode, 5 .. motion compensation
+	bool redirectSuspended = false;
+	Device* redirectRef = nullptr;
+	// The enabled offsets as one transform applied to every pose, false when it would change nothing
+	bool transformPose = false;
+	PoseTransform poseTransform;
+	PoseFilterTuning poseFilterTuning;
+	// Bumped to ask the pose hook to restart its pose filter
+	unsigned poseFilterGeneration = 0;
+};
+
+
+// Hands the current config to readers with one atomic load, no lock and no reference counting.
+// A replaced config stays alive until the publisher goes away, a pose hook may still be reading it.
+// Configs only change on user actions, so keeping them all costs a few hundred bytes per change
+template <typename Config>
+class PublishedConfig {
+public:
+	PublishedConfig() {
+		publish(std::unique_ptr<const Config>(new Config()));
+	}
+
+	PublishedConfig(const PublishedConfig&) = delete;
+	PublishedConfig& operator=(const PublishedConfig&) = delete;
+
+	// Any thread, never null
+	const Config* load() const {
+		return m_current.load(std::memory_order_acquire);
+	}
+
+	// Publishers have to hold their own lock, only readers are lock-free
+	void publish(std::unique_ptr<const Config> config) {
+		m_current.store(config.get(), std::memory_order_release);
+		m_configs.push_back(std::move(config));
+	}
+
+	size_t publishedCount() const {
+		return m_configs.size();
+	}
+
+private:
+	std::atomic<const Config*> m_current { nullptr };
+	std::vector<std::unique_ptr<const Config>> m_configs;
+};
+
+
+// What the pose hook does with a pose in every mode but motion compensation. Returns whether the hook passes the pose
+// on to the driver host, for device unWhichDevice which swap mode changes. compensate(pose) runs after the offsets.
+// Fake disconnect and redirect source send one disconnected pose, disconnectedMsgSend remembers that it went out
+template <typename Device, typename Compensate>
+bool routePose(const PoseConfig<Device>& config, std::atomic<bool>& disconnectedMsgSend, uint32_t& unWhichDevice,
+		vr::DriverPose_t& newPose, Compensate compensate) {
+	auto disconnectOnce = [&]() {
+		if (disconnectedMsgSend.exchange(true)) {
+			return false;
+		}
+		newPose.poseIsValid = false;
+		newPose.deviceIsConnected = false;
+		newPose.result = vr::TrackingResult_Uninitialized;
+		return true;
+	};
+
+	if (config.deviceMode == 1) { // fake disconnect mode
+		return disconnectOnce();
+
+	} else if (config.deviceMode == 3 && !config.redirectSuspended) { // redirect target
+		return false;
+
+	} else {
+		if (config.transformPose) {
+			config.poseTransform.applyTo(newPose);
+		}
+
+		compensate(newPose);
+
+		if (config.deviceMode == 2 && !config.redirectSuspended) { // redirect source
+			config.redirectRef->ll_sendPoseUpdate(newPose);
+			return disconnectOnce();
+		} else if (config.deviceMode == 4) { // swap mode
+			unWhichDevice = config.redirectRef->openvrId();
+		}
+		return true;
+	}
+}
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
@@ -0,0 +1,108 @@
+#include "PoseKalmanFilter.h"
+
+#include <cmath>
+#include <openvr_math.h>
+
+
+namespace vrinputemulator {
+namespace driver {
+
+namespace {
+
+// rotation vector (axis * angle) to quaternion
+vr::HmdQuaternion_t rotationVectorToQuaternion(const vr::HmdVector3d_t& v) {
+	double angle = std::sqrt(v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2]);
+	if (angle < 1e-12) {
+		return { 1.0, v.v[0] / 2.0, v.v[1] / 2.0, v.v[2] / 2.0 };
+	}
+	double s = std::sin(angle / 2.0) / angle;
+	return { std::cos(angle / 2.0), v.v[0] * s, v.v[1] * s, v.v[2] * s };
+}
+
+// quaternion to rotation vector, taking the shorter way around
+vr::HmdVector3d_t quaternionToRotationVector(const vr::HmdQuaternion_t& q) {
+	double sign = q.w < 0.0 ? -1.0 : 1.0;
+	double sinHalf = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+	if (sinHalf < 1e-12) {
+		return { 2.0 * sign * q.x, 2.0 * sign * q.y, 2.0 * sign * q.z };
+	}
+	double angle = 2.0 * std::atan2(sinHalf, sign * q.w);
+	double s = sign * angle / sinHalf;
+	return { q.x * s, q.y * s, q.z * s };
+}
+
+vr::HmdQuaternion_t normalize(const vr::HmdQuaternion_t& q) {
+	double length = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	return { q.w / length, q.x / length, q.y / length, q.z / length };
+}
+
+}
+
+void PoseKalmanFilter::init(const vr::HmdVector3d_t& initPos, const vr::HmdQuaternion_t& initRot, double sampleTime, const double(&initCovariance)[2][2]) {
+	lastPos = initPos;
+	lastVel = { 0.0, 0.0, 0.0 };
+	lastRot = initRot;
+	lastAngVel = { 0.0, 0.0, 0.0 };
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			lastPosCovariance[i][j] = initCovariance[i][j];
+			lastRotCovariance[i][j] = initCovariance[i][j];
+		}
+	}
+	lastSampleTime = sampleTime;
+	initialized = true;
+}
+
+// Same predict and gain steps as PosKalmanFilter::update, for a [value, rate] state per axis
+void PoseKalmanFilter::updateCovariance(double(&covariance)[2][2], double processNoise, double observationNoise, double dt, double(&gain)[2]) {
+	// predict new covariance matrix
+	double newCovariance[2][2] = {
+		covariance[0][0] + dt * (covariance[0][1] + covariance[1][0]) + dt*dt* covariance[1][1] + 1.0 / 4.0 * pow(dt, 4.0) * processNoise,
+		covariance[0][1] + dt * covariance[1][1] + 1.0 / 2.0 * pow(dt, 3.0) * processNoise,
+		covariance[1][0] + dt * covariance[1][1] + 1.0 / 2.0 * pow(dt, 3.0) * processNoise,
+		covariance[1][1] + dt*dt * processNoise
+	};
+	// calculate kalman gain
+	double innovationVariance = newCovariance[0][0] + observationNoise;
+	if (innovationVariance == 0.0) {
+		gain[0] = 1;
+		gain[1] = 1;
+	} else {
+		gain[0] = newCovariance[0][0] / innovationVariance;
+		gain[1] = newCovariance[1][0] / innovationVariance;
+	}
+	// calculate new a posteriori covariance matrix
+	covariance[0][0] = (1 - gain[0]) * newCovariance[0][0];
+	covariance[0][1] = (1 - gain[0]) * newCovariance[0][1];
+	covariance[1][0] = newCovariance[1][0] - gain[1] * newCovariance[0][0];
+	covariance[1][1] = newCovariance[1][1] - gain[1] * newCovariance[0][1];
+}
+
+void PoseKalmanFilter::update(const vr::HmdVector3d_t& devicePos, const vr::HmdQuaternion_t& deviceRot, double sampleTime) {
+	double dt = sampleTime - lastSampleTime;
+	if (!initialized || dt > maxTimeStep || dt < 0.0) {
+		init(devicePos, deviceRot, sampleTime);
+		return;
+	} else if (dt < minTimeStep) {
+		return;
+	}
+	lastSampleTime = sampleTime;
+
+	// position: predict, then correct with the measured position
+	vr::HmdVector3d_t predictedPos = lastPos + lastVel * dt;
+	vr::HmdVector3d_t innovation = devicePos - predictedPos;
+	double gain[2];
+	updateCovariance(lastPosCovariance, tuning.positionProcessNoise, tuning.positionObservationNoise, dt, gain);
+	lastPos = predictedPos + innovation * gain[0];
+	lastVel = lastVel + innovation * gain[1];
+
+	// rotation: keep turning at the last angular velocity, the innovation is the rotation left from there to the measurement
+	vr::HmdQuaternion_t predictedRot = normalize(rotationVectorToQuaternion(lastAngVel * dt) * lastRot);
+	vr::HmdVector3d_t rotInnovation = quaternionToRotationVector(deviceRot * vrmath::quaternionConjugate(predictedRot));
+	updateCovariance(lastRotCovariance, tuning.rotationProcessNoise, tuning.rotationObservationNoise, dt, gain);
+	lastRot = normalize(rotationVectorToQuaternion(rotInnovation * gain[0]) * predictedRot);
+	lastAngVel = lastAngVel + rotInnovation * gain[1];
+}
+
+}
+} // end namespace vrinputemulator
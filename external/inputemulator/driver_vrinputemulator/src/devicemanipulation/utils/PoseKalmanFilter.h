@@ -0,0 +1,51 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <vrinputemulator_types.h>
+
+// driver namespace
+namespace vrinputemulator {
+namespace driver {
+
+// Constant velocity Kalman filter for whole device poses (gives linear and angular velocity at the same time)
+// Position is filtered per axis like in PosKalmanFilter. Rotation is filtered as a small rotation vector
+// around the predicted orientation, so the estimate stays on the unit quaternions.
+class PoseKalmanFilter {
+private:
+	// last a posteriori state estimate
+	vr::HmdVector3d_t lastPos = { 0.0, 0.0, 0.0 };
+	vr::HmdVector3d_t lastVel = { 0.0, 0.0, 0.0 };
+	vr::HmdQuaternion_t lastRot = { 1.0, 0.0, 0.0, 0.0 };
+	vr::HmdVector3d_t lastAngVel = { 0.0, 0.0, 0.0 }; // axis-angle, radians per second
+	// last a posteriori estimate covariance matrices, shared by all three axes
+	double lastPosCovariance[2][2] = { 0.0, 0.0, 0.0, 0.0 };
+	double lastRotCovariance[2][2] = { 0.0, 0.0, 0.0, 0.0 };
+	PoseFilterTuning tuning;
+	bool initialized = false;
+	double lastSampleTime = 0.0; // seconds
+
+	static void updateCovariance(double(&covariance)[2][2], double processNoise, double observationNoise, double dt, double(&gain)[2]);
+
+public:
+	// Gaps longer than this, or time going backwards, restart the filter instead of predicting across them
+	constexpr static double maxTimeStep = 0.5;
+	// Smaller steps leave the estimate as it is
+	constexpr static double minTimeStep = 0.0001;
+
+	void init(const vr::HmdVector3d_t& initPos, const vr::HmdQuaternion_t& initRot, double sampleTime, const double(&initCovariance)[2][2] = { { 100.0, 0.0 },{ 0.0, 100.0 } });
+	void reset() { initialized = false; }
+	bool isInitialized() const { return initialized; }
+	void setTuning(const PoseFilterTuning& value) { tuning = value; }
+	const PoseFilterTuning& getTuning() const { return tuning; }
+
+	// sampleTime is when the pose was measured, in seconds on a steady clock
+	void update(const vr::HmdVector3d_t& devicePos, const vr::HmdQuaternion_t& deviceRot, double sampleTime);
+
+	const vr::HmdVector3d_t& getUpdatedPositionEstimate() const { return lastPos; }
+	const vr::HmdVector3d_t& getUpdatedVelocityEstimate() const { return lastVel; }
+	const vr::HmdQuaternion_t& getUpdatedRotationEstimate() const { return lastRot; }
+	const vr::HmdVector3d_t& getUpdatedAngularVelocityEstimate() const { return lastAngVel; }
+};
+
+}
+}
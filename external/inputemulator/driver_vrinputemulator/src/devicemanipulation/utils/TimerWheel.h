@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// driver namespace
+namespace vrinputemulator {
+namespace driver {
+
+
+/**
+* Hashed timer wheel for one-shot timers.
+*
+* Timers are sorted into slots by their due tick, so advance() only looks at the slots of the ticks that
+* passed since the last call, and timers that are not due cost nothing. Timers further away than one turn
+* of the wheel stay in their slot until a later turn. Cancelled timers are dropped when their slot comes up.
+*
+* Callbacks are called from advance() without the wheel's lock held, so they may schedule and cancel timers.
+* Clock only needs now(), time_point and duration, which lets tests drive the wheel with a fake clock.
+*/
+template <typename Clock = std::chrono::steady_clock>
+class TimerWheel {
+public:
+	typedef typename Clock::time_point time_point;
+	typedef typename Clock::duration duration;
+	typedef uint64_t TimerId; // 0 is never handed out
+	// Gets the id returned by schedule() and the time the timer was due (not when advance() got to it)
+	typedef std::function<void(TimerId id, time_point due)> Callback;
+
+	explicit TimerWheel(duration tick = std::chrono::milliseconds(1), unsigned slotCount = 256, time_point start = Clock::now())
+			: m_tick(tick.count() > 0 ? tick : duration(1)), m_slots(_roundUpToPowerOfTwo(slotCount)), m_currentTick(_toTick(start)) {}
+
+	TimerId schedule(time_point due, Callback callback) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		TimerId id = ++m_lastId;
+		int64_t tick = std::max(_toTick(due), m_currentTick);
+		m_slots[(size_t)tick & (m_slots.size() - 1)].push_back({ id, due, std::move(callback) });
+		m_live.insert(id);
+		return id;
+	}
+
+	static time_point now() { return Clock::now(); }
+
+	// Due time for a timer chained off one that was due at previousDue: interval later, but never in the past.
+	// A chain that fell behind (a stalled frame) carries on from now instead of firing its catch-ups in a burst
+	static time_point next(time_point previousDue, duration interval) { return std::max(previousDue + interval, Clock::now()); }
+
+	TimerId scheduleAfter(duration delay, Callback callback) {
+		return schedule(Clock::now() + delay, std::move(callback));
+	}
+
+	// Returns false when the timer already fired or was cancelled before
+	bool cancel(TimerId id) {
+		if (id == 0) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_live.erase(id) > 0;
+	}
+
+	// Fires all timers due at or before now, in order of their due time within a tick. Returns how many fired.
+	size_t advance(time_point now) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		int64_t nowTick = _toTick(now);
+		if (nowTick < m_currentTick) {
+			return 0;
+		}
+		// Timers scheduled by the callbacks below for the past go into the slot of now, which the next call looks at again
+		int64_t firstTick = m_currentTick;
+		m_currentTick = nowTick;
+		// After a pause longer than one turn every slot gets looked at exactly once
+		int64_t lastTick = std::min(nowTick, firstTick + (int64_t)m_slots.size() - 1);
+		size_t fired = 0;
+		std::vector<Entry> due;
+		for (int64_t tick = firstTick; tick <= lastTick; tick++) {
+			auto& slot = m_slots[(size_t)tick & (m_slots.size() - 1)];
+			if (slot.empty()) {
+				continue;
+			}
+			due.clear();
+			size_t kept = 0;
+			for (size_t i = 0; i < slot.size(); i++) {
+				if (m_live.find(slot[i].id) == m_live.end()) {
+					continue;
+				} else if (slot[i].due <= now) {
+					due.push_back(std::move(slot[i]));
+				} else {
+					if (kept != i) {
+						slot[kept] = std::move(slot[i]);
+					}
+					kept++;
+				}
+			}
+			slot.resize(kept);
+			std::sort(due.begin(), due.end(), [](const Entry& a, const Entry& b) {
+				return a.due < b.due || (a.due == b.due && a.id < b.id);
+			});
+			for (auto& entry : due) {
+				// An earlier callback may have cancelled this one
+				if (m_live.erase(entry.id) == 0) {
+					continue;
+				}
+				lock.unlock();
+				entry.callback(entry.id, entry.due);
+				lock.lock();
+				fired++;
+			}
+		}
+		return fired;
+	}
+
+	size_t advance() { return advance(Clock::now()); }
+
+	size_t pending() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_live.size();
+	}
+
+private:
+	struct Entry {
+		TimerId id;
+		time_point due;
+		Callback callback;
+	};
+
+	static size_t _roundUpToPowerOfTwo(unsigned value) {
+		size_t result = 1;
+		while (result < value) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	int64_t _toTick(time_point t) const {
+		return (int64_t)(t.time_since_epoch() / m_tick);
+	}
+
+	std::mutex m_mutex;
+	duration m_tick;
+	std::vector<std::vector<Entry>> m_slots;
+	std::unordered_set<TimerId> m_live;
+	int64_t m_currentTick;
+	TimerId m_lastId = 0;
+};
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
@@ -17,6 +17,8 @@ const char* logConfigDefault =
 
 INITIALIZE_EASYLOGGINGPP
 
+std::atomic<bool> g_hotPathLogging { false };
+
 void init_logging() {
 	el::Loggers::addFlag(el::LoggingFlag::DisableApplicationAbortOnFatalLog);
 	el::Configurations conf(logConfigFileName);
@@ -24,6 +26,8 @@ void init_logging() {
 	conf.parseFromFile(logConfigFileName);
 	conf.setRemainingToDefault();
 	el::Loggers::reconfigureAllLoggers(conf);
+	auto logger = el::Loggers::getLogger("default");
+	g_hotPathLogging = logger && (logger->enabled(el::Level::Trace) || logger->enabled(el::Level::Debug));
 }
 
 BOOL APIENTRY DllMain( HMODULE hModule,
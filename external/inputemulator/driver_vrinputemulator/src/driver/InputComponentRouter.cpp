@@ -0,0 +1,44 @@
+#include "InputComponentRouter.h"
+
+
+namespace vrinputemulator {
+namespace driver {
+
+
+InputComponentRouter::InputComponentRouter()
+		: m_keys(new std::atomic<uint64_t>[tableSize]), m_keySlots(new std::atomic<uint32_t>[tableSize]), m_routes(new Route[maxComponents]), m_routeCount(0) {
+	for (uint32_t i = 0; i < tableSize; i++) {
+		m_keys[i].store(vr::k_ulInvalidInputComponentHandle, std::memory_order_relaxed);
+		m_keySlots[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+
+uint32_t InputComponentRouter::add(vr::VRInputComponentHandle_t component, const Route& route) {
+	if (component == vr::k_ulInvalidInputComponentHandle) {
+		return invalidSlot;
+	}
+	std::lock_guard<std::mutex> lock(m_addMutex);
+	uint32_t slot = m_routeCount.load(std::memory_order_relaxed);
+	if (slot >= maxComponents) {
+		return invalidSlot;
+	}
+	uint32_t i = _hash(component) & (tableSize - 1);
+	while (true) {
+		uint64_t key = m_keys[i].load(std::memory_order_relaxed);
+		if (key == component || key == vr::k_ulInvalidInputComponentHandle) {
+			break;
+		}
+		i = (i + 1) & (tableSize - 1);
+	}
+	// A replaced route gets a new slot, readers still holding the old one see it unchanged
+	m_routes[slot] = route;
+	m_keySlots[i].store(slot, std::memory_order_release);
+	m_keys[i].store(component, std::memory_order_release);
+	m_routeCount.store(slot + 1, std::memory_order_release);
+	return slot;
+}
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
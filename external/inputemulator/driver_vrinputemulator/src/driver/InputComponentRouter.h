@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <openvr_driver.h>
+
+
+// driver namespace
+namespace vrinputemulator {
+namespace driver {
+
+
+// forward declarations
+class DeviceManipulationHandle;
+
+
+/**
+* Routes input component updates to the device manipulation handle that owns the component.
+*
+* Components get a dense slot when they are created, the slot holds the handle and what the component's name
+* was mapped to, so an update needs neither a tree lookup in the server driver nor one in the handle.
+* Component handles are found through an open-addressing table of fixed size, so find() never sees a rehash
+* and can run without a lock while components of another device are being created.
+*/
+class InputComponentRouter {
+public:
+	enum class ComponentType : uint8_t {
+		Boolean,
+		Scalar,
+		Haptic
+	};
+
+	struct Route {
+		DeviceManipulationHandle* handle = nullptr;
+		ComponentType type = ComponentType::Boolean;
+		bool mapped = false; // false when the component name could not be mapped to a button or axis
+		uint32_t id = 0; // button id for boolean, axis id for scalar components
+		uint32_t dim = 0; // 0 .. touch, 1 .. click for boolean components, axis dimension for scalar components
+	};
+
+	static constexpr uint32_t maxComponents = 2048;
+	static constexpr uint32_t invalidSlot = 0xFFFFFFFF;
+
+	InputComponentRouter();
+
+	/** Returns the component's slot, or invalidSlot when the table is full. Adding a component again replaces its route. */
+	uint32_t add(vr::VRInputComponentHandle_t component, const Route& route);
+
+	/** Lock free, may run concurrently with add() */
+	const Route* find(vr::VRInputComponentHandle_t component) const {
+		if (component == vr::k_ulInvalidInputComponentHandle) {
+			return nullptr;
+		}
+		for (uint32_t i = _hash(component) & (tableSize - 1), probes = 0; probes < tableSize; i = (i + 1) & (tableSize - 1), probes++) {
+			uint64_t key = m_keys[i].load(std::memory_order_acquire);
+			if (key == component) {
+				return &m_routes[m_keySlots[i].load(std::memory_order_acquire)];
+			} else if (key == vr::k_ulInvalidInputComponentHandle) {
+				return nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	uint32_t size() const { return m_routeCount.load(std::memory_order_acquire); }
+
+private:
+	// At most half of the table is in use, so probe sequences stay short
+	static constexpr uint32_t tableSize = maxComponents * 2;
+
+	static uint32_t _hash(uint64_t key) {
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		return (uint32_t)key;
+	}
+
+	std::unique_ptr<std::atomic<uint64_t>[]> m_keys;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_keySlots;
+	std::unique_ptr<Route[]> m_routes; // never moved, a slot's route is written before the slot gets published
+	std::atomic<uint32_t> m_routeCount;
+	std::mutex m_addMutex;
+};
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
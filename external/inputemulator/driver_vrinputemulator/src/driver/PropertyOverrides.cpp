@@ -0,0 +1,125 @@
+#include "PropertyOverrides.h"
+
+#include <algorithm>
+#include "../logging.h"
+
+
+namespace vrinputemulator {
+namespace driver {
+
+
+void PropertyOverrides::addStringOverride(vr::ETrackedDeviceProperty prop, const std::string& value, DeviceFilter filter, const std::string& description) {
+	auto it = std::lower_bound(m_rules.begin(), m_rules.end(), prop, [](const Rule& rule, vr::ETrackedDeviceProperty p) {
+		return rule.prop < p;
+	});
+	if (it == m_rules.end() || it->prop != prop) {
+		it = m_rules.insert(it, Rule());
+	}
+	it->prop = prop;
+	it->filter = filter;
+	it->value = value;
+	it->description = description;
+	m_minProp = m_rules.front().prop;
+	m_maxProp = m_rules.back().prop;
+}
+
+
+void PropertyOverrides::deviceActivated(vr::PropertyContainerHandle_t container, uint32_t openvrId) {
+	if (container == vr::k_ulInvalidPropertyContainer) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_indexMutex);
+	if (openvrId == vr::k_unTrackedDeviceIndex_Hmd) {
+		// A re-added hmd gets a new container, the old one must stop matching hmd-only rules
+		if (m_hmdContainer != vr::k_ulInvalidPropertyContainer && m_hmdContainer != container) {
+			m_containerToDeviceId.erase(m_hmdContainer);
+		}
+		m_hmdContainer = container;
+	} else if (container == m_hmdContainer) {
+		m_hmdContainer = vr::k_ulInvalidPropertyContainer;
+	}
+	m_containerToDeviceId[container] = openvrId;
+}
+
+
+PropertyOverrides::Rule* PropertyOverrides::_findRule(vr::ETrackedDeviceProperty prop) {
+	if (prop < m_minProp || prop > m_maxProp) {
+		return nullptr;
+	}
+	auto it = std::lower_bound(m_rules.begin(), m_rules.end(), prop, [](const Rule& rule, vr::ETrackedDeviceProperty p) {
+		return rule.prop < p;
+	});
+	if (it != m_rules.end() && it->prop == prop) {
+		return &*it;
+	}
+	return nullptr;
+}
+
+
+uint32_t PropertyOverrides::_deviceIdForContainer(vr::IVRProperties* properties, vr::PropertyContainerHandle_t container) {
+	std::lock_guard<std::mutex> lock(_indexMutex);
+	auto it = m_containerToDeviceId.find(container);
+	if (it != m_containerToDeviceId.end()) {
+		return it->second;
+	}
+	// Not one of the devices we saw being activated, the only id a rule asks about is the hmd's
+	if (m_hmdContainer == vr::k_ulInvalidPropertyContainer && properties) {
+		m_hmdContainer = properties->TrackedDeviceToPropertyContainer(vr::k_unTrackedDeviceIndex_Hmd);
+		if (m_hmdContainer != vr::k_ulInvalidPropertyContainer) {
+			m_containerToDeviceId[m_hmdContainer] = vr::k_unTrackedDeviceIndex_Hmd;
+		}
+	}
+	return container == m_hmdContainer ? vr::k_unTrackedDeviceIndex_Hmd : vr::k_unTrackedDeviceIndexInvalid;
+}
+
+
+void PropertyOverrides::apply(vr::IVRProperties* properties, vr::PropertyContainerHandle_t container, vr::PropertyWrite_t* batch, uint32_t batchEntryCount) {
+	if (m_rules.empty()) {
+		return;
+	}
+	bool deviceIdKnown = false;
+	uint32_t deviceId = vr::k_unTrackedDeviceIndexInvalid;
+	for (uint32_t i = 0; i < batchEntryCount; i++) {
+		vr::PropertyWrite_t& entry = batch[i];
+		auto rule = _findRule(entry.prop);
+		if (!rule || rule->value.empty()) {
+			continue;
+		}
+		if (rule->filter == DeviceFilter::HmdOnly) {
+			if (!deviceIdKnown) {
+				deviceId = _deviceIdForContainer(properties, container);
+				deviceIdKnown = true;
+			}
+			if (deviceId != vr::k_unTrackedDeviceIndex_Hmd) {
+				continue;
+			}
+		}
+		_logOverride(*rule, entry, deviceId);
+		entry.pvBuffer = (void*)rule->value.c_str();
+		entry.unBufferSize = (uint32_t)rule->value.size() + 1;
+	}
+}
+
+
+void PropertyOverrides::_logOverride(Rule& rule, const vr::PropertyWrite_t& entry, uint32_t deviceId) {
+	std::lock_guard<std::mutex> lock(_logMutex);
+	auto now = std::chrono::steady_clock::now();
+	if (rule.logged && now - rule.lastLogTime < std::chrono::seconds(logIntervalSeconds)) {
+		rule.suppressedLogs++;
+		return;
+	}
+	const char* oldValue = entry.unTag == vr::k_unStringPropertyTag && entry.pvBuffer ? (const char*)entry.pvBuffer : "<unknown>";
+	if (rule.suppressedLogs > 0) {
+		LOG(INFO) << "Overwriting " << rule.description << ": " << oldValue << " => " << rule.value
+			<< " (and " << rule.suppressedLogs << " more times in the last " << logIntervalSeconds << " seconds)";
+	} else {
+		LOG(INFO) << "Overwriting " << rule.description << ": " << oldValue << " => " << rule.value;
+	}
+	rule.logged = true;
+	rule.lastLogTime = now;
+	rule.suppressedLogs = 0;
+}
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <openvr_driver.h>
+
+
+// driver namespace
+namespace vrinputemulator {
+namespace driver {
+
+
+/**
+* Rewrites device property writes on their way into SteamVR.
+*
+* The overrides from the vrsettings are compiled into a table sorted by property, so entries of a batch
+* that no rule cares about are skipped with one lookup. Devices are looked up by property container in
+* an index filled when they get activated, instead of asking SteamVR for every device id on each batch.
+*/
+class PropertyOverrides {
+public:
+	enum class DeviceFilter {
+		AnyDevice,
+		HmdOnly
+	};
+
+	// Seconds between two log messages about the same override
+	static constexpr int logIntervalSeconds = 10;
+
+	void addStringOverride(vr::ETrackedDeviceProperty prop, const std::string& value, DeviceFilter filter, const std::string& description);
+	bool empty() const { return m_rules.empty(); }
+
+	void deviceActivated(vr::PropertyContainerHandle_t container, uint32_t openvrId);
+
+	/** properties is only asked for the hmd's container, and only for containers no activated device owns */
+	void apply(vr::IVRProperties* properties, vr::PropertyContainerHandle_t container, vr::PropertyWrite_t* batch, uint32_t batchEntryCount);
+
+private:
+	struct Rule {
+		vr::ETrackedDeviceProperty prop;
+		DeviceFilter filter;
+		std::string value;
+		std::string description;
+		std::chrono::steady_clock::time_point lastLogTime;
+		bool logged = false;
+		uint32_t suppressedLogs = 0;
+	};
+
+	Rule* _findRule(vr::ETrackedDeviceProperty prop);
+	uint32_t _deviceIdForContainer(vr::IVRProperties* properties, vr::PropertyContainerHandle_t container);
+	void _logOverride(Rule& rule, const vr::PropertyWrite_t& entry, uint32_t deviceId);
+
+	std::vector<Rule> m_rules; // sorted by prop
+	vr::ETrackedDeviceProperty m_minProp = vr::Prop_Invalid;
+	vr::ETrackedDeviceProperty m_maxProp = vr::Prop_Invalid;
+
+	std::mutex _indexMutex;
+	std::unordered_map<vr::PropertyContainerHandle_t, uint32_t> m_containerToDeviceId;
+	vr::PropertyContainerHandle_t m_hmdContainer = vr::k_ulInvalidPropertyContainer;
+
+	std::mutex _logMutex;
+};
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
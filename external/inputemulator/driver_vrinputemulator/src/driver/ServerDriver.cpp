@@ -151,6 +151,7 @@ void ServerDriver::hooksTrackedDeviceActivated(void* serverDriver, int version,
 		auto container = vr::VRPropertiesRaw()->TrackedDeviceToPropertyContainer(unObjectId);
 		handle->setPropertyContainer(container);
 		_propertyContainerToDeviceManipulationHandleMap[container] = handle.get();
+		_propertyOverrides.deviceActivated(container, unObjectId);
 
 		LOG(INFO) << "Successfully added device " << handle->serialNumber() << " (OpenVR Id: " << handle->openvrId() << ")";
 	}
@@ -204,38 +205,7 @@ void ServerDriver::hooksPropertiesReadPropertyBatch(void* properties, int versio
 
 void ServerDriver::hooksPropertiesWritePropertyBatch(void* properties, int version, vr::PropertyContainerHandle_t ulContainer, void* pBatch, uint32_t unBatchEntryCount) {
 	//LOG(TRACE) << "ServerDriver::hooksPropertiesWritePropertyBatch(" << properties << ", " << (uint64_t)ulContainer << ", " << (void*)pBatch << ", " << unBatchEntryCount << ")";
-	uint32_t deviceId = vr::k_unTrackedDeviceIndexInvalid;
-	DeviceManipulationHandle* deviceHandle = nullptr;
-	auto entryIt = _propertyContainerToDeviceManipulationHandleMap.find(ulContainer);
-	if (entryIt != _propertyContainerToDeviceManipulationHandleMap.end()) {
-		deviceHandle = entryIt->second;
-		deviceId = deviceHandle->openvrId();
-	} else {
-		for (uint32_t id = 0; id < vr::k_unMaxTrackedDeviceCount; id++) {
-			auto propsContainer = vr::VRPropertiesRaw()->TrackedDeviceToPropertyContainer(id);
-			if (propsContainer == ulContainer) {
-				deviceId = id;
-				break;
-			}
-		}
-	}
-	for (uint32_t i = 0; i < unBatchEntryCount; i++) {
-		vr::PropertyWrite_t& be = ((vr::PropertyWrite_t*)pBatch)[i];
-		//LOG(TRACE) << "\tProperty "<< i << ": " << (int)be.prop << " = " << _propertyValueToString(be.pvBuffer, be.unBufferSize, be.unTag);
-		if (be.prop == vr::Prop_ManufacturerName_String && !_propertiesOverrideHmdManufacturer.empty()) {
-			LOG(INFO) << "Overwriting Device Manufacturer: " << be.pvBuffer << " => " << _propertiesOverrideHmdManufacturer;
-			be.pvBuffer = (void*)_propertiesOverrideHmdManufacturer.c_str();
-			be.unBufferSize = (uint32_t)_propertiesOverrideHmdManufacturer.size() + 1;
-		} else if (deviceId == vr::k_unTrackedDeviceIndex_Hmd && be.prop == vr::Prop_ModelNumber_String && !_propertiesOverrideHmdModel.empty()) {
-			LOG(INFO) << "Overwriting Hmd Model: " << be.pvBuffer << " => " << _propertiesOverrideHmdModel;
-			be.pvBuffer = (void*)_propertiesOverrideHmdModel.c_str();
-			be.unBufferSize = (uint32_t)_propertiesOverrideHmdModel.size() + 1;
-		} else if (be.prop == vr::Prop_TrackingSystemName_String && !_propertiesOverrideHmdTrackingSystem.empty()) {
-			LOG(INFO) << "Overwriting Device TrackingSystem: " << be.pvBuffer << " => " << _propertiesOverrideHmdTrackingSystem;
-			be.pvBuffer = (void*)_propertiesOverrideHmdTrackingSystem.c_str();
-			be.unBufferSize = (uint32_t)_propertiesOverrideHmdTrackingSystem.size() + 1;
-		}
-	}
+	_propertyOverrides.apply(vr::VRPropertiesRaw(), ulContainer, (vr::PropertyWrite_t*)pBatch, unBatchEntryCount);
 }
 
 void ServerDriver::hooksCreateBooleanComponent(void * driverInput, int version, vr::PropertyContainerHandle_t ulContainer, const char * pchName, void * pHandle) {
@@ -243,8 +213,11 @@ void ServerDriver::hooksCreateBooleanComponent(void * driverInput, int version,
 	if (it != _propertyContainerToDeviceManipulationHandleMap.end()) {
 		LOG(INFO) << "Device " << it->second->serialNumber() << " has boolean input component \"" << pchName << "\"";
 		it->second->setDriverInputPtr(driverInput);
-		_inputComponentToDeviceManipulationHandleMap[*((uint64_t*)pHandle)] = it->second;
-		it->second->inputAddBooleanComponent(pchName, *((uint64_t*)pHandle));
+		InputComponentRouter::Route route;
+		route.handle = it->second;
+		route.type = InputComponentRouter::ComponentType::Boolean;
+		route.mapped = it->second->inputAddBooleanComponent(pchName, *((uint64_t*)pHandle), route.id, route.dim);
+		_addInputComponentRoute(*((uint64_t*)pHandle), route);
 	}
 }
 
@@ -254,8 +227,11 @@ void ServerDriver::hooksCreateScalarComponent(void * driverInput, int version, v
 	if (it != _propertyContainerToDeviceManipulationHandleMap.end()) {
 		LOG(INFO) << "Device " << it->second->serialNumber() << " has scalar input component \"" << pchName << "\" (type: " << (int)eType << ", units: " << (int)eUnits << ")";
 		it->second->setDriverInputPtr(driverInput);
-		_inputComponentToDeviceManipulationHandleMap[*((uint64_t*)pHandle)] = it->second;
-		it->second->inputAddScalarComponent(pchName, *((uint64_t*)pHandle), eType, eUnits);
+		InputComponentRouter::Route route;
+		route.handle = it->second;
+		route.type = InputComponentRouter::ComponentType::Scalar;
+		route.mapped = it->second->inputAddScalarComponent(pchName, *((uint64_t*)pHandle), eType, eUnits, route.id, route.dim);
+		_addInputComponentRoute(*((uint64_t*)pHandle), route);
 	}
 }
 
@@ -264,23 +240,32 @@ void ServerDriver::hooksCreateHapticComponent(void * driverInput, int version, v
 	if (it != _propertyContainerToDeviceManipulationHandleMap.end()) {
 	LOG(INFO) << "Device " << it->second->serialNumber() << " has haptic input component \"" << pchName << "\"";
 		it->second->setDriverInputPtr(driverInput);
-		_inputComponentToDeviceManipulationHandleMap[*((uint64_t*)pHandle)] = it->second;
+		InputComponentRouter::Route route;
+		route.handle = it->second;
+		route.type = InputComponentRouter::ComponentType::Haptic;
 		it->second->inputAddHapticComponent(pchName, *((uint64_t*)pHandle));
+		_addInputComponentRoute(*((uint64_t*)pHandle), route);
+	}
+}
+
+void ServerDriver::_addInputComponentRoute(vr::VRInputComponentHandle_t component, const InputComponentRouter::Route& route) {
+	if (_inputComponentRouter.add(component, route) == InputComponentRouter::invalidSlot) {
+		LOG(ERROR) << "Could not route input component " << component << ": more than " << InputComponentRouter::maxComponents << " components";
 	}
 }
 
 bool ServerDriver::hooksUpdateBooleanComponent(void* driverInput, int version, vr::VRInputComponentHandle_t& ulComponent, bool& bNewValue, double& fTimeOffset) {
-	auto it = _inputComponentToDeviceManipulationHandleMap.find(ulComponent);
-	if (it != _inputComponentToDeviceManipulationHandleMap.end()) {
-		return it->second->handleBooleanComponentUpdate(ulComponent, bNewValue, fTimeOffset);
+	auto route = _inputComponentRouter.find(ulComponent);
+	if (route && route->mapped && route->type == InputComponentRouter::ComponentType::Boolean) {
+		return route->handle->handleBooleanComponentUpdate(ulComponent, (vr::EVRButtonId)route->id, route->dim, bNewValue, fTimeOffset);
 	}
 	return true;
 }
 
 bool ServerDriver::hooksUpdateScalarComponent(void* driverInput, int version, vr::VRInputComponentHandle_t& ulComponent, float& fNewValue, double& fTimeOffset) {
-	auto it = _inputComponentToDeviceManipulationHandleMap.find(ulComponent);
-	if (it != _inputComponentToDeviceManipulationHandleMap.end()) {
-		return it->second->handleScalarComponentUpdate(ulComponent, fNewValue, fTimeOffset);
+	auto route = _inputComponentRouter.find(ulComponent);
+	if (route && route->mapped && route->type == InputComponentRouter::ComponentType::Scalar) {
+		return route->handle->handleScalarComponentUpdate(ulComponent, route->id, route->dim, fNewValue, fTimeOffset);
 	}
 	return true;
 }
@@ -315,18 +300,18 @@ vr::EVRInitError ServerDriver::Init(vr::IVRDriverContext *pDriverContext) {
 	vr::EVRSettingsError peError;
 	vr::VRSettings()->GetString(vrsettings_SectionName, vrsettings_overrideHmdManufacturer_string, buffer, vr::k_unMaxPropertyStringSize, &peError);
 	if (peError == vr::VRSettingsError_None) {
-		_propertiesOverrideHmdManufacturer = buffer;
-		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdManufacturer_string << " = " << _propertiesOverrideHmdManufacturer;
+		_propertyOverrides.addStringOverride(vr::Prop_ManufacturerName_String, buffer, PropertyOverrides::DeviceFilter::AnyDevice, "Device Manufacturer");
+		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdManufacturer_string << " = " << buffer;
 	}
 	vr::VRSettings()->GetString(vrsettings_SectionName, vrsettings_overrideHmdModel_string, buffer, vr::k_unMaxPropertyStringSize, &peError);
 	if (peError == vr::VRSettingsError_None) {
-		_propertiesOverrideHmdModel = buffer;
-		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdModel_string << " = " << _propertiesOverrideHmdModel;
+		_propertyOverrides.addStringOverride(vr::Prop_ModelNumber_String, buffer, PropertyOverrides::DeviceFilter::HmdOnly, "Hmd Model");
+		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdModel_string << " = " << buffer;
 	}
 	vr::VRSettings()->GetString(vrsettings_SectionName, vrsettings_overrideHmdTrackingSystem_string, buffer, vr::k_unMaxPropertyStringSize, &peError);
 	if (peError == vr::VRSettingsError_None) {
-		_propertiesOverrideHmdTrackingSystem = buffer;
-		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdTrackingSystem_string << " = " << _propertiesOverrideHmdTrackingSystem;
+		_propertyOverrides.addStringOverride(vr::Prop_TrackingSystemName_String, buffer, PropertyOverrides::DeviceFilter::AnyDevice, "Device TrackingSystem");
+		LOG(INFO) << vrsettings_SectionName << "::" << vrsettings_overrideHmdTrackingSystem_string << " = " << buffer;
 	}
 	auto boolVal = vr::VRSettings()->GetBool(vrsettings_SectionName, vrsettings_genericTrackerFakeController_bool, &peError);
 	if (peError == vr::VRSettingsError_None) {
@@ -357,9 +342,7 @@ void ServerDriver::RunFrame() {
 			vd->sendPoseUpdate();
 		}
 	}
-	for (auto d : _deviceManipulationHandles) {
-		d.second->RunFrame();
-	}
+	m_inputTimers.advance();
 	m_motionCompensation.runFrame();
 }
 
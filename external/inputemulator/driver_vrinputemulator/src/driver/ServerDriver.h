@@ -10,6 +10,9 @@
 #include "../logging.h"
 #include "../com/shm/driver_ipc_shm.h"
 #include "../devicemanipulation/MotionCompensationManager.h"
+#include "../devicemanipulation/utils/TimerWheel.h"
+#include "PropertyOverrides.h"
+#include "InputComponentRouter.h"
 
 
 
@@ -109,6 +112,9 @@ public:
 	MotionCompensationManager& motionCompensation() { return m_motionCompensation; }
 	void sendReplySetMotionCompensationMode(bool success);
 
+	/* Long press, double press, toggle and auto trigger timeouts of the input remapping, advanced every frame */
+	TimerWheel<>& inputTimers() { return m_inputTimers; }
+
 	//// function hooks related ////
 	void hooksTrackedDeviceAdded(void* serverDriverHost, int version, const char *pchDeviceSerialNumber, vr::ETrackedDeviceClass& eDeviceClass, void* pDriver);
 	void hooksTrackedDeviceActivated(void* serverDriver, int version, uint32_t unObjectId);
@@ -156,11 +162,15 @@ private:
 	DeviceManipulationHandle* _openvrIdToDeviceManipulationHandleMap[vr::k_unMaxTrackedDeviceCount];
 	std::map<vr::PropertyContainerHandle_t, DeviceManipulationHandle*> _propertyContainerToDeviceManipulationHandleMap;
 	std::map<void*, DeviceManipulationHandle*> _ptrToDeviceManipulationHandleMap;
-	std::map<uint64_t, DeviceManipulationHandle*> _inputComponentToDeviceManipulationHandleMap;
+	InputComponentRouter _inputComponentRouter;
+	void _addInputComponentRoute(vr::VRInputComponentHandle_t component, const InputComponentRouter::Route& route);
 
 	//// motion compensation related ////
 	MotionCompensationManager m_motionCompensation;
 
+	//// input remapping related ////
+	TimerWheel<> m_inputTimers;
+
 	//// function hooks related ////
 	std::shared_ptr<InterfaceHooks> _driverContextHooks;
 
@@ -169,9 +179,7 @@ private:
 	std::map<void*, std::queue<std::pair<std::shared_ptr<void>, uint32_t>>> m_eventsToInjectQueues;
 
 	// Device Property Overrides
-	std::string _propertiesOverrideHmdManufacturer;
-	std::string _propertiesOverrideHmdModel;
-	std::string _propertiesOverrideHmdTrackingSystem;
+	PropertyOverrides _propertyOverrides;
 	bool _propertiesOverrideGenericTrackerFakeController;
 };
 
@@ -7,13 +7,18 @@ namespace vrinputemulator {
 namespace driver {
 
 
+static vr::DriverPose_t _initialPose() {
+	vr::DriverPose_t pose;
+	memset(&pose, 0, sizeof(vr::DriverPose_t));
+	pose.qDriverFromHeadRotation.w = 1;
+	pose.qWorldFromDriverRotation.w = 1;
+	pose.qRotation.w = 1;
+	pose.result = vr::ETrackingResult::TrackingResult_Uninitialized;
+	return pose;
+}
+
 VirtualDeviceDriver::VirtualDeviceDriver(ServerDriver* parent, VirtualDeviceType type, const std::string& serial, uint32_t virtualId)
-		: m_serverDriver(parent), m_deviceType(type), m_serialNumber(serial), m_virtualDeviceId(virtualId) {
-	memset(&m_pose, 0, sizeof(vr::DriverPose_t));
-	m_pose.qDriverFromHeadRotation.w = 1;
-	m_pose.qWorldFromDriverRotation.w = 1;
-	m_pose.qRotation.w = 1;
-	m_pose.result = vr::ETrackingResult::TrackingResult_Uninitialized;
+		: m_serverDriver(parent), m_deviceType(type), m_serialNumber(serial), m_virtualDeviceId(virtualId), m_pose(_initialPose()) {
 	memset(&m_ControllerState, 0, sizeof(vr::VRControllerState_t));
 }
 
@@ -52,31 +57,34 @@ void * VirtualDeviceDriver::GetComponent(const char * pchComponentNameAndVersion
 }
 
 
+// The pose functions run for every pose of every virtual device, so they neither lock nor log
+
 vr::DriverPose_t VirtualDeviceDriver::GetPose() {
-	LOG(TRACE) << "VirtualDeviceDriver[" << m_serialNumber << "]::GetPose()";
-	return m_pose;
+	return m_pose.load();
 }
 
 
 void VirtualDeviceDriver::updatePose(const vr::DriverPose_t & newPose, double timeOffset, bool notify) {
-	LOG(TRACE) << "VirtualDeviceDriver[" << m_serialNumber << "]::updatePose( " << timeOffset << " )";
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	m_pose = newPose;
-	m_pose.poseTimeOffset += timeOffset;
-	if (notify && m_openvrId != vr::k_unTrackedDeviceIndexInvalid) {
-		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_openvrId, m_pose, sizeof(vr::DriverPose_t));
-	}
+	uint32_t openvrId = m_openvrId;
+	bool submitNow = notify && openvrId != vr::k_unTrackedDeviceIndexInvalid;
+	vr::DriverPose_t pose = newPose;
+	pose.poseTimeOffset += timeOffset;
+	m_pose.update(pose, submitNow, [openvrId](const vr::DriverPose_t& submitted) {
+		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(openvrId, submitted, sizeof(vr::DriverPose_t));
+	});
 }
 
 void VirtualDeviceDriver::sendPoseUpdate(double timeOffset, bool onlyWhenConnected) {
-	LOG(TRACE) << "VirtualDeviceDriver[" << m_serialNumber << "]::sendPoseUpdate( " << timeOffset << " )";
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	if (!onlyWhenConnected || (m_pose.poseIsValid && m_pose.deviceIsConnected)) {
-		m_pose.poseTimeOffset = timeOffset;
-		if (m_openvrId != vr::k_unTrackedDeviceIndexInvalid) {
-			vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_openvrId, m_pose, sizeof(vr::DriverPose_t));
-		}
+	uint32_t openvrId = m_openvrId;
+	if (openvrId == vr::k_unTrackedDeviceIndexInvalid) {
+		return;
 	}
+	m_pose.submitForFrame([openvrId, timeOffset, onlyWhenConnected](vr::DriverPose_t pose) {
+		if (!onlyWhenConnected || (pose.poseIsValid && pose.deviceIsConnected)) {
+			pose.poseTimeOffset = timeOffset;
+			vr::VRServerDriverHost()->TrackedDevicePoseUpdated(openvrId, pose, sizeof(vr::DriverPose_t));
+		}
+	});
 }
 
 void VirtualDeviceDriver::publish() {
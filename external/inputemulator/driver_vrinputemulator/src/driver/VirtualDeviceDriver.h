@@ -1,10 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <openvr_driver.h>
 #include <vrinputemulator_types.h>
 #include "utils/DevicePropertyValueVisitor.h"
+#include "utils/PoseSlot.h"
 
 
 
@@ -30,12 +32,12 @@ protected:
 	VirtualDeviceType m_deviceType;
 	std::string m_serialNumber;
 	uint32_t m_virtualDeviceId;
-	uint32_t m_openvrId = vr::k_unTrackedDeviceIndexInvalid;
+	std::atomic<uint32_t> m_openvrId { vr::k_unTrackedDeviceIndexInvalid };
 	bool m_published = false;
 	bool m_periodicPoseUpdates = true;
 	vr::PropertyContainerHandle_t m_propertyContainer = vr::k_ulInvalidPropertyContainer;
 
-	vr::DriverPose_t m_pose;
+	PoseSlot m_pose; // not guarded by _mutex, see PoseSlot
 	typedef boost::variant<int32_t, uint64_t, float, bool, std::string, vr::HmdMatrix34_t, vr::HmdMatrix44_t, vr::HmdVector3_t, vr::HmdVector4_t> _devicePropertyType_t;
 	std::map<int, _devicePropertyType_t> _deviceProperties;
 
@@ -69,12 +71,14 @@ public:
 	uint32_t openvrDeviceId() { return m_openvrId; }
 	uint32_t virtualDeviceId() { return m_virtualDeviceId; }
 
-	vr::DriverPose_t& driverPose() { return m_pose; }
+	vr::DriverPose_t driverPose() const { return m_pose.load(); }
 
 	bool enablePeriodicPoseUpdates(bool enabled) { return m_periodicPoseUpdates; }
 	void publish();
 
+	// Called from the IPC thread only, notify submits the pose right away instead of with the next frame
 	void updatePose(const vr::DriverPose_t& newPose, double timeOffset, bool notify = true);
+	// Called once per frame, skips the pose when updatePose submitted it since the last frame
 	void sendPoseUpdate(double timeOffset = 0.0, bool onlyWhenConnected = true);
 
 	template<class T>
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <openvr_driver.h>
+
+
+namespace vrinputemulator {
+namespace driver {
+
+
+/**
+* Latest pose of a virtual device, written by one thread (the IPC thread) and read by any number of others
+* (SteamVR's GetPose, the frame thread) without a lock.
+*
+* The pose is kept twice under a sequence counter: while the writer fills one copy readers take the other,
+* so a reader only has to copy again when two writes happened during its copy. The copies are made of
+* relaxed atomic words, which keeps a reader racing with the writer well-defined and costs plain moves on x86.
+*
+* The slot also remembers whether the writer submitted the pose itself. The frame thread submits the held pose
+* every frame, except right after the writer did, so a device fed at frame rate is not sent everything twice.
+*/
+class PoseSlot {
+public:
+	explicit PoseSlot(const vr::DriverPose_t& initial) {
+		_write(0, initial);
+		_write(1, initial);
+	}
+
+	PoseSlot(const PoseSlot&) = delete;
+	PoseSlot& operator=(const PoseSlot&) = delete;
+
+	/** Only ever call from one thread at a time. With submitNow the pose goes to submit right away, else with the next frame. */
+	template <typename Submit>
+	void update(const vr::DriverPose_t& pose, bool submitNow, Submit submit) {
+		store(pose);
+		m_state.store(submitNow ? State::Submitted : State::Pending, std::memory_order_release);
+		if (submitNow) {
+			submit(pose);
+		}
+	}
+
+	/** Once per frame, from one thread: submits the held pose unless update submitted one since the last frame */
+	template <typename Submit>
+	void submitForFrame(Submit submit) {
+		if (m_state.exchange(State::Held, std::memory_order_acq_rel) != State::Submitted) {
+			submit(load());
+		}
+	}
+
+	/** Only ever call from one thread at a time, the pose is not submitted */
+	void store(const vr::DriverPose_t& pose) {
+		uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, std::memory_order_relaxed); // readers switch to copy 1
+		std::atomic_thread_fence(std::memory_order_release);
+		_write(0, pose);
+		m_sequence.store(sequence + 2, std::memory_order_release); // and back to copy 0
+		_write(1, pose);
+	}
+
+	vr::DriverPose_t load() const {
+		vr::DriverPose_t pose;
+		uint32_t sequence;
+		do {
+			sequence = m_sequence.load(std::memory_order_acquire);
+			_read(sequence & 1, pose);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while (m_sequence.load(std::memory_order_relaxed) != sequence);
+		return pose;
+	}
+
+private:
+	enum class State : uint8_t {
+		Held,      // already went out, the frame thread sends it again
+		Pending,   // stored without submitting, the next frame sends it
+		Submitted  // the writer sent it, the next frame skips it
+	};
+
+	static constexpr size_t wordCount = (sizeof(vr::DriverPose_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	void _write(int copy, const vr::DriverPose_t& pose) {
+		uint64_t words[wordCount] = {};
+		std::memcpy(words, &pose, sizeof(vr::DriverPose_t));
+		for (size_t i = 0; i < wordCount; i++) {
+			m_copies[copy][i].store(words[i], std::memory_order_relaxed);
+		}
+	}
+
+	void _read(int copy, vr::DriverPose_t& pose) const {
+		uint64_t words[wordCount];
+		for (size_t i = 0; i < wordCount; i++) {
+			words[i] = m_copies[copy][i].load(std::memory_order_relaxed);
+		}
+		std::memcpy(&pose, words, sizeof(vr::DriverPose_t));
+	}
+
+	std::atomic<uint32_t> m_sequence { 0 };
+	std::atomic<State> m_state { State::Held };
+	std::atomic<uint64_t> m_copies[2][wordCount];
+};
+
+
+} // end namespace driver
+} // end namespace vrinputemulator
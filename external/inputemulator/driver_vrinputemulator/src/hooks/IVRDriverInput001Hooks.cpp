@@ -62,7 +62,7 @@ vr::EVRInputError IVRDriverInput001Hooks::_createBooleanComponent(void* _this, v
 }
 
 vr::EVRInputError IVRDriverInput001Hooks::_updateBooleanComponent(void* _this, vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) {
-	LOG(TRACE) << "IVRDriverInput001Hooks::_updateBooleanComponent(" << _this << ", " << ulComponent << ", " << bNewValue << ", " << fTimeOffset << ")";
+	LOG_HOT_PATH(TRACE) << "IVRDriverInput001Hooks::_updateBooleanComponent(" << _this << ", " << ulComponent << ", " << bNewValue << ", " << fTimeOffset << ")";
 	if (serverDriver->hooksUpdateBooleanComponent(_this, 1, ulComponent, bNewValue, fTimeOffset)) {
 		return updateBooleanComponentHook.origFunc(_this, ulComponent, bNewValue, fTimeOffset);
 	}
@@ -79,7 +79,7 @@ vr::EVRInputError IVRDriverInput001Hooks::_createScalarComponent(void* _this, vr
 }
 
 vr::EVRInputError IVRDriverInput001Hooks::_updateScalarComponent(void* _this, vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) {
-	LOG(TRACE) << "IVRDriverInput001Hooks::_updateScalarComponent(" << _this << ", " << ulComponent << ", " << fNewValue << ", " << fTimeOffset << ")";
+	LOG_HOT_PATH(TRACE) << "IVRDriverInput001Hooks::_updateScalarComponent(" << _this << ", " << ulComponent << ", " << fNewValue << ", " << fTimeOffset << ")";
 	if (serverDriver->hooksUpdateScalarComponent(_this, 1, ulComponent, fNewValue, fTimeOffset)) {
 		return updateScalarComponentHook.origFunc(_this, ulComponent, fNewValue, fTimeOffset);
 	}
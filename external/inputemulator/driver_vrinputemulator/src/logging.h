@@ -12,3 +12,11 @@
 #define ELPP_NO_DEFAULT_LOG_FILE
 #include <easylogging++.h>
 #endif
+
+#include <atomic>
+
+// Hooks that run for every input update check this before building a log line at all,
+// a relaxed load is much cheaper than easylogging looking up its logger on each call.
+// init_logging() sets it when trace or debug logging is enabled in the configuration.
+extern std::atomic<bool> g_hotPathLogging;
+#define LOG_HOT_PATH(LEVEL) if (!g_hotPathLogging.load(std::memory_order_relaxed)) {} else LOG(LEVEL)
@@ -55,7 +55,10 @@ enum class RequestType : uint32_t {
 	InputRemapping_GetDigitalRemapping,
 	InputRemapping_SetAnalogRemapping,
 	InputRemapping_GetAnalogRemapping,
-	InputRemapping_SetTouchpadEmulationFixEnabled
+	InputRemapping_SetTouchpadEmulationFixEnabled,
+
+	// Appended so the values above stay those of protocol version 3, older drivers log it as unknown and ignore it
+	DeviceManipulation_SetPoseFilterTuning
 };
 
 
@@ -299,6 +302,14 @@ struct Request_DeviceManipulation_SetMotionCompensationProperties {
 	unsigned movingAverageWindow;
 };
 
+struct Request_DeviceManipulation_SetPoseFilterTuning {
+	uint32_t clientId;
+	uint32_t messageId; // Used to associate with Reply
+	uint32_t deviceId;
+	bool useDefaultTuning; // tuning is ignored, device follows the motion compensation properties again
+	PoseFilterTuning tuning;
+};
+
 struct Request_InputRemapping_SetDigitalRemapping {
 	uint32_t clientId;
 	uint32_t messageId; // Used to associate with Reply
@@ -373,6 +384,7 @@ struct Request {
 		Request_DeviceManipulation_MotionCompensationMode dm_MotionCompensationMode;
 		Request_DeviceManipulation_TriggerHapticPulse dm_triggerHapticPulse;
 		Request_DeviceManipulation_SetMotionCompensationProperties dm_SetMotionCompensationProperties;
+		Request_DeviceManipulation_SetPoseFilterTuning dm_SetPoseFilterTuning;
 		Request_InputRemapping_SetDigitalRemapping ir_SetDigitalRemapping;
 		Request_InputRemapping_GetDigitalRemapping ir_GetDigitalRemapping;
 		Request_InputRemapping_SetAnalogRemapping ir_SetAnalogRemapping;
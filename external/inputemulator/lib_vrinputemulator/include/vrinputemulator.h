@@ -190,6 +190,9 @@ public:
 	void setMotionCompensationKalmanProcessNoise(double variance, bool modal = true);
 	void setMotionCompensationKalmanObservationNoise(double variance, bool modal = true);
 	void setMotionCompensationMovingAverageWindow(unsigned window, bool modal = true);
+	// Drivers built before the pose filter never reply to these, only wait (modal) on ones that know it
+	void setDevicePoseFilterTuning(uint32_t deviceId, const PoseFilterTuning& tuning, bool modal = true);
+	void resetDevicePoseFilterTuning(uint32_t deviceId, bool modal = true);
 
 	void triggerHapticPulse(uint32_t deviceId, uint32_t axisId, uint16_t durationMicroseconds, bool directMode, bool modal = true);
 
@@ -208,6 +211,8 @@ private:
 	std::thread _ipcThread;
 	static void _ipcThreadFunc(VRInputEmulator* _this);
 
+	void _setDevicePoseFilterTuning(uint32_t deviceId, bool useDefault, const PoseFilterTuning& tuning, bool modal);
+
 	std::random_device _ipcRandomDevice;
 	std::uniform_int_distribution<uint32_t> _ipcRandomDist;
 	struct _ipcPromiseMapEntry {
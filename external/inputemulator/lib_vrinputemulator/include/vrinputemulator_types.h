@@ -67,7 +67,17 @@ namespace vrinputemulator {
 		SetZero = 1,
 		SubstractMotionRef = 2,
 		LinearApproximation = 3,
-		KalmanFilter = 4
+		KalmanFilter = 4,
+		PoseKalmanFilter = 5 // position and rotation, gives linear and angular velocity
+	};
+
+
+	// Noise variances of the pose Kalman filter, either the default for all devices or a device's own
+	struct PoseFilterTuning {
+		double positionProcessNoise = 0.1;
+		double positionObservationNoise = 0.1;
+		double rotationProcessNoise = 10.0; // angular acceleration variance, (rad/s^2)^2
+		double rotationObservationNoise = 0.00001; // rad^2
 	};
 
 
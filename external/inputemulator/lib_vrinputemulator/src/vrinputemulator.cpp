@@ -1703,6 +1703,58 @@ void VRInputEmulator::setMotionCompensationMovingAverageWindow(unsigned window,
 	}
 }
 
+void VRInputEmulator::setDevicePoseFilterTuning(uint32_t deviceId, const PoseFilterTuning& tuning, bool modal) {
+	_setDevicePoseFilterTuning(deviceId, false, tuning, modal);
+}
+
+void VRInputEmulator::resetDevicePoseFilterTuning(uint32_t deviceId, bool modal) {
+	_setDevicePoseFilterTuning(deviceId, true, PoseFilterTuning(), modal);
+}
+
+void VRInputEmulator::_setDevicePoseFilterTuning(uint32_t deviceId, bool useDefault, const PoseFilterTuning& tuning, bool modal) {
+	if (_ipcServerQueue) {
+		ipc::Request message(ipc::RequestType::DeviceManipulation_SetPoseFilterTuning);
+		memset(&message.msg, 0, sizeof(message.msg));
+		message.msg.dm_SetPoseFilterTuning.clientId = m_clientId;
+		message.msg.dm_SetPoseFilterTuning.messageId = 0;
+		message.msg.dm_SetPoseFilterTuning.deviceId = deviceId;
+		message.msg.dm_SetPoseFilterTuning.useDefaultTuning = useDefault;
+		message.msg.dm_SetPoseFilterTuning.tuning = tuning;
+		if (modal) {
+			uint32_t messageId = _ipcRandomDist(_ipcRandomDevice);
+			message.msg.dm_SetPoseFilterTuning.messageId = messageId;
+			std::promise<ipc::Reply> respPromise;
+			auto respFuture = respPromise.get_future();
+			{
+				std::lock_guard<std::recursive_mutex> lock(_mutex);
+				_ipcPromiseMap.insert({ messageId, std::move(respPromise) });
+			}
+			_ipcServerQueue->send(&message, sizeof(ipc::Request), 0);
+			auto resp = respFuture.get();
+			{
+				std::lock_guard<std::recursive_mutex> lock(_mutex);
+				_ipcPromiseMap.erase(messageId);
+			}
+			std::stringstream ss;
+			ss << "Error while setting pose filter tuning: ";
+			if (resp.status == ipc::ReplyStatus::InvalidId) {
+				ss << "Invalid device id";
+				throw vrinputemulator_invalidid(ss.str(), (int)resp.status);
+			} else if (resp.status == ipc::ReplyStatus::NotFound) {
+				ss << "Device not found";
+				throw vrinputemulator_notfound(ss.str(), (int)resp.status);
+			} else if (resp.status != ipc::ReplyStatus::Ok) {
+				ss << "Error code " << (int)resp.status;
+				throw vrinputemulator_exception(ss.str(), (int)resp.status);
+			}
+		} else {
+			_ipcServerQueue->send(&message, sizeof(ipc::Request), 0);
+		}
+	} else {
+		throw vrinputemulator_connectionerror("No active connection.");
+	}
+}
+
 
 void VRInputEmulator::triggerHapticPulse(uint32_t deviceId, uint32_t axisId, uint16_t durationMicroseconds, bool directMode, bool modal) {
 	if (_ipcServerQueue) {
@@ -0,0 +1,145 @@
+// Checks that AsyncLog copies wide strings on the calling thread, keeps long writeText lines whole
+// (or marks where they were cut), and that a log from an idle process still gets written promptly.
+// Then measures what a log costs the calling thread, against writing the same line synchronously
+// with fprintf and fflush like the driver's log sink does
+//
+// g++ -std=c++17 -O2 -pthread -ISFMLProject/inc tests/AsyncLogTest.cpp -o AsyncLogTest
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncLog.h"
+
+namespace
+{
+	std::mutex linesMutex;
+	std::condition_variable linesChanged;
+	std::vector<std::string> lines;
+
+	void collect(AsyncLog::Level, const char* line)
+	{
+		{
+			std::lock_guard<std::mutex> lock(linesMutex);
+			lines.push_back(line);
+		}
+		linesChanged.notify_all();
+	}
+
+	// The line that arrives next, or an empty string after the timeout
+	std::string nextLine(size_t index, std::chrono::milliseconds timeout = std::chrono::milliseconds(500))
+	{
+		std::unique_lock<std::mutex> lock(linesMutex);
+		if (!linesChanged.wait_for(lock, timeout, [index] { return lines.size() > index; }))
+			return std::string();
+		return lines[index];
+	}
+
+	bool check(bool ok, const char* what)
+	{
+		if (!ok)
+			std::printf("FAIL: %s\n", what);
+		return ok;
+	}
+
+	std::atomic<size_t> benchmarkWritten{0};
+	FILE* benchmarkFile = nullptr;
+
+	void writeToFile(AsyncLog::Level, const char* line)
+	{
+		std::fprintf(benchmarkFile, "%s\n", line);
+		std::fflush(benchmarkFile);
+		++benchmarkWritten;
+	}
+
+	// Nanoseconds per call on the logging thread. Logs in bursts that fit the thread's ring and lets the
+	// log thread drain it in between, untimed, so nothing is dropped and only the caller's cost is counted
+	double asyncNanosecondsPerLog(int bursts)
+	{
+		const size_t burst = AsyncLog::k_ringSize / 2;
+		benchmarkWritten = 0;
+		std::chrono::steady_clock::duration spent{};
+		for (int i = 0; i < bursts; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t j = 0; j < burst; j++)
+				ASYNC_LOG(AsyncLog::Level::Info, 0, "pose %d: %f %f %f", static_cast<int>(j), 0.5, -1.25, 2.0);
+			spent += std::chrono::steady_clock::now() - start;
+			while (benchmarkWritten < burst * (i + 1))
+				std::this_thread::yield();
+		}
+		return std::chrono::duration<double, std::nano>(spent).count() / (burst * bursts);
+	}
+
+	double syncNanosecondsPerLog(int count)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			std::fprintf(benchmarkFile, "pose %d: %f %f %f\n", i, 0.5, -1.25, 2.0);
+			std::fflush(benchmarkFile);
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+	}
+}
+
+int main()
+{
+	AsyncLog::start(&collect);
+	bool ok = true;
+
+	// The wide string is gone, and its memory overwritten, before the log thread formats the line
+	{
+		std::thread([]
+		{
+			std::wstring* name = new std::wstring(L"\\\\.\\pipe\\LogPipeTracker");
+			ASYNC_LOG(AsyncLog::Level::Info, 0, "Pipe %ls connected", name->c_str());
+			name->assign(name->size(), L'X');
+			delete name;
+		}).join();
+		ok &= check(nextLine(0) == "Pipe \\\\.\\pipe\\LogPipeTracker connected", "wide string argument");
+	}
+
+	// Longer than one record, shorter than a line
+	const std::string longText(700, 'a');
+	static AsyncLog::Site longSite(AsyncLog::Level::Info, 0, "%s");
+	AsyncLog::writeText(longSite, longText.c_str());
+	ok &= check(nextLine(1) == longText, "long line is kept whole");
+
+	// Longer than a line
+	const std::string tooLong(3000, 'b');
+	AsyncLog::writeText(longSite, tooLong.c_str());
+	const std::string cut = nextLine(2);
+	ok &= check(cut.size() == AsyncLog::k_lineSize - 1 && cut.compare(cut.size() - 3, 3, "...") == 0,
+	            "overlong line ends in ...");
+
+	// After sitting idle, a new line wakes the log thread
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	const auto logged = std::chrono::steady_clock::now();
+	ASYNC_LOG(AsyncLog::Level::Info, 0, "after idle %d", 1);
+	ok &= check(nextLine(3) == "after idle 1", "line logged after idling");
+	const double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - logged).count();
+	std::printf("Idle wake-up latency: %.3fms\n", latencyMs);
+
+	AsyncLog::stop();
+
+	benchmarkFile = std::tmpfile();
+	if (check(benchmarkFile != nullptr, "temporary file for the benchmark"))
+	{
+		AsyncLog::start(&writeToFile);
+		asyncNanosecondsPerLog(10); // Warms up the ring and the file
+		const double asyncNs = asyncNanosecondsPerLog(400);
+		AsyncLog::stop();
+		const double syncNs = syncNanosecondsPerLog(100000);
+		std::fclose(benchmarkFile);
+		std::printf("Per log on the calling thread: ASYNC_LOG %.1fns, fprintf+fflush %.1fns\n", asyncNs, syncNs);
+		ok &= check(asyncNs < syncNs, "ASYNC_LOG costs the caller less than a synchronous write");
+	}
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
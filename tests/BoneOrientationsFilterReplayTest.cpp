@@ -0,0 +1,537 @@
+// Replays a recorded-like skeleton through DoubleExpBoneOrientationsFilter (KinectV2Process) and through the
+// filter as it was before its history moved into per-field arrays and its radii were worked out up front,
+// copied below. Joints wander at different speeds, drop to inferred or not tracked, lose their position and
+// report zero or NaN orientations, and every filtered orientation has to be bit for bit the same, for the
+// default rotation parameters and for each way of setting others
+//
+// g++ -std=c++17 -O2 -Itests/stubs -ISFMLProject/inc -IKinectV2Process -Iexternal/SFML/include
+//     -Iexternal/inputemulator/lib_vrinputemulator/include tests/BoneOrientationsFilterReplayTest.cpp
+//     KinectV2Process/SmoothingParameters.cpp -o BoneOrientationsFilterReplayTest
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+// MSVC's headers declare the float abs and isnan in the global namespace, which both filters call unqualified
+#include <math.h>
+
+#include "KinectDoubleExponentialRotationFilter.h"
+
+namespace
+{
+	// DoubleExpBoneOrientationsFilter before the per-field history and precomputed radii, with the helpers
+	// FilterJoint doesn't reach left out. Reset also clears filteredOrientations, which the old filter left
+	// uninitialised until the first valid frame
+	namespace Old
+	{
+		class DoubleExpBoneOrientationsFilter
+		{
+		private:
+			struct FilterDoubleExponentialData
+			{
+				Vector4 RawBoneOrientation = QuaternionIdentity;
+				Vector4 FilteredBoneOrientation = QuaternionIdentity;
+				Vector4 Trend = QuaternionIdentity;
+				unsigned int FrameCount = 0;
+			};
+
+			FilterDoubleExponentialData history[JointType_Count];
+			SmoothingParameters smoothParameters;
+			bool init;
+
+		public:
+			DoubleExpBoneOrientationsFilter()
+			{
+				init = false;
+				Init(getRotationSmoothingParams());
+			}
+
+			const Vector4* GetFilteredJoints() const { return &filteredOrientations[0]; }
+
+			void Init()
+			{
+				Init(0.5f, 0.8f, 0.75f, 0.1f, 0.1f);
+			}
+
+			void Init(float smoothingValue, float correctionValue, float predictionValue, float jitterRadiusValue,
+			          float maxDeviationRadiusValue)
+			{
+				smoothParameters = getRotationSmoothingParams();
+				smoothParameters.maxDeviationRadius = maxDeviationRadiusValue;
+				smoothParameters.smoothing = smoothingValue;
+				smoothParameters.correction = correctionValue;
+				smoothParameters.prediction = predictionValue;
+				smoothParameters.jitterRadius = jitterRadiusValue;
+				Reset();
+				init = true;
+			}
+
+			void Init(const SmoothingParameters& smoothingParameters)
+			{
+				smoothParameters = smoothingParameters;
+				Reset();
+				init = true;
+			}
+
+			void Reset()
+			{
+				for (int i = 0; i < JointType_Count; ++i)
+				{
+					FilterDoubleExponentialData d;
+					d.FilteredBoneOrientation = QuaternionIdentity;
+					d.FrameCount = 0;
+					d.RawBoneOrientation = QuaternionIdentity;
+					d.Trend = QuaternionIdentity;
+					history[i] = d;
+					filteredOrientations[i] = QuaternionIdentity;
+				}
+			}
+
+			void UpdateFilter(IBody* const pBody, JointOrientation* jointsOrientations)
+			{
+				Joint joints[JointType_Count];
+				pBody->GetJoints(JointType_Count, joints);
+
+				if (init == false)
+				{
+					Init();
+				}
+
+				SmoothingParameters tempSmoothingParams = getRotationSmoothingParams();
+
+				smoothParameters.jitterRadius = max(0.0001f, smoothParameters.jitterRadius);
+
+				tempSmoothingParams.smoothing = smoothParameters.smoothing;
+				tempSmoothingParams.correction = smoothParameters.correction;
+				tempSmoothingParams.prediction = smoothParameters.prediction;
+
+				for (int jointIndex = 0; jointIndex < JointType_Count; jointIndex++)
+				{
+					if (joints[jointIndex].TrackingState != TrackingState_Tracked ||
+						jointIndex == JointType_FootLeft || jointIndex == JointType_FootRight)
+					{
+						tempSmoothingParams.jitterRadius = smoothParameters.jitterRadius * 2.0f;
+						tempSmoothingParams.maxDeviationRadius = smoothParameters.maxDeviationRadius * 2.0f;
+					}
+					else
+					{
+						tempSmoothingParams.jitterRadius = smoothParameters.jitterRadius;
+						tempSmoothingParams.maxDeviationRadius = smoothParameters.maxDeviationRadius;
+					}
+
+					FilterJoint(joints, jointIndex, tempSmoothingParams, jointsOrientations);
+				}
+			}
+
+		private:
+			bool jointPositionIsValid(sf::Vector3f vJointPosition)
+			{
+				return (vJointPosition.x != 0.0f ||
+					vJointPosition.y != 0.0f ||
+					vJointPosition.z != 0.0f);
+			}
+
+			bool equal(const Vector4& lhs, const Vector4& rhs)
+			{
+				return
+					lhs.w == rhs.w
+					&& lhs.x == rhs.x
+					&& lhs.y == rhs.y
+					&& lhs.z == rhs.z;
+			}
+
+			float length(Vector4 v)
+			{
+				return sqrt(v.w * v.w + v.x * v.x + v.y * v.y + v.z * v.z);
+			}
+
+			Vector4 normalisedQ(Vector4 a)
+			{
+				Vector4 v = a;
+				float magnitude = pow(length(v), 2);
+				v.w /= magnitude;
+				v.x /= magnitude;
+				v.y /= magnitude;
+				v.z /= magnitude;
+				return v;
+			}
+
+			Vector4 divide(const Vector4& x, float k)
+			{
+				Vector4 q;
+				q.w = x.w / k;
+				q.x = x.x / k;
+				q.y = x.y / k;
+				q.z = x.z / k;
+				return q;
+			}
+
+			Vector4 subtract(Vector4 left, Vector4 right)
+			{
+				return Vector4{left.x - right.x, left.y - right.y, left.z - right.z, left.w - right.w};
+			}
+
+			Vector4 add(Vector4 left, Vector4 right)
+			{
+				return Vector4{left.x + right.x, left.y + right.y, left.z + right.z, left.w + right.w};
+			}
+
+			Vector4 product(Vector4 q, float k)
+			{
+				return Vector4{k * q.x, k * q.y, k * q.z, k * q.w};
+			}
+
+			Vector4 conj(const Vector4 x)
+			{
+				return {-x.x, -x.y, -x.z, x.w};
+			}
+
+			Vector4 inverse(const Vector4 x)
+			{
+				auto sq = norm_squared(x);
+				if (sq == 0.0f)
+					return QuaternionIdentity;
+				return divide(conj(x), sq);
+			}
+
+			float norm_squared(const Vector4 x) const
+			{
+				return x.w * x.w + x.x * x.x + x.y * x.y + x.z * x.z;
+			}
+
+			Vector4 RotationBetweenQuaternions(Vector4 quaternionA, Vector4 quaternionB)
+			{
+				if (equal(quaternionA, quaternionB))
+					return quaternionA;
+				Vector4 modifiedB = EnsureQuaternionNeighborhood(quaternionA, quaternionB);
+				return product(inverse(quaternionA), modifiedB);
+			}
+
+			float dot(Vector4 q1, Vector4 q2)
+			{
+				return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+			}
+
+			Vector4 EnsureQuaternionNeighborhood(Vector4 quaternionA, Vector4 quaternionB)
+			{
+				if (dot(quaternionA, quaternionB) < 0)
+				{
+					return Vector4{-quaternionB.x, -quaternionB.y, -quaternionB.z, -quaternionB.w};
+				}
+
+				return quaternionB;
+			}
+
+			float QuaternionAngle(Vector4 rotation)
+			{
+				float angle = 2.0f * acos(rotation.w);
+				return angle;
+			}
+
+			Vector4 EnhancedQuaternionSlerp(Vector4 quaternionA, Vector4 quaternionB, float amount)
+			{
+				if (equal(quaternionA, quaternionB))
+					return quaternionA;
+				Vector4 modifiedB = EnsureQuaternionNeighborhood(quaternionA, quaternionB);
+				return slerp(quaternionA, modifiedB, amount);
+			}
+
+			Vector4 slerp(const Vector4& q1, const Vector4& q2, const float t)
+			{
+				Vector4 a = normalisedQ(q1);
+				Vector4 b = normalisedQ(q2);
+
+				double dproduct = dot(a, b);
+
+				if (dproduct < 0.0f)
+				{
+					b = Vector4{-b.x, -b.y, -b.z, -b.w};
+					dproduct = -dproduct;
+				}
+				const double DOT_THRESHOLD = 0.9995;
+				if (dproduct > DOT_THRESHOLD)
+				{
+					Vector4 result = add(a, product(subtract(b, a), t));
+					result = normalisedQ(result);
+					return result;
+				}
+				double theta_0 = acos(dproduct);
+				double theta = theta_0 * t;
+
+				double s0 = cos(theta) - dproduct * sin(theta) / sin(theta_0);
+				double s1 = sin(theta) / sin(theta_0);
+
+				return (add(product(a, s0), product(b, s1)));
+			}
+
+			bool isTrackedOrInferred(Joint joints[], int index)
+			{
+				return (joints[index].TrackingState == TrackingState_Inferred || joints[index].TrackingState ==
+					TrackingState_Tracked);
+			}
+
+			bool rotationIsValid(Vector4 q)
+			{
+				return !(isnan(q.x) || isnan(q.y) || isnan(q.z) || isnan(q.w));
+			}
+
+			void FilterJoint(Joint* joints, int jointIndex, SmoothingParameters& params, JointOrientation* jointOrientations)
+			{
+				Vector4 filteredOrientation{};
+				Vector4 trend{};
+
+				Vector4 rawOrientation = jointOrientations[jointIndex].Orientation;
+				if (equal(rawOrientation, {0, 0, 0, 0}))
+					rawOrientation = QuaternionIdentity;
+
+				Vector4 prevFilteredOrientation = history[jointIndex].FilteredBoneOrientation;
+				Vector4 prevTrend = history[jointIndex].Trend;
+				sf::Vector3f rawPosition = {
+					joints[jointIndex].Position.X, joints[jointIndex].Position.Y, joints[jointIndex].Position.Z
+				};
+				bool orientationIsValid = jointPositionIsValid(rawPosition) && isTrackedOrInferred(joints, jointIndex) &&
+					rotationIsValid(rawOrientation);
+
+				if (!orientationIsValid)
+				{
+					if (history[jointIndex].FrameCount > 0)
+					{
+						rawOrientation = history[jointIndex].FilteredBoneOrientation;
+						history[jointIndex].FrameCount = 0;
+					}
+				}
+
+				if (history[jointIndex].FrameCount == 0)
+				{
+					filteredOrientation = rawOrientation;
+					trend = QuaternionIdentity;
+				}
+				else if (history[jointIndex].FrameCount == 1)
+				{
+					Vector4 prevRawOrientation = history[jointIndex].RawBoneOrientation;
+					filteredOrientation = EnhancedQuaternionSlerp(prevRawOrientation, rawOrientation, 0.5f);
+
+					Vector4 diffStarted = RotationBetweenQuaternions(filteredOrientation, prevFilteredOrientation);
+					trend = EnhancedQuaternionSlerp(prevTrend, diffStarted, params.correction);
+				}
+				else
+				{
+					Vector4 diffJitter = RotationBetweenQuaternions(rawOrientation, prevFilteredOrientation);
+
+					float diffValJitter = abs(QuaternionAngle(diffJitter));
+
+					if (diffValJitter <= params.jitterRadius)
+					{
+						filteredOrientation = EnhancedQuaternionSlerp(prevFilteredOrientation, rawOrientation,
+						                                              diffValJitter / params.jitterRadius);
+					}
+					else
+					{
+						filteredOrientation = rawOrientation;
+					}
+
+					filteredOrientation = EnhancedQuaternionSlerp(filteredOrientation,
+					                                              product(prevFilteredOrientation, prevTrend),
+					                                              params.smoothing);
+
+					diffJitter = RotationBetweenQuaternions(filteredOrientation, prevFilteredOrientation);
+
+					trend = EnhancedQuaternionSlerp(prevTrend, diffJitter, params.correction);
+				}
+
+				Vector4 predictedOrientation = product(filteredOrientation,
+				                                       EnhancedQuaternionSlerp(QuaternionIdentity, trend, params.prediction));
+
+				Vector4 diff = RotationBetweenQuaternions(predictedOrientation, filteredOrientation);
+				float diffVal = abs(QuaternionAngle(diff));
+
+				if (diffVal > params.maxDeviationRadius)
+				{
+					predictedOrientation = EnhancedQuaternionSlerp(filteredOrientation, predictedOrientation,
+					                                               params.maxDeviationRadius / diffVal);
+				}
+
+				history[jointIndex].RawBoneOrientation = rawOrientation;
+				history[jointIndex].FilteredBoneOrientation = filteredOrientation;
+				history[jointIndex].Trend = trend;
+				history[jointIndex].FrameCount++;
+
+				if (rotationIsValid(predictedOrientation))
+				{
+					filteredOrientations[jointIndex] = predictedOrientation;
+				}
+			}
+
+			Vector4 product(const Vector4& lhs, const Vector4& rhs)
+			{
+				return {
+					(lhs.w * rhs.x) + (lhs.x * rhs.w) + (lhs.y * rhs.z) - (lhs.z * rhs.y),
+					(lhs.w * rhs.y) + (lhs.y * rhs.w) + (lhs.z * rhs.x) - (lhs.x * rhs.z),
+					(lhs.w * rhs.z) + (lhs.z * rhs.w) + (lhs.x * rhs.y) - (lhs.y * rhs.x),
+					(lhs.w * rhs.w) - (lhs.x * rhs.x) - (lhs.y * rhs.y) - (lhs.z * rhs.z)
+				};
+			}
+
+			Vector4 filteredOrientations[JointType_Count];
+		};
+	}
+
+	Vector4 normalised(Vector4 q)
+	{
+		const float l = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		return {q.x / l, q.y / l, q.z / l, q.w / l};
+	}
+
+	// A body whose joints each turn a little further every frame, the hands and feet faster than the spine,
+	// with the tracking glitches the sensor produces now and then
+	struct Recording
+	{
+		std::mt19937 rng;
+		std::normal_distribution<float> step{0, 1};
+		std::uniform_real_distribution<float> glitch{0, 1};
+		IBody body;
+		Vector4 rotations[JointType_Count];
+		JointOrientation orientations[JointType_Count];
+
+		explicit Recording(unsigned seed) : rng(seed)
+		{
+			for (int j = 0; j < JointType_Count; j++)
+			{
+				rotations[j] = {0, 0, 0, 1};
+				body.joints[j].JointType = static_cast<JointType>(j);
+				orientations[j].JointType = static_cast<JointType>(j);
+			}
+		}
+
+		void nextFrame()
+		{
+			for (int j = 0; j < JointType_Count; j++)
+			{
+				const float speed = j % 3 == 0 ? 0.4f : 0.02f;
+				const Vector4 turn = normalised({step(rng) * speed, step(rng) * speed, step(rng) * speed, 1});
+				rotations[j] = normalised(KMath::Quat::multiply(rotations[j], turn));
+
+				const float r = glitch(rng);
+				body.joints[j].TrackingState = r < 0.02f
+					                               ? TrackingState_NotTracked
+					                               : r < 0.1f
+					                               ? TrackingState_Inferred
+					                               : TrackingState_Tracked;
+				body.joints[j].Position = {r < 0.01f ? 0.f : 0.5f, 1, 2};
+				orientations[j].Orientation = r > 0.998f
+					                              ? Vector4{NAN, 0, 0, 1}
+					                              : r > 0.995f
+					                              ? Vector4{0, 0, 0, 0}
+					                              : rotations[j];
+			}
+		}
+	};
+
+	struct Replay
+	{
+		long frames = 0;
+		long mismatches = 0;
+	};
+
+	// Runs both filters over the same frames and counts joints whose filtered orientations differ in any bit.
+	// The current filter gets the body and the joints already taken from it on alternate frames
+	Replay replay(Old::DoubleExpBoneOrientationsFilter& oldFilter, DoubleExpBoneOrientationsFilter& filter, unsigned seed,
+	              int frames)
+	{
+		Recording recording(seed);
+		Replay result;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			recording.nextFrame();
+			oldFilter.UpdateFilter(&recording.body, recording.orientations);
+			if (frame % 2)
+				filter.UpdateFilter(&recording.body, recording.orientations);
+			else
+				filter.UpdateFilter(recording.body.joints, recording.orientations);
+
+			for (int j = 0; j < JointType_Count; j++)
+			{
+				if (std::memcmp(&oldFilter.GetFilteredJoints()[j], &filter.GetFilteredJoints()[j], sizeof(Vector4)) != 0)
+					result.mismatches++;
+			}
+			result.frames++;
+		}
+		return result;
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool expectIdentical(const Replay& result, const char* what)
+	{
+		std::printf("%s: %ld frames, %ld joints differ\n", what, result.frames, result.mismatches);
+		return expect(result.mismatches == 0, what);
+	}
+
+	bool testRotationParams()
+	{
+		Old::DoubleExpBoneOrientationsFilter oldFilter;
+		DoubleExpBoneOrientationsFilter filter;
+		return expectIdentical(replay(oldFilter, filter, 7, 50000), "the default rotation parameters");
+	}
+
+	bool testOtherParams()
+	{
+		bool ok = true;
+		{
+			Old::DoubleExpBoneOrientationsFilter oldFilter;
+			DoubleExpBoneOrientationsFilter filter;
+			oldFilter.Init();
+			filter.Init();
+			ok &= expectIdentical(replay(oldFilter, filter, 8, 20000), "the defaults of Init()");
+		}
+		{
+			Old::DoubleExpBoneOrientationsFilter oldFilter;
+			DoubleExpBoneOrientationsFilter filter;
+			oldFilter.Init(0.3f, 0.6f, 0.1f, 0.05f, 0.2f);
+			filter.Init(0.3f, 0.6f, 0.1f, 0.05f, 0.2f);
+			ok &= expectIdentical(replay(oldFilter, filter, 9, 20000), "Init with each parameter");
+		}
+		{
+			Old::DoubleExpBoneOrientationsFilter oldFilter;
+			DoubleExpBoneOrientationsFilter filter;
+			oldFilter.Init(getAggressiveSmoothingParams());
+			filter.Init(getAggressiveSmoothingParams());
+			ok &= expectIdentical(replay(oldFilter, filter, 10, 20000), "Init with a SmoothingParameters");
+		}
+		{
+			// A jitter radius of zero is raised to the 0.1mm epsilon
+			SmoothingParameters params = getDefaultSmoothingParams();
+			params.jitterRadius = 0;
+			Old::DoubleExpBoneOrientationsFilter oldFilter;
+			DoubleExpBoneOrientationsFilter filter;
+			oldFilter.Init(params);
+			filter.Init(params);
+			ok &= expectIdentical(replay(oldFilter, filter, 11, 20000), "a zero jitter radius");
+		}
+		return ok;
+	}
+
+	bool testReset()
+	{
+		Old::DoubleExpBoneOrientationsFilter oldFilter;
+		DoubleExpBoneOrientationsFilter filter;
+		replay(oldFilter, filter, 12, 1000);
+		oldFilter.Reset();
+		filter.Reset();
+		return expectIdentical(replay(oldFilter, filter, 13, 20000), "after a Reset");
+	}
+}
+
+int main()
+{
+	bool ok = testRotationParams();
+	ok &= testOtherParams();
+	ok &= testReset();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
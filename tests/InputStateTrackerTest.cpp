@@ -0,0 +1,241 @@
+// Feeds the driver's InputStateTracker button arrays like the ones the BUT pipes deliver and records what it
+// submits to a mock IVRDriverInput: clicks switch with hysteresis, touches from a deadband around zero,
+// scalars skip changes inside their deadband but always reach the ends of the range, unchanged components
+// are never submitted again and a failed update is retried on the next call
+//
+// g++ -std=c++17 -O2 -pthread -Itests/stubs -ISFMLProject/inc -Idriver_K2VR
+//     tests/InputStateTrackerTest.cpp driver_K2VR/input_state.cpp -o InputStateTrackerTest
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "input_state.h"
+
+namespace
+{
+	using namespace soft_knuckles;
+
+	// The last value per component handle, and every update in order
+	struct MockInput : IVRDriverInput
+	{
+		std::map<VRInputComponentHandle_t, bool> booleans;
+		std::map<VRInputComponentHandle_t, float> scalars;
+		std::vector<VRInputComponentHandle_t> updates;
+		VRInputComponentHandle_t failing = 0;
+
+		EVRInputError UpdateBooleanComponent(VRInputComponentHandle_t handle, bool value, double) override
+		{
+			if (handle == failing)
+				return VRInputError_InvalidHandle;
+			booleans[handle] = value;
+			updates.push_back(handle);
+			return VRInputError_None;
+		}
+
+		EVRInputError UpdateScalarComponent(VRInputComponentHandle_t handle, float value, double) override
+		{
+			if (handle == failing)
+				return VRInputError_InvalidHandle;
+			scalars[handle] = value;
+			updates.push_back(handle);
+			return VRInputError_None;
+		}
+	};
+
+	enum Handle : VRInputComponentHandle_t
+	{
+		H_STICK_X = 1,
+		H_STICK_TOUCH,
+		H_TRIGGER,
+		H_TRIGGER_TOUCH,
+		H_A,
+		H_GRIP_FORCE,
+		H_HAPTIC,
+	};
+
+	// Like the right hand's table, with a path nothing binds and a haptic on a bound path
+	const KnuckleComponentDefinition definitions[] = {
+		{"/input/thumbstick/x", CT_SCALAR, VRScalarType_Absolute, VRScalarUnits_NormalizedTwoSided, nullptr, nullptr},
+		{"/input/thumbstick/touch", CT_BOOLEAN, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+		{"/input/trigger/value", CT_SCALAR, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+		{"/input/trigger/touch", CT_BOOLEAN, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+		{"/input/a/click", CT_BOOLEAN, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+		{"/input/grip/force", CT_SCALAR, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+		{"/input/system/click", CT_HAPTIC, VRScalarType_Absolute, VRScalarUnits_NormalizedOneSided, nullptr, nullptr},
+	};
+	const VRInputComponentHandle_t handles[] = {H_STICK_X, H_STICK_TOUCH, H_TRIGGER, H_TRIGGER_TOUCH, H_A, H_GRIP_FORCE, H_HAPTIC};
+	const uint32_t numDefinitions = sizeof(definitions) / sizeof(definitions[0]);
+
+	struct Buttons
+	{
+		float values[12] = {};
+
+		Buttons& set(ButtonSource source, float value)
+		{
+			values[source] = value;
+			return *this;
+		}
+	};
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testBindAndDiff()
+	{
+		bool ok = true;
+		InputStateTracker tracker;
+		MockInput input;
+		ok &= expect(!tracker.IsBound(), "nothing is bound before Bind");
+		ok &= expect(tracker.Submit(Buttons().values, &input) == 0, "an unbound tracker submits nothing");
+
+		tracker.Bind(definitions, numDefinitions, handles);
+		ok &= expect(tracker.IsBound(), "bound after Bind");
+		Buttons buttons;
+		buttons.set(BS_TRIGGER, 0.5f).set(BS_A, 1.f);
+		ok &= expect(tracker.Submit(buttons.values, &input) == 5, "the first submit sends every bound component");
+		ok &= expect(!input.booleans.count(H_GRIP_FORCE) && !input.scalars.count(H_GRIP_FORCE) && !input.booleans.count(H_HAPTIC),
+		             "unknown paths and haptics aren't bound");
+		ok &= expect(input.scalars[H_TRIGGER] == 0.5f && input.booleans[H_A] && input.booleans[H_TRIGGER_TOUCH]
+		             && !input.booleans[H_STICK_TOUCH] && input.scalars[H_STICK_X] == 0.f,
+		             "with the values of the first buttons");
+
+		const size_t updates = input.updates.size();
+		for (int i = 0; i < 100; i++)
+			ok &= expect(tracker.Submit(buttons.values, &input) == 0, "unchanged buttons submit nothing");
+		ok &= expect(input.updates.size() == updates, "not a single update for them");
+
+		buttons.set(BS_THUMBSTICK_X, 0.3f);
+		ok &= expect(tracker.Submit(buttons.values, &input) == 2 && input.scalars[H_STICK_X] == 0.3f
+		             && input.booleans[H_STICK_TOUCH], "moving the stick submits its axis and touch, nothing else");
+
+		// Binding again starts over
+		tracker.Bind(definitions, numDefinitions, handles);
+		ok &= expect(tracker.Submit(buttons.values, &input) == 5, "a new Bind submits everything once more");
+		return ok;
+	}
+
+	bool testClickHysteresis()
+	{
+		bool ok = true;
+		InputStateTracker tracker;
+		MockInput input;
+		tracker.Bind(definitions, numDefinitions, handles);
+		Buttons buttons;
+		tracker.Submit(buttons.values, &input);
+
+		const struct
+		{
+			float value;
+			bool pressed;
+		} steps[] = {{0.5f, false}, {0.74f, false}, {0.75f, true}, {0.5f, true}, {0.26f, true}, {0.8f, true},
+		             {0.25f, false}, {0.5f, false}, {0.7f, false}, {1.f, true}, {0.f, false}};
+		bool last = false;
+		for (const auto& step : steps)
+		{
+			const size_t before = input.updates.size();
+			tracker.Submit(buttons.set(BS_A, step.value).values, &input);
+			ok &= expect(input.booleans[H_A] == step.pressed, "a click presses at 0.75 and releases at 0.25");
+			ok &= expect((input.updates.size() != before) == (step.pressed != last), "and is only submitted when it switches");
+			last = step.pressed;
+		}
+		return ok;
+	}
+
+	bool testTouchDeadband()
+	{
+		bool ok = true;
+		InputStateTracker tracker;
+		MockInput input;
+		tracker.Bind(definitions, numDefinitions, handles);
+		Buttons buttons;
+		tracker.Submit(buttons.values, &input);
+
+		const struct
+		{
+			float value;
+			bool touched;
+		} steps[] = {{0.04f, false}, {0.06f, true}, {0.03f, true}, {0.021f, true}, {0.019f, false}, {0.049f, false},
+		             {-0.06f, true}, {0.f, false}};
+		for (const auto& step : steps)
+		{
+			tracker.Submit(buttons.set(BS_TRIGGER, step.value).values, &input);
+			ok &= expect(input.booleans[H_TRIGGER_TOUCH] == step.touched, "touch turns on above 0.05 and off below 0.02");
+		}
+
+		// The stick's touch comes from either axis
+		tracker.Submit(buttons.set(BS_THUMBSTICK_Y, -0.1f).values, &input);
+		ok &= expect(input.booleans[H_STICK_TOUCH], "a stick pushed along y alone is touched");
+		tracker.Submit(buttons.set(BS_THUMBSTICK_X, 0.03f).set(BS_THUMBSTICK_Y, 0.01f).values, &input);
+		ok &= expect(input.booleans[H_STICK_TOUCH], "and stays touched while either axis is inside the deadband");
+		tracker.Submit(buttons.set(BS_THUMBSTICK_X, 0.01f).values, &input);
+		ok &= expect(!input.booleans[H_STICK_TOUCH], "until both are back near zero");
+		return ok;
+	}
+
+	bool testScalarDeadband()
+	{
+		bool ok = true;
+		InputStateTracker tracker;
+		MockInput input;
+		tracker.Bind(definitions, numDefinitions, handles);
+		Buttons buttons;
+		buttons.set(BS_TRIGGER, 0.5f);
+		tracker.Submit(buttons.values, &input);
+
+		auto submitTrigger = [&](float value)
+		{
+			const size_t before = input.updates.size();
+			tracker.Submit(buttons.set(BS_TRIGGER, value).values, &input);
+			return input.updates.size() != before;
+		};
+		ok &= expect(!submitTrigger(0.501f) && input.scalars[H_TRIGGER] == 0.5f, "a change inside the deadband is skipped");
+		ok &= expect(!submitTrigger(0.4995f), "either way");
+		ok &= expect(submitTrigger(0.5025f) && input.scalars[H_TRIGGER] == 0.5025f, "a larger change goes out");
+		// Small steps are measured from the last submitted value, so a slow drift still gets through
+		ok &= expect(!submitTrigger(0.5035f) && !submitTrigger(0.5042f) && submitTrigger(0.5047f),
+		             "small steps add up until they leave the deadband");
+
+		ok &= expect(submitTrigger(0.9995f) && !submitTrigger(0.9990f), "near the end of the range the deadband holds");
+		ok &= expect(submitTrigger(1.f) && input.scalars[H_TRIGGER] == 1.f, "but the end itself always goes out");
+		ok &= expect(!submitTrigger(1.f), "once");
+		ok &= expect(submitTrigger(0.0015f) && submitTrigger(0.f) && input.scalars[H_TRIGGER] == 0.f, "so does zero");
+
+		// Two sided axes end at -1
+		tracker.Submit(buttons.set(BS_THUMBSTICK_X, -0.9995f).values, &input);
+		tracker.Submit(buttons.set(BS_THUMBSTICK_X, -1.f).values, &input);
+		ok &= expect(input.scalars[H_STICK_X] == -1.f, "and -1");
+		return ok;
+	}
+
+	bool testFailedUpdate()
+	{
+		bool ok = true;
+		InputStateTracker tracker;
+		MockInput input;
+		tracker.Bind(definitions, numDefinitions, handles);
+		Buttons buttons;
+		tracker.Submit(buttons.values, &input);
+
+		input.failing = H_A;
+		ok &= expect(tracker.Submit(buttons.set(BS_A, 1.f).values, &input) == 0, "a failed update isn't counted");
+		input.failing = 0;
+		ok &= expect(tracker.Submit(buttons.values, &input) == 1 && input.booleans[H_A], "and is retried on the next submit");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testBindAndDiff();
+	ok &= testClickHysteresis();
+	ok &= testTouchDeadband();
+	ok &= testScalarDeadband();
+	ok &= testFailedUpdate();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// Compares JointRotationSmoother with the SmoothFilter the Kinect V1 rotation filter used before it,
+// for the window of 1 the old code effectively had, and for a real per-joint window of 5.
+// Also times one skeleton update of each
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc -IKinectV1Process tests/JointRotationSmootherTest.cpp -o JointRotationSmootherTest
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "JointRotationSmoother.h"
+
+namespace
+{
+	const int k_jointCount = 20; // NUI_SKELETON_POSITION_COUNT
+	const int k_frames = 20000;
+	const float k_tolerance = 2e-6f;
+
+	struct Vector4
+	{
+		float x, y, z, w;
+	};
+
+	// The old RotationalSmoothingFilter maths, one joint at a time
+	namespace Reference
+	{
+		float dot(Vector4 q1, Vector4 q2)
+		{
+			return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+		}
+
+		float length(Vector4 v)
+		{
+			return std::sqrt(v.w * v.w + v.x * v.x + v.y * v.y + v.z * v.z);
+		}
+
+		Vector4 normalisedQ(Vector4 v)
+		{
+			const float magnitude = std::pow(length(v), 2);
+			return {v.x / magnitude, v.y / magnitude, v.z / magnitude, v.w / magnitude};
+		}
+
+		Vector4 lerp(const Vector4& a, const Vector4& b, const float t)
+		{
+			const float t_ = 1 - t;
+			return normalisedQ({t_ * a.x + t * b.x, t_ * a.y + t * b.y, t_ * a.z + t * b.z, t_ * a.w + t * b.w});
+		}
+
+		Vector4 NormalizeQuaternion(Vector4 q)
+		{
+			if (q.x == 0 && q.y == 0 && q.z == 0 && q.w == 0)
+				return q;
+			const float len = 1.0f / length(q);
+			return {q.x * len, q.y * len, q.z * len, q.w * len};
+		}
+
+		Vector4 SmoothFilter(std::deque<Vector4> quaternions, Vector4 lastMedian)
+		{
+			Vector4 median = {0, 0, 0, 0};
+			for (Vector4 quaternion : quaternions)
+			{
+				const float weight = 1.0f - (dot(lastMedian, quaternion) / (PI / 2.0f));
+				const Vector4 weighted = lerp(lastMedian, quaternion, weight);
+				median.x += weighted.x;
+				median.y += weighted.y;
+				median.z += weighted.z;
+				median.w += weighted.w;
+			}
+			median.x /= quaternions.size();
+			median.y /= quaternions.size();
+			median.z /= quaternions.size();
+			median.w /= quaternions.size();
+			return NormalizeQuaternion(median);
+		}
+	}
+
+	// What the old filter did every frame: push one joint, smooth, pop
+	struct ReferenceFilter
+	{
+		explicit ReferenceFilter(size_t window) : window(window) {}
+
+		void update(const Vector4* joints)
+		{
+			for (int i = 0; i < k_jointCount; ++i)
+			{
+				std::deque<Vector4>& rotations = history[i];
+				rotations.push_back(joints[i]);
+				if (rotations.size() > window)
+					rotations.pop_front();
+				filtered[i] = Reference::SmoothFilter(rotations, filtered[i]);
+			}
+		}
+
+		size_t window;
+		std::deque<Vector4> history[k_jointCount];
+		Vector4 filtered[k_jointCount] = {};
+	};
+
+	std::vector<Vector4> randomFrames()
+	{
+		// A slowly turning skeleton with some jitter, like a tracked body
+		std::mt19937 rng(31);
+		std::normal_distribution<float> jitter(0.f, 0.02f);
+		std::vector<Vector4> frames(k_frames * k_jointCount);
+		for (int frame = 0; frame < k_frames; ++frame)
+		{
+			for (int i = 0; i < k_jointCount; ++i)
+			{
+				const float angle = 0.002f * frame + 0.3f * i;
+				Vector4 q = {std::sin(angle) + jitter(rng), jitter(rng), jitter(rng), std::cos(angle) + jitter(rng)};
+				const float length = Reference::length(q);
+				frames[frame * k_jointCount + i] = {q.x / length, q.y / length, q.z / length, q.w / length};
+			}
+		}
+		return frames;
+	}
+
+	bool compare(int window, const std::vector<Vector4>& frames)
+	{
+		ReferenceFilter reference(window);
+		JointRotationSmoother<k_jointCount> smoother;
+		smoother.setWindowLength(window);
+
+		float worst = 0;
+		for (int frame = 0; frame < k_frames; ++frame)
+		{
+			const Vector4* joints = &frames[frame * k_jointCount];
+			reference.update(joints);
+			auto& next = smoother.nextFrame();
+			for (int i = 0; i < k_jointCount; ++i)
+				next.set(i, joints[i]);
+			smoother.smooth();
+
+			for (int i = 0; i < k_jointCount; ++i)
+			{
+				const Vector4 expected = reference.filtered[i], actual = smoother.result().get<Vector4>(i);
+				worst = std::max({worst, std::fabs(expected.x - actual.x), std::fabs(expected.y - actual.y),
+				                  std::fabs(expected.z - actual.z), std::fabs(expected.w - actual.w)});
+			}
+		}
+
+		std::printf("Window %d: largest difference to SmoothFilter %g\n", window, worst);
+		if (worst > k_tolerance)
+		{
+			std::printf("FAIL: window %d doesn't match SmoothFilter\n", window);
+			return false;
+		}
+		return true;
+	}
+
+	template <typename Update>
+	double microsecondsPerFrame(Update update)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < k_frames; ++frame)
+			update(frame);
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / k_frames;
+	}
+}
+
+int main()
+{
+	const std::vector<Vector4> frames = randomFrames();
+	bool ok = compare(1, frames);
+	ok &= compare(5, frames);
+
+	for (int window : {1, 5})
+	{
+		ReferenceFilter reference(window);
+		JointRotationSmoother<k_jointCount> smoother;
+		smoother.setWindowLength(window);
+
+		const double referenceTime = microsecondsPerFrame([&](int frame)
+		{
+			reference.update(&frames[frame * k_jointCount]);
+		});
+		const double smootherTime = microsecondsPerFrame([&](int frame)
+		{
+			auto& next = smoother.nextFrame();
+			for (int i = 0; i < k_jointCount; ++i)
+				next.set(i, frames[frame * k_jointCount + i]);
+			smoother.smooth();
+		});
+		std::printf("Window %d, one skeleton: SmoothFilter %.3fus, JointRotationSmoother %.3fus\n",
+		            window, referenceTime, smootherTime);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// Converts synthetic camera frames with the KinectImage kernels and passes them through KinectImageStaging.
+// The swizzle has to match a per-byte BGRX to RGBA reference for widths that do and don't fill its four pixel
+// steps, with packed and padded row pitches, and neither kernel may touch bytes past the frame. The staging
+// hands each frame out once, always the newest, and never one the camera thread is still writing. Prints how
+// long a 640x480 frame takes each way
+//
+// g++ -std=c++17 -O2 -pthread -ISFMLProject/inc tests/KinectImageStagingTest.cpp -o KinectImageStagingTest
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "KinectImageStaging.h"
+
+namespace
+{
+	// A BGRX frame of noise-like bytes, padding included, rows pitch bytes apart
+	struct Frame
+	{
+		int width;
+		int height;
+		int pitch;
+		std::vector<uint8_t> bytes;
+
+		Frame(int width, int height, int padding, unsigned seed)
+			: width(width), height(height), pitch(width * 4 + padding), bytes(static_cast<size_t>(pitch) * height)
+		{
+			for (size_t i = 0; i < bytes.size(); i++)
+				bytes[i] = static_cast<uint8_t>(i * 131 + seed * 7 + (i >> 8));
+		}
+	};
+
+	void referenceSwizzle(const Frame& frame, uint8_t* out)
+	{
+		for (int y = 0; y < frame.height; y++)
+		{
+			for (int x = 0; x < frame.width; x++)
+			{
+				const uint8_t* in = &frame.bytes[static_cast<size_t>(frame.pitch) * y + x * 4];
+				out[0] = in[2];
+				out[1] = in[1];
+				out[2] = in[0];
+				out[3] = 255;
+				out += 4;
+			}
+		}
+	}
+
+	// Output with guard bytes on either side that no kernel may overwrite
+	struct Output
+	{
+		static const size_t guard = 64;
+		std::vector<uint8_t> bytes;
+
+		explicit Output(const Frame& frame) : bytes(static_cast<size_t>(frame.width) * frame.height * 4 + guard * 2, 0xCD)
+		{
+		}
+
+		uint8_t* pixels() { return bytes.data() + guard; }
+
+		bool guardsIntact() const
+		{
+			for (size_t i = 0; i < guard; i++)
+			{
+				if (bytes[i] != 0xCD || bytes[bytes.size() - 1 - i] != 0xCD)
+					return false;
+			}
+			return true;
+		}
+	};
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testSwizzle()
+	{
+		bool ok = true;
+		const int widths[] = {1, 2, 3, 4, 5, 7, 8, 13, 639, 640, 641};
+		const int paddings[] = {0, 4, 12, 64};
+		for (int width : widths)
+		{
+			for (int padding : paddings)
+			{
+				const Frame frame(width, 7, padding, width + padding);
+				Output swizzled(frame), expected(frame);
+				KinectImage::swizzleBGRXToRGBA(frame.bytes.data(), frame.pitch, swizzled.pixels(), width, frame.height);
+				referenceSwizzle(frame, expected.pixels());
+				ok &= expect(swizzled.bytes == expected.bytes, "the swizzle matches the per-byte reference");
+				ok &= expect(swizzled.guardsIntact(), "and writes nothing outside the frame");
+			}
+		}
+		return ok;
+	}
+
+	bool testCopyRows()
+	{
+		bool ok = true;
+		const int widths[] = {1, 3, 640, 641};
+		const int paddings[] = {0, 12};
+		for (int width : widths)
+		{
+			for (int padding : paddings)
+			{
+				const Frame frame(width, 5, padding, width);
+				Output copied(frame);
+				KinectImage::copyRows(frame.bytes.data(), frame.pitch, copied.pixels(), width, frame.height);
+				bool same = true;
+				for (int y = 0; y < frame.height; y++)
+				{
+					for (int i = 0; i < width * 4; i++)
+						same &= copied.pixels()[y * width * 4 + i] == frame.bytes[static_cast<size_t>(frame.pitch) * y + i];
+				}
+				ok &= expect(same, "copyRows packs the rows and leaves the padding behind");
+				ok &= expect(copied.guardsIntact(), "and writes nothing outside the frame");
+			}
+		}
+		return ok;
+	}
+
+	bool testStaging()
+	{
+		bool ok = true;
+		KinectImageStaging staging;
+		staging.resize(5, 3);
+		ok &= expect(staging.width() == 5 && staging.height() == 3, "resize sets the frame size");
+
+		uint64_t sequence = 0;
+		int uploads = 0;
+		std::vector<uint8_t> uploaded;
+		auto upload = [&](const uint8_t* pixels)
+		{
+			uploads++;
+			uploaded.assign(pixels, pixels + 5 * 3 * 4);
+		};
+		ok &= expect(!staging.consume(sequence, upload) && uploads == 0, "nothing is handed out before the first frame");
+
+		const Frame first(5, 3, 12, 1), second(5, 3, 12, 2);
+		Output expected(first);
+		staging.writeBGRX(first.bytes.data(), first.pitch);
+		referenceSwizzle(first, expected.pixels());
+		ok &= expect(staging.consume(sequence, upload) && uploads == 1, "a written frame is handed out");
+		ok &= expect(std::equal(uploaded.begin(), uploaded.end(), expected.pixels()), "converted to RGBA");
+		ok &= expect(!staging.consume(sequence, upload) && uploads == 1, "but only once");
+
+		staging.writeBGRX(first.bytes.data(), first.pitch);
+		staging.writeBGRX(second.bytes.data(), second.pitch);
+		referenceSwizzle(second, expected.pixels());
+		ok &= expect(staging.consume(sequence, upload) && uploads == 2, "two frames written in between are one upload");
+		ok &= expect(std::equal(uploaded.begin(), uploaded.end(), expected.pixels()), "of the newer one");
+
+		staging.writeRGBA(second.bytes.data(), second.pitch);
+		ok &= expect(staging.consume(sequence, upload) && std::equal(uploaded.begin(), uploaded.begin() + 20, second.bytes.begin()),
+		             "an RGBA frame is copied as it is");
+
+		staging.resize(5, 3);
+		ok &= expect(!staging.consume(sequence, upload), "a resize drops the frames it had");
+		return ok;
+	}
+
+	// The camera thread writes frames filled with their number while the drawing side consumes them
+	bool testConcurrent()
+	{
+		bool ok = true;
+		const int width = 64, height = 48, frames = 2000;
+		KinectImageStaging staging;
+		staging.resize(width, height);
+
+		std::thread camera([&]()
+		{
+			std::vector<uint8_t> frame(width * height * 4);
+			for (int i = 1; i <= frames; i++)
+			{
+				std::fill(frame.begin(), frame.end(), static_cast<uint8_t>(i));
+				staging.writeRGBA(frame.data(), width * 4);
+				std::this_thread::yield();
+			}
+		});
+
+		uint64_t sequence = 0, lastSequence = 0;
+		int uploads = 0;
+		bool whole = true, ordered = true;
+		while (sequence != static_cast<uint64_t>(frames))
+		{
+			staging.consume(sequence, [&](const uint8_t* pixels)
+			{
+				for (int i = 1; i < width * height * 4; i++)
+					whole &= pixels[i] == pixels[0];
+				uploads++;
+			});
+			ordered &= sequence >= lastSequence;
+			lastSequence = sequence;
+		}
+		camera.join();
+
+		std::printf("%d frames written, %d uploaded\n", frames, uploads);
+		ok &= expect(whole, "an uploaded frame is never one being written");
+		ok &= expect(ordered, "frames are handed out in order, ending with the last");
+		return ok;
+	}
+
+	template <typename Convert>
+	double microsecondsPerFrame(Convert convert)
+	{
+		const int runs = 200;
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; i++)
+			convert();
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+	}
+
+	void benchmark()
+	{
+		const Frame frame(640, 480, 64, 3);
+		Output swizzled(frame), reference(frame), copied(frame);
+		const double swizzle = microsecondsPerFrame([&]
+		{
+			KinectImage::swizzleBGRXToRGBA(frame.bytes.data(), frame.pitch, swizzled.pixels(), frame.width, frame.height);
+		});
+		const double perByte = microsecondsPerFrame([&] { referenceSwizzle(frame, reference.pixels()); });
+		const double copy = microsecondsPerFrame([&]
+		{
+			KinectImage::copyRows(frame.bytes.data(), frame.pitch, copied.pixels(), frame.width, frame.height);
+		});
+		std::printf("640x480 with padded rows: swizzle %.0fus, per-byte reference %.0fus, copyRows %.0fus%s\n",
+		            swizzle, perByte, copy, swizzled.bytes == reference.bytes ? "" : " (results differ)");
+	}
+}
+
+int main()
+{
+	bool ok = testSwizzle();
+	ok &= testCopyRows();
+	ok &= testStaging();
+	ok &= testConcurrent();
+	benchmark();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
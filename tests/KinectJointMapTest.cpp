@@ -0,0 +1,159 @@
+// Checks the joint and bone tables of KinectJointMap.h at run time as well. Every joint maps onto a v1 and a v2
+// joint, the joints v1 has map back onto themselves, k_bones is a tree rooted at the head, the v1 and v2
+// bone lists are it in each SDK's indices, and the bones rotation estimation and filtering look along are the
+// k_bones entries between the joints they always used
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc tests/KinectJointMapTest.cpp -o KinectJointMapTest
+#include <cstdio>
+
+#include "KinectJointMap.h"
+
+namespace
+{
+	using KVR::KinectJointType;
+	using namespace KVR::JointMap;
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool isBone(const KVR::JointBone& bone, KinectJointType from, KinectJointType to)
+	{
+		return bone.from == static_cast<int>(from) && bone.to == static_cast<int>(to);
+	}
+
+	bool testJointTables()
+	{
+		bool ok = true;
+		bool identity = true, inRange = true;
+		for (int joint = 0; joint < KVR::KinectJointCount; joint++)
+		{
+			identity &= toV2(static_cast<KinectJointType>(joint)) == joint;
+			inRange &= toV1(static_cast<KinectJointType>(joint)) < V1_Count;
+		}
+		ok &= expect(identity, "v2 joints are the KinectJointType ids");
+		ok &= expect(inRange, "every joint has a v1 joint");
+		ok &= expect(toV1(KinectJointType::INVALID) == V1_WristLeft && toV2(KinectJointType::INVALID) == toV2(KinectJointType::WristLeft),
+		             "INVALID falls back on the left wrist");
+
+		// The first 20 pairs are the joints v1 has, each v1 joint once
+		int hits[V1_Count] = {};
+		for (int i = 0; i < V1_Count; i++)
+			hits[toV1(k_v1Pairs[i].joint)]++;
+		bool once = true;
+		for (int joint = 0; joint < V1_Count; joint++)
+			once &= hits[joint] == 1;
+		ok &= expect(once, "the joints v1 has map onto every v1 joint once");
+		ok &= expect(toV1(KinectJointType::SpineBase) == V1_HipCenter && toV1(KinectJointType::SpineShoulder) == V1_ShoulderCenter
+		             && toV1(KinectJointType::FootRight) == V1_FootRight, "by name");
+		ok &= expect(toV1(KinectJointType::Neck) == V1_ShoulderCenter && toV1(KinectJointType::HandTipLeft) == V1_HandLeft
+		             && toV1(KinectJointType::ThumbRight) == V1_HandRight, "the others onto the v1 joint nearest to them");
+		return ok;
+	}
+
+	// Follows the bones back from the joint to the head, false if that takes more steps than there are joints
+	bool reachesHead(int joint)
+	{
+		for (int steps = 0; steps < KVR::KinectJointCount; steps++)
+		{
+			if (joint == static_cast<int>(KinectJointType::Head))
+				return true;
+			int parent = -1;
+			for (size_t b = 0; b < k_boneCount; b++)
+			{
+				if (k_bones[b].to == joint)
+					parent = k_bones[b].from;
+			}
+			if (parent < 0)
+				return false;
+			joint = parent;
+		}
+		return false;
+	}
+
+	bool testBones()
+	{
+		bool ok = true;
+		ok &= expect(k_boneCount == 24, "24 bones for 25 joints");
+
+		int parents[KVR::KinectJointCount] = {};
+		for (size_t b = 0; b < k_boneCount; b++)
+			parents[k_bones[b].to]++;
+		bool once = true, rooted = true;
+		for (int joint = 0; joint < KVR::KinectJointCount; joint++)
+		{
+			once &= parents[joint] == (joint == static_cast<int>(KinectJointType::Head) ? 0 : 1);
+			rooted &= reachesHead(joint);
+		}
+		ok &= expect(once, "every joint but the head ends one bone");
+		ok &= expect(rooted, "and leads back to it");
+
+		bool same = k_v2Bones.size() == k_boneCount;
+		for (size_t b = 0; same && b < k_boneCount; b++)
+			same &= k_v2Bones[b].from == k_bones[b].from && k_v2Bones[b].to == k_bones[b].to;
+		ok &= expect(same, "the v2 bones are k_bones as they are");
+
+		int v1Parents[V1_Count] = {};
+		bool valid = k_v1Bones.size() == 19;
+		for (const KVR::JointBone& bone : k_v1Bones)
+		{
+			valid &= bone.from >= 0 && bone.from < V1_Count && bone.to >= 0 && bone.to < V1_Count && bone.from != bone.to;
+			if (bone.to >= 0 && bone.to < V1_Count)
+				v1Parents[bone.to]++;
+		}
+		bool v1Once = true;
+		for (int joint = 0; joint < V1_Count; joint++)
+			v1Once &= v1Parents[joint] == (joint == V1_Head ? 0 : 1);
+		ok &= expect(valid, "19 v1 bones between distinct v1 joints");
+		ok &= expect(v1Once, "ending on every v1 joint but the head once");
+		ok &= expect(k_v1Bones[0].from == V1_Head && k_v1Bones[0].to == V1_ShoulderCenter,
+		             "the head to the neck bone becomes head to shoulder centre, the neck to spine shoulder one goes");
+		return ok;
+	}
+
+	bool testLookups()
+	{
+		bool ok = true;
+		bool found = true;
+		for (size_t b = 0; b < k_boneCount; b++)
+			found &= findBone(static_cast<KinectJointType>(k_bones[b].from), static_cast<KinectJointType>(k_bones[b].to)) == b;
+		ok &= expect(found, "findBone finds every bone where it is");
+		ok &= expect(findBone(KinectJointType::FootLeft, KinectJointType::AnkleLeft) == k_boneCount
+		             && findBone(KinectJointType::HipLeft, KinectJointType::HipRight) == k_boneCount, "and nothing else");
+
+		ok &= expect(isBone(k_bones[k_legBones[0].shin], KinectJointType::KneeLeft, KinectJointType::AnkleLeft)
+		             && isBone(k_bones[k_legBones[0].foot], KinectJointType::AnkleLeft, KinectJointType::FootLeft),
+		             "the left leg looks along the left shin and foot");
+		ok &= expect(isBone(k_bones[k_legBones[1].shin], KinectJointType::KneeRight, KinectJointType::AnkleRight)
+		             && isBone(k_bones[k_legBones[1].foot], KinectJointType::AnkleRight, KinectJointType::FootRight),
+		             "the right leg along the right ones");
+		ok &= expect(isBone(k_bones[k_handBones[0]], KinectJointType::WristLeft, KinectJointType::HandLeft)
+		             && isBone(k_bones[k_handBones[1]], KinectJointType::WristRight, KinectJointType::HandRight),
+		             "the hands from the wrists");
+		ok &= expect(k_bones[k_hipBones[0]].to == static_cast<int>(KinectJointType::HipLeft)
+		             && k_bones[k_hipBones[1]].to == static_cast<int>(KinectJointType::HipRight), "the hips across their joints");
+
+		int feet = 0;
+		for (int joint = 0; joint < KVR::KinectJointCount; joint++)
+			feet += isFoot(static_cast<KinectJointType>(joint)) ? 1 : 0;
+		ok &= expect(feet == 2 && isFoot(KinectJointType::FootLeft) && isFoot(KinectJointType::FootRight),
+		             "only the two feet are filtered as feet");
+
+		const KVR::JointBone v1Shin = sdkBone(k_toV1, k_legBones[1].shin);
+		ok &= expect(v1Shin.from == V1_KneeRight && v1Shin.to == V1_AnkleRight, "sdkBone puts a bone into v1 joints");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testJointTables();
+	ok &= testBones();
+	ok &= testLookups();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// Runs PSMovePoller against a simulated PSMoveService and compares the worst tracking loop stall
+// with the synchronous list rebuild the handler used to do on that loop.
+// Also checks that an orientation reset is only reported once a snapshot containing it was published
+//
+// g++ -std=c++17 -O2 -pthread -Itests/stubs -ISFMLProject/inc -Iexternal/PSMoveService/include
+//     tests/PSMovePollerTest.cpp -o PSMovePollerTest
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PSMovePoller.h"
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	// One request/response round trip to the service
+	const std::chrono::milliseconds k_roundTrip(15);
+	const int k_controllerCount = 3;
+
+	struct PendingResponse
+	{
+		clock::time_point due;
+		PSMResponseMessage message;
+	};
+
+	struct PendingReset
+	{
+		clock::time_point due;
+		PSMControllerID controller;
+		PSMQuatf orientation;
+	};
+
+	std::recursive_mutex serviceMutex;
+	PSMController controllers[k_controllerCount];
+	std::vector<PendingResponse> responses;
+	std::vector<PendingReset> resets;
+	std::map<PSMRequestID, std::pair<PSMResponseCallback, void*>> callbacks;
+	PSMRequestID nextRequest = 1;
+	clock::time_point lastListChange = clock::now();
+
+	PSMControllerList fullList()
+	{
+		PSMControllerList list = {};
+		list.count = k_controllerCount;
+		for (int i = 0; i < k_controllerCount; ++i)
+			list.controller_id[i] = i;
+		return list;
+	}
+
+	PSMRequestID queueResponse(PSMResponseMessage::eResponsePayloadType type)
+	{
+		PendingResponse response = {};
+		response.due = clock::now() + k_roundTrip;
+		response.message.request_id = nextRequest++;
+		response.message.result_code = PSMResult_Success;
+		response.message.payload_type = type;
+		if (type == PSMResponseMessage::_responsePayloadType_ControllerList)
+			response.message.payload.controller_list = fullList();
+		responses.push_back(response);
+		return response.message.request_id;
+	}
+
+	void blockForRoundTrip()
+	{
+		std::this_thread::sleep_for(k_roundTrip);
+	}
+}
+
+PSMResult PSM_Update()
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(200)); // Reading the socket
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	const auto now = clock::now();
+
+	// The service applies a reset before it answers, so the new orientation streams in first
+	for (auto it = resets.begin(); it != resets.end();)
+	{
+		if (it->due > now)
+		{
+			++it;
+			continue;
+		}
+		controllers[it->controller].ControllerState.PSMoveState.Pose.Orientation = it->orientation;
+		it = resets.erase(it);
+	}
+	for (auto& controller : controllers)
+		++controller.OutputSequenceNum;
+
+	// Callbacks send new requests, so take the answers out first
+	std::vector<PSMResponseMessage> answered;
+	for (auto it = responses.begin(); it != responses.end();)
+	{
+		if (it->due > now)
+		{
+			++it;
+			continue;
+		}
+		answered.push_back(it->message);
+		it = responses.erase(it);
+	}
+	for (const PSMResponseMessage& message : answered)
+	{
+		auto callback = callbacks.find(message.request_id);
+		if (callback != callbacks.end())
+		{
+			const auto registered = callback->second;
+			callbacks.erase(callback);
+			registered.first(&message, registered.second);
+		}
+	}
+	return PSMResult_Success;
+}
+
+bool PSM_HasControllerListChanged()
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	if (clock::now() - lastListChange < std::chrono::milliseconds(500))
+		return false;
+	lastListChange = clock::now();
+	return true;
+}
+
+bool PSM_HasTrackerListChanged() { return false; }
+bool PSM_HasHMDListChanged() { return false; }
+
+PSMController* PSM_GetController(PSMControllerID controller_id)
+{
+	return controller_id >= 0 && controller_id < k_controllerCount ? &controllers[controller_id] : nullptr;
+}
+
+PSMResult PSM_RegisterCallback(PSMRequestID request_id, PSMResponseCallback callback, void* callback_userdata)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	callbacks[request_id] = {callback, callback_userdata};
+	return PSMResult_Success;
+}
+
+PSMResult PSM_EatResponse(PSMRequestID) { return PSMResult_Success; }
+PSMResult PSM_AllocateControllerListener(PSMControllerID) { return PSMResult_Success; }
+PSMResult PSM_FreeControllerListener(PSMControllerID) { return PSMResult_Success; }
+
+PSMResult PSM_GetControllerListAsync(PSMRequestID* out_request_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	*out_request_id = queueResponse(PSMResponseMessage::_responsePayloadType_ControllerList);
+	return PSMResult_RequestSent;
+}
+
+PSMResult PSM_GetTrackerListAsync(PSMRequestID* out_request_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	*out_request_id = queueResponse(PSMResponseMessage::_responsePayloadType_TrackerList);
+	return PSMResult_RequestSent;
+}
+
+PSMResult PSM_StartControllerDataStreamAsync(PSMControllerID, unsigned int, PSMRequestID* out_request_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	*out_request_id = queueResponse(PSMResponseMessage::_responsePayloadType_Empty);
+	return PSMResult_RequestSent;
+}
+
+PSMResult PSM_StopControllerDataStreamAsync(PSMControllerID, PSMRequestID* out_request_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	*out_request_id = queueResponse(PSMResponseMessage::_responsePayloadType_Empty);
+	return PSMResult_RequestSent;
+}
+
+PSMResult PSM_ResetControllerOrientationAsync(PSMControllerID controller_id, const PSMQuatf* q_pose,
+                                              PSMRequestID* out_request_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(serviceMutex);
+	resets.push_back({clock::now() + k_roundTrip / 2, controller_id, *q_pose});
+	*out_request_id = queueResponse(PSMResponseMessage::_responsePayloadType_Empty);
+	return PSMResult_RequestSent;
+}
+
+// What the handler's update used to do on the tracking loop
+PSMResult PSM_GetControllerList(PSMControllerList* out_controller_list, int)
+{
+	blockForRoundTrip();
+	*out_controller_list = fullList();
+	return PSMResult_Success;
+}
+
+PSMResult PSM_StartControllerDataStream(PSMControllerID, unsigned int, int)
+{
+	blockForRoundTrip();
+	return PSMResult_Success;
+}
+
+PSMResult PSM_StopControllerDataStream(PSMControllerID, int)
+{
+	blockForRoundTrip();
+	return PSMResult_Success;
+}
+
+namespace
+{
+	const std::chrono::milliseconds k_frame(11); // 90Hz tracking loop
+	const std::chrono::seconds k_runTime(2);
+
+	double synchronousWorstStallMs()
+	{
+		PSMControllerList list = fullList();
+		double worst = 0;
+		const auto end = clock::now() + k_runTime;
+		while (clock::now() < end)
+		{
+			const auto start = clock::now();
+			PSM_Update();
+			if (PSM_HasControllerListChanged())
+			{
+				for (int i = 0; i < list.count; ++i)
+					PSM_StopControllerDataStream(list.controller_id[i], PSM_DEFAULT_TIMEOUT);
+				PSM_GetControllerList(&list, PSM_DEFAULT_TIMEOUT);
+				for (int i = 0; i < list.count; ++i)
+					PSM_StartControllerDataStream(list.controller_id[i], 0, PSM_DEFAULT_TIMEOUT);
+			}
+			PSMController controller;
+			for (int i = 0; i < list.count; ++i)
+				controller = *PSM_GetController(list.controller_id[i]);
+			worst = std::max(worst, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+			std::this_thread::sleep_until(start + k_frame);
+		}
+		return worst;
+	}
+
+	double polledWorstStallMs(PSMovePoller& poller)
+	{
+		double worst = 0;
+		const auto end = clock::now() + k_runTime;
+		while (clock::now() < end)
+		{
+			const auto start = clock::now();
+			PSMController controller;
+			for (int i = 0; i < k_controllerCount; ++i)
+				poller.readController(i, i, controller);
+			worst = std::max(worst, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+			std::this_thread::sleep_until(start + k_frame);
+		}
+		return worst;
+	}
+
+	bool sameOrientation(const PSMQuatf& a, const PSMQuatf& b)
+	{
+		return a.w == b.w && a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	bool resetIsPublishedBeforeItIsReported(PSMovePoller& poller)
+	{
+		const PSMQuatf resetOrientation = {std::sqrt(.5f), std::sqrt(.5f), 0.f, 0.f};
+		const uint64_t ticket = poller.postOrientationReset(1, resetOrientation);
+
+		const auto timeout = clock::now() + std::chrono::seconds(1);
+		while (!poller.hasPublishedAfterReset(ticket))
+		{
+			if (clock::now() > timeout)
+			{
+				std::printf("FAIL: reset was never reported as published\n");
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		PSMController controller;
+		if (!poller.readController(1, 1, controller) ||
+			!sameOrientation(controller.ControllerState.PSMoveState.Pose.Orientation, resetOrientation))
+		{
+			std::printf("FAIL: snapshot after the reset was reported doesn't contain it\n");
+			return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	for (int i = 0; i < k_controllerCount; ++i)
+	{
+		controllers[i].ControllerID = i;
+		controllers[i].ControllerType = PSMController_Move;
+		controllers[i].bValid = true;
+		controllers[i].IsConnected = true;
+		controllers[i].DataFrameAverageFPS = 120.f;
+		controllers[i].ControllerState.PSMoveState.Pose.Orientation = {1.f, 0.f, 0.f, 0.f};
+	}
+
+	const double synchronousStall = synchronousWorstStallMs();
+
+	PSMovePoller poller;
+	const PSMTrackerList trackers = {};
+	poller.start(fullList(), trackers);
+	const double polledStall = polledWorstStallMs(poller);
+	const bool resetOk = resetIsPublishedBeforeItIsReported(poller);
+	poller.stop();
+
+	std::printf("Worst tracking loop stall, list rebuilds every 500ms, %lldms round trips:\n",
+	            static_cast<long long>(k_roundTrip.count()));
+	std::printf("  synchronous update: %8.3fms\n", synchronousStall);
+	std::printf("  PSMovePoller:       %8.3fms\n", polledStall);
+
+	// A rebuild costs 2 * controllers + 1 round trips when done inline
+	const bool stallOk = synchronousStall >= (2 * k_controllerCount + 1) * k_roundTrip.count() &&
+		polledStall < k_roundTrip.count();
+	if (!stallOk)
+		std::printf("FAIL: the poller still stalls the tracking loop\n");
+
+	return stallOk && resetOk ? 0 : 1;
+}
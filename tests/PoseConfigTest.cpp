@@ -0,0 +1,267 @@
+// Routes poses through the pose hook's routePose the way DeviceManipulationHandle does, with fake devices
+// that pass what the hook lets through on to a mock IVRServerDriverHost. Checks the offset transform, fake
+// disconnect (mode 1), redirect source and target (modes 2 and 3, suspended or not) and swap (mode 4), and
+// that a config replaced while a reader still holds it stays readable
+//
+// g++ -std=c++17 -O2 -pthread -Itests/stubs -Iexternal/inputemulator/lib_vrinputemulator/include
+//     -Iexternal/inputemulator/driver_vrinputemulator/src/devicemanipulation/utils tests/PoseConfigTest.cpp -o PoseConfigTest
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "PoseConfig.h"
+
+namespace
+{
+	using namespace vrinputemulator::driver;
+
+	// Records every pose a device sends, with the device it was sent for
+	struct MockHost : vr::IVRServerDriverHost
+	{
+		struct Update
+		{
+			uint32_t device;
+			vr::DriverPose_t pose;
+		};
+		std::vector<Update> updates;
+
+		void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) override
+		{
+			if (unPoseStructSize == sizeof(vr::DriverPose_t))
+				updates.push_back({unWhichDevice, newPose});
+		}
+	};
+
+	// The parts of DeviceManipulationHandle the pose hook uses
+	struct FakeDevice
+	{
+		typedef PoseConfig<FakeDevice> Config;
+
+		uint32_t id;
+		MockHost& host;
+		PublishedConfig<Config> config;
+		std::atomic<bool> disconnectedMsgSend{false};
+		int compensated = 0;
+
+		FakeDevice(uint32_t id, MockHost& host) : id(id), host(host)
+		{
+		}
+
+		uint32_t openvrId() const
+		{
+			return id;
+		}
+
+		void ll_sendPoseUpdate(const vr::DriverPose_t& newPose)
+		{
+			host.TrackedDevicePoseUpdated(id, newPose, sizeof(vr::DriverPose_t));
+		}
+
+		void setMode(int mode, FakeDevice* redirectRef = nullptr, bool suspended = false)
+		{
+			std::unique_ptr<Config> next(new Config(*config.load()));
+			next->deviceMode = mode;
+			next->redirectRef = redirectRef;
+			next->redirectSuspended = suspended;
+			config.publish(std::move(next));
+			disconnectedMsgSend = false;
+		}
+
+		// The IVRServerDriverHost hook: only what routePose lets through reaches the host
+		void poseUpdated(vr::DriverPose_t pose)
+		{
+			uint32_t device = id;
+			if (routePose(*config.load(), disconnectedMsgSend, device, pose, [this](vr::DriverPose_t&) { compensated++; }))
+				host.TrackedDevicePoseUpdated(device, pose, sizeof(vr::DriverPose_t));
+		}
+	};
+
+	vr::DriverPose_t trackedPose(double x)
+	{
+		vr::DriverPose_t pose = {};
+		pose.qWorldFromDriverRotation = {1, 0, 0, 0};
+		pose.qDriverFromHeadRotation = {1, 0, 0, 0};
+		pose.qRotation = {1, 0, 0, 0};
+		pose.vecPosition[0] = x;
+		pose.result = vr::TrackingResult_Running_OK;
+		pose.poseIsValid = true;
+		pose.deviceIsConnected = true;
+		return pose;
+	}
+
+	bool disconnected(const vr::DriverPose_t& pose)
+	{
+		return !pose.poseIsValid && !pose.deviceIsConnected && pose.result == vr::TrackingResult_Uninitialized;
+	}
+
+	bool near(double a, double b)
+	{
+		return std::fabs(a - b) < 1e-12;
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testTransform()
+	{
+		bool ok = true;
+		MockHost host;
+		FakeDevice device(1, host);
+		ok &= expect(!PoseTransform().changesPose(), "the default transform changes nothing");
+
+		device.poseUpdated(trackedPose(0.5));
+		ok &= expect(host.updates.size() == 1 && host.updates[0].device == 1 && host.updates[0].pose.vecPosition[0] == 0.5,
+		             "without offsets the pose passes unchanged");
+		ok &= expect(device.compensated == 1, "motion compensation runs for every passed pose");
+
+		// A quarter turn around y on the device, plus a translation in each frame
+		const double h = std::sqrt(0.5);
+		std::unique_ptr<FakeDevice::Config> config(new FakeDevice::Config());
+		config->poseTransform.deviceRotation = {h, 0, h, 0};
+		config->poseTransform.deviceTranslation = {{0, 1, 0}};
+		config->poseTransform.worldFromDriverTranslation = {{0, 0, 2}};
+		config->poseTransform.driverFromHeadRotation = {h, h, 0, 0};
+		config->transformPose = config->poseTransform.changesPose();
+		ok &= expect(config->transformPose, "offsets change the pose");
+		device.config.publish(std::move(config));
+
+		vr::DriverPose_t pose = trackedPose(0.5);
+		pose.qRotation = {h, 0, 0, h};
+		pose.vecWorldFromDriverTranslation[2] = 1;
+		device.poseUpdated(pose);
+		const vr::DriverPose_t& out = host.updates.back().pose;
+		// (w, 0, w, 0) * (w, 0, 0, w) = (1/2, 1/2, 1/2, 1/2)
+		ok &= expect(near(out.qRotation.w, 0.5) && near(out.qRotation.x, 0.5) && near(out.qRotation.y, 0.5)
+		             && near(out.qRotation.z, 0.5), "the device rotation is applied in front of the pose's");
+		ok &= expect(out.vecPosition[0] == 0.5 && out.vecPosition[1] == 1 && out.vecPosition[2] == 0,
+		             "the device translation is added to the position");
+		ok &= expect(out.vecWorldFromDriverTranslation[2] == 3, "the world from driver translation is added");
+		ok &= expect(near(out.qDriverFromHeadRotation.w, h) && near(out.qDriverFromHeadRotation.x, h),
+		             "the driver from head rotation is applied");
+		ok &= expect(out.qWorldFromDriverRotation.w == 1 && out.vecDriverFromHeadTranslation[0] == 0,
+		             "identity parts leave their fields alone");
+		return ok;
+	}
+
+	bool testFakeDisconnect()
+	{
+		bool ok = true;
+		MockHost host;
+		FakeDevice device(1, host);
+		device.setMode(1);
+		device.poseUpdated(trackedPose(1));
+		device.poseUpdated(trackedPose(2));
+		ok &= expect(host.updates.size() == 1 && host.updates[0].device == 1 && disconnected(host.updates[0].pose),
+		             "mode 1 sends one disconnected pose, then nothing");
+		ok &= expect(device.compensated == 0, "and never compensates");
+
+		device.setMode(0);
+		device.poseUpdated(trackedPose(3));
+		ok &= expect(host.updates.size() == 2 && host.updates[1].pose.poseIsValid, "back in mode 0 poses pass again");
+		return ok;
+	}
+
+	bool testRedirect()
+	{
+		bool ok = true;
+		MockHost host;
+		FakeDevice source(1, host);
+		FakeDevice target(2, host);
+		source.setMode(2, &target);
+		target.setMode(3, &source);
+
+		source.poseUpdated(trackedPose(1));
+		ok &= expect(host.updates.size() == 2, "the first redirected pose also disconnects the source");
+		ok &= expect(host.updates[0].device == 2 && host.updates[0].pose.vecPosition[0] == 1,
+		             "the source's pose goes out as the target's");
+		ok &= expect(host.updates[1].device == 1 && disconnected(host.updates[1].pose), "the source shows as disconnected");
+
+		source.poseUpdated(trackedPose(2));
+		target.poseUpdated(trackedPose(9));
+		ok &= expect(host.updates.size() == 3 && host.updates[2].device == 2 && host.updates[2].pose.vecPosition[0] == 2,
+		             "afterwards only the redirected pose goes out, the target's own poses are dropped");
+
+		source.setMode(2, &target, true);
+		target.setMode(3, &source, true);
+		source.poseUpdated(trackedPose(3));
+		target.poseUpdated(trackedPose(4));
+		ok &= expect(host.updates.size() == 5 && host.updates[3].device == 1 && host.updates[3].pose.vecPosition[0] == 3
+		             && host.updates[4].device == 2 && host.updates[4].pose.vecPosition[0] == 4,
+		             "while suspended both devices send their own poses");
+		return ok;
+	}
+
+	bool testSwap()
+	{
+		bool ok = true;
+		MockHost host;
+		FakeDevice left(1, host);
+		FakeDevice right(2, host);
+		left.setMode(4, &right);
+		right.setMode(4, &left);
+		left.poseUpdated(trackedPose(1));
+		right.poseUpdated(trackedPose(2));
+		ok &= expect(host.updates.size() == 2 && host.updates[0].device == 2 && host.updates[0].pose.vecPosition[0] == 1
+		             && host.updates[1].device == 1 && host.updates[1].pose.vecPosition[0] == 2,
+		             "mode 4 sends each device's pose as the other's");
+		ok &= expect(left.compensated == 1 && right.compensated == 1, "swapped poses are compensated");
+		return ok;
+	}
+
+	bool testPublish()
+	{
+		bool ok = true;
+		typedef PoseConfig<FakeDevice> Config;
+		PublishedConfig<Config> published;
+		const Config* first = published.load();
+		ok &= expect(first != nullptr && first->deviceMode == 0, "a default config is there from the start");
+
+		std::unique_ptr<Config> next(new Config());
+		next->deviceMode = 4;
+		next->poseFilterGeneration = 4;
+		published.publish(std::move(next));
+		ok &= expect(published.load()->deviceMode == 4, "readers get the new config");
+		ok &= expect(first->deviceMode == 0 && published.publishedCount() == 2, "the replaced one is still readable");
+
+		// A reader racing with a publisher only ever sees complete configs
+		std::atomic<bool> done{false};
+		bool consistent = true;
+		std::thread reader([&]()
+		{
+			while (!done)
+			{
+				const Config* config = published.load();
+				consistent &= config->poseFilterGeneration == static_cast<unsigned>(config->deviceMode);
+			}
+		});
+		for (int i = 0; i < 10000; i++)
+		{
+			std::unique_ptr<Config> config(new Config());
+			config->deviceMode = i;
+			config->poseFilterGeneration = i;
+			published.publish(std::move(config));
+		}
+		done = true;
+		reader.join();
+		ok &= expect(consistent, "no reader sees a half written config");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testTransform();
+	ok &= testFakeDisconnect();
+	ok &= testRedirect();
+	ok &= testSwap();
+	ok &= testPublish();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
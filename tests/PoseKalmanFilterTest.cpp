@@ -0,0 +1,181 @@
+// Feeds PoseKalmanFilter a motion platform swaying and yawing on sinusoids at 90 Hz with jittered timestamps.
+// Checks that it follows position, rotation and both velocities, that it filters the timestamps it is given
+// rather than a nominal frame time, that it smooths a noisy resting pose, and that a gap, a clock going
+// backwards or a repeated timestamp are handled without predicting across them
+//
+// g++ -std=c++17 -O2 -Itests/stubs -Iexternal/inputemulator/lib_vrinputemulator/include
+//     -Iexternal/inputemulator/driver_vrinputemulator/src/devicemanipulation/utils
+//     tests/PoseKalmanFilterTest.cpp external/inputemulator/driver_vrinputemulator/src/devicemanipulation/utils/PoseKalmanFilter.cpp
+//     -o PoseKalmanFilterTest
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "PoseKalmanFilter.h"
+
+namespace
+{
+	using vrinputemulator::PoseFilterTuning;
+	using vrinputemulator::driver::PoseKalmanFilter;
+
+	// Sways 10cm along x at 2 rad/s and yaws 0.3 rad at 1.5 rad/s
+	struct Platform
+	{
+		static vr::HmdVector3d_t position(double time)
+		{
+			return {{0.1 * std::sin(2 * time), 1.0, 0.0}};
+		}
+
+		static double velocity(double time)
+		{
+			return 0.2 * std::cos(2 * time);
+		}
+
+		static vr::HmdQuaternion_t rotation(double time)
+		{
+			const double yaw = 0.3 * std::sin(1.5 * time);
+			return {std::cos(yaw / 2), 0, std::sin(yaw / 2), 0};
+		}
+
+		static double yawRate(double time)
+		{
+			return 0.45 * std::cos(1.5 * time);
+		}
+	};
+
+	// Follows the platform closely, like a motion compensation reference that must not lag
+	PoseFilterTuning responsive()
+	{
+		PoseFilterTuning tuning;
+		tuning.positionProcessNoise = 100;
+		tuning.positionObservationNoise = 1e-5;
+		tuning.rotationProcessNoise = 100;
+		tuning.rotationObservationNoise = 1e-5;
+		return tuning;
+	}
+
+	struct Errors
+	{
+		double velocity = 0;
+		double yawRate = 0;
+		double position = 0;
+	};
+
+	// Ten seconds at 90 Hz, samples taken up to jitter seconds late. With nominalTime the filter is told
+	// every sample came exactly one frame after the last, errors count after the first two seconds
+	Errors track(double jitter, bool nominalTime)
+	{
+		PoseKalmanFilter filter;
+		filter.setTuning(responsive());
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> late(0, jitter);
+		Errors errors;
+		for (int i = 0; i < 900; i++)
+		{
+			const double time = i / 90.0 + late(rng);
+			filter.update(Platform::position(time), Platform::rotation(time), nominalTime ? i / 90.0 : time);
+			if (i > 180)
+			{
+				errors.velocity = std::max(errors.velocity, std::fabs(filter.getUpdatedVelocityEstimate().v[0] - Platform::velocity(time)));
+				errors.yawRate = std::max(errors.yawRate,
+				                          std::fabs(filter.getUpdatedAngularVelocityEstimate().v[1] - Platform::yawRate(time)));
+				errors.position = std::max(errors.position,
+				                           std::fabs(filter.getUpdatedPositionEstimate().v[0] - Platform::position(time).v[0]));
+			}
+		}
+		return errors;
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testTracking()
+	{
+		bool ok = true;
+		const Errors jittered = track(0.004, false);
+		const Errors nominal = track(0.004, true);
+		std::printf("4ms jitter: velocity error %.4f m/s (peak 0.2), yaw rate error %.4f rad/s (peak 0.45), "
+		            "with nominal timestamps %.4f m/s, %.4f rad/s\n",
+		            jittered.velocity, jittered.yawRate, nominal.velocity, nominal.yawRate);
+		ok &= expect(jittered.velocity < 0.02, "the linear velocity follows the sway");
+		ok &= expect(jittered.yawRate < 0.03, "the angular velocity follows the yaw");
+		ok &= expect(jittered.position < 0.001, "the position follows within a millimetre");
+		ok &= expect(jittered.velocity * 1.5 < nominal.velocity && jittered.yawRate * 1.5 < nominal.yawRate,
+		             "filtering the real timestamps beats assuming a fixed frame time");
+		return ok;
+	}
+
+	bool testNoise()
+	{
+		PoseKalmanFilter filter;
+		std::mt19937 rng(2);
+		std::normal_distribution<double> noise(0, 0.002);
+		double measuredSquares = 0, estimatedSquares = 0;
+		int count = 0;
+		for (int i = 0; i < 900; i++)
+		{
+			const double measured = noise(rng);
+			filter.update({{measured, 1, 0}}, {1, 0, 0, 0}, i / 90.0);
+			if (i > 180)
+			{
+				measuredSquares += measured * measured;
+				estimatedSquares += filter.getUpdatedPositionEstimate().v[0] * filter.getUpdatedPositionEstimate().v[0];
+				count++;
+			}
+		}
+		const double measuredNoise = std::sqrt(measuredSquares / count);
+		const double estimatedNoise = std::sqrt(estimatedSquares / count);
+		std::printf("resting with 2mm noise: estimate %.3fmm\n", estimatedNoise * 1000);
+		return expect(estimatedNoise < measuredNoise / 3, "the default tuning smooths a noisy resting pose");
+	}
+
+	bool testTimeSteps()
+	{
+		bool ok = true;
+		PoseKalmanFilter filter;
+		filter.setTuning(responsive());
+		double time = 0;
+		for (int i = 0; i < 90; i++, time += 1 / 90.0)
+			filter.update(Platform::position(time), Platform::rotation(time), time);
+		ok &= expect(filter.getUpdatedVelocityEstimate().v[0] != 0, "moving after a second of samples");
+
+		// A repeated timestamp changes nothing
+		const vr::HmdVector3d_t before = filter.getUpdatedPositionEstimate();
+		filter.update({{5, 5, 5}}, {1, 0, 0, 0}, time - 1 / 90.0 + PoseKalmanFilter::minTimeStep / 2);
+		ok &= expect(filter.getUpdatedPositionEstimate().v[0] == before.v[0], "a step below minTimeStep is ignored");
+
+		// A gap starts over from the measurement
+		time += 1;
+		filter.update({{0.5, 1, 0}}, {1, 0, 0, 0}, time);
+		ok &= expect(filter.getUpdatedPositionEstimate().v[0] == 0.5 && filter.getUpdatedVelocityEstimate().v[0] == 0
+		             && filter.getUpdatedAngularVelocityEstimate().v[1] == 0, "a gap over maxTimeStep restarts the filter");
+
+		// A clock going backwards too, instead of dropping every sample until time catches up again
+		for (int i = 0; i < 20; i++)
+		{
+			time += 1 / 90.0;
+			filter.update({{0.5 + i * 0.01, 1, 0}}, {1, 0, 0, 0}, time);
+		}
+		time -= 0.3;
+		filter.update({{0.2, 1, 0}}, {1, 0, 0, 0}, time);
+		ok &= expect(filter.getUpdatedPositionEstimate().v[0] == 0.2 && filter.getUpdatedVelocityEstimate().v[0] == 0,
+		             "time going backwards restarts the filter");
+		filter.update({{0.21, 1, 0}}, {1, 0, 0, 0}, time + 1 / 90.0);
+		ok &= expect(filter.getUpdatedVelocityEstimate().v[0] > 0, "and the next sample is filtered from there");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testTracking();
+	ok &= testNoise();
+	ok &= testTimeSteps();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// Drives a virtual device's PoseSlot the way the driver does, against a mock driver host that records
+// every submitted pose: the frame loop keeps re-submitting a held pose, skips the frame right after the
+// IPC thread submitted one itself, and sends a pose stored without submitting on the next frame.
+// Then an IPC thread and a frame thread race and the host checks that no submitted pose is torn
+//
+// g++ -std=c++17 -O2 -pthread -Itests/stubs -Iexternal/inputemulator/driver_vrinputemulator/src/driver/utils
+//     tests/PoseSlotTest.cpp -o PoseSlotTest
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "PoseSlot.h"
+
+namespace
+{
+	using vrinputemulator::driver::PoseSlot;
+
+	// Every field of the pose set from one counter, so a pose mixing two writes is easy to spot
+	vr::DriverPose_t makePose(double value)
+	{
+		vr::DriverPose_t pose;
+		std::memset(&pose, 0, sizeof(pose));
+		pose.qRotation = { value, value, value, value };
+		for (int i = 0; i < 3; i++)
+		{
+			pose.vecPosition[i] = value;
+			pose.vecVelocity[i] = value;
+			pose.vecAngularVelocity[i] = value;
+		}
+		pose.poseIsValid = true;
+		pose.deviceIsConnected = true;
+		pose.result = vr::TrackingResult_Running_OK;
+		return pose;
+	}
+
+	bool isConsistent(const vr::DriverPose_t& pose)
+	{
+		const double value = pose.vecPosition[0];
+		for (int i = 0; i < 3; i++)
+		{
+			if (pose.vecPosition[i] != value || pose.vecVelocity[i] != value || pose.vecAngularVelocity[i] != value)
+				return false;
+		}
+		return pose.qRotation.w == value && pose.qRotation.x == value
+			&& pose.qRotation.y == value && pose.qRotation.z == value;
+	}
+
+	// Stands in for IVRServerDriverHost::TrackedDevicePoseUpdated
+	struct MockHost
+	{
+		std::atomic<int> submitted{0};
+		std::atomic<int> torn{0};
+		double lastValue = -1.0;
+
+		void trackedDevicePoseUpdated(const vr::DriverPose_t& pose)
+		{
+			if (!isConsistent(pose))
+				++torn;
+			lastValue = pose.vecPosition[0];
+			++submitted;
+		}
+	};
+
+	// What VirtualDeviceDriver::updatePose and ServerDriver::RunFrame do with the slot
+	void updatePose(PoseSlot& slot, MockHost& host, double value, bool submitNow)
+	{
+		slot.update(makePose(value), submitNow, [&host](const vr::DriverPose_t& pose) { host.trackedDevicePoseUpdated(pose); });
+	}
+
+	void runFrame(PoseSlot& slot, MockHost& host)
+	{
+		slot.submitForFrame([&host](const vr::DriverPose_t& pose) { host.trackedDevicePoseUpdated(pose); });
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+}
+
+int main()
+{
+	bool ok = true;
+
+	{
+		PoseSlot slot(makePose(0.0));
+		MockHost host;
+		for (int frame = 0; frame < 3; frame++)
+			runFrame(slot, host);
+		ok &= expect(host.submitted == 3, "a held pose is submitted again every frame");
+
+		updatePose(slot, host, 1.0, true);
+		ok &= expect(host.submitted == 4 && host.lastValue == 1.0, "the IPC thread submits a new pose right away");
+		runFrame(slot, host);
+		ok &= expect(host.submitted == 4, "the frame after an IPC submission skips the pose");
+		runFrame(slot, host);
+		ok &= expect(host.submitted == 5 && host.lastValue == 1.0, "the frame after that re-submits it again");
+
+		updatePose(slot, host, 2.0, false);
+		ok &= expect(host.submitted == 5, "a deferred pose is not submitted by the IPC thread");
+		runFrame(slot, host);
+		ok &= expect(host.submitted == 6 && host.lastValue == 2.0, "the next frame submits the deferred pose");
+	}
+
+	{
+		// About 1 kHz of poses against a 90 Hz frame loop, for half a second
+		PoseSlot slot(makePose(0.0));
+		MockHost ipcHost;
+		MockHost frameHost;
+		std::atomic<bool> running{true};
+		std::thread ipcThread([&]
+		{
+			double value = 0.0;
+			while (running)
+			{
+				updatePose(slot, ipcHost, ++value, true);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		int frames = 0;
+		const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+		while (std::chrono::steady_clock::now() < end)
+		{
+			runFrame(slot, frameHost);
+			++frames;
+			std::this_thread::sleep_for(std::chrono::microseconds(11111));
+		}
+		running = false;
+		ipcThread.join();
+
+		ok &= expect(ipcHost.torn == 0 && frameHost.torn == 0, "no submitted pose is torn");
+		ok &= expect(frameHost.submitted < frames / 2, "frames skip the poses the IPC thread already submitted");
+		std::printf("%d IPC poses, %d of %d frames re-submitted\n", ipcHost.submitted.load(), frameHost.submitted.load(), frames);
+	}
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+// Applies PropertyOverrides to property batches against fake IVRProperties. An hmd-only rule only rewrites
+// batches for the hmd's container, whether the hmd was seen being activated or is looked up once for a
+// container nobody activated, an any-device rule rewrites every batch, properties without a rule are left
+// alone, a re-added hmd's old container stops matching, and each rule logs once however often it applies
+//
+// g++ -std=c++17 -O2 -Itests/stubs -Iexternal/inputemulator/driver_vrinputemulator/src/driver
+//     tests/PropertyOverridesTest.cpp external/inputemulator/driver_vrinputemulator/src/driver/PropertyOverrides.cpp
+//     -o PropertyOverridesTest
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "PropertyOverrides.h"
+
+namespace
+{
+	using vrinputemulator::driver::PropertyOverrides;
+
+	// The hmd lives in container hmdContainer, every lookup is counted
+	struct FakeProperties : vr::IVRProperties
+	{
+		vr::PropertyContainerHandle_t hmdContainer = 100;
+		int lookups = 0;
+
+		vr::ETrackedPropertyError WritePropertyBatch(vr::PropertyContainerHandle_t, vr::PropertyWrite_t*, uint32_t) override
+		{
+			return vr::TrackedProp_Success;
+		}
+
+		vr::PropertyContainerHandle_t TrackedDeviceToPropertyContainer(uint32_t device) override
+		{
+			lookups++;
+			return device == vr::k_unTrackedDeviceIndex_Hmd ? hmdContainer : vr::k_ulInvalidPropertyContainer;
+		}
+	};
+
+	// What a device driver writes on activation: model, serial and manufacturer
+	struct Batch
+	{
+		char original[9] = "original";
+		vr::PropertyWrite_t entries[3] = {};
+
+		Batch()
+		{
+			const vr::ETrackedDeviceProperty props[] = {vr::Prop_ModelNumber_String, vr::Prop_SerialNumber_String,
+			                                            vr::Prop_ManufacturerName_String};
+			for (int i = 0; i < 3; i++)
+			{
+				entries[i].prop = props[i];
+				entries[i].writeType = vr::PropertyWrite_Set;
+				entries[i].pvBuffer = original;
+				entries[i].unBufferSize = sizeof(original);
+				entries[i].unTag = vr::k_unStringPropertyTag;
+			}
+		}
+
+		std::string value(int i) const
+		{
+			return std::string(static_cast<const char*>(entries[i].pvBuffer), entries[i].unBufferSize - 1);
+		}
+
+		std::string model() const { return value(0); }
+		std::string serial() const { return value(1); }
+		std::string manufacturer() const { return value(2); }
+	};
+
+	std::string applied(PropertyOverrides& overrides, FakeProperties& properties, vr::PropertyContainerHandle_t container,
+	                    std::string (Batch::*field)() const)
+	{
+		Batch batch;
+		overrides.apply(&properties, container, batch.entries, 3);
+		return (batch.*field)();
+	}
+
+	void addRules(PropertyOverrides& overrides)
+	{
+		overrides.addStringOverride(vr::Prop_ModelNumber_String, "Model X", PropertyOverrides::DeviceFilter::HmdOnly, "Hmd Model");
+		overrides.addStringOverride(vr::Prop_ManufacturerName_String, "Acme", PropertyOverrides::DeviceFilter::AnyDevice,
+		                            "Device Manufacturer");
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testContainers()
+	{
+		bool ok = true;
+		PropertyOverrides overrides;
+		FakeProperties properties;
+		ok &= expect(overrides.empty(), "no rules, nothing to do");
+		addRules(overrides);
+
+		// Indexed devices, the hmd as 0 and a controller as 3
+		overrides.deviceActivated(100, vr::k_unTrackedDeviceIndex_Hmd);
+		overrides.deviceActivated(200, 3);
+		ok &= expect(applied(overrides, properties, 100, &Batch::model) == "Model X", "the hmd's model is rewritten");
+		ok &= expect(applied(overrides, properties, 200, &Batch::model) == "original", "the controller's model is not");
+		ok &= expect(applied(overrides, properties, 200, &Batch::manufacturer) == "Acme", "any-device rules apply to it");
+		ok &= expect(applied(overrides, properties, 100, &Batch::serial) == "original", "a property without a rule is left alone");
+		ok &= expect(applied(overrides, properties, 300, &Batch::model) == "original", "an unknown container is no hmd");
+		ok &= expect(applied(overrides, properties, 300, &Batch::manufacturer) == "Acme", "but any-device rules still apply");
+		ok &= expect(properties.lookups == 0, "SteamVR isn't asked while the hmd's container is indexed");
+		return ok;
+	}
+
+	bool testHmdLookup()
+	{
+		bool ok = true;
+		PropertyOverrides overrides;
+		FakeProperties properties;
+		addRules(overrides);
+
+		// Nothing was seen being activated, the hmd's container is asked for once and kept
+		for (int i = 0; i < 100; i++)
+		{
+			ok &= expect(applied(overrides, properties, 300, &Batch::model) == "original", "an unknown container is no hmd");
+			ok &= expect(applied(overrides, properties, 100, &Batch::model) == "Model X", "the looked up hmd container is");
+		}
+		ok &= expect(properties.lookups == 1, "the hmd's container is looked up once");
+
+		Batch batch;
+		overrides.apply(&properties, 300, batch.entries, 1);
+		overrides.apply(nullptr, 100, batch.entries, 1);
+		ok &= expect(batch.model() == "Model X", "and cached, no properties needed afterwards");
+		return ok;
+	}
+
+	bool testHmdReadded()
+	{
+		bool ok = true;
+		PropertyOverrides overrides;
+		FakeProperties properties;
+		addRules(overrides);
+		overrides.deviceActivated(100, vr::k_unTrackedDeviceIndex_Hmd);
+		ok &= expect(applied(overrides, properties, 100, &Batch::model) == "Model X", "the first hmd container matches");
+
+		properties.hmdContainer = 150;
+		overrides.deviceActivated(150, vr::k_unTrackedDeviceIndex_Hmd);
+		ok &= expect(applied(overrides, properties, 150, &Batch::model) == "Model X", "the re-added hmd's container matches");
+		ok &= expect(applied(overrides, properties, 100, &Batch::model) == "original", "its old container no longer does");
+
+		// The old handle handed to another device
+		overrides.deviceActivated(150, 4);
+		ok &= expect(applied(overrides, properties, 150, &Batch::model) == "original", "a reused container belongs to its new device");
+		return ok;
+	}
+
+	bool testLogRate()
+	{
+		bool ok = true;
+		PropertyOverrides overrides;
+		FakeProperties properties;
+		addRules(overrides);
+		overrides.deviceActivated(100, vr::k_unTrackedDeviceIndex_Hmd);
+
+		std::ostringstream log;
+		std::streambuf* stderrBuffer = std::cerr.rdbuf(log.rdbuf());
+		for (int i = 0; i < 1000; i++)
+		{
+			Batch batch;
+			overrides.apply(&properties, 100, batch.entries, 3);
+		}
+		std::cerr.rdbuf(stderrBuffer);
+
+		const std::string lines = log.str();
+		auto count = [&lines](const char* text)
+		{
+			int n = 0;
+			for (size_t at = lines.find(text); at != std::string::npos; at = lines.find(text, at + 1))
+				n++;
+			return n;
+		};
+		ok &= expect(count("Overwriting Hmd Model: original => Model X") == 1, "the hmd model override logs once");
+		ok &= expect(count("Overwriting Device Manufacturer: original => Acme") == 1, "each rule logs on its own");
+		ok &= expect(count("\n") == 2, "nothing else is logged within logIntervalSeconds");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testContainers();
+	ok &= testHmdLookup();
+	ok &= testHmdReadded();
+	ok &= testLogRate();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+// Checks KMath::Quat against the helpers the Kinect filters carried before they moved onto it, copied
+// below as they were. Every function has to give bit for bit the same result on random quaternions,
+// including the near-identical and opposite pairs the slerp handles specially
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc tests/QuaternionMathTest.cpp -o QuaternionMathTest
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "QuaternionMath.h"
+
+namespace
+{
+	// Laid out like the Kinect SDKs' Vector4
+	struct Vector4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	// From DoubleExpBoneOrientationsFilter (KinectV2Process) before it forwarded to KMath::Quat
+	namespace Old
+	{
+		float length(Vector4 v)
+		{
+			return sqrt(v.w * v.w + v.x * v.x + v.y * v.y + v.z * v.z);
+		}
+
+		Vector4 normalisedQ(Vector4 a)
+		{
+			Vector4 v = a;
+			float magnitude = pow(length(v), 2);
+			v.w /= magnitude;
+			v.x /= magnitude;
+			v.y /= magnitude;
+			v.z /= magnitude;
+			return v;
+		}
+
+		Vector4 subtract(Vector4 left, Vector4 right)
+		{
+			return Vector4{left.x - right.x, left.y - right.y, left.z - right.z, left.w - right.w};
+		}
+
+		Vector4 add(Vector4 left, Vector4 right)
+		{
+			return Vector4{left.x + right.x, left.y + right.y, left.z + right.z, left.w + right.w};
+		}
+
+		Vector4 product(Vector4 q, float k)
+		{
+			return Vector4{k * q.x, k * q.y, k * q.z, k * q.w};
+		}
+
+		Vector4 conj(const Vector4 x)
+		{
+			return {-x.x, -x.y, -x.z, x.w};
+		}
+
+		float norm_squared(const Vector4 x)
+		{
+			return x.w * x.w + x.x * x.x + x.y * x.y + x.z * x.z;
+		}
+
+		float dot(Vector4 q1, Vector4 q2)
+		{
+			return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+		}
+
+		Vector4 product(const Vector4& lhs, const Vector4& rhs)
+		{
+			return {
+				(lhs.w * rhs.x) + (lhs.x * rhs.w) + (lhs.y * rhs.z) - (lhs.z * rhs.y),
+				(lhs.w * rhs.y) + (lhs.y * rhs.w) + (lhs.z * rhs.x) - (lhs.x * rhs.z),
+				(lhs.w * rhs.z) + (lhs.z * rhs.w) + (lhs.x * rhs.y) - (lhs.y * rhs.x),
+				(lhs.w * rhs.w) - (lhs.x * rhs.x) - (lhs.y * rhs.y) - (lhs.z * rhs.z)
+			};
+		}
+
+		Vector4 slerp(const Vector4& q1, const Vector4& q2, const float t)
+		{
+			// From wikipedia
+			Vector4 a = normalisedQ(q1);
+			Vector4 b = normalisedQ(q2);
+
+			// Compute the cosine of the angle between the two vectors.
+			double dproduct = dot(a, b);
+
+			// If the dot product is negative, the quaternions
+			// have opposite handed-ness and slerp won't take
+			// the shorter path. Fix by reversing one quaternion.
+			if (dproduct < 0.0f)
+			{
+				b = Vector4{-b.x, -b.y, -b.z, -b.w};
+				dproduct = -dproduct;
+			}
+			const double DOT_THRESHOLD = 0.9995;
+			if (dproduct > DOT_THRESHOLD)
+			{
+				// If the inputs are too close for comfort, linearly interpolate
+				// and normalize the result.
+				Vector4 result = add(a, product(subtract(b, a), t));
+				result = normalisedQ(result);
+				return result;
+			}
+			double theta_0 = acos(dproduct);
+			double theta = theta_0 * t; // theta = angle between v0 and result
+
+			double s0 = cos(theta) - dproduct * sin(theta) / sin(theta_0); // == sin(theta_0 - theta) / sin(theta_0)
+			double s1 = sin(theta) / sin(theta_0);
+
+			return (add(product(a, s0), product(b, s1)));
+		}
+	}
+
+	bool same(const Vector4& a, const Vector4& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Vector4)) == 0;
+	}
+
+	bool same(float a, float b)
+	{
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	struct Check
+	{
+		const char* name;
+		long mismatches = 0;
+
+		void operator()(bool equal)
+		{
+			mismatches += !equal;
+		}
+
+		bool report() const
+		{
+			if (mismatches)
+				std::printf("FAIL: %s differs from the old helper %ld times\n", name, mismatches);
+			return mismatches == 0;
+		}
+	};
+}
+
+int main()
+{
+	std::mt19937 rng(11);
+	std::normal_distribution<float> normal(0.f, 1.f);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+	auto randomUnit = [&]
+	{
+		Vector4 q{normal(rng), normal(rng), normal(rng), normal(rng)};
+		const float l = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		return Vector4{q.x / l, q.y / l, q.z / l, q.w / l};
+	};
+
+	Check multiply{"multiply"}, dot{"dot"}, lengthSquared{"lengthSquared"}, conjugate{"conjugate"},
+	      divide{"divideBySquaredLength"}, slerp{"slerp"}, batched{"batched multiply"};
+
+	const int count = 1000000;
+	for (int i = 0; i < count; ++i)
+	{
+		const Vector4 a = randomUnit();
+		Vector4 b = randomUnit();
+		// A quarter of the pairs close together or opposite, for both slerp branches and the sign flip
+		const float pick = uniform(rng);
+		if (pick < 0.125f)
+			b = KMath::Quat::multiply(a, Vector4{normal(rng) * 0.01f, normal(rng) * 0.01f, normal(rng) * 0.01f, 1.f});
+		else if (pick < 0.25f)
+			b = Vector4{-a.x, -a.y, -a.z, -a.w};
+		const float t = uniform(rng);
+		// Not quite unit length, like the filters' products drift
+		const Vector4 scaled{a.x * 1.01f, a.y * 1.01f, a.z * 1.01f, a.w * 1.01f};
+
+		multiply(same(KMath::Quat::multiply(a, b), Old::product(a, b)));
+		dot(same(KMath::Quat::dot(a, b), Old::dot(a, b)));
+		lengthSquared(same(KMath::Quat::lengthSquared(scaled), Old::norm_squared(scaled)));
+		conjugate(same(KMath::Quat::conjugate(a), Old::conj(a)));
+		divide(same(KMath::Quat::divideBySquaredLength(scaled), Old::normalisedQ(scaled)));
+		slerp(same(KMath::Quat::slerp(a, b, t), Old::slerp(a, b, t)));
+		slerp(same(KMath::Quat::slerp(scaled, b, t), Old::slerp(scaled, b, t)));
+	}
+
+	// The array form against the single one, which is checked against the old product above
+	KMath::Quat::QuaternionArray<25> lhs, rhs, out;
+	for (int round = 0; round < 10000; ++round)
+	{
+		for (int i = 0; i < 25; ++i)
+		{
+			lhs.set(i, randomUnit());
+			rhs.set(i, randomUnit());
+		}
+		const Vector4 single = randomUnit();
+		KMath::Quat::multiply(lhs, rhs, out);
+		for (int i = 0; i < 25; ++i)
+			batched(same(out.get<Vector4>(i), KMath::Quat::multiply(lhs.get<Vector4>(i), rhs.get<Vector4>(i))));
+		KMath::Quat::multiply(lhs, single, out);
+		for (int i = 0; i < 25; ++i)
+			batched(same(out.get<Vector4>(i), KMath::Quat::multiply(lhs.get<Vector4>(i), single)));
+	}
+
+	bool ok = true;
+	for (const Check* check : {&multiply, &dot, &lengthSquared, &conjugate, &divide, &slerp, &batched})
+		ok &= check->report();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
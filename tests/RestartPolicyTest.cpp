@@ -0,0 +1,73 @@
+// Walks RestartPolicy through a crash loop: the delay doubles from 0.5s up to 8s, the sixth crash
+// within two minutes keeps the process down, and crashes older than the window stop counting
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc tests/RestartPolicyTest.cpp -o RestartPolicyTest
+#include <cstdio>
+
+#include "RestartPolicy.h"
+
+namespace
+{
+	using std::chrono::milliseconds;
+	using std::chrono::seconds;
+
+	bool expectRestart(RestartPolicy& policy, RestartPolicy::clock::time_point now, milliseconds expectedDelay)
+	{
+		RestartPolicy::clock::duration delay{};
+		if (!policy.onCrash(now, delay))
+		{
+			std::printf("FAIL: expected a restart after %lldms\n", static_cast<long long>(expectedDelay.count()));
+			return false;
+		}
+		if (delay != expectedDelay)
+		{
+			std::printf("FAIL: restart delay %lldms, expected %lldms\n",
+			            static_cast<long long>(std::chrono::duration_cast<milliseconds>(delay).count()),
+			            static_cast<long long>(expectedDelay.count()));
+			return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	bool ok = true;
+	const auto start = RestartPolicy::clock::time_point{};
+
+	// Shortened limits to reach the cap before giving up
+	{
+		RestartPolicy policy(6, std::chrono::minutes(2), milliseconds(500), seconds(8));
+		const milliseconds expected[] = {milliseconds(500), seconds(1), seconds(2), seconds(4), seconds(8), seconds(8)};
+		for (int i = 0; i < 6; ++i)
+			ok &= expectRestart(policy, start + seconds(i), expected[i]);
+
+		RestartPolicy::clock::duration delay{};
+		if (policy.onCrash(start + seconds(6), delay))
+		{
+			std::printf("FAIL: restarted after too many crashes\n");
+			ok = false;
+		}
+	}
+
+	// Defaults: five restarts, then the crashes have to age out of the window
+	{
+		RestartPolicy policy;
+		for (int i = 0; i < 5; ++i)
+			ok &= expectRestart(policy, start + seconds(i), milliseconds(500) * (1 << i));
+
+		RestartPolicy::clock::duration delay{};
+		if (policy.onCrash(start + seconds(30), delay))
+		{
+			std::printf("FAIL: restarted a sixth time within the window\n");
+			ok = false;
+		}
+
+		// The first crash is older than two minutes now, the other four still count
+		ok &= expectRestart(policy, start + seconds(120) + milliseconds(1), seconds(8));
+		// Much later everything has aged out and the backoff starts over
+		ok &= expectRestart(policy, start + std::chrono::minutes(10), milliseconds(500));
+	}
+
+	return ok ? 0 : 1;
+}
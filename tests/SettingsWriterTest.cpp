@@ -0,0 +1,115 @@
+// Hammers SettingsWriter from several threads and checks every file is written exactly once
+// with the newest contents, through the real temp file and rename
+//
+// g++ -std=c++17 -O2 -pthread -Itests/stubs -ISFMLProject/inc tests/SettingsWriterTest.cpp -o SettingsWriterTest
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SettingsWriter.h"
+
+namespace
+{
+	const int k_threads = 8;
+	const int k_updatesPerThread = 2000;
+	// Longer than the writer's quiet period
+	const std::chrono::milliseconds k_settleTime(1000);
+
+	std::mutex writesMutex;
+	std::map<std::wstring, int> writes;
+
+	bool countingSink(const std::wstring& path, const std::string& contents)
+	{
+		{
+			std::lock_guard<std::mutex> lock(writesMutex);
+			++writes[path];
+		}
+		return SettingsWriter::writeFile(path, contents);
+	}
+
+	int writeCount(const std::wstring& path)
+	{
+		std::lock_guard<std::mutex> lock(writesMutex);
+		return writes[path];
+	}
+
+	std::string readFile(const std::filesystem::path& path)
+	{
+		std::ifstream is(path, std::ios::binary);
+		std::ostringstream contents;
+		contents << is.rdbuf();
+		return contents.str();
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+}
+
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "SettingsWriterTest";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	const std::wstring files[] = {
+		(directory / "ConfigSettings.cfg").wstring(),
+		(directory / "KinectToVR.cfg").wstring(),
+	};
+
+	bool ok = true;
+	{
+		SettingsWriter writer(countingSink);
+
+		// Queue order per file decides which contents are the newest, so take it under a lock
+		std::mutex orderMutex;
+		std::string newest[2];
+		std::atomic<int> sequence{0};
+		std::vector<std::thread> threads;
+		for (int t = 0; t < k_threads; ++t)
+		{
+			threads.emplace_back([&, t]
+			{
+				for (int i = 0; i < k_updatesPerThread; ++i)
+				{
+					const int file = (t + i) % 2;
+					std::lock_guard<std::mutex> lock(orderMutex);
+					newest[file] = "thread " + std::to_string(t) + " update " + std::to_string(sequence++);
+					writer.queue(files[file], newest[file]);
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		std::this_thread::sleep_for(k_settleTime);
+		for (int file = 0; file < 2; ++file)
+		{
+			ok &= expect(writeCount(files[file]) == 1, "burst of updates wasn't written exactly once");
+			ok &= expect(readFile(files[file]) == newest[file], "file doesn't hold the newest update");
+		}
+
+		// A later change is written again, flushing leaves nothing for the destructor
+		writer.queue(files[0], "after the burst");
+		writer.flush();
+		ok &= expect(writeCount(files[0]) == 2, "flush didn't write the later change once");
+		ok &= expect(readFile(files[0]) == "after the burst", "flush wrote stale contents");
+	}
+	ok &= expect(writeCount(files[0]) == 2 && writeCount(files[1]) == 1, "destructor rewrote unchanged files");
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+		ok &= expect(entry.path().extension() != ".tmp", "temp file left behind");
+	std::filesystem::remove_all(directory);
+
+	std::printf("%d updates from %d threads: %s\n", k_threads * k_updatesPerThread, k_threads, ok ? "ok" : "failed");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+// Builds skeleton overlay geometry with SkeletonOverlay::Renderer from hand made joints and from the v1 and v2
+// bone tables. Every drawn bone is one quad of two triangles as wide as its style says, every drawn joint a
+// fan of k_circleSegments triangles around its centre. Bones with both ends tracked and tracked joints get the
+// tracked style, bones with one end inferred and inferred joints the inferred one, and nothing is drawn for
+// lost joints, bones between two inferred joints or bones outside the joints. Calling update with the same
+// skeleton keeps the geometry, changing any point, state, bone table or style rebuilds it
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc -Iexternal/SFML/include tests/SkeletonOverlayTest.cpp tests/stubs/SFMLGraphics.cpp
+//     -o SkeletonOverlayTest
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "SkeletonOverlay.h"
+
+namespace
+{
+	using SkeletonOverlay::Bone;
+	using SkeletonOverlay::JointState;
+	using SkeletonOverlay::Renderer;
+
+	const size_t quadVertices = 6;
+	const size_t fanVertices = Renderer::k_circleSegments * 3;
+
+	float distance(sf::Vector2f a, sf::Vector2f b)
+	{
+		return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+	}
+
+	bool near(float a, float b)
+	{
+		return std::fabs(a - b) < 1e-4f;
+	}
+
+	// Checks the bone quad starting at vertex first runs from start to end with the given width and colour
+	bool isBone(const sf::VertexArray& vertices, size_t first, sf::Vector2f start, sf::Vector2f end, float width, sf::Color colour)
+	{
+		bool ok = true;
+		for (size_t i = first; i < first + quadVertices; i++)
+			ok &= vertices[i].color == colour;
+		// Triangles (0, 1, 2) and (0, 2, 3) of the quad start + offset, end + offset, end - offset, start - offset
+		const sf::Vector2f startSide = vertices[first].position, endSide = vertices[first + 1].position;
+		const sf::Vector2f endOther = vertices[first + 2].position, startOther = vertices[first + 5].position;
+		ok &= vertices[first + 3].position == startSide && vertices[first + 4].position == endOther;
+		ok &= near(distance(startSide, startOther), width) && near(distance(endSide, endOther), width);
+		ok &= near((startSide.x + startOther.x) / 2, start.x) && near((startSide.y + startOther.y) / 2, start.y);
+		ok &= near((endSide.x + endOther.x) / 2, end.x) && near((endSide.y + endOther.y) / 2, end.y);
+		return ok;
+	}
+
+	// Checks the joint fan starting at vertex first closes a circle of the given radius, with the point as the
+	// top left of its bounding box like sf::CircleShape
+	bool isJoint(const sf::VertexArray& vertices, size_t first, sf::Vector2f point, float radius, sf::Color colour)
+	{
+		bool ok = true;
+		const sf::Vector2f centre = point + sf::Vector2f(radius, radius);
+		for (size_t triangle = 0; triangle < static_cast<size_t>(Renderer::k_circleSegments); triangle++)
+		{
+			const size_t v = first + triangle * 3;
+			ok &= vertices[v].position == centre;
+			ok &= near(distance(vertices[v + 1].position, centre), radius) && near(distance(vertices[v + 2].position, centre), radius);
+			// Each triangle starts where the last one ended, the last one ends where the first started
+			const size_t next = first + (triangle + 1) % Renderer::k_circleSegments * 3;
+			ok &= vertices[v + 2].position == vertices[next + 1].position;
+			for (size_t i = v; i < v + 3; i++)
+				ok &= vertices[i].color == colour;
+		}
+		return ok;
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testStyling()
+	{
+		bool ok = true;
+		const SkeletonOverlay::Style style;
+		// A chain 0-1-2-3-4 plus bones to a joint that isn't there
+		const Bone bones[] = {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {-1, 0}};
+		const sf::Vector2f points[] = {{10, 10}, {10, 50}, {40, 50}, {40, 90}, {80, 90}};
+		const JointState states[] = {
+			JointState::Tracked, JointState::Tracked, JointState::Inferred, JointState::Inferred, JointState::NotTracked
+		};
+
+		Renderer renderer;
+		ok &= expect(renderer.update(bones, 6, points, states, 5, style), "the first update builds");
+		const sf::VertexArray& vertices = renderer.vertices();
+		ok &= expect(vertices.getPrimitiveType() == sf::Triangles, "as triangles");
+		// Bones 0-1 tracked and 1-2 inferred, 2-3 has both ends inferred, 3-4 a lost end and 4-5, -1-0 no joint
+		ok &= expect(vertices.getVertexCount() == 2 * quadVertices + 4 * fanVertices,
+		             "one quad per drawn bone and one fan per tracked or inferred joint");
+		if (vertices.getVertexCount() != 2 * quadVertices + 4 * fanVertices)
+			return false;
+
+		ok &= expect(isBone(vertices, 0, points[0], points[1], style.trackedBoneThickness, style.trackedBone),
+		             "a bone between tracked joints is thick and green");
+		ok &= expect(isBone(vertices, quadVertices, points[1], points[2], style.inferredBoneThickness, style.inferredBone),
+		             "a bone with an inferred end is thin and red");
+
+		const size_t joints = 2 * quadVertices;
+		ok &= expect(isJoint(vertices, joints, points[0], style.jointRadius, style.trackedJoint)
+		             && isJoint(vertices, joints + fanVertices, points[1], style.jointRadius, style.trackedJoint),
+		             "tracked joints are yellow circles, drawn over the bones");
+		ok &= expect(isJoint(vertices, joints + 2 * fanVertices, points[2], style.jointRadius, style.inferredJoint)
+		             && isJoint(vertices, joints + 3 * fanVertices, points[3], style.jointRadius, style.inferredJoint),
+		             "inferred ones red");
+
+		// A bone without length has no direction to be drawn across
+		const sf::Vector2f stacked[] = {{10, 10}, {10, 10}};
+		const JointState tracked[] = {JointState::Tracked, JointState::Tracked};
+		renderer.update(bones, 1, stacked, tracked, 2, style);
+		ok &= expect(vertices.getVertexCount() == 2 * fanVertices, "a bone between joints in the same place is skipped");
+
+		SkeletonOverlay::Style custom;
+		custom.trackedBoneThickness = 10;
+		custom.jointRadius = 7;
+		custom.trackedBone = sf::Color::Blue;
+		renderer.update(bones, 1, points, tracked, 2, custom);
+		ok &= expect(isBone(vertices, 0, points[0], points[1], 10, sf::Color::Blue) && isJoint(vertices, quadVertices, points[0], 7,
+		             custom.trackedJoint), "the style sets widths, radii and colours");
+		return ok;
+	}
+
+	bool testTables()
+	{
+		bool ok = true;
+		const SkeletonOverlay::Style style;
+		std::vector<sf::Vector2f> points;
+		for (int i = 0; i < KVR::KinectJointCount; i++)
+			points.push_back(sf::Vector2f(static_cast<float>(i * 20), static_cast<float>(i * i)));
+		std::vector<JointState> states(KVR::KinectJointCount, JointState::Tracked);
+
+		Renderer renderer;
+		const auto& v2 = KVR::JointMap::k_v2Bones;
+		renderer.update(v2.data(), v2.size(), points.data(), states.data(), KVR::KinectJointCount, style);
+		ok &= expect(renderer.vertices().getVertexCount() == 24 * quadVertices + 25 * fanVertices,
+		             "a fully tracked v2 skeleton is 24 bones and 25 joints");
+
+		const auto& v1 = KVR::JointMap::k_v1Bones;
+		renderer.update(v1.data(), v1.size(), points.data(), states.data(), KVR::JointMap::V1_Count, style);
+		ok &= expect(renderer.vertices().getVertexCount() == 19 * quadVertices + 20 * fanVertices,
+		             "a fully tracked v1 skeleton is 19 bones and 20 joints");
+
+		// Losing the v1 spine drops its joint and the two bones to it
+		states[KVR::JointMap::V1_Spine] = JointState::NotTracked;
+		renderer.update(v1.data(), v1.size(), points.data(), states.data(), KVR::JointMap::V1_Count, style);
+		ok &= expect(renderer.vertices().getVertexCount() == 17 * quadVertices + 19 * fanVertices,
+		             "a lost joint takes its bones with it");
+		return ok;
+	}
+
+	bool testRebuilds()
+	{
+		bool ok = true;
+		SkeletonOverlay::Style style;
+		const auto& bones = KVR::JointMap::k_v2Bones;
+		std::vector<sf::Vector2f> points(KVR::KinectJointCount);
+		for (int i = 0; i < KVR::KinectJointCount; i++)
+			points[i] = sf::Vector2f(static_cast<float>(i), static_cast<float>(2 * i));
+		std::vector<JointState> states(KVR::KinectJointCount, JointState::Tracked);
+		auto update = [&](Renderer& renderer)
+		{
+			return renderer.update(bones.data(), bones.size(), points.data(), states.data(), points.size(), style);
+		};
+
+		Renderer renderer;
+		ok &= expect(update(renderer), "the first frame builds");
+		const sf::Vector2f firstVertex = renderer.vertices()[0].position;
+		for (int i = 0; i < 100; i++)
+			ok &= expect(!update(renderer), "an unchanged skeleton is not rebuilt");
+		ok &= expect(renderer.vertices()[0].position == firstVertex, "and keeps its geometry");
+
+		points[3].x += 0.5f;
+		ok &= expect(update(renderer) && !update(renderer), "a moved joint rebuilds once");
+		states[7] = JointState::Inferred;
+		ok &= expect(update(renderer) && !update(renderer), "so does a joint changing state");
+		style.jointRadius = 5;
+		ok &= expect(update(renderer) && !update(renderer), "or a changed style");
+
+		const auto& v1 = KVR::JointMap::k_v1Bones;
+		ok &= expect(renderer.update(v1.data(), v1.size(), points.data(), states.data(), points.size(), style),
+		             "or another bone table");
+		ok &= expect(update(renderer), "and back");
+		ok &= expect(renderer.update(bones.data(), bones.size(), points.data(), states.data(), 20, style), "or fewer joints");
+
+		renderer.clear();
+		ok &= expect(renderer.vertices().getVertexCount() == 0, "clear drops the geometry");
+		ok &= expect(update(renderer) && renderer.vertices().getVertexCount() > 0, "and the next update builds it again");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testStyling();
+	ok &= testTables();
+	ok &= testRebuilds();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
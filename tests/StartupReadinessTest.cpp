@@ -0,0 +1,181 @@
+// Brings up simulated subsystems at scripted times and waits on them with the Readiness primitives the
+// startup uses: a Gate returns when it is signalled rather than at its timeout, waitUntil returns within a
+// poll interval of its condition holding and gives up at its deadline, and a Sequence waits on its steps in
+// order, stops at the first one that times out and reports how long each took
+//
+// g++ -std=c++17 -O2 -pthread -ISFMLProject/inc tests/StartupReadinessTest.cpp -o StartupReadinessTest
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "StartupReadiness.h"
+
+namespace
+{
+	using std::chrono::milliseconds;
+
+	// Sleeps are allowed to run late on a busy machine, never early
+	const milliseconds slack(40);
+
+	long long msSince(Readiness::clock::time_point start)
+	{
+		return std::chrono::duration_cast<milliseconds>(Readiness::clock::now() - start).count();
+	}
+
+	// Runs ready after delay on its own thread, like a subsystem coming up
+	struct Subsystem
+	{
+		std::thread thread;
+
+		template <typename Ready>
+		Subsystem(milliseconds delay, Ready ready)
+			: thread([delay, ready]
+			{
+				std::this_thread::sleep_for(delay);
+				ready();
+			})
+		{
+		}
+
+		~Subsystem()
+		{
+			thread.join();
+		}
+	};
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testGate()
+	{
+		bool ok = true;
+		Readiness::Gate gate;
+		auto start = Readiness::clock::now();
+		ok &= expect(!gate.waitFor(milliseconds(30)), "a gate nobody signals times out");
+		ok &= expect(msSince(start) >= 30, "after its timeout");
+
+		start = Readiness::clock::now();
+		{
+			Subsystem sensor(milliseconds(30), [&gate] { gate.signal(); });
+			ok &= expect(gate.waitFor(milliseconds(2000)), "a gate signalled in time is ready");
+		}
+		const long long elapsed = msSince(start);
+		ok &= expect(elapsed >= 30 && elapsed < 30 + slack.count(), "the wait ends when it is signalled, not at the timeout");
+		ok &= expect(gate.isSet() && gate.waitFor(milliseconds(0)), "a signalled gate stays set");
+
+		gate.reset();
+		ok &= expect(!gate.isSet() && !gate.waitFor(milliseconds(0)), "until it is reset");
+		return ok;
+	}
+
+	bool testWaitUntil()
+	{
+		bool ok = true;
+		int asked = 0;
+		ok &= expect(Readiness::waitUntil([&asked] { return ++asked > 0; }, milliseconds(0)) && asked == 1,
+		             "a condition that already holds is asked once, even without time left");
+
+		std::atomic<bool> runtime{false};
+		auto start = Readiness::clock::now();
+		{
+			Subsystem vr(milliseconds(50), [&runtime] { runtime = true; });
+			ok &= expect(Readiness::waitUntil([&runtime] { return runtime.load(); }, milliseconds(2000), milliseconds(10)),
+			             "a condition that comes to hold in time is ready");
+		}
+		const long long elapsed = msSince(start);
+		ok &= expect(elapsed >= 50 && elapsed < 50 + 10 + slack.count(), "noticed within a poll interval");
+
+		asked = 0;
+		start = Readiness::clock::now();
+		ok &= expect(!Readiness::waitUntil([&asked] { ++asked; return false; }, milliseconds(45), milliseconds(20)),
+		             "a condition that never holds times out");
+		const long long timedOut = msSince(start);
+		ok &= expect(timedOut >= 45 && timedOut < 45 + slack.count(), "at the deadline, the last sleep is cut short");
+		ok &= expect(asked >= 3 && asked <= 5, "asked once per poll interval and at the deadline");
+		return ok;
+	}
+
+	bool testSequence()
+	{
+		bool ok = true;
+		Readiness::Gate pipes;
+		std::atomic<bool> runtime{false};
+		int emulatorAsked = 0;
+		bool lastStepRan = false;
+
+		Readiness::Sequence startup;
+		startup.step("driver pipes", milliseconds(500), [&pipes](Readiness::clock::duration timeout)
+		{
+			return pipes.waitFor(timeout);
+		}).step("VR runtime", milliseconds(500), [&runtime](Readiness::clock::duration timeout)
+		{
+			return Readiness::waitUntil([&runtime] { return runtime.load(); }, timeout);
+		}).step("input emulator", milliseconds(60), [&emulatorAsked](Readiness::clock::duration timeout)
+		{
+			return Readiness::waitUntil([&emulatorAsked] { ++emulatorAsked; return false; }, timeout, milliseconds(20));
+		}).step("after", milliseconds(500), [&lastStepRan](Readiness::clock::duration)
+		{
+			lastStepRan = true;
+			return true;
+		});
+
+		bool ready;
+		{
+			Subsystem driver(milliseconds(30), [&pipes] { pipes.signal(); });
+			Subsystem vr(milliseconds(80), [&runtime] { runtime = true; });
+			ready = startup.run();
+		}
+		ok &= expect(!ready, "a step that times out fails the sequence");
+		ok &= expect(!lastStepRan, "and the steps after it are not waited on");
+
+		const std::vector<Readiness::Sequence::StepResult>& results = startup.results();
+		ok &= expect(results.size() == 3, "one result per step that ran");
+		if (results.size() != 3)
+			return false;
+		ok &= expect(results[0].name == "driver pipes" && results[0].ready && results[1].ready && !results[2].ready,
+		             "results keep the step order");
+		const auto ms = [](Readiness::clock::duration d)
+		{
+			return std::chrono::duration_cast<milliseconds>(d).count();
+		};
+		ok &= expect(ms(results[0].elapsed) >= 30 && ms(results[0].elapsed) < 30 + slack.count(),
+		             "the first step takes until its subsystem is up");
+		ok &= expect(ms(results[1].elapsed) >= 80 - 30 - slack.count() && ms(results[1].elapsed) < 80 - 30 + slack.count(),
+		             "the second only waits the rest of the way, they come up in parallel");
+		ok &= expect(ms(results[2].elapsed) >= 60 && emulatorAsked >= 3, "the third waits out its own timeout");
+
+		const std::string summary = startup.summary();
+		std::printf("%s\n", summary.c_str());
+		ok &= expect(summary.find("driver pipes ") == 0 && summary.find(", VR runtime ") != std::string::npos
+		             && summary.find(", input emulator timed out after ") != std::string::npos,
+		             "the summary names every step and the one that timed out");
+
+		// With everything up already nothing is waited for
+		Readiness::Sequence restart;
+		restart.step("driver pipes", milliseconds(500), [&pipes](Readiness::clock::duration timeout)
+		{
+			return pipes.waitFor(timeout);
+		}).step("VR runtime", milliseconds(500), [&runtime](Readiness::clock::duration timeout)
+		{
+			return Readiness::waitUntil([&runtime] { return runtime.load(); }, timeout);
+		});
+		const auto start = Readiness::clock::now();
+		ok &= expect(restart.run() && restart.results().size() == 2, "a sequence of ready steps is ready");
+		ok &= expect(msSince(start) < slack.count(), "without waiting");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testGate();
+	ok &= testWaitUntil();
+	ok &= testSequence();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
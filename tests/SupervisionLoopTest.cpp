@@ -0,0 +1,147 @@
+// Supervises forked dummy children with Supervision::superviseLoop, the way the crash handlers supervise the
+// Kinect processes. Each child exits with the next code of a script or aborts; the loop has to free the Kinect
+// after every exit, stop on a clean exit, restart crashed children after RestartPolicy's doubling delays, give
+// up on a crash loop, and stop when it may not restart or a restart fails
+//
+// g++ -std=c++17 -O2 -ISFMLProject/inc tests/SupervisionLoopTest.cpp -o SupervisionLoopTest
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "SupervisionLoop.h"
+
+namespace
+{
+	using std::chrono::milliseconds;
+
+	// Exit code of a child that aborts instead of exiting
+	const int k_abort = -1;
+
+	// Forks one dummy child per launch, each exiting with the next code of the script
+	struct DummyProcess
+	{
+		std::vector<int> script;
+		size_t launches = 0;
+		pid_t pid = -1;
+
+		bool launch()
+		{
+			if (launches == script.size())
+				return false;
+			const int code = script[launches++];
+			pid = fork();
+			if (pid == 0)
+			{
+				std::this_thread::sleep_for(milliseconds(5));
+				if (code == k_abort)
+					std::abort();
+				_exit(code);
+			}
+			return pid > 0;
+		}
+
+		// Blocks until the child is gone, a signal counts as a crash like an exception code does on Windows
+		int waitForExit()
+		{
+			int status = 0;
+			if (pid <= 0 || waitpid(pid, &status, 0) != pid)
+				return 0;
+			pid = -1;
+			return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+		}
+	};
+
+	struct Run
+	{
+		Supervision::LoopEnd end;
+		int exits;
+		std::vector<RestartPolicy::clock::duration> delays;
+	};
+
+	Run supervise(DummyProcess& process, RestartPolicy& policy, bool canRestart)
+	{
+		Run run{Supervision::LoopEnd::Closed, 0, {}};
+		process.launch();
+		run.end = Supervision::superviseLoop(policy, canRestart,
+			[&]() { return process.waitForExit(); },
+			[&]() { run.exits++; },
+			[&]() { return process.launch(); },
+			[&](RestartPolicy::clock::duration delay)
+			{
+				run.delays.push_back(delay);
+				std::this_thread::sleep_for(delay);
+			});
+		return run;
+	}
+
+	// Delays of 1ms, 2ms, 4ms and then 8ms, at most three restarts
+	RestartPolicy shortPolicy()
+	{
+		return RestartPolicy(3, std::chrono::minutes(2), milliseconds(1), milliseconds(8));
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+}
+
+int main()
+{
+	bool ok = true;
+
+	{
+		DummyProcess process{{0}};
+		RestartPolicy policy = shortPolicy();
+		const Run run = supervise(process, policy, true);
+		ok &= expect(run.end == Supervision::LoopEnd::Closed && run.exits == 1 && process.launches == 1,
+		             "a clean exit frees the Kinect and ends supervision");
+	}
+
+	{
+		DummyProcess process{{3, k_abort, 0}};
+		RestartPolicy policy = shortPolicy();
+		const Run run = supervise(process, policy, true);
+		ok &= expect(run.end == Supervision::LoopEnd::Closed && process.launches == 3,
+		             "crashed and aborted children are restarted until one exits cleanly");
+		ok &= expect(run.exits == 3, "the Kinect is freed after every exit");
+		ok &= expect(run.delays == std::vector<RestartPolicy::clock::duration>{milliseconds(1), milliseconds(2)},
+		             "after the policy's doubling delays");
+	}
+
+	{
+		DummyProcess process{{1, 1, 1, 1, 1, 0}};
+		RestartPolicy policy = shortPolicy();
+		const Run run = supervise(process, policy, true);
+		ok &= expect(run.end == Supervision::LoopEnd::CrashLoop && process.launches == 4 && run.exits == 4,
+		             "a crash loop is left down after the policy's three restarts");
+		ok &= expect(run.delays.size() == 3 && run.delays.back() == milliseconds(4), "the last after 4ms");
+	}
+
+	{
+		DummyProcess process{{2, 0}};
+		RestartPolicy policy = shortPolicy();
+		const Run run = supervise(process, policy, false);
+		ok &= expect(run.end == Supervision::LoopEnd::NoRestart && process.launches == 1 && run.exits == 1
+		             && run.delays.empty(), "without a way to restart a crash ends supervision");
+	}
+
+	{
+		DummyProcess process{{2}};
+		RestartPolicy policy = shortPolicy();
+		const Run run = supervise(process, policy, true);
+		ok &= expect(run.end == Supervision::LoopEnd::LaunchFailed && run.exits == 1 && run.delays.size() == 1,
+		             "so does a restart that fails to launch");
+	}
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
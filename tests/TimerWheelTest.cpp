@@ -0,0 +1,158 @@
+// Drives the input remapping TimerWheel with a fake clock: timers fire in order of their due time, cancelled
+// ones never fire, timers more than one turn of the wheel away wait for their turn, and a chain of timers
+// that fell behind a stall carries on from now through TimerWheel::next instead of catching up one per frame
+//
+// g++ -std=c++17 -O2 -pthread -Iexternal/inputemulator/driver_vrinputemulator/src/devicemanipulation/utils
+//     tests/TimerWheelTest.cpp -o TimerWheelTest
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "TimerWheel.h"
+
+namespace
+{
+	// Milliseconds that only move when the test says so
+	struct FakeClock
+	{
+		typedef std::chrono::milliseconds duration;
+		typedef std::chrono::time_point<FakeClock, duration> time_point;
+
+		static time_point current;
+
+		static time_point now()
+		{
+			return current;
+		}
+	};
+
+	FakeClock::time_point FakeClock::current{};
+
+	typedef vrinputemulator::driver::TimerWheel<FakeClock> Wheel;
+
+	FakeClock::time_point at(int ms)
+	{
+		return FakeClock::time_point(std::chrono::milliseconds(ms));
+	}
+
+	// Moves the clock and advances the wheel, like one frame of ServerDriver::RunFrame
+	size_t frame(Wheel& wheel, int ms)
+	{
+		FakeClock::current = at(ms);
+		return wheel.advance();
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testOrderAndCancel()
+	{
+		bool ok = true;
+		FakeClock::current = at(0);
+		Wheel wheel(std::chrono::milliseconds(1), 16, at(0));
+		std::vector<int> fired;
+		auto record = [&fired](int value)
+		{
+			return [&fired, value](Wheel::TimerId, Wheel::time_point) { fired.push_back(value); };
+		};
+
+		wheel.schedule(at(5), record(5));
+		wheel.schedule(at(3), record(3));
+		const Wheel::TimerId cancelled = wheel.schedule(at(4), record(4));
+		// Same due time, fire in the order they were scheduled
+		wheel.schedule(at(5), record(6));
+		ok &= expect(wheel.cancel(cancelled), "a pending timer can be cancelled");
+		ok &= expect(!wheel.cancel(cancelled), "cancelling twice reports false");
+		ok &= expect(!wheel.cancel(0), "id 0 is never a timer");
+
+		ok &= expect(frame(wheel, 2) == 0, "nothing fires early");
+		ok &= expect(frame(wheel, 10) == 3, "everything due fires in one advance");
+		ok &= expect(fired == std::vector<int>({3, 5, 6}), "timers fire in order of their due time, cancelled ones not at all");
+		ok &= expect(wheel.pending() == 0, "fired timers are no longer pending");
+
+		// A callback cancelling a later timer due in the same advance
+		Wheel::TimerId victim = 0;
+		wheel.schedule(at(20), [&](Wheel::TimerId, Wheel::time_point) { fired.push_back(20); wheel.cancel(victim); });
+		victim = wheel.schedule(at(21), record(21));
+		frame(wheel, 30);
+		ok &= expect(fired.back() == 20, "a timer cancelled by an earlier callback doesn't fire");
+		return ok;
+	}
+
+	bool testFarTimers()
+	{
+		bool ok = true;
+		FakeClock::current = at(0);
+		// One turn is 16ms
+		Wheel wheel(std::chrono::milliseconds(1), 16, at(0));
+		Wheel::time_point firedDue{};
+		int fired = 0;
+		wheel.schedule(at(40), [&](Wheel::TimerId, Wheel::time_point due) { fired++; firedDue = due; });
+
+		// Slot 8 comes up at 8 and 24 before 40
+		for (int ms = 1; ms < 40; ms++)
+			frame(wheel, ms);
+		ok &= expect(fired == 0, "a timer more than one turn away waits for its turn");
+		frame(wheel, 40);
+		ok &= expect(fired == 1 && firedDue == at(40), "and fires at its due time, with its due time");
+
+		// Nobody advanced for several turns
+		wheel.schedule(at(100), [&](Wheel::TimerId, Wheel::time_point) { fired++; });
+		ok &= expect(frame(wheel, 500) == 1 && fired == 2, "after a long pause every slot is looked at once");
+		return ok;
+	}
+
+	// A chain of 100ms timers like auto-trigger, each scheduling the next from inside its callback
+	bool testStalledChain(bool catchUp)
+	{
+		FakeClock::current = at(0);
+		Wheel wheel(std::chrono::milliseconds(1), 256, at(0));
+		std::vector<int> firedAt;
+		std::function<void(Wheel::TimerId, Wheel::time_point)> press = [&](Wheel::TimerId, Wheel::time_point due)
+		{
+			firedAt.push_back(static_cast<int>(FakeClock::now().time_since_epoch().count()));
+			const Wheel::time_point next = catchUp ? due + std::chrono::milliseconds(100)
+			                                       : Wheel::next(due, std::chrono::milliseconds(100));
+			wheel.schedule(next, press);
+		};
+		wheel.schedule(at(100), press);
+
+		// 90 Hz frames, with a half second stall after the first press
+		int ms = 0;
+		for (; ms <= 100; ms += 11)
+			frame(wheel, ms);
+		ms = 600;
+		int framesWithPress = 0;
+		for (int i = 0; i < 6; i++, ms += 11)
+		{
+			const size_t before = firedAt.size();
+			frame(wheel, ms);
+			framesWithPress += firedAt.size() > before;
+		}
+		const bool burst = framesWithPress > 1;
+		std::printf("%s: a press in %d of the 6 frames after the stall\n", catchUp ? "due + interval" : "TimerWheel::next",
+		            framesWithPress);
+		return catchUp ? burst : !burst;
+	}
+}
+
+int main()
+{
+	bool ok = testOrderAndCancel();
+	ok &= testFarTimers();
+	ok &= expect(testStalledChain(true), "counting from the previous due time catches up one press per frame");
+	ok &= expect(testStalledChain(false), "TimerWheel::next sends one press after a stall, then keeps the interval");
+
+	{
+		FakeClock::current = at(1000);
+		ok &= expect(Wheel::next(at(990), std::chrono::milliseconds(100)) == at(1090), "next is interval after a recent due");
+		ok &= expect(Wheel::next(at(500), std::chrono::milliseconds(100)) == at(1000), "next is never in the past");
+	}
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
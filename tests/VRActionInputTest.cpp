@@ -0,0 +1,269 @@
+// Drives VRActionInput against a mock IVRInput and VRcontroller against a mock IVRSystem, counting the
+// SteamVR calls each makes per frame: one UpdateActionState plus one read per bound action, press and
+// release events only on edges, legacy mode on InvalidHandle, and for the controllers one state call each
+// with the role only looked up again on device events. Also checks the manifest test initialiseVRInput
+// uses to decide between the actions and legacy input once, at startup
+//
+// g++ -std=c++17 -O2 -Itests/stubs -ISFMLProject/inc -Iexternal/SFML/include
+//     tests/VRActionInputTest.cpp -o VRActionInputTest
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <openvr.h>
+
+// VRcontroller hands the left controller's pose to the settings
+namespace KinectSettings
+{
+	vr::TrackedDevicePose_t controllersPose[2];
+}
+
+#include "VRActionInput.h"
+#include "VRController.h"
+
+namespace
+{
+	typedef std::pair<vr::VRActionHandle_t, vr::VRInputValueHandle_t> ActionSource;
+
+	// Hands out a handle per path, and keeps the action data SteamVR would report per action and source
+	struct MockInput : vr::IVRInput
+	{
+		std::map<std::string, uint64_t> handles;
+		std::map<ActionSource, vr::InputDigitalActionData_t> digital;
+		std::map<ActionSource, vr::InputAnalogActionData_t> analog;
+		vr::EVRInputError updateResult = vr::VRInputError_None;
+		int updates = 0;
+		int reads = 0;
+
+		uint64_t handle(const char* path)
+		{
+			uint64_t& value = handles[path];
+			if (value == 0)
+				value = handles.size();
+			return value;
+		}
+
+		vr::EVRInputError SetActionManifestPath(const char*) override
+		{
+			return vr::VRInputError_None;
+		}
+
+		vr::EVRInputError GetActionSetHandle(const char* path, vr::VRActionSetHandle_t* out) override
+		{
+			*out = handle(path);
+			return vr::VRInputError_None;
+		}
+
+		vr::EVRInputError GetActionHandle(const char* path, vr::VRActionHandle_t* out) override
+		{
+			*out = handle(path);
+			return vr::VRInputError_None;
+		}
+
+		vr::EVRInputError GetInputSourceHandle(const char* path, vr::VRInputValueHandle_t* out) override
+		{
+			*out = handle(path);
+			return vr::VRInputError_None;
+		}
+
+		vr::EVRInputError UpdateActionState(vr::VRActiveActionSet_t* sets, uint32_t size, uint32_t count) override
+		{
+			++updates;
+			if (size != sizeof(*sets) || count != 1)
+				return vr::VRInputError_WrongType;
+			return updateResult;
+		}
+
+		vr::EVRInputError GetDigitalActionData(vr::VRActionHandle_t action, vr::InputDigitalActionData_t* data, uint32_t,
+		                                       vr::VRInputValueHandle_t source) override
+		{
+			++reads;
+			vr::InputDigitalActionData_t& current = digital[{action, source}];
+			*data = current;
+			current.bChanged = false;
+			return vr::VRInputError_None;
+		}
+
+		vr::EVRInputError GetAnalogActionData(vr::VRActionHandle_t action, vr::InputAnalogActionData_t* data, uint32_t,
+		                                      vr::VRInputValueHandle_t source) override
+		{
+			++reads;
+			*data = analog[{action, source}];
+			return vr::VRInputError_None;
+		}
+
+		void press(const char* action, const char* source, bool state)
+		{
+			vr::InputDigitalActionData_t& data = digital[{handle(action), handle(source)}];
+			data.bActive = true;
+			data.bChanged = data.bState != state;
+			data.bState = state;
+		}
+	};
+
+	// The left hand is device 3 until a test moves it, the right one 4
+	struct MockSystem : vr::IVRSystem
+	{
+		vr::TrackedDeviceIndex_t leftIndex = 3;
+		uint64_t pressed = 0;
+		int roleLookups = 0;
+		int stateCalls = 0;
+
+		vr::TrackedDeviceIndex_t GetTrackedDeviceIndexForControllerRole(vr::ETrackedControllerRole role) override
+		{
+			++roleLookups;
+			return role == vr::TrackedControllerRole_LeftHand ? leftIndex : 4;
+		}
+
+		bool IsTrackedDeviceConnected(vr::TrackedDeviceIndex_t) override
+		{
+			return true;
+		}
+
+		bool GetControllerStateWithPose(vr::ETrackingUniverseOrigin, vr::TrackedDeviceIndex_t index,
+		                                vr::VRControllerState_t* state, uint32_t, vr::TrackedDevicePose_t* pose) override
+		{
+			++stateCalls;
+			if (index == vr::k_unTrackedDeviceIndexInvalid)
+				return false;
+			*state = {};
+			state->ulButtonPressed = pressed;
+			*pose = {};
+			// Tags the pose with the device it came from
+			pose->mDeviceToAbsoluteTracking.m[0][3] = static_cast<float>(index);
+			return true;
+		}
+
+		void TriggerHapticPulse(vr::TrackedDeviceIndex_t, uint32_t, unsigned short) override
+		{
+		}
+	};
+
+	const char* const trigger = "/actions/calibration/in/Trigger";
+	const char* const rightHand = "/user/hand/right";
+	const char* const leftHand = "/user/hand/left";
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testActions()
+	{
+		bool ok = true;
+		MockInput input;
+		VRActionInput actions;
+		ok &= expect(actions.init(&input, "/actions/calibration") == vr::VRInputError_None, "the action set is found");
+		const VRActionInput::ActionId move = actions.addAnalog("/actions/calibration/in/MoveHorizontally");
+		const VRActionInput::ActionId rightTrigger = actions.addDigital(trigger, rightHand);
+		const VRActionInput::ActionId leftTrigger = actions.addDigital(trigger, leftHand);
+		ok &= expect(move >= 0 && rightTrigger >= 0 && leftTrigger >= 0, "every action is bound");
+
+		vr::InputAnalogActionData_t stick = {};
+		stick.bActive = true;
+		stick.x = 0.5f;
+		input.analog[{input.handle("/actions/calibration/in/MoveHorizontally"), vr::k_ulInvalidInputValueHandle}] = stick;
+		ok &= expect(actions.update() == vr::VRInputError_None, "the update succeeds");
+		ok &= expect(input.updates == 1 && input.reads == 3, "one UpdateActionState and one read per action");
+		ok &= expect(actions.getAnalog(move).bActive && actions.getAnalog(move).x == 0.5f, "the analog value is read");
+		ok &= expect(!actions.isActive(rightTrigger), "an action nothing reported is inactive");
+
+		VRActionInput::DigitalEvent event;
+		ok &= expect(!actions.pollEvent(event), "no event before anything is pressed");
+
+		input.press(trigger, rightHand, true);
+		actions.update();
+		ok &= expect(actions.getState(rightTrigger) && !actions.getState(leftTrigger), "the right trigger alone is held");
+		ok &= expect(actions.pollEvent(event) && event.action == rightTrigger && event.pressed, "the press is queued");
+		ok &= expect(!actions.pollEvent(event), "one event per press");
+		actions.update();
+		ok &= expect(!actions.pollEvent(event), "holding the trigger queues nothing more");
+
+		input.press(trigger, rightHand, false);
+		input.press(trigger, leftHand, true);
+		actions.update();
+		ok &= expect(actions.pollEvent(event) && event.action == rightTrigger && !event.pressed, "the release is queued");
+		ok &= expect(actions.pollEvent(event) && event.action == leftTrigger && event.pressed, "the other hand is separate");
+		ok &= expect(input.updates == 4 && input.reads == 12, "still one UpdateActionState per update");
+
+		input.updateResult = vr::VRInputError_InvalidHandle;
+		ok &= expect(actions.update() == vr::VRInputError_InvalidHandle && actions.isLegacyMode(),
+		             "InvalidHandle means legacy mode");
+		ok &= expect(input.reads == 12, "nothing is read in legacy mode");
+		ok &= expect(!actions.isActive(leftTrigger) && !actions.getState(leftTrigger), "legacy mode leaves no state behind");
+		return ok;
+	}
+
+	bool testManifest()
+	{
+		bool ok = true;
+		const std::string manifest =
+			"{\"actions\": [{\"name\": \"/actions/calibration/in/moveHorizontally\", \"type\": \"vector2\"},"
+			" {\"name\": \"/actions/calibration/in/Triggered\", \"type\": \"boolean\"}]}";
+		ok &= expect(VRActionInput::manifestDeclares(manifest, "/actions/calibration/in/MoveHorizontally"),
+		             "action paths match regardless of case");
+		ok &= expect(!VRActionInput::manifestDeclares(manifest, trigger), "a longer name isn't the action");
+		ok &= expect(!VRActionInput::manifestDeclares("", trigger), "a missing manifest declares nothing");
+		return ok;
+	}
+
+	bool testControllers()
+	{
+		bool ok = true;
+		MockSystem system;
+		vr::IVRSystem* systemPointer = &system;
+		VRcontroller left(vr::TrackedControllerRole_LeftHand);
+		VRcontroller right(vr::TrackedControllerRole_RightHand);
+		left.Connect(systemPointer);
+		right.Connect(systemPointer);
+
+		const int lookups = system.roleLookups;
+		int calls = system.stateCalls;
+		for (int frame = 0; frame < 100; frame++)
+		{
+			left.update(0.01f);
+			right.update(0.01f);
+		}
+		ok &= expect(system.roleLookups == lookups, "roles aren't looked up every frame");
+		ok &= expect(system.stateCalls == calls + 200, "one state call per controller per frame");
+		ok &= expect(KinectSettings::controllersPose[0].mDeviceToAbsoluteTracking.m[0][3] == 3.f,
+		             "the left pose comes with its state");
+
+		vr::VREvent_t event = {vr::VREvent_TrackedDeviceUpdated, 3, 0.f};
+		left.handleEvent(event);
+		ok &= expect(system.roleLookups == lookups, "unrelated events don't look the role up");
+		system.leftIndex = 7;
+		event.eventType = vr::VREvent_TrackedDeviceRoleChanged;
+		left.handleEvent(event);
+		left.update(0.f);
+		ok &= expect(left.getID() == 7 && KinectSettings::controllersPose[0].mDeviceToAbsoluteTracking.m[0][3] == 7.f,
+		             "a role change moves the controller to its new device");
+
+		system.pressed = vr::ButtonMaskFromId(vr::k_EButton_Grip);
+		left.update(0.f);
+		ok &= expect(left.GetPressDown(vr::k_EButton_Grip) && left.GetGripDown(), "a grip press is an edge");
+		left.update(0.f);
+		ok &= expect(!left.GetPressDown(vr::k_EButton_Grip) && left.GetGrip(), "a held grip is no edge");
+
+		system.leftIndex = vr::k_unTrackedDeviceIndexInvalid;
+		event.eventType = vr::VREvent_TrackedDeviceDeactivated;
+		left.handleEvent(event);
+		calls = system.stateCalls;
+		left.update(0.f);
+		ok &= expect(system.stateCalls == calls && !left.GetGrip(), "a controller that went away isn't queried");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testActions();
+	ok &= testManifest();
+	ok &= testControllers();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+// Replays HMD trajectories through VirtualHipsSolver at 90 Hz. The HMD walks down from standing through sitting
+// to lying and back up, the hips take each mode's position and rotation, leaving a lower mode takes the HMD
+// rising modeHysteresis above its threshold, and with a blend time the hips move between the modes' poses
+// linearly over modeBlendSeconds, turning back mid way when the mode does. The standing rotation follows
+// the HMD's yaw on every frame
+//
+// g++ -std=c++17 -O2 -Itests/stubs -ISFMLProject/inc tests/VirtualHipsSolverTest.cpp -o VirtualHipsSolverTest
+#include <cmath>
+#include <cstdio>
+
+#include "VirtualHipsSolver.h"
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+	const double frameSeconds = 1 / 90.0;
+
+	// The hips 0.7m under the HMD, sitting below 1.2m and lying below 0.5m
+	VirtualHipsSolver::Params params(double blendSeconds)
+	{
+		VirtualHipsSolver::Params params;
+		params.heightFromHMD = 0.7;
+		params.hipThickness = 0.1;
+		params.sittingMaxHeightThreshold = 1.2;
+		params.lyingMaxHeightThreshold = 0.5;
+		params.modeBlendSeconds = blendSeconds;
+		return params;
+	}
+
+	VirtualHipsSolver::Snapshot frame(double hmdHeight, double hmdYaw = 0)
+	{
+		VirtualHipsSolver::Snapshot frame;
+		frame.hmdPosition = {{0, hmdHeight, 0}};
+		frame.hmdRotation = {std::cos(hmdYaw / 2), 0, std::sin(hmdYaw / 2), 0};
+		frame.deltaSeconds = frameSeconds;
+		return frame;
+	}
+
+	bool near(double a, double b, double tolerance = 1e-9)
+	{
+		return std::fabs(a - b) < tolerance;
+	}
+
+	// The same rotation, either sign
+	bool sameRotation(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b)
+	{
+		return near(std::fabs(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z), 1, 1e-9);
+	}
+
+	vr::HmdQuaternion_t rotationX(double angle) { return {std::cos(angle / 2), std::sin(angle / 2), 0, 0}; }
+	vr::HmdQuaternion_t rotationY(double angle) { return {std::cos(angle / 2), 0, std::sin(angle / 2), 0}; }
+
+	vr::HmdQuaternion_t multiply(const vr::HmdQuaternion_t& lhs, const vr::HmdQuaternion_t& rhs)
+	{
+		return {
+			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
+			lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.w * rhs.y + lhs.y * rhs.w + lhs.z * rhs.x - lhs.x * rhs.z,
+			lhs.w * rhs.z + lhs.z * rhs.w + lhs.x * rhs.y - lhs.y * rhs.x
+		};
+	}
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testModePoses()
+	{
+		bool ok = true;
+		VirtualHipsSolver solver;
+		const VirtualHipsSolver::Params instant = params(0);
+		const double yaw = 0.8;
+
+		VirtualHipsSolver::Result hips = solver.solve(frame(1.7, yaw), instant);
+		ok &= expect(hips.mode == VirtualHipMode::Standing, "standing with the HMD at 1.7m");
+		ok &= expect(near(hips.position.v[1], 1.0), "the hips hang heightFromHMD under the HMD");
+		ok &= expect(sameRotation(hips.rotation, rotationY(yaw)), "turned with the HMD's yaw only");
+
+		hips = solver.solve(frame(1.0, yaw), instant);
+		ok &= expect(hips.mode == VirtualHipMode::Sitting, "sitting with the HMD at 1.0m");
+		ok &= expect(near(hips.position.v[1], 0.3), "the hips still hang under the HMD");
+		// 0.3m of the 0.5m between the hips' height and the sitting threshold is left
+		ok &= expect(sameRotation(hips.rotation, multiply(rotationY(yaw), rotationX(-pi / 4 * 0.6))),
+		             "tilted up by 45 degrees times the part of the sitting range left");
+
+		hips = solver.solve(frame(0.75, yaw), instant);
+		ok &= expect(hips.mode == VirtualHipMode::Sitting && near(hips.position.v[1], 0.3),
+		             "sitting hips don't sink below hipThickness + 0.2m");
+
+		hips = solver.solve(frame(0.4, yaw), instant);
+		ok &= expect(hips.mode == VirtualHipMode::Lying, "lying with the HMD at 0.4m");
+		ok &= expect(near(hips.position.v[1], 0.1), "the hips rest at hipThickness");
+		ok &= expect(sameRotation(hips.rotation, rotationX(pi / 2)), "and lie flat without feet to look at");
+
+		VirtualHipsSolver::Snapshot withFeet = frame(0.4, yaw);
+		withFeet.hmdPosition.v[2] = -0.6;
+		withFeet.feetTracked = true;
+		withFeet.averageFootPosition = {{0.2, 0.1, 1.0}};
+		hips = solver.solve(withFeet, instant);
+		ok &= expect(near(hips.position.v[0], 0.1) && near(hips.position.v[2], 0.2), "or half way between head and feet");
+		return ok;
+	}
+
+	bool testHysteresis()
+	{
+		bool ok = true;
+		VirtualHipsSolver solver;
+		const VirtualHipsSolver::Params instant = params(0);
+
+		ok &= expect(solver.solve(frame(1.22), instant).mode == VirtualHipMode::Standing,
+		             "the first frame takes the plain thresholds");
+
+		const struct
+		{
+			double height;
+			VirtualHipMode mode;
+		} walk[] = {
+			{1.19, VirtualHipMode::Sitting}, {1.24, VirtualHipMode::Sitting}, {1.26, VirtualHipMode::Standing},
+			{1.24, VirtualHipMode::Standing}, {1.2, VirtualHipMode::Sitting}, {0.5, VirtualHipMode::Lying},
+			{0.54, VirtualHipMode::Lying}, {0.51, VirtualHipMode::Lying}, {0.56, VirtualHipMode::Sitting},
+			{0.52, VirtualHipMode::Sitting}, {0.3, VirtualHipMode::Lying}, {1.23, VirtualHipMode::Sitting},
+			{0.45, VirtualHipMode::Lying}, {1.3, VirtualHipMode::Standing},
+		};
+		for (const auto& step : walk)
+		{
+			const VirtualHipMode mode = solver.solve(frame(step.height), instant).mode;
+			const bool right = expect(mode == step.mode, "a lower mode is only left 0.05m above its threshold");
+			ok &= right;
+			if (!right)
+				std::printf("  at %.2fm: mode %d, expected %d\n", step.height, static_cast<int>(mode), static_cast<int>(step.mode));
+		}
+
+		// A reset forgets the mode, 1.22m is standing again
+		solver.solve(frame(1.0), instant);
+		solver.reset();
+		ok &= expect(solver.solve(frame(1.22), instant).mode == VirtualHipMode::Standing, "a reset starts over");
+		return ok;
+	}
+
+	// Standing hips follow the feet tracked at x = 0.3, sitting ones stay under the HMD at x = 0
+	VirtualHipsSolver::Snapshot footFrame(double hmdHeight)
+	{
+		VirtualHipsSolver::Snapshot snapshot = frame(hmdHeight);
+		snapshot.feetTracked = true;
+		snapshot.averageFootPosition = {{0.3, 0, 0}};
+		return snapshot;
+	}
+
+	bool testBlend()
+	{
+		bool ok = true;
+		VirtualHipsSolver solver;
+		VirtualHipsSolver::Params blended = params(0.3);
+		blended.positionAccountsForFootTrackers = true;
+
+		ok &= expect(near(solver.solve(footFrame(1.7), blended).position.v[0], 0.3), "the first frame starts fully in its mode");
+
+		// 27 frames of 1/90s make the 0.3s blend
+		bool linear = true;
+		for (int i = 1; i <= 27; i++)
+		{
+			const VirtualHipsSolver::Result hips = solver.solve(footFrame(1.0), blended);
+			linear &= hips.mode == VirtualHipMode::Sitting;
+			linear &= near(hips.position.v[0], 0.3 * (1 - i / 27.0), 1e-9);
+		}
+		ok &= expect(linear, "the hips move over to the sitting pose linearly while reporting the new mode");
+		ok &= expect(near(solver.solve(footFrame(1.0), blended).position.v[0], 0), "and stay there once the blend is done");
+
+		// A third of the way back to standing the HMD drops down again and the blend turns around
+		for (int i = 0; i < 9; i++)
+			solver.solve(footFrame(1.3), blended);
+		ok &= expect(near(solver.solve(footFrame(1.3), blended).position.v[0], 0.3 * 10 / 27.0), "a third of the way back");
+		VirtualHipsSolver::Snapshot paused = footFrame(1.0);
+		paused.deltaSeconds = 0;
+		ok &= expect(near(solver.solve(paused, blended).position.v[0], 0.3 * 10 / 27.0), "a frame without time doesn't blend");
+		for (int i = 9; i >= 1; i--)
+			ok &= expect(near(solver.solve(footFrame(1.0), blended).position.v[0], 0.3 * i / 27.0), "turning back from there");
+		ok &= expect(near(solver.solve(footFrame(1.0), blended).position.v[0], 0), "in as many frames as it went");
+
+		// Rotations blend too, staying unit length on the way from sitting to lying
+		bool unit = true, between = true;
+		const vr::HmdQuaternion_t sitting = solver.solve(footFrame(1.0), blended).rotation;
+		vr::HmdQuaternion_t previous = sitting;
+		for (int i = 0; i < 27; i++)
+		{
+			VirtualHipsSolver::Snapshot lying = frame(0.4);
+			const vr::HmdQuaternion_t rotation = solver.solve(lying, blended).rotation;
+			unit &= near(rotation.w * rotation.w + rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z, 1);
+			between &= !sameRotation(rotation, previous);
+			previous = rotation;
+		}
+		ok &= expect(unit, "blended rotations are normalised");
+		ok &= expect(between && sameRotation(previous, rotationX(pi / 2)), "and turn a little every frame until they lie flat");
+
+		// Without a blend time the switch is instant
+		blended.modeBlendSeconds = 0;
+		ok &= expect(near(solver.solve(footFrame(1.7), blended).position.v[0], 0.3), "a blend time of 0 switches at once");
+		return ok;
+	}
+
+	bool testFollowsHmd()
+	{
+		bool ok = true;
+		VirtualHipsSolver solver;
+		VirtualHipsSolver::Params follow = params(0.3);
+		bool yawFollowed = true;
+		for (int i = 0; i < 90; i++)
+		{
+			// Turning slowly, so consecutive HMD rotations are close but never the same
+			const double yaw = 0.5 + i * 1e-4;
+			yawFollowed &= sameRotation(solver.solve(frame(1.7, yaw), follow).rotation, rotationY(yaw));
+		}
+		ok &= expect(yawFollowed, "the standing hips take the HMD's yaw every frame");
+
+		// Pitched down 0.4 rad after a quarter turn, only followed when asked to
+		VirtualHipsSolver::Snapshot pitched = frame(1.7);
+		pitched.hmdRotation = multiply(rotationY(pi / 2), rotationX(-0.4));
+		ok &= expect(sameRotation(solver.solve(pitched, follow).rotation, rotationY(pi / 2)), "pitch isn't followed by default");
+		follow.followHmdPitchRotation = true;
+		ok &= expect(sameRotation(solver.solve(pitched, follow).rotation, multiply(rotationY(pi / 2), rotationX(-0.4))),
+		             "but is with followHmdPitchRotation");
+		follow.followHmdYawRotation = false;
+		follow.followHmdPitchRotation = false;
+		ok &= expect(sameRotation(solver.solve(pitched, follow).rotation, {1, 0, 0, 0}), "and following nothing leaves them square");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testModePoses();
+	ok &= testHysteresis();
+	ok &= testBlend();
+	ok &= testFollowsHmd();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+// Feeds YawDriftCorrector a synthetic recording: a body part turning and pitching, an IMU strapped on at
+// an angle that drifts in yaw at 60 Hz, and a noisy Kinect bone at 30 Hz. Checks that it settles before
+// correcting, holds the yaw error down over ten minutes of drift with wild skeleton frames mixed in,
+// only trusts a large error once it persists, and never turns or learns drift faster than its limits
+//
+// g++ -std=c++17 -O2 -Itests/stubs -ISFMLProject/inc -Iexternal/inputemulator/lib_vrinputemulator/include
+//     tests/YawDriftCorrectorTest.cpp -o YawDriftCorrectorTest
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "YawDriftCorrector.h"
+
+namespace
+{
+	using namespace vrmath;
+
+	const double pi = 3.14159265358979323846;
+	const double degrees = 180 / pi;
+
+	double yawOf(const vr::HmdQuaternion_t& q)
+	{
+		const vr::HmdVector3d_t forward = quaternionRotateVector(q, vr::HmdVector3d_t{1, 0, 0});
+		return std::atan2(-forward.v[2], forward.v[0]);
+	}
+
+	double wrap(double angle)
+	{
+		return std::remainder(angle, 2 * pi);
+	}
+
+	// A foot walking around slowly, with the PSMove strapped on crooked
+	struct Recording
+	{
+		std::mt19937 rng{1};
+		std::normal_distribution<double> normal{0, 1};
+		const vr::HmdQuaternion_t mount = quaternionFromYawPitchRoll(0.7, 0.3, -0.2);
+		const vr::HmdVector3d_t boneLocal = {0, -0.2, 1}; // Forward and a bit down in the body part's frame
+		double bodyYaw = 0;
+		vr::HmdQuaternion_t body = {1, 0, 0, 0};
+
+		void advance(double time, double dt)
+		{
+			bodyYaw += 0.6 * std::sin(time * 0.3) * dt + 0.02 * normal(rng);
+			body = quaternionFromRotationY(bodyYaw) * quaternionFromRotationX(0.4 * std::sin(time * 1.7));
+		}
+
+		vr::HmdQuaternion_t imu(double drift) const
+		{
+			return quaternionFromRotationY(drift) * body * mount;
+		}
+
+		// About 3 degrees of noise, plus extraYaw
+		vr::HmdVector3d_t bone(double extraYaw)
+		{
+			return quaternionRotateVector(quaternionFromRotationY(normal(rng) * 0.05 + extraYaw),
+			                              quaternionRotateVector(body, boneLocal));
+		}
+
+		// Yaw between the body and where a corrected IMU rotation puts it
+		double error(const vr::HmdQuaternion_t& rotation) const
+		{
+			return wrap(yawOf(rotation * quaternionConjugate(mount)) - yawOf(body));
+		}
+	};
+
+	bool expect(bool condition, const char* what)
+	{
+		if (!condition)
+			std::printf("FAIL: %s\n", what);
+		return condition;
+	}
+
+	bool testSettling()
+	{
+		bool ok = true;
+		YawDriftCorrector corrector;
+		Recording recording;
+		const int settleSamples = corrector.getSettings().settleSamples;
+		const double dt = 1.0 / 30;
+		for (int i = 0; i < settleSamples; i++)
+		{
+			recording.advance(i * dt, dt);
+			ok &= expect(!corrector.isSettled(), "not settled before enough bone samples");
+			// One wild skeleton frame among them must not skew what is learnt
+			corrector.addBoneDirection(recording.imu(0.3), recording.bone(i == 5 ? 1.5 : 0), i * dt);
+			ok &= expect(corrector.getCorrectionYaw() == 0, "no correction while settling");
+		}
+		ok &= expect(corrector.isSettled(), "settled after settleSamples bone samples");
+
+		// Settling learns the bone in the drifted frame, that drift is taken as the mount and left alone
+		for (int i = settleSamples; i < settleSamples + 300; i++)
+		{
+			recording.advance(i * dt, dt);
+			corrector.addBoneDirection(recording.imu(0.3), recording.bone(0), i * dt);
+		}
+		ok &= expect(std::fabs(corrector.getCorrectionYaw()) * degrees < 2.5, "no drift, no correction after settling");
+
+		ok &= expect(!corrector.addBoneDirection(recording.imu(0), vr::HmdVector3d_t{0, 0, 0}, 100),
+		             "a zero length bone is unusable");
+		ok &= expect(!corrector.addBoneDirection(recording.imu(0), vr::HmdVector3d_t{0, -1, 0}, 100),
+		             "a vertical bone has no heading");
+		return ok;
+	}
+
+	bool testDrift(double driftRate)
+	{
+		YawDriftCorrector corrector;
+		Recording recording;
+		std::mt19937 wild(2);
+		double errorSum = 0, errorMax = 0, uncorrected = 0;
+		int errorCount = 0;
+		const double dt = 1.0 / 60;
+		for (int i = 0; i < 60 * 600; i++)
+		{
+			const double time = i * dt;
+			recording.advance(time, dt);
+			// Plus an 11 degree jump at five minutes, like a PSMove re-orienting on its magnetometer
+			const vr::HmdQuaternion_t imu = recording.imu(driftRate * time + (time > 300 ? 0.2 : 0));
+			if (i % 2 == 0)
+			{
+				// 2% of skeleton frames are way off, a flipped or mislabelled body
+				const double extraYaw = wild() % 50 == 0 ? 1.5 : 0;
+				corrector.addBoneDirection(imu, recording.bone(extraYaw), time);
+			}
+
+			// After the first minute, and not while catching up with the jump
+			if (time > 60 && (time < 300 || time > 330))
+			{
+				const double error = std::fabs(recording.error(corrector.correct(imu)));
+				errorSum += error;
+				errorMax = std::max(errorMax, error);
+				errorCount++;
+			}
+			uncorrected = std::fabs(recording.error(imu));
+		}
+
+		const double errorMean = errorSum / errorCount * degrees;
+		std::printf("drift %.3f rad/s: uncorrected %.1f deg at the end, corrected mean %.2f deg, max %.2f deg\n",
+		            driftRate, uncorrected * degrees, errorMean, errorMax * degrees);
+		bool ok = expect(errorMean < 1, "the mean yaw error stays small");
+		ok &= expect(errorMax * degrees < 3, "the yaw error never runs away");
+		return ok;
+	}
+
+	// Settles on a still body part and IMU, so a bone sample's yaw error is exactly extraYaw
+	double settleStill(YawDriftCorrector& corrector, Recording& recording)
+	{
+		double time = 0;
+		while (!corrector.isSettled())
+		{
+			corrector.addBoneDirection(recording.imu(0), quaternionRotateVector(recording.body, recording.boneLocal), time);
+			time += 1.0 / 30;
+		}
+		return time;
+	}
+
+	vr::HmdVector3d_t turnedBone(const Recording& recording, double yaw)
+	{
+		return quaternionRotateVector(quaternionFromRotationY(yaw), quaternionRotateVector(recording.body, recording.boneLocal));
+	}
+
+	bool testOutlierGate()
+	{
+		bool ok = true;
+		YawDriftCorrector corrector;
+		Recording recording;
+		double time = settleStill(corrector, recording);
+		const YawDriftCorrector::Settings& settings = corrector.getSettings();
+
+		ok &= expect(!corrector.addBoneDirection(recording.imu(0), turnedBone(recording, 1.0), time),
+		             "a single large error is rejected");
+		ok &= expect(corrector.getCorrectionYaw() == 0, "a rejected sample doesn't turn the correction");
+		time += 1.0 / 30;
+		ok &= expect(corrector.addBoneDirection(recording.imu(0), turnedBone(recording, 0.1), time),
+		             "a small error after it is used again");
+		ok &= expect(corrector.getCorrectionYaw() > 0, "and turns the correction");
+
+		// Only the samples in a row count, the one above reset them
+		const double before = corrector.getCorrectionYaw();
+		for (int i = 1; i < settings.outlierSamples; i++)
+		{
+			time += 1.0 / 30;
+			ok &= expect(!corrector.addBoneDirection(recording.imu(0), turnedBone(recording, 1.0), time),
+			             "a large error is rejected until it persists");
+		}
+		ok &= expect(corrector.getCorrectionYaw() == before, "rejected samples leave the correction alone");
+		time += 1.0 / 30;
+		ok &= expect(corrector.addBoneDirection(recording.imu(0), turnedBone(recording, 1.0), time),
+		             "a large error that persists is trusted");
+		ok &= expect(corrector.getCorrectionYaw() > before, "and turns the correction towards it");
+		return ok;
+	}
+
+	bool testRateLimits()
+	{
+		bool ok = true;
+		YawDriftCorrector corrector;
+		Recording recording;
+		double time = settleStill(corrector, recording);
+		const YawDriftCorrector::Settings& settings = corrector.getSettings();
+
+		// Far beyond what the filter may learn, so both limits are hit
+		const double driftRate = 0.3;
+		const double dt = 1.0 / 30;
+		double maxStep = 0, maxDriftRate = 0;
+		for (int i = 0; i < 30 * 60; i++)
+		{
+			time += dt;
+			const double before = corrector.getCorrectionYaw();
+			const vr::HmdQuaternion_t imu = recording.imu(driftRate * i * dt);
+			corrector.addBoneDirection(imu, quaternionRotateVector(recording.body, recording.boneLocal), time);
+			maxStep = std::max(maxStep, std::fabs(wrap(corrector.getCorrectionYaw() - before)));
+			maxDriftRate = std::max(maxDriftRate, std::fabs(corrector.getDriftRate()));
+		}
+		ok &= expect(maxStep <= settings.maxCorrectionRate * dt + 1e-12, "the correction never turns faster than its limit");
+		ok &= expect(maxDriftRate <= settings.maxDriftRate + 1e-12, "the learnt drift rate never exceeds its limit");
+		ok &= expect(maxDriftRate == settings.maxDriftRate, "a faster drift is learnt up to the limit");
+
+		// A long gap between samples only counts as maxSampleGap
+		time += 60;
+		const double before = corrector.getCorrectionYaw();
+		corrector.addBoneDirection(recording.imu(driftRate * 120), turnedBone(recording, -0.4), time);
+		ok &= expect(std::fabs(wrap(corrector.getCorrectionYaw() - before))
+		             <= settings.maxCorrectionRate * settings.maxSampleGap + 1e-12, "a gap doesn't allow a larger turn");
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = testSettling();
+	for (double driftRate : {0.0, 0.01, 0.03})
+		ok &= testDrift(driftRate);
+	ok &= testOutlierGate();
+	ok &= testRateLimits();
+
+	std::printf(ok ? "PASS\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,2 @@
+#pragma once
+// Stands in for the Windows SDK header KinectV2Process/targetver.h includes, nothing from it is used
@@ -0,0 +1,90 @@
+// Stands in for the sfml-graphics library when a test draws into SFML types without a window (only SFML's
+// headers are checked out). Colours, vertices and vertex arrays behave as in SFML 2.4, drawing does nothing
+#include <SFML/Graphics.hpp>
+
+namespace sf
+{
+	const Color Color::Black(0, 0, 0);
+	const Color Color::White(255, 255, 255);
+	const Color Color::Red(255, 0, 0);
+	const Color Color::Green(0, 255, 0);
+	const Color Color::Blue(0, 0, 255);
+	const Color Color::Yellow(255, 255, 0);
+	const Color Color::Magenta(255, 0, 255);
+	const Color Color::Cyan(0, 255, 255);
+	const Color Color::Transparent(0, 0, 0, 0);
+
+	Color::Color() : r(0), g(0), b(0), a(255)
+	{
+	}
+
+	Color::Color(Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha) : r(red), g(green), b(blue), a(alpha)
+	{
+	}
+
+	bool operator ==(const Color& left, const Color& right)
+	{
+		return left.r == right.r && left.g == right.g && left.b == right.b && left.a == right.a;
+	}
+
+	bool operator !=(const Color& left, const Color& right)
+	{
+		return !(left == right);
+	}
+
+	Vertex::Vertex() : position(0, 0), color(255, 255, 255), texCoords(0, 0)
+	{
+	}
+
+	Vertex::Vertex(const Vector2f& thePosition, const Color& theColor)
+		: position(thePosition), color(theColor), texCoords(0, 0)
+	{
+	}
+
+	VertexArray::VertexArray() : m_vertices(), m_primitiveType(Points)
+	{
+	}
+
+	VertexArray::VertexArray(PrimitiveType type, std::size_t vertexCount) : m_vertices(vertexCount), m_primitiveType(type)
+	{
+	}
+
+	std::size_t VertexArray::getVertexCount() const
+	{
+		return m_vertices.size();
+	}
+
+	Vertex& VertexArray::operator [](std::size_t index)
+	{
+		return m_vertices[index];
+	}
+
+	const Vertex& VertexArray::operator [](std::size_t index) const
+	{
+		return m_vertices[index];
+	}
+
+	void VertexArray::clear()
+	{
+		m_vertices.clear();
+	}
+
+	void VertexArray::append(const Vertex& vertex)
+	{
+		m_vertices.push_back(vertex);
+	}
+
+	PrimitiveType VertexArray::getPrimitiveType() const
+	{
+		return m_primitiveType;
+	}
+
+	void VertexArray::draw(RenderTarget&, RenderStates) const
+	{
+	}
+
+	void RenderTarget::draw(const Drawable& drawable, const RenderStates& states)
+	{
+		drawable.draw(*this, states);
+	}
+}
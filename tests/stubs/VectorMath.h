@@ -0,0 +1,42 @@
+#pragma once
+// Stands in for SFMLProject/inc/VectorMath.h, which needs glm (not checked out for the tests).
+// The sf::Vector3f helpers, defined here as VectorMath.cpp does, without the glm up and forward vectors
+#include <cmath>
+#include <string>
+#include <SFML/System/Vector3.hpp>
+
+namespace KMath
+{
+#define PI 3.14159265359
+	inline float length(sf::Vector3f vector)
+	{
+		return
+			sqrt(pow(vector.x, 2) + pow(vector.y, 2) + pow(vector.z, 2));
+	}
+
+	inline std::string to_string(sf::Vector3f v)
+	{
+		return std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z);
+	}
+
+	inline sf::Vector3f cross(sf::Vector3f v1, sf::Vector3f v2)
+	{
+		float x = (v1.y * v2.z) - (v1.z * v2.y);
+		float y = -((v1.x * v2.z) - (v1.z * v2.x));
+		float z = (v1.x * v2.y) - (v1.y * v2.x);
+		return {x, y, z};
+	}
+
+	inline float dot(sf::Vector3f v1, sf::Vector3f v2)
+	{
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	}
+
+	inline sf::Vector3f rotate(const sf::Vector3f& v, const sf::Vector3f& k, double theta)
+	{
+		float cos_theta = cos(theta);
+		float sin_theta = sin(theta);
+
+		return (v * cos_theta) + (cross(k, v) * sin_theta) + (k * dot(k, v)) * (1 - cos_theta);
+	}
+}
@@ -0,0 +1,3 @@
+#pragma once
+// Stands in for easylogging++ in the input emulator driver's logging.h, LOG(...) is the one from stdafx.h
+#include "stdafx.h"
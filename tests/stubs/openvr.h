@@ -0,0 +1,171 @@
+#pragma once
+// Stands in for the OpenVR client header (a submodule that is not checked out for the tests).
+// Only the math types openvr_math.h works on, and the types and IVRInput/IVRSystem calls VRActionInput and
+// VRcontroller use.
+// The structs are laid out like the real ones and the interfaces are left abstract, so tests can mock them
+#include <cstdint>
+
+namespace vr
+{
+	typedef uint64_t VRActionHandle_t;
+	typedef uint64_t VRActionSetHandle_t;
+	typedef uint64_t VRInputValueHandle_t;
+	typedef uint32_t TrackedDeviceIndex_t;
+
+	static const VRActionHandle_t k_ulInvalidActionHandle = 0;
+	static const VRInputValueHandle_t k_ulInvalidInputValueHandle = 0;
+	static const TrackedDeviceIndex_t k_unTrackedDeviceIndexInvalid = 0xFFFFFFFF;
+	static const uint32_t k_unMaxTrackedDeviceCount = 64;
+
+	enum EVRInputError
+	{
+		VRInputError_None = 0,
+		VRInputError_NameNotFound = 1,
+		VRInputError_WrongType = 2,
+		VRInputError_InvalidHandle = 3,
+	};
+
+	enum ETrackedControllerRole
+	{
+		TrackedControllerRole_Invalid = 0,
+		TrackedControllerRole_LeftHand = 1,
+		TrackedControllerRole_RightHand = 2,
+	};
+
+	enum ETrackingUniverseOrigin
+	{
+		TrackingUniverseSeated = 0,
+		TrackingUniverseStanding = 1,
+	};
+
+	enum ETrackingResult
+	{
+		TrackingResult_Running_OK = 200,
+		TrackingResult_Running_OutOfRange = 201,
+	};
+
+	enum EVRButtonId
+	{
+		k_EButton_Grip = 2,
+		k_EButton_Axis0 = 32,
+		k_EButton_SteamVR_Touchpad = k_EButton_Axis0,
+	};
+
+	enum EVREventType
+	{
+		VREvent_TrackedDeviceActivated = 100,
+		VREvent_TrackedDeviceDeactivated = 101,
+		VREvent_TrackedDeviceUpdated = 102,
+		VREvent_TrackedDeviceRoleChanged = 108,
+	};
+
+	inline uint64_t ButtonMaskFromId(EVRButtonId id)
+	{
+		return 1ull << id;
+	}
+
+	struct HmdMatrix34_t
+	{
+		float m[3][4];
+	};
+
+	struct HmdVector3_t
+	{
+		float v[3];
+	};
+
+	struct HmdVector3d_t
+	{
+		double v[3];
+	};
+
+	struct HmdQuaternion_t
+	{
+		double w, x, y, z;
+	};
+
+	struct TrackedDevicePose_t
+	{
+		HmdMatrix34_t mDeviceToAbsoluteTracking;
+		HmdVector3_t vVelocity;
+		HmdVector3_t vAngularVelocity;
+		ETrackingResult eTrackingResult;
+		bool bPoseIsValid;
+		bool bDeviceIsConnected;
+	};
+
+	struct VRControllerAxis_t
+	{
+		float x, y;
+	};
+
+	struct VRControllerState_t
+	{
+		uint32_t unPacketNum;
+		uint64_t ulButtonPressed;
+		uint64_t ulButtonTouched;
+		VRControllerAxis_t rAxis[5];
+	};
+
+	// Without the data union, nothing here reads it
+	struct VREvent_t
+	{
+		uint32_t eventType;
+		TrackedDeviceIndex_t trackedDeviceIndex;
+		float eventAgeSeconds;
+	};
+
+	struct VRActiveActionSet_t
+	{
+		VRActionSetHandle_t ulActionSet;
+		VRInputValueHandle_t ulRestrictedToDevice;
+		VRActionSetHandle_t ulSecondaryActionSet;
+		uint32_t unPadding;
+		int32_t nPriority;
+	};
+
+	struct InputDigitalActionData_t
+	{
+		bool bActive;
+		VRInputValueHandle_t activeOrigin;
+		bool bState;
+		bool bChanged;
+		float fUpdateTime;
+	};
+
+	struct InputAnalogActionData_t
+	{
+		bool bActive;
+		VRInputValueHandle_t activeOrigin;
+		float x, y, z;
+		float deltaX, deltaY, deltaZ;
+		float fUpdateTime;
+	};
+
+	class IVRInput
+	{
+	public:
+		virtual EVRInputError SetActionManifestPath(const char* pchActionManifestPath) = 0;
+		virtual EVRInputError GetActionSetHandle(const char* pchActionSetName, VRActionSetHandle_t* pHandle) = 0;
+		virtual EVRInputError GetActionHandle(const char* pchActionName, VRActionHandle_t* pHandle) = 0;
+		virtual EVRInputError GetInputSourceHandle(const char* pchInputSourcePath, VRInputValueHandle_t* pHandle) = 0;
+		virtual EVRInputError UpdateActionState(VRActiveActionSet_t* pSets, uint32_t unSizeOfVRSelectedActionSet_t,
+		                                        uint32_t unSetCount) = 0;
+		virtual EVRInputError GetDigitalActionData(VRActionHandle_t action, InputDigitalActionData_t* pActionData,
+		                                           uint32_t unActionDataSize, VRInputValueHandle_t ulRestrictToDevice) = 0;
+		virtual EVRInputError GetAnalogActionData(VRActionHandle_t action, InputAnalogActionData_t* pActionData,
+		                                          uint32_t unActionDataSize, VRInputValueHandle_t ulRestrictToDevice) = 0;
+	};
+
+	class IVRSystem
+	{
+	public:
+		virtual TrackedDeviceIndex_t GetTrackedDeviceIndexForControllerRole(ETrackedControllerRole unDeviceType) = 0;
+		virtual bool IsTrackedDeviceConnected(TrackedDeviceIndex_t unDeviceIndex) = 0;
+		virtual bool GetControllerStateWithPose(ETrackingUniverseOrigin eOrigin, TrackedDeviceIndex_t unControllerDeviceIndex,
+		                                        VRControllerState_t* pControllerState, uint32_t unControllerStateSize,
+		                                        TrackedDevicePose_t* pTrackedDevicePose) = 0;
+		virtual void TriggerHapticPulse(TrackedDeviceIndex_t unControllerDeviceIndex, uint32_t unAxisId,
+		                                unsigned short usDurationMicroSec) = 0;
+	};
+}
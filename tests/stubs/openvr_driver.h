@@ -0,0 +1,144 @@
+#pragma once
+// Stands in for the OpenVR driver header (a submodule that is not checked out for the tests).
+// Only the pose types the portable driver headers, vrinputemulator_types.h and openvr_math.h use, laid out like the real ones,
+// property batches, the pose call of IVRServerDriverHost, the component updates of IVRDriverInput and IVRProperties,
+// the interfaces left abstract so tests can mock them
+#include <cstdint>
+
+namespace vr
+{
+	static const uint32_t k_unTrackedDeviceIndex_Hmd = 0;
+	static const uint32_t k_unTrackedDeviceIndexInvalid = 0xFFFFFFFF;
+
+	typedef uint64_t PropertyContainerHandle_t;
+	typedef uint32_t PropertyTypeTag_t;
+	static const PropertyContainerHandle_t k_ulInvalidPropertyContainer = 0;
+	static const PropertyTypeTag_t k_unStringPropertyTag = 5;
+
+	enum ETrackedDeviceProperty
+	{
+		Prop_Invalid = 0,
+		Prop_TrackingSystemName_String = 1000,
+		Prop_ModelNumber_String = 1001,
+		Prop_SerialNumber_String = 1002,
+		Prop_ManufacturerName_String = 1005,
+	};
+
+	enum ETrackedPropertyError
+	{
+		TrackedProp_Success = 0,
+	};
+
+	enum EPropertyWriteType
+	{
+		PropertyWrite_Set = 0,
+		PropertyWrite_Erase = 1,
+		PropertyWrite_SetError = 2,
+	};
+
+	struct PropertyWrite_t
+	{
+		ETrackedDeviceProperty prop;
+		EPropertyWriteType writeType;
+		ETrackedPropertyError eSetError;
+		void* pvBuffer;
+		uint32_t unBufferSize;
+		PropertyTypeTag_t unTag;
+		ETrackedPropertyError eError;
+	};
+
+	typedef uint64_t VRInputComponentHandle_t;
+
+	enum EVRInputError
+	{
+		VRInputError_None = 0,
+		VRInputError_InvalidHandle = 3,
+	};
+
+	enum EVRScalarType
+	{
+		VRScalarType_Absolute = 0,
+		VRScalarType_Relative = 1,
+	};
+
+	enum EVRScalarUnits
+	{
+		VRScalarUnits_NormalizedOneSided = 0,
+		VRScalarUnits_NormalizedTwoSided = 1,
+	};
+
+	struct HmdMatrix34_t
+	{
+		float m[3][4];
+	};
+
+	struct HmdVector3_t
+	{
+		float v[3];
+	};
+
+	struct HmdVector3d_t
+	{
+		double v[3];
+	};
+
+	struct HmdQuaternion_t
+	{
+		double w, x, y, z;
+	};
+
+	enum ETrackedDeviceClass
+	{
+		TrackedDeviceClass_Invalid = 0,
+		TrackedDeviceClass_HMD = 1,
+		TrackedDeviceClass_Controller = 2,
+		TrackedDeviceClass_GenericTracker = 3,
+	};
+
+	enum ETrackingResult
+	{
+		TrackingResult_Uninitialized = 1,
+		TrackingResult_Running_OK = 200,
+	};
+
+	struct DriverPose_t
+	{
+		double poseTimeOffset;
+		HmdQuaternion_t qWorldFromDriverRotation;
+		double vecWorldFromDriverTranslation[3];
+		HmdQuaternion_t qDriverFromHeadRotation;
+		double vecDriverFromHeadTranslation[3];
+		double vecPosition[3];
+		double vecVelocity[3];
+		double vecAcceleration[3];
+		HmdQuaternion_t qRotation;
+		double vecAngularVelocity[3];
+		double vecAngularAcceleration[3];
+		ETrackingResult result;
+		bool poseIsValid;
+		bool willDriftInYaw;
+		bool shouldApplyHeadModel;
+		bool deviceIsConnected;
+	};
+
+	class IVRServerDriverHost
+	{
+	public:
+		virtual void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const DriverPose_t& newPose, uint32_t unPoseStructSize) = 0;
+	};
+
+	class IVRProperties
+	{
+	public:
+		virtual ETrackedPropertyError WritePropertyBatch(PropertyContainerHandle_t ulContainerHandle, PropertyWrite_t* pBatch,
+		                                                 uint32_t unBatchEntryCount) = 0;
+		virtual PropertyContainerHandle_t TrackedDeviceToPropertyContainer(uint32_t nDevice) = 0;
+	};
+
+	class IVRDriverInput
+	{
+	public:
+		virtual EVRInputError UpdateBooleanComponent(VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) = 0;
+		virtual EVRInputError UpdateScalarComponent(VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) = 0;
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+// Stands in for the projects' precompiled headers when the portable headers are built on their own.
+// LOG(...) writes to stderr like easylogging++ would, nothing else of the Windows headers is provided
+#include <iostream>
+#include <string>
+
+struct TestLogLine
+{
+	explicit TestLogLine(const char* level)
+	{
+		std::cerr << level << ' ';
+	}
+
+	~TestLogLine()
+	{
+		std::cerr << '\n';
+	}
+
+	template <typename T>
+	TestLogLine& operator<<(const T& value)
+	{
+		std::cerr << value;
+		return *this;
+	}
+
+	// Config paths are wide, the tests only use ASCII ones
+	TestLogLine& operator<<(const std::wstring& value)
+	{
+		std::cerr << std::string(value.begin(), value.end());
+		return *this;
+	}
+};
+
+#define LOG(level) TestLogLine(#level)
@@ -0,0 +1,2 @@
+#pragma once
+// Stands in for the Windows generic-text header KinectV2Process/stdafx.h includes, nothing from it is used